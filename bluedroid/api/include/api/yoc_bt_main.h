@@ -30,6 +30,14 @@ typedef enum {
     YOC_BLUEDROID_STATUS_ENABLED                     /*!< Bluetooth initialized and enabled */
 } yoc_bluedroid_status_t;
 
+/**
+ * @brief Storage of the bonded devices
+ */
+typedef enum {
+    YOC_BT_BOND_STORE_KV = 0,                        /*!< aos_kv value, the default on targets */
+    YOC_BT_BOND_STORE_FILE,                          /*!< file, for host builds and tests */
+} yoc_bt_bond_store_t;
+
 /**
  * @brief     Get bluetooth stack status
  *
@@ -74,6 +82,19 @@ yoc_err_t yoc_bluedroid_init(void);
  */
 yoc_err_t yoc_bluedroid_deinit(void);
 
+/**
+ * @brief     Select where the bonded devices are stored, must be prior to yoc_bluedroid_init()
+ *
+ * @param[in] type : aos_kv value or file
+ * @param[in] name : aos_kv key or file path, NULL for the default of the type
+ *
+ * @return
+ *            - YOC_OK : Succeed
+ *            - YOC_ERR_INVALID_STATE : Bluedroid already initialised
+ *            - YOC_ERR_NOT_SUPPORTED : The storage is not built in, or the name is too long
+ */
+yoc_err_t yoc_bluedroid_set_bond_store(yoc_bt_bond_store_t type, const char *name);
+
 #ifdef __cplusplus
 }
 #endif
@@ -360,6 +360,36 @@ typedef struct {
                                                         advertising reports for each packet received */
 } yoc_ble_scan_params_t;
 
+/// Scan report filter checks, see yoc_ble_scan_report_filter_t
+#define YOC_BLE_SCAN_RPT_FILTER_UUID        (1 << 0)    /*!< Report only devices advertising service_uuid */
+#define YOC_BLE_SCAN_RPT_FILTER_MANUF       (1 << 1)    /*!< Report only devices whose manufacturer data starts with manuf_prefix */
+#define YOC_BLE_SCAN_RPT_FILTER_RSSI        (1 << 2)    /*!< Report only packets received at rssi_floor or above */
+#define YOC_BLE_SCAN_RPT_FILTER_ADDR        (1 << 3)    /*!< Report only devices in addr_list */
+#define YOC_BLE_SCAN_RPT_FILTER_RATE        (1 << 4)    /*!< Report each device at most once per rate_limit_ms */
+
+/// Maximum length of the manufacturer data prefix of the scan report filter
+#define YOC_BLE_SCAN_RPT_MANUF_PREFIX_MAX   8
+/// Maximum number of addresses in the scan report filter
+#define YOC_BLE_SCAN_RPT_ADDR_LIST_MAX      8
+/// Maximum number of scan reports delivered in one batch
+#define YOC_BLE_SCAN_RPT_BATCH_MAX          16
+
+/// Host side filter and batching of scan results
+typedef struct {
+    uint8_t                 filter_mask;            /*!< Checks to apply, YOC_BLE_SCAN_RPT_FILTER_xxx. A report is delivered only if it passes all of them */
+    int8_t                  rssi_floor;             /*!< Lowest RSSI delivered, in dBm */
+    yoc_bt_uuid_t           service_uuid;           /*!< Service UUID looked up in the 16, 32 and 128 bit service UUID lists */
+    uint8_t                 manuf_prefix_len;       /*!< Length of manuf_prefix */
+    uint8_t                 manuf_prefix[YOC_BLE_SCAN_RPT_MANUF_PREFIX_MAX];  /*!< Leading bytes of the manufacturer specific data,
+                                                                                starting with the company identifier in little endian */
+    uint8_t                 addr_num;               /*!< Number of addresses in addr_list */
+    yoc_bd_addr_t           addr_list[YOC_BLE_SCAN_RPT_ADDR_LIST_MAX];        /*!< Devices to report */
+    uint16_t                rate_limit_ms;          /*!< Minimum time between two reports of the same device */
+    uint8_t                 batch_num;              /*!< Scan results handed to the application task at once, 0 or 1 for no batching.
+                                                      Range: 0 to YOC_BLE_SCAN_RPT_BATCH_MAX */
+    uint16_t                batch_timeout_ms;       /*!< Longest time a scan result waits for its batch to fill */
+} yoc_ble_scan_report_filter_t;
+
 /// Connection update parameters
 typedef struct {
     yoc_bd_addr_t bda;                              /*!< Bluetooth device address */
@@ -755,6 +785,25 @@ yoc_err_t yoc_ble_gap_config_adv_data (yoc_ble_adv_data_t *adv_data);
  */
 yoc_err_t yoc_ble_gap_set_scan_params(yoc_ble_scan_params_t *scan_params);
 
+/**
+ * @brief           This function is called to filter and batch the scan results before
+ *                  they are handed to the application. The filter is applied in the
+ *                  Bluetooth host task, reports it rejects never reach the application
+ *                  queue. Scan results that pass are still delivered one by one with
+ *                  YOC_GAP_BLE_SCAN_RESULT_EVT, but up to batch_num of them are moved to
+ *                  the application task at once. The filter stays in use until it is cleared.
+ *
+ * @param[in]       filter: Pointer to the filter configuration, copied before the function
+ *                  returns. NULL clears the filter and stops batching.
+ *
+ * @return
+ *                  - YOC_OK : success
+ *                  - other  : failed
+ *
+ */
+yoc_err_t yoc_ble_gap_set_scan_report_filter(const yoc_ble_scan_report_filter_t *filter);
+
+
 
 /**
  * @brief           This procedure keep the device scanning the peer device which advertising on the air
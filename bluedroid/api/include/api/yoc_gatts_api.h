@@ -475,6 +475,53 @@ yoc_err_t yoc_ble_gatts_stop_service(uint16_t service_handle);
 yoc_err_t yoc_ble_gatts_send_indicate(yoc_gatt_if_t gatts_if, uint16_t conn_id, uint16_t attr_handle,
                                       uint16_t value_len, uint8_t *value, bool need_confirm);
 
+/**
+ * @brief           Allocate a buffer for a notification or indication value.
+ *                  The value is written in place and sent with yoc_ble_gatts_send_indicate_buf,
+ *                  which passes the buffer down to L2CAP without copying it.
+ *
+ * @param[in]       gatts_if: GATT server access interface
+ * @param[in]       conn_id - connection id to indicate.
+ * @param[inout]    value_len - requested value length, updated to the usable length
+ *                  (at most MTU - 3 of the connection).
+ *
+ * @return
+ *                  - pointer to the value area : success
+ *                  - NULL : unknown connection or out of memory
+ *
+ */
+uint8_t *yoc_ble_gatts_alloc_indicate_buf(yoc_gatt_if_t gatts_if, uint16_t conn_id, uint16_t *value_len);
+
+/**
+ * @brief           Send a value filled in a buffer from yoc_ble_gatts_alloc_indicate_buf.
+ *                  Set param need_confirm as false will send notification, otherwise indication.
+ *                  On YOC_OK the buffer belongs to the stack. On any other return it still
+ *                  belongs to the caller, who may retry or release it with yoc_ble_gatts_free_indicate_buf.
+ *
+ * @param[in]       gatts_if: GATT server access interface
+ * @param[in]       conn_id - connection id to indicate.
+ * @param[in]       attr_handle - attribute handle to indicate.
+ * @param[in]       value_len - value length, not larger than the allocated length.
+ * @param[in]       value: value area returned by yoc_ble_gatts_alloc_indicate_buf.
+ * @param[in]       need_confirm - Whether a confirmation is required.
+ *                  false sends a GATT notification, true sends a GATT indication.
+ *
+ * @return
+ *                  - YOC_OK : success
+ *                  - other  : failed
+ *
+ */
+yoc_err_t yoc_ble_gatts_send_indicate_buf(yoc_gatt_if_t gatts_if, uint16_t conn_id, uint16_t attr_handle,
+                                          uint16_t value_len, uint8_t *value, bool need_confirm);
+
+/**
+ * @brief           Release a buffer from yoc_ble_gatts_alloc_indicate_buf that was not sent.
+ *
+ * @param[in]       value: value area returned by yoc_ble_gatts_alloc_indicate_buf.
+ *
+ */
+void yoc_ble_gatts_free_indicate_buf(uint8_t *value);
+
 
 /**
  * @brief           This function is called to send a response to a request.
@@ -16,6 +16,7 @@
 #include "yoc_bt_main.h"
 #include "btc/btc_task.h"
 #include "btc/btc_main.h"
+#include "btc/btc_config.h"
 #include "osi/future.h"
 #include "osi/allocator.h"
 
@@ -129,7 +130,7 @@ yoc_err_t yoc_bluedroid_init(void)
         return YOC_ERR_INVALID_STATE;
     }
 
-#ifdef CONFIG_BLUEDROID_MEM_DEBUG
+#if CONFIG_BLUEDROID_MEM_DEBUG
     osi_mem_dbg_init();
 #endif
 
@@ -205,3 +206,16 @@ yoc_err_t yoc_bluedroid_deinit(void)
     return YOC_OK;
 }
 
+yoc_err_t yoc_bluedroid_set_bond_store(yoc_bt_bond_store_t type, const char *name)
+{
+    if (bd_already_init) {
+        LOG_ERROR("Bluedroid already initialised\n");
+        return YOC_ERR_INVALID_STATE;
+    }
+
+    if (!btc_config_select_backend(type == YOC_BT_BOND_STORE_KV, name)) {
+        return YOC_ERR_NOT_SUPPORTED;
+    }
+
+    return YOC_OK;
+}
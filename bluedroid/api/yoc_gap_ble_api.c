@@ -75,6 +75,39 @@ yoc_err_t yoc_ble_gap_set_scan_params(yoc_ble_scan_params_t *scan_params)
     return (btc_transfer_context(&msg, &arg, sizeof(btc_ble_gap_args_t), NULL) == BT_STATUS_SUCCESS ? YOC_OK : YOC_FAIL);
 }
 
+yoc_err_t yoc_ble_gap_set_scan_report_filter(const yoc_ble_scan_report_filter_t *filter)
+{
+    btc_msg_t msg;
+    btc_ble_gap_args_t arg;
+
+    YOC_BLUEDROID_STATUS_CHECK(YOC_BLUEDROID_STATUS_ENABLED);
+
+#if (BTC_SCAN_RPT_FILTER_INCLUDED == FALSE)
+    return YOC_ERR_NOT_SUPPORTED;
+#endif
+
+    if (filter && (filter->manuf_prefix_len > YOC_BLE_SCAN_RPT_MANUF_PREFIX_MAX
+                   || filter->addr_num > YOC_BLE_SCAN_RPT_ADDR_LIST_MAX
+                   || filter->batch_num > YOC_BLE_SCAN_RPT_BATCH_MAX)) {
+        return YOC_ERR_INVALID_ARG;
+    }
+
+    if (filter && (filter->filter_mask & YOC_BLE_SCAN_RPT_FILTER_UUID)
+        && filter->service_uuid.len != YOC_UUID_LEN_16
+        && filter->service_uuid.len != YOC_UUID_LEN_32
+        && filter->service_uuid.len != YOC_UUID_LEN_128) {
+        return YOC_ERR_INVALID_ARG;
+    }
+
+    msg.sig = BTC_SIG_API_CALL;
+    msg.pid = BTC_PID_GAP_BLE;
+    msg.act = BTC_GAP_BLE_ACT_SET_SCAN_RPT_FILTER;
+    arg.set_scan_rpt_filter.filter = (yoc_ble_scan_report_filter_t *)filter;
+
+    return (btc_transfer_context(&msg, &arg, sizeof(btc_ble_gap_args_t), btc_gap_ble_arg_deep_copy)
+            == BT_STATUS_SUCCESS ? YOC_OK : YOC_FAIL);
+}
+
 yoc_err_t yoc_ble_gap_start_scanning(uint32_t duration)
 {
     btc_msg_t msg;
@@ -22,6 +22,8 @@
 #include "common/bt_target.h"
 #include "stack/l2cdefs.h"
 #include "stack/l2c_api.h"
+#include "stack/gatt_api.h"
+#include "osi/allocator.h"
 
 #if (GATTS_INCLUDED == TRUE)
 #define COPY_TO_GATTS_ARGS(_gatt_args, _arg, _arg_type) memcpy(_gatt_args, _arg, sizeof(_arg_type))
@@ -278,6 +280,78 @@ yoc_err_t yoc_ble_gatts_send_indicate(yoc_gatt_if_t gatts_if, uint16_t conn_id,
                                  btc_gatts_arg_deep_copy) == BT_STATUS_SUCCESS ? YOC_OK : YOC_FAIL);
 }
 
+/* buffers handed out by yoc_ble_gatts_alloc_indicate_buf always start the value at this offset */
+static BT_HDR *yoc_ble_gatts_indicate_buf_hdr(uint8_t *value)
+{
+    return (BT_HDR *)(value - GATT_HDR_SIZE - L2CAP_MIN_OFFSET) - 1;
+}
+
+uint8_t *yoc_ble_gatts_alloc_indicate_buf(yoc_gatt_if_t gatts_if, uint16_t conn_id, uint16_t *value_len)
+{
+    BT_HDR *p_buf;
+    uint16_t mtu;
+
+    if (value_len == NULL || yoc_bluedroid_get_status() != YOC_BLUEDROID_STATUS_ENABLED) {
+        return NULL;
+    }
+
+    /* MTU as cached by BTC from the connection and MTU events */
+    mtu = btc_gatts_get_mtu(conn_id);
+    if (mtu == 0) {
+        return NULL;
+    }
+
+    p_buf = GATTS_AllocHandleValueBuf(mtu, *value_len);
+    if (p_buf == NULL) {
+        return NULL;
+    }
+
+    *value_len = p_buf->len - GATT_HDR_SIZE;
+    return GATTS_HANDLE_VALUE_BUF_DATA(p_buf);
+}
+
+void yoc_ble_gatts_free_indicate_buf(uint8_t *value)
+{
+    if (value) {
+        osi_free(yoc_ble_gatts_indicate_buf_hdr(value));
+    }
+}
+
+yoc_err_t yoc_ble_gatts_send_indicate_buf(yoc_gatt_if_t gatts_if, uint16_t conn_id, uint16_t attr_handle,
+                                          uint16_t value_len, uint8_t *value, bool need_confirm)
+{
+    btc_msg_t msg;
+    btc_ble_gatts_args_t arg;
+    BT_HDR *p_buf;
+
+    YOC_BLUEDROID_STATUS_CHECK(YOC_BLUEDROID_STATUS_ENABLED);
+
+    if (value == NULL) {
+        return YOC_ERR_INVALID_ARG;
+    }
+
+    p_buf = yoc_ble_gatts_indicate_buf_hdr(value);
+    if (value_len > p_buf->len - GATT_HDR_SIZE) {
+        return YOC_ERR_INVALID_ARG;
+    }
+
+    if (L2CA_CheckIsCongest(L2CAP_ATT_CID, conn_id)) {
+        LOG_DEBUG("%s, the l2cap chanel is congest.", __func__);
+        return YOC_FAIL;
+    }
+
+    msg.sig = BTC_SIG_API_CALL;
+    msg.pid = BTC_PID_GATTS;
+    msg.act = BTC_GATTS_ACT_SEND_INDICATE_BUF;
+    arg.send_ind_buf.conn_id = BTC_GATT_CREATE_CONN_ID(gatts_if, conn_id);
+    arg.send_ind_buf.attr_handle = attr_handle;
+    arg.send_ind_buf.need_confirm = need_confirm;
+    arg.send_ind_buf.value_len = value_len;
+    arg.send_ind_buf.p_buf = p_buf;
+
+    return (btc_transfer_context(&msg, &arg, sizeof(btc_ble_gatts_args_t), NULL) == BT_STATUS_SUCCESS ? YOC_OK : YOC_FAIL);
+}
+
 yoc_err_t yoc_ble_gatts_send_response(yoc_gatt_if_t gatts_if, uint16_t conn_id, uint32_t trans_id,
                                       yoc_gatt_status_t status, yoc_gatt_rsp_t *rsp)
 {
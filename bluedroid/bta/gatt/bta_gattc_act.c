@@ -105,6 +105,7 @@ static const char *bta_gattc_op_code_name[] = {
 
 
 void bta_gattc_reset_discover_st(tBTA_GATTC_SERV *p_srcb, tBTA_GATT_STATUS status);
+void bta_gattc_set_discover_st(tBTA_GATTC_SERV *p_srcb);
 
 /*******************************************************************************
 **
@@ -670,10 +671,22 @@ void bta_gattc_conn(tBTA_GATTC_CLCB *p_clcb, tBTA_GATTC_DATA *p_data)
 #if (GATTC_CACHE_NVS == TRUE)
             p_clcb->p_srcb->state = BTA_GATTC_SERV_LOAD;
             if (bta_gattc_cache_load(p_clcb)) {
-                p_clcb->p_srcb->state = BTA_GATTC_SERV_IDLE;
-                bta_gattc_reset_discover_st(p_clcb->p_srcb, BTA_GATT_OK);
-                //register service change
-                bta_gattc_register_service_change_notify(p_clcb->bta_conn_id, p_clcb->bda);
+                if (!p_clcb->p_srcb->db_hash_valid) {
+                    p_clcb->p_srcb->state = BTA_GATTC_SERV_IDLE;
+                    bta_gattc_reset_discover_st(p_clcb->p_srcb, BTA_GATT_OK);
+                    //register service change
+                    bta_gattc_register_service_change_notify(p_clcb->bta_conn_id, p_clcb->bda);
+                } else if (bta_gattc_read_db_hash(p_clcb) == BTA_GATT_OK) {
+                    /* hold the operations until the cache is validated */
+                    p_clcb->p_srcb->state = BTA_GATTC_SERV_HASH;
+                    bta_gattc_set_discover_st(p_clcb->p_srcb);
+                } else {
+                    /* the saved Database Hash cannot be confirmed, rediscover */
+                    bta_gattc_free_srvc_cache(p_clcb->p_srcb);
+                    bta_gattc_cache_reset(p_clcb->p_srcb->server_bda);
+                    p_clcb->p_srcb->state = BTA_GATTC_SERV_DISC;
+                    bta_gattc_start_discover(p_clcb, NULL);
+                }
             } else 
 #endif
             { /* cache is building */
@@ -851,11 +864,20 @@ void bta_gattc_reset_discover_st(tBTA_GATTC_SERV *p_srcb, tBTA_GATT_STATUS statu
 *******************************************************************************/
 void bta_gattc_disc_close(tBTA_GATTC_CLCB *p_clcb, tBTA_GATTC_DATA *p_data)
 {
+    tBTA_GATTC_OP_CMPL hash_cmpl;
+
     APPL_TRACE_DEBUG("%s: Discovery cancel conn_id=%d", __func__,
                      p_clcb->bta_conn_id);
 
+    memset(&hash_cmpl, 0, sizeof(tBTA_GATTC_OP_CMPL));
+    hash_cmpl.op_code = GATTC_OPTYPE_READ;
+    hash_cmpl.status = GATT_ERROR;
+
     if (p_clcb->disc_active) {
         bta_gattc_reset_discover_st(p_clcb->p_srcb, BTA_GATT_ERROR);
+    } else if (bta_gattc_db_hash_cmpl(p_clcb, &hash_cmpl)) {
+        /* the Database Hash read ends with this connection, its result
+           will not be reported: go on as if the server had no hash */
     } else {
         p_clcb->state = BTA_GATTC_CONN_ST;
     }
@@ -1019,8 +1041,7 @@ void bta_gattc_disc_cmpl(tBTA_GATTC_CLCB *p_clcb, tBTA_GATTC_DATA *p_data)
     if (p_clcb->status != GATT_SUCCESS) {
         /* clean up cache */
         if (p_clcb->p_srcb && p_clcb->p_srcb->p_srvc_cache) {
-            list_free(p_clcb->p_srcb->p_srvc_cache);
-            p_clcb->p_srcb->p_srvc_cache = NULL;
+            bta_gattc_free_srvc_cache(p_clcb->p_srcb);
         }
 #if(GATTC_CACHE_NVS == TRUE)
         /* used to reset cache in application */
@@ -1443,7 +1464,10 @@ void  bta_gattc_op_cmpl(tBTA_GATTC_CLCB *p_clcb, tBTA_GATTC_DATA *p_data)
 *******************************************************************************/
 void  bta_gattc_ignore_op_cmpl(tBTA_GATTC_CLCB *p_clcb, tBTA_GATTC_DATA *p_data)
 {
-    UNUSED(p_clcb);
+    /* the Database Hash read made for the server cache */
+    if (bta_gattc_db_hash_cmpl(p_clcb, &p_data->op_cmpl)) {
+        return;
+    }
 
     /* receive op complete when discovery is started, ignore the response,
         and wait for discovery finish and resent */
@@ -1729,8 +1753,7 @@ void bta_gattc_process_api_refresh(tBTA_GATTC_CB *p_cb, tBTA_GATTC_DATA *p_msg)
         }
         /* in all other cases, mark it and delete the cache */
         if (p_srvc_cb->p_srvc_cache != NULL) {
-            list_free(p_srvc_cb->p_srvc_cache);
-            p_srvc_cb->p_srvc_cache = NULL;
+            bta_gattc_free_srvc_cache(p_srvc_cb);
         }
     }
 }
@@ -28,6 +28,7 @@
 #if defined(GATTC_INCLUDED) && (GATTC_INCLUDED == TRUE)
 
 #include <string.h>
+#include <stdlib.h>
 #include "bta/utl.h"
 #include "bta/bta_sys.h"
 #include "stack/sdp_api.h"
@@ -44,11 +45,11 @@
 
 static void bta_gattc_char_dscpt_disc_cmpl(UINT16 conn_id, tBTA_GATTC_SERV *p_srvc_cb);
 extern void bta_to_btif_uuid(bt_uuid_t *p_dest, tBT_UUID *p_src);
-static size_t bta_gattc_get_db_size_with_type(list_t *services,
+static size_t bta_gattc_get_db_size_with_type(tBTA_GATTC_SERV *p_srvc_cb,
                                               bt_gatt_db_attribute_type_t type,
                                               tBT_UUID *char_uuid,
                                               UINT16 start_handle, UINT16 end_handle);
-static void bta_gattc_cache_write(BD_ADDR server_bda, UINT16 num_attr,
+static void bta_gattc_cache_write(BD_ADDR server_bda, UINT16 num_attr, UINT8 *db_hash,
                            tBTA_GATTC_NV_ATTR *attr);
 tBTA_GATTC_SERVICE*  bta_gattc_find_matching_service(const list_t *services, UINT16 handle);
 tBTA_GATTC_DESCRIPTOR*  bta_gattc_get_descriptor_srcb(tBTA_GATTC_SERV *p_srcb, UINT16 handle);
@@ -172,10 +173,7 @@ static void bta_gattc_display_explore_record(tBTA_GATTC_ATTR_REC *p_rec, UINT8 n
 *******************************************************************************/
 tBTA_GATT_STATUS bta_gattc_init_cache(tBTA_GATTC_SERV *p_srvc_cb)
 {
-    if (p_srvc_cb->p_srvc_cache != NULL) {
-        list_free(p_srvc_cb->p_srvc_cache);
-        p_srvc_cb->p_srvc_cache = NULL;
-    }
+    bta_gattc_free_srvc_cache(p_srvc_cb);
 
     osi_free(p_srvc_cb->p_srvc_list);
 
@@ -213,6 +211,182 @@ static void bta_gattc_free(void *ptr)
     osi_free(ptr);
 }
 
+static void bta_gattc_free_attr_index(tBTA_GATTC_SERV *p_srvc_cb)
+{
+    osi_free(p_srvc_cb->p_attr_index);
+    p_srvc_cb->p_attr_index = NULL;
+    p_srvc_cb->num_attr_index = 0;
+}
+
+/*******************************************************************************
+**
+** Function         bta_gattc_free_srvc_cache
+**
+** Description      free the server cache and its handle index.
+**
+** Returns          None.
+**
+*******************************************************************************/
+void bta_gattc_free_srvc_cache(tBTA_GATTC_SERV *p_srvc_cb)
+{
+    list_free(p_srvc_cb->p_srvc_cache);
+    p_srvc_cb->p_srvc_cache = NULL;
+    bta_gattc_free_attr_index(p_srvc_cb);
+}
+
+static int bta_gattc_attr_index_cmp(const void *p_a, const void *p_b)
+{
+    return (int)((const tBTA_GATTC_ATTR_INDEX *)p_a)->handle -
+           (int)((const tBTA_GATTC_ATTR_INDEX *)p_b)->handle;
+}
+
+static tBTA_GATTC_ATTR_INDEX *bta_gattc_attr_index_add(tBTA_GATTC_ATTR_INDEX *p_entry, UINT16 handle,
+                                                       bt_gatt_db_attribute_type_t type,
+                                                       tBTA_GATTC_SERVICE *p_service, void *p_attr)
+{
+    p_entry->handle = handle;
+    p_entry->type = type;
+    p_entry->p_service = p_service;
+    p_entry->p_attr = p_attr;
+    return p_entry + 1;
+}
+
+/*******************************************************************************
+**
+** Function         bta_gattc_build_attr_index
+**
+** Description      build the handle index of the server cache if it is not
+**                  built yet. The index is dropped whenever the cache changes.
+**
+** Returns          TRUE if the index is available.
+**
+*******************************************************************************/
+static BOOLEAN bta_gattc_build_attr_index(tBTA_GATTC_SERV *p_srvc_cb)
+{
+    list_t *services = p_srvc_cb->p_srvc_cache;
+    tBTA_GATTC_ATTR_INDEX *p_entry;
+    size_t num_attr = 0;
+
+    if (p_srvc_cb->p_attr_index != NULL) {
+        return TRUE;
+    }
+    if (!services || list_is_empty(services)) {
+        return FALSE;
+    }
+
+    for (list_node_t *sn = list_begin(services); sn != list_end(services); sn = list_next(sn)) {
+        tBTA_GATTC_SERVICE *p_srvc = list_node(sn);
+
+        num_attr += 1 + (p_srvc->included_svc ? list_length(p_srvc->included_svc) : 0);
+        if (!p_srvc->characteristics) {
+            continue;
+        }
+        for (list_node_t *cn = list_begin(p_srvc->characteristics);
+             cn != list_end(p_srvc->characteristics); cn = list_next(cn)) {
+            tBTA_GATTC_CHARACTERISTIC *p_char = list_node(cn);
+            num_attr += 1 + (p_char->descriptors ? list_length(p_char->descriptors) : 0);
+        }
+    }
+
+    if (num_attr > 0xFFFF ||
+            (p_srvc_cb->p_attr_index = osi_malloc(num_attr * sizeof(tBTA_GATTC_ATTR_INDEX))) == NULL) {
+        APPL_TRACE_WARNING("%s(), no resource.", __func__);
+        return FALSE;
+    }
+
+    p_entry = p_srvc_cb->p_attr_index;
+    for (list_node_t *sn = list_begin(services); sn != list_end(services); sn = list_next(sn)) {
+        tBTA_GATTC_SERVICE *p_srvc = list_node(sn);
+
+        p_entry = bta_gattc_attr_index_add(p_entry, p_srvc->s_handle,
+                                           p_srvc->is_primary ? BTGATT_DB_PRIMARY_SERVICE :
+                                           BTGATT_DB_SECONDARY_SERVICE, p_srvc, p_srvc);
+        if (p_srvc->included_svc) {
+            for (list_node_t *isn = list_begin(p_srvc->included_svc);
+                 isn != list_end(p_srvc->included_svc); isn = list_next(isn)) {
+                tBTA_GATTC_INCLUDED_SVC *p_isvc = list_node(isn);
+                p_entry = bta_gattc_attr_index_add(p_entry, p_isvc->handle,
+                                                   BTGATT_DB_INCLUDED_SERVICE, p_srvc, p_isvc);
+            }
+        }
+        if (!p_srvc->characteristics) {
+            continue;
+        }
+        for (list_node_t *cn = list_begin(p_srvc->characteristics);
+             cn != list_end(p_srvc->characteristics); cn = list_next(cn)) {
+            tBTA_GATTC_CHARACTERISTIC *p_char = list_node(cn);
+
+            p_entry = bta_gattc_attr_index_add(p_entry, p_char->handle,
+                                               BTGATT_DB_CHARACTERISTIC, p_srvc, p_char);
+            if (!p_char->descriptors) {
+                continue;
+            }
+            for (list_node_t *dn = list_begin(p_char->descriptors);
+                 dn != list_end(p_char->descriptors); dn = list_next(dn)) {
+                tBTA_GATTC_DESCRIPTOR *p_desc = list_node(dn);
+                p_entry = bta_gattc_attr_index_add(p_entry, p_desc->handle,
+                                                   BTGATT_DB_DESCRIPTOR, p_srvc, p_desc);
+            }
+        }
+    }
+
+    /* included services are declared before the characteristics of their
+       service, and secondary services may not be in handle order */
+    qsort(p_srvc_cb->p_attr_index, num_attr, sizeof(tBTA_GATTC_ATTR_INDEX), bta_gattc_attr_index_cmp);
+    p_srvc_cb->num_attr_index = num_attr;
+    return TRUE;
+}
+
+/* position of the first attribute of the index at or after handle */
+static UINT16 bta_gattc_attr_index_lower_bound(const tBTA_GATTC_SERV *p_srvc_cb, UINT32 handle)
+{
+    UINT16 lo = 0, hi = p_srvc_cb->num_attr_index;
+
+    while (lo < hi) {
+        UINT16 mid = lo + (hi - lo) / 2;
+        if (p_srvc_cb->p_attr_index[mid].handle < handle) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/*******************************************************************************
+**
+** Function         bta_gattc_attr_index_range
+**
+** Description      find the attributes of the server cache between start_handle
+**                  and end_handle, in handle order.
+**
+** Returns          number of attributes, the first one is p_attr_index[*p_first].
+**
+*******************************************************************************/
+static UINT16 bta_gattc_attr_index_range(tBTA_GATTC_SERV *p_srvc_cb, UINT16 start_handle,
+                                         UINT16 end_handle, UINT16 *p_first)
+{
+    *p_first = 0;
+    if (start_handle > end_handle || !bta_gattc_build_attr_index(p_srvc_cb)) {
+        return 0;
+    }
+
+    *p_first = bta_gattc_attr_index_lower_bound(p_srvc_cb, start_handle);
+    return bta_gattc_attr_index_lower_bound(p_srvc_cb, (UINT32)end_handle + 1) - *p_first;
+}
+
+static tBTA_GATTC_ATTR_INDEX *bta_gattc_find_attr_index(tBTA_GATTC_SERV *p_srvc_cb, UINT16 handle,
+                                                        bt_gatt_db_attribute_type_t type)
+{
+    UINT16 first;
+
+    if (bta_gattc_attr_index_range(p_srvc_cb, handle, handle, &first) == 0 ||
+            p_srvc_cb->p_attr_index[first].type != type) {
+        return NULL;
+    }
+    return &p_srvc_cb->p_attr_index[first];
+}
+
 void bta_gattc_insert_sec_service_to_cache(list_t *services, tBTA_GATTC_SERVICE *p_new_srvc) 
 {
     // services/p_new_srvc is NULL 
@@ -264,6 +438,7 @@ static tBTA_GATT_STATUS bta_gattc_add_srvc_to_cache(tBTA_GATTC_SERV *p_srvc_cb,
 #if (defined BTA_GATT_DEBUG && BTA_GATT_DEBUG == TRUE)
     APPL_TRACE_DEBUG("Add a service into Service");
 #endif
+    bta_gattc_free_attr_index(p_srvc_cb);
 
     tBTA_GATTC_SERVICE *p_new_srvc = osi_malloc(sizeof(tBTA_GATTC_SERVICE));
     if (!p_new_srvc) {
@@ -304,6 +479,7 @@ static tBTA_GATT_STATUS bta_gattc_add_char_to_cache(tBTA_GATTC_SERV *p_srvc_cb,
     APPL_TRACE_DEBUG("handle=%d uuid16=0x%x property=0x%x",
                       value_handle, p_uuid->uu.uuid16, property);
 #endif
+    bta_gattc_free_attr_index(p_srvc_cb);
 
     tBTA_GATTC_SERVICE *service = bta_gattc_find_matching_service(p_srvc_cb->p_srvc_cache, attr_handle);
     if (!service) {
@@ -354,6 +530,7 @@ static tBTA_GATT_STATUS bta_gattc_add_attr_to_cache(tBTA_GATTC_SERV *p_srvc_cb,
     APPL_TRACE_DEBUG("handle=%d uuid16=0x%x property=0x%x type=%d",
                       handle, p_uuid->uu.uuid16, property, type);
 #endif
+    bta_gattc_free_attr_index(p_srvc_cb);
 
     tBTA_GATTC_SERVICE *service = bta_gattc_find_matching_service(p_srvc_cb->p_srvc_cache, handle);
     if (!service) {
@@ -611,6 +788,7 @@ static void bta_gattc_explore_srvc(UINT16 conn_id, tBTA_GATTC_SERV *p_srvc_cb)
 #if (defined BTA_GATT_DEBUG && BTA_GATT_DEBUG == TRUE)
     bta_gattc_display_cache_server(p_srvc_cb->p_srvc_cache);
 #endif
+    bta_gattc_build_attr_index(p_srvc_cb);
 
     //server discover end, update connection parameters
 #if BLE_INCLUDED == TRUE
@@ -619,9 +797,12 @@ static void bta_gattc_explore_srvc(UINT16 conn_id, tBTA_GATTC_SERV *p_srvc_cb)
     }
 #endif
 #if(GATTC_CACHE_NVS == TRUE)
-    /* save cache to NV */
+    /* save cache to NV once the Database Hash it matches is read */
     p_clcb->p_srcb->state = BTA_GATTC_SERV_SAVE;
-    bta_gattc_cache_save(p_clcb->p_srcb, p_clcb->bta_conn_id);
+    if (bta_gattc_read_db_hash(p_clcb) == BTA_GATT_OK) {
+        return;
+    }
+    bta_gattc_cache_save(p_clcb->p_srcb, p_clcb->bta_conn_id, NULL);
 #endif
     bta_gattc_reset_discover_st(p_clcb->p_srcb, BTA_GATT_OK);
 }
@@ -1137,33 +1318,43 @@ tBTA_GATTC_SERVICE*  bta_gattc_find_matching_service(const list_t *services, UIN
 
 const tBTA_GATTC_SERVICE*  bta_gattc_get_service_for_handle_srcb(tBTA_GATTC_SERV *p_srcb, UINT16 handle) 
 {
-    const list_t *services = bta_gattc_get_services_srcb(p_srcb);
+    const tBTA_GATTC_SERVICE *service;
+    UINT16 idx;
+
+    if (!p_srcb || !bta_gattc_build_attr_index(p_srcb)) {
+        return NULL;
+    }
+
+    /* the last attribute at or before handle tells which service it falls in */
+    idx = bta_gattc_attr_index_lower_bound(p_srcb, (UINT32)handle + 1);
+    if (idx == 0) {
+        return NULL;
+    }
+    service = p_srcb->p_attr_index[idx - 1].p_service;
 
-    return bta_gattc_find_matching_service(services, handle);
+    return (handle <= service->e_handle) ? service : NULL;
 }
 
 const tBTA_GATTC_SERVICE*  bta_gattc_get_service_for_handle(UINT16 conn_id, UINT16 handle) 
 {
-    const list_t *services = bta_gattc_get_services(conn_id);
+    tBTA_GATTC_CLCB *p_clcb = bta_gattc_find_clcb_by_conn_id(conn_id);
+
+    if (p_clcb == NULL )
+        return NULL;
 
-    return bta_gattc_find_matching_service(services, handle);
+    return bta_gattc_get_service_for_handle_srcb(p_clcb->p_srcb, handle);
 }
 
 tBTA_GATTC_CHARACTERISTIC*  bta_gattc_get_characteristic_srcb(tBTA_GATTC_SERV *p_srcb, UINT16 handle) 
 {
-    const tBTA_GATTC_SERVICE* service = bta_gattc_get_service_for_handle_srcb(p_srcb, handle);
+    tBTA_GATTC_ATTR_INDEX *p_entry;
 
-    if (!service)
+    if (!p_srcb) {
         return NULL;
-
-    for (list_node_t *cn = list_begin(service->characteristics);
-         cn != list_end(service->characteristics); cn = list_next(cn)) {
-        tBTA_GATTC_CHARACTERISTIC *p_char = list_node(cn);
-        if (handle == p_char->handle)
-            return p_char;
     }
+    p_entry = bta_gattc_find_attr_index(p_srcb, handle, BTGATT_DB_CHARACTERISTIC);
 
-    return NULL;
+    return p_entry ? (tBTA_GATTC_CHARACTERISTIC *)p_entry->p_attr : NULL;
 }
 
 tBTA_GATTC_CHARACTERISTIC*  bta_gattc_get_characteristic(UINT16 conn_id, UINT16 handle) 
@@ -1179,24 +1370,14 @@ tBTA_GATTC_CHARACTERISTIC*  bta_gattc_get_characteristic(UINT16 conn_id, UINT16
 
 tBTA_GATTC_DESCRIPTOR*  bta_gattc_get_descriptor_srcb(tBTA_GATTC_SERV *p_srcb, UINT16 handle) 
 {
-    const tBTA_GATTC_SERVICE* service = bta_gattc_get_service_for_handle_srcb(p_srcb, handle);
+    tBTA_GATTC_ATTR_INDEX *p_entry;
 
-    if (!service) {
+    if (!p_srcb) {
         return NULL;
     }
+    p_entry = bta_gattc_find_attr_index(p_srcb, handle, BTGATT_DB_DESCRIPTOR);
 
-    for (list_node_t *cn = list_begin(service->characteristics);
-         cn != list_end(service->characteristics); cn = list_next(cn)) {
-        tBTA_GATTC_CHARACTERISTIC *p_char = list_node(cn);
-        for (list_node_t *dn = list_begin(p_char->descriptors);
-             dn != list_end(p_char->descriptors); dn = list_next(dn)) {
-            tBTA_GATTC_DESCRIPTOR *p_desc = list_node(dn);
-            if (handle == p_desc->handle)
-                return p_desc;
-        }
-    }
-
-    return NULL;
+    return p_entry ? (tBTA_GATTC_DESCRIPTOR *)p_entry->p_attr : NULL;
 }
 
 tBTA_GATTC_DESCRIPTOR*  bta_gattc_get_descriptor(UINT16 conn_id, UINT16 handle) 
@@ -1278,6 +1459,121 @@ void bta_gattc_fill_gatt_db_el(btgatt_db_element_t *p_attr,
     bta_to_btif_uuid(&p_attr->uuid, &uuid);
 }
 
+/*******************************************************************************
+**
+** Function         bta_gattc_fill_gatt_db_el_from_index
+**
+** Description      fill a btgatt_db_element_t value from an attribute of the
+**                  handle index
+**
+** Returns          None.
+**
+*******************************************************************************/
+static void bta_gattc_fill_gatt_db_el_from_index(btgatt_db_element_t *p_db_attr,
+                                                 const tBTA_GATTC_ATTR_INDEX *p_entry)
+{
+    switch (p_entry->type) {
+    case BTGATT_DB_PRIMARY_SERVICE:
+    case BTGATT_DB_SECONDARY_SERVICE: {
+        tBTA_GATTC_SERVICE *p_srvc = p_entry->p_attr;
+        bta_gattc_fill_gatt_db_el(p_db_attr, p_entry->type,
+                                  0 /* att_handle */,
+                                  p_srvc->s_handle,
+                                  p_srvc->e_handle,
+                                  p_srvc->s_handle,
+                                  p_srvc->uuid,
+                                  0 /* prop */);
+        break;
+    }
+    case BTGATT_DB_INCLUDED_SERVICE: {
+        tBTA_GATTC_INCLUDED_SVC *p_isvc = p_entry->p_attr;
+        bta_gattc_fill_gatt_db_el(p_db_attr, BTGATT_DB_INCLUDED_SERVICE,
+                                  p_isvc->handle,
+                                  p_isvc->incl_srvc_s_handle /* s_handle */,
+                                  p_isvc->incl_srvc_e_handle /* e_handle */,
+                                  p_isvc->handle,
+                                  p_isvc->uuid,
+                                  0 /* property */);
+        break;
+    }
+    case BTGATT_DB_CHARACTERISTIC: {
+        tBTA_GATTC_CHARACTERISTIC *p_char = p_entry->p_attr;
+        bta_gattc_fill_gatt_db_el(p_db_attr, BTGATT_DB_CHARACTERISTIC,
+                                  p_char->handle,
+                                  0 /* s_handle */,
+                                  0 /* e_handle */,
+                                  p_char->handle,
+                                  p_char->uuid,
+                                  p_char->properties);
+        break;
+    }
+    case BTGATT_DB_DESCRIPTOR: {
+        tBTA_GATTC_DESCRIPTOR *p_desc = p_entry->p_attr;
+        bta_gattc_fill_gatt_db_el(p_db_attr, BTGATT_DB_DESCRIPTOR,
+                                  p_desc->handle,
+                                  0 /* s_handle */,
+                                  0 /* e_handle */,
+                                  p_desc->handle,
+                                  p_desc->uuid,
+                                  0 /* property */);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+/*******************************************************************************
+**
+** Function         bta_gattc_db_op_match
+**
+** Description      check whether an attribute of the handle index is selected
+**                  by a bta_gattc_get_db_with_opration request.
+**
+** Returns          TRUE if the attribute is selected.
+**
+*******************************************************************************/
+static BOOLEAN bta_gattc_db_op_match(bt_gatt_get_db_op_t op, const tBTA_GATTC_ATTR_INDEX *p_entry,
+                                     UINT16 char_handle, tBT_UUID *incl_uuid,
+                                     tBT_UUID *char_uuid, tBT_UUID *descr_uuid)
+{
+    switch (op) {
+    case GATT_OP_GET_INCLUDE_SVC: {
+        tBTA_GATTC_INCLUDED_SVC *p_isvc = p_entry->p_attr;
+        return p_entry->type == BTGATT_DB_INCLUDED_SERVICE &&
+               (!incl_uuid || bta_gattc_uuid_compare(&p_isvc->uuid, incl_uuid, TRUE));
+    }
+    case GATT_OP_GET_ALL_CHAR:
+    case GATT_OP_GET_CHAR_BY_UUID: {
+        tBTA_GATTC_CHARACTERISTIC *p_char = p_entry->p_attr;
+        return p_entry->type == BTGATT_DB_CHARACTERISTIC &&
+               (char_uuid == NULL || bta_gattc_uuid_compare(&p_char->uuid, char_uuid, TRUE));
+    }
+    case GATT_OP_GET_ALL_DESCRI:
+    case GATT_OP_GET_DESCRI_BY_UUID:
+    case GATT_OP_GET_DESCRI_BY_HANDLE: {
+        tBTA_GATTC_DESCRIPTOR *p_desc = p_entry->p_attr;
+
+        if (p_entry->type != BTGATT_DB_DESCRIPTOR) {
+            return FALSE;
+        }
+        if (op == GATT_OP_GET_DESCRI_BY_UUID) {
+            return bta_gattc_uuid_compare(&p_desc->characteristic->uuid, char_uuid, TRUE) &&
+                   (descr_uuid == NULL || bta_gattc_uuid_compare(&p_desc->uuid, descr_uuid, TRUE));
+        }
+        if (p_desc->characteristic->handle != char_handle) {
+            return FALSE;
+        }
+        if (op == GATT_OP_GET_ALL_DESCRI) {
+            return descr_uuid == NULL || bta_gattc_uuid_compare(&p_desc->uuid, descr_uuid, TRUE);
+        }
+        return bta_gattc_uuid_compare(&p_desc->uuid, descr_uuid, TRUE);
+    }
+    default:
+        return FALSE;
+    }
+}
+
 void bta_gattc_get_db_with_opration(UINT16 conn_id,
                                                       bt_gatt_get_db_op_t op,
                                                       UINT16 char_handle,
@@ -1289,6 +1585,7 @@ void bta_gattc_get_db_with_opration(UINT16 conn_id,
                                                       int *count)
 {
     tBTA_GATTC_CLCB *p_clcb = bta_gattc_find_clcb_by_conn_id(conn_id);
+    UINT16 first;
 
     if (p_clcb == NULL) {
         return;
@@ -1302,7 +1599,7 @@ void bta_gattc_get_db_with_opration(UINT16 conn_id,
         return;
     }
 
-    size_t db_size = ((end_handle - start_handle + 1) < p_srcb->total_attr) ? (end_handle - start_handle + 1) : p_srcb->total_attr;
+    size_t db_size = bta_gattc_attr_index_range(p_srcb, start_handle, end_handle, &first);
     if (!db_size) {
         APPL_TRACE_DEBUG("the db size is 0.");
         *count = 0;
@@ -1319,129 +1616,15 @@ void bta_gattc_get_db_with_opration(UINT16 conn_id,
         return;
     }
     btgatt_db_element_t *curr_db_attr = buffer;
-    db_size = 0;
-    for (list_node_t *sn = list_begin(p_srcb->p_srvc_cache);
-         sn != list_end(p_srcb->p_srvc_cache); sn = list_next(sn)) {
-        tBTA_GATTC_SERVICE *p_cur_srvc = list_node(sn);
-
-        if (p_cur_srvc->e_handle < start_handle) {
-            continue;
-        }
-
-        if (p_cur_srvc->s_handle > end_handle) {
-            break;
-        }
-
-        if (op == GATT_OP_GET_INCLUDE_SVC) {
-            if (!p_cur_srvc->included_svc || list_is_empty(p_cur_srvc->included_svc))
-                continue;
-
-            for (list_node_t *isn = list_begin(p_cur_srvc->included_svc);
-                 isn != list_end(p_cur_srvc->included_svc); isn = list_next(isn)) {
-                tBTA_GATTC_INCLUDED_SVC *p_isvc = list_node(isn);
-
-                if (p_isvc->handle < start_handle) {
-                    continue;
-                }
-
-                if (p_isvc->handle > end_handle) {
-                    *char_db = buffer;
-                    *count = db_size;
-                    return;
-                }
-                if (!incl_uuid || bta_gattc_uuid_compare(&p_isvc->uuid, incl_uuid, TRUE)) {
-                    bta_gattc_fill_gatt_db_el(curr_db_attr,
-                                              BTGATT_DB_INCLUDED_SERVICE,
-                                              p_isvc->handle,
-                                              p_isvc->incl_srvc_s_handle /* s_handle */,
-                                              p_isvc->incl_srvc_e_handle /* e_handle */,
-                                              p_isvc->handle,
-                                              p_isvc->uuid,
-                                              0 /* property */);
-                    curr_db_attr++;
-                    db_size++;
-                }
-            }
-            continue;
-        }
-
-        if (!p_cur_srvc->characteristics || list_is_empty(p_cur_srvc->characteristics)) {
-            continue;
-        }
-
-        for (list_node_t *cn = list_begin(p_cur_srvc->characteristics);
-             cn != list_end(p_cur_srvc->characteristics); cn = list_next(cn)) {
-            tBTA_GATTC_CHARACTERISTIC *p_char = list_node(cn);
-            if(op == GATT_OP_GET_ALL_CHAR || op == GATT_OP_GET_CHAR_BY_UUID) {
-                if (p_char->handle < start_handle) {
-                    continue;
-                }
-            }
-
-            if (p_char->handle > end_handle) {
-                *char_db = buffer;
-                *count = db_size;
-                return;
-            }
-            if ((op == GATT_OP_GET_ALL_CHAR || op == GATT_OP_GET_CHAR_BY_UUID) &&
-                (char_uuid == NULL || bta_gattc_uuid_compare(&p_char->uuid, char_uuid, TRUE))) {
-                APPL_TRACE_DEBUG("%s(), uuid match.", __func__);
-                bta_gattc_fill_gatt_db_el(curr_db_attr,
-                                          BTGATT_DB_CHARACTERISTIC,
-                                          p_char->handle,
-                                          0 /* s_handle */,
-                                          0 /* e_handle */,
-                                          p_char->handle,
-                                          p_char->uuid,
-                                          p_char->properties);
-                curr_db_attr++;
-                db_size++;
-                continue;
-            }
-
-            if (!p_char->descriptors || list_is_empty(p_char->descriptors)) {
-                continue;
-            }
+    const tBTA_GATTC_ATTR_INDEX *p_entry = &p_srcb->p_attr_index[first];
+    const tBTA_GATTC_ATTR_INDEX *p_end = p_entry + db_size;
 
-            if ((op == GATT_OP_GET_DESCRI_BY_HANDLE || op == GATT_OP_GET_ALL_DESCRI) && (p_char->handle != char_handle)) {
-                continue;
-            }
-
-            if ((op == GATT_OP_GET_DESCRI_BY_UUID) &&
-                !bta_gattc_uuid_compare(&p_char->uuid, char_uuid, TRUE)) {
-                continue;
-            }
-
-            if (op == GATT_OP_GET_ALL_DESCRI || op == GATT_OP_GET_DESCRI_BY_UUID || op == GATT_OP_GET_DESCRI_BY_HANDLE) {
-                for (list_node_t *dn = list_begin(p_char->descriptors);
-                     dn != list_end(p_char->descriptors); dn = list_next(dn)) {
-                    tBTA_GATTC_DESCRIPTOR *p_desc = list_node(dn);
-
-                    if (p_desc->handle < start_handle) {
-                        continue;
-                    }
-                    if (p_desc->handle > end_handle) {
-                        *char_db = buffer;
-                        *count = db_size;
-                        return;
-                    }
-                    if (((op == GATT_OP_GET_ALL_DESCRI || op == GATT_OP_GET_DESCRI_BY_UUID) &&
-                        (descr_uuid == NULL || bta_gattc_uuid_compare(&p_desc->uuid, descr_uuid, TRUE))) ||
-                        (op == GATT_OP_GET_DESCRI_BY_HANDLE && bta_gattc_uuid_compare(&p_desc->uuid, descr_uuid, TRUE))) {
-                        bta_gattc_fill_gatt_db_el(curr_db_attr,
-                                                  BTGATT_DB_DESCRIPTOR,
-                                                  p_desc->handle,
-                                                  0 /* s_handle */,
-                                                  0 /* e_handle */,
-                                                  p_desc->handle,
-                                                  p_desc->uuid,
-                                                  0 /* property */);
-                        curr_db_attr++;
-                        db_size++;
-                    }
-                }
-            }
-            
+    db_size = 0;
+    for (; p_entry < p_end; p_entry++) {
+        if (bta_gattc_db_op_match(op, p_entry, char_handle, incl_uuid, char_uuid, descr_uuid)) {
+            bta_gattc_fill_gatt_db_el_from_index(curr_db_attr, p_entry);
+            curr_db_attr++;
+            db_size++;
         }
     }
 
@@ -1449,118 +1632,30 @@ void bta_gattc_get_db_with_opration(UINT16 conn_id,
     *count = db_size;
 }
 
-static size_t bta_gattc_get_db_size_with_type(list_t *services,
+static size_t bta_gattc_get_db_size_with_type(tBTA_GATTC_SERV *p_srvc_cb,
                                               bt_gatt_db_attribute_type_t type,
                                               tBT_UUID *char_uuid,
                                               UINT16 start_handle, UINT16 end_handle)
 {
-    if (!services || list_is_empty(services)) {
-        return 0;
-    }
-
     size_t db_size = 0;
-    UINT16 svc_length = list_length(services) - 1;
-
-    for (list_node_t *sn = list_begin(services);
-         sn != list_end(services); sn = list_next(sn), svc_length--) {
-        tBTA_GATTC_SERVICE *p_cur_srvc = list_node(sn);
+    UINT16 first;
+    UINT16 num = bta_gattc_attr_index_range(p_srvc_cb, start_handle, end_handle, &first);
+    const tBTA_GATTC_ATTR_INDEX *p_entry = &p_srvc_cb->p_attr_index[first];
 
-        if (p_cur_srvc->e_handle < start_handle) {
+    for (; num > 0; num--, p_entry++) {
+        if (p_entry->type != type) {
             continue;
         }
-
-        if (p_cur_srvc->s_handle > end_handle) {
-            break;
+        if (char_uuid == NULL) {
+            /* descriptors are only counted per characteristic */
+            db_size += (type != BTGATT_DB_DESCRIPTOR);
+        } else if (type == BTGATT_DB_CHARACTERISTIC) {
+            db_size += bta_gattc_uuid_compare(&((tBTA_GATTC_CHARACTERISTIC *)p_entry->p_attr)->uuid,
+                                              char_uuid, TRUE);
+        } else if (type == BTGATT_DB_DESCRIPTOR) {
+            db_size += bta_gattc_uuid_compare(&((tBTA_GATTC_DESCRIPTOR *)p_entry->p_attr)->characteristic->uuid,
+                                              char_uuid, TRUE);
         }
-
-        if (type == BTGATT_DB_PRIMARY_SERVICE || type == BTGATT_DB_SECONDARY_SERVICE) {
-            if ((type == BTGATT_DB_PRIMARY_SERVICE && p_cur_srvc->is_primary) || 
-                (type == BTGATT_DB_SECONDARY_SERVICE && !p_cur_srvc->is_primary)) {
-                // if the current service is the last service in the db, need to ensure the current service start handle is not less than the start_handle.
-                if (!svc_length) {
-                    if (p_cur_srvc->s_handle >= start_handle) {
-                        db_size++;
-                    }
-                } else {
-                    db_size++;
-                }
-            }
-            continue;
-        }
-
-        if (p_cur_srvc->included_svc && (type == BTGATT_DB_INCLUDED_SERVICE)) {
-            for (list_node_t *isn = list_begin(p_cur_srvc->included_svc);
-                 isn != list_end(p_cur_srvc->included_svc); isn = list_next(isn)) {
-                tBTA_GATTC_INCLUDED_SVC *p_isvc = list_node(isn);
-
-                if (p_isvc->handle < start_handle) {
-                    continue;
-                }
-
-                if (p_isvc->handle > end_handle) {
-                    return db_size;
-                }
-                db_size++;
-            }
-            continue;
-        }
-
-        if (!p_cur_srvc->characteristics || list_is_empty(p_cur_srvc->characteristics)) {
-            continue;
-        }
-
-        if (char_uuid != NULL) {
-            for (list_node_t *cn = list_begin(p_cur_srvc->characteristics);
-                cn != list_end(p_cur_srvc->characteristics); cn = list_next(cn)) {
-                tBTA_GATTC_CHARACTERISTIC *p_char = list_node(cn);
-
-                if (p_char->handle < start_handle) {
-                    continue;
-                }
-
-                if (p_char->handle > end_handle) {
-                    return db_size;
-                }
-
-                if ((type == BTGATT_DB_CHARACTERISTIC) && bta_gattc_uuid_compare(&p_char->uuid, char_uuid, TRUE)) {
-                    db_size++;
-                    continue;
-                }
-
-                if (p_char->descriptors && (type == BTGATT_DB_DESCRIPTOR) && bta_gattc_uuid_compare(&p_char->uuid, char_uuid, TRUE)) {
-                    for (list_node_t *dn = list_begin(p_char->descriptors);
-                         dn != list_end(p_char->descriptors); dn = list_next(dn)) {
-                        tBTA_GATTC_DESCRIPTOR *p_desc = list_node(dn);
-
-                        if (p_desc->handle < start_handle) {
-                            continue;
-                        }
-
-                        if (p_desc->handle > end_handle) {
-                            return db_size;
-                        }
-                        db_size++;
-                    }
-                }
-            }
-        } else {
-            if (type == BTGATT_DB_CHARACTERISTIC) {
-                for (list_node_t *cn = list_begin(p_cur_srvc->characteristics);
-                     cn != list_end(p_cur_srvc->characteristics); cn = list_next(cn)) {
-                    tBTA_GATTC_CHARACTERISTIC *p_char = list_node(cn);
-
-                    if (p_char->handle < start_handle) {
-                        continue;
-                    }
-
-                    if (p_char->handle > end_handle) {
-                        return db_size;
-                    }
-                    db_size++;
-                }
-            }
-        }
-
     }
 
     return db_size;
@@ -1569,82 +1664,12 @@ static size_t bta_gattc_get_db_size_with_type(list_t *services,
 /*******************************************************************************
 ** Returns          number of elements inside db from start_handle to end_handle
 *******************************************************************************/
-static size_t bta_gattc_get_db_size(list_t *services,
+static size_t bta_gattc_get_db_size(tBTA_GATTC_SERV *p_srvc_cb,
                                     UINT16 start_handle, UINT16 end_handle) 
 {
-    if (!services || list_is_empty(services))
-        return 0;
-
-    size_t db_size = 0;
-    UINT16 svc_length = list_length(services) - 1;
-    for (list_node_t *sn = list_begin(services);
-         sn != list_end(services); sn = list_next(sn), svc_length--) {
-        tBTA_GATTC_SERVICE *p_cur_srvc = list_node(sn);
-
-        if (p_cur_srvc->e_handle < start_handle) {
-            continue;
-        }
-
-        if (p_cur_srvc->s_handle > end_handle) {
-            break;
-        }
-
-        if (!svc_length) {
-            if (p_cur_srvc->s_handle >= start_handle) {
-                db_size++;
-            }
-        } else {
-            db_size++;
-        }
-        
-        if (!p_cur_srvc->characteristics || list_is_empty(p_cur_srvc->characteristics))
-            continue;
-
-        for (list_node_t *cn = list_begin(p_cur_srvc->characteristics);
-             cn != list_end(p_cur_srvc->characteristics); cn = list_next(cn)) {
-            tBTA_GATTC_CHARACTERISTIC *p_char = list_node(cn);
-
-            if (p_char->handle < start_handle) {
-                continue;
-            }
-            if (p_char->handle > end_handle) {
-                return db_size;
-            }
-            db_size++;
+    UINT16 first;
 
-            if (p_char->descriptors) {
-                for (list_node_t *dn = list_begin(p_char->descriptors);
-                     dn != list_end(p_char->descriptors); dn = list_next(dn)) {
-                    tBTA_GATTC_DESCRIPTOR *p_desc = list_node(dn);
-                    if (p_desc->handle < start_handle) {
-                        continue;
-                    }
-                    if (p_desc->handle > end_handle) {
-                        return db_size;
-                    }
-                    db_size++;
-                }
-            }
-        }
-
-        if (p_cur_srvc->included_svc) {
-            for (list_node_t *isn = list_begin(p_cur_srvc->included_svc);
-                 isn != list_end(p_cur_srvc->included_svc); isn = list_next(isn)) {
-                tBTA_GATTC_INCLUDED_SVC *p_isvc = list_node(isn);
-
-                if (p_isvc->handle < start_handle) {
-                    continue;
-                }
-
-                if (p_isvc->handle > end_handle) {
-                    return db_size;
-                }
-                db_size++;
-            }
-        }
-    }
-
-    return db_size;
+    return bta_gattc_attr_index_range(p_srvc_cb, start_handle, end_handle, &first);
 }
 
 void bta_gattc_get_db_size_handle(UINT16 conn_id, UINT16 start_handle, UINT16 end_handle, int *count)
@@ -1662,7 +1687,7 @@ void bta_gattc_get_db_size_handle(UINT16 conn_id, UINT16 start_handle, UINT16 en
         return;
     }
 
-    *count = bta_gattc_get_db_size(p_srcb->p_srvc_cache, start_handle, end_handle);
+    *count = bta_gattc_get_db_size(p_srcb, start_handle, end_handle);
 }
 
 void bta_gattc_get_db_size_with_type_handle(UINT16 conn_id, bt_gatt_db_attribute_type_t type,
@@ -1690,7 +1715,7 @@ void bta_gattc_get_db_size_with_type_handle(UINT16 conn_id, bt_gatt_db_attribute
             return;
         }
     }
-    *count = bta_gattc_get_db_size_with_type(p_srcb->p_srvc_cache, type, NULL, start_handle, end_handle);
+    *count = bta_gattc_get_db_size_with_type(p_srcb, type, NULL, start_handle, end_handle);
     
 }
 
@@ -1723,7 +1748,8 @@ static void bta_gattc_get_gatt_db_impl(tBTA_GATTC_SERV *p_srvc_cb,
         return;
     }
 
-    size_t db_size = bta_gattc_get_db_size(p_srvc_cb->p_srvc_cache, start_handle, end_handle);
+    UINT16 first;
+    size_t db_size = bta_gattc_attr_index_range(p_srvc_cb, start_handle, end_handle, &first);
 
     void* buffer = osi_malloc(db_size * sizeof(btgatt_db_element_t));
     if (!buffer) {
@@ -1734,110 +1760,8 @@ static void bta_gattc_get_gatt_db_impl(tBTA_GATTC_SERV *p_srvc_cb,
     }
     btgatt_db_element_t *curr_db_attr = buffer;
 
-    for (list_node_t *sn = list_begin(p_srvc_cb->p_srvc_cache);
-         sn != list_end(p_srvc_cb->p_srvc_cache); sn = list_next(sn)) {
-        tBTA_GATTC_SERVICE *p_cur_srvc = list_node(sn);
-
-        if (p_cur_srvc->e_handle < start_handle) {
-            continue;
-        }
-
-        if (p_cur_srvc->s_handle > end_handle) {
-            break;
-        }
-
-        bta_gattc_fill_gatt_db_el(curr_db_attr,
-                                  p_cur_srvc->is_primary ?
-                                  BTGATT_DB_PRIMARY_SERVICE :
-                                  BTGATT_DB_SECONDARY_SERVICE,
-                                  0 /* att_handle */,
-                                  p_cur_srvc->s_handle,
-                                  p_cur_srvc->e_handle,
-                                  p_cur_srvc->s_handle,
-                                  p_cur_srvc->uuid,
-                                  0 /* prop */);
-        curr_db_attr++;
-
-        if (p_cur_srvc->characteristics && !list_is_empty(p_cur_srvc->characteristics)) {
-
-            for (list_node_t *cn = list_begin(p_cur_srvc->characteristics);
-                 cn != list_end(p_cur_srvc->characteristics); cn = list_next(cn)) {
-                tBTA_GATTC_CHARACTERISTIC *p_char = list_node(cn);
-
-                if (p_char->handle < start_handle) {
-                    continue;
-                }
-
-                if (p_char->handle > end_handle) {
-                    *db = buffer;
-                    *count = db_size;
-                    return;
-                }
-                bta_gattc_fill_gatt_db_el(curr_db_attr,
-                                          BTGATT_DB_CHARACTERISTIC,
-                                          p_char->handle,
-                                          0 /* s_handle */,
-                                          0 /* e_handle */,
-                                          p_char->handle,
-                                          p_char->uuid,
-                                          p_char->properties);
-                curr_db_attr++;
-
-                if (!p_char->descriptors || list_is_empty(p_char->descriptors))
-                    continue;
-
-                for (list_node_t *dn = list_begin(p_char->descriptors);
-                     dn != list_end(p_char->descriptors); dn = list_next(dn)) {
-                    tBTA_GATTC_DESCRIPTOR *p_desc = list_node(dn);
-
-                    if (p_desc->handle < start_handle) {
-                        continue;
-                    }
-
-                    if (p_desc->handle > end_handle) {
-                        *db = buffer;
-                        *count = db_size;
-                        return;
-                    }
-                    bta_gattc_fill_gatt_db_el(curr_db_attr,
-                                              BTGATT_DB_DESCRIPTOR,
-                                              p_desc->handle,
-                                              0 /* s_handle */,
-                                              0 /* e_handle */,
-                                              p_desc->handle,
-                                              p_desc->uuid,
-                                              0 /* property */);
-                    curr_db_attr++;
-                }
-            }
-        }
-
-        if (!p_cur_srvc->included_svc || list_is_empty(p_cur_srvc->included_svc))
-            continue;
-
-        for (list_node_t *isn = list_begin(p_cur_srvc->included_svc);
-             isn != list_end(p_cur_srvc->included_svc); isn = list_next(isn)) {
-            tBTA_GATTC_INCLUDED_SVC *p_isvc = list_node(isn);
-
-            if (p_isvc->handle < start_handle) {
-                continue;
-            }
-
-            if (p_isvc->handle > end_handle) {
-                *db = buffer;
-                *count = db_size;
-                return;
-            }
-            bta_gattc_fill_gatt_db_el(curr_db_attr,
-                                      BTGATT_DB_INCLUDED_SERVICE,
-                                      p_isvc->handle,
-                                      0 /* s_handle */,
-                                      0 /* e_handle */,
-                                      p_isvc->handle,
-                                      p_isvc->uuid,
-                                      0 /* property */);
-            curr_db_attr++;
-        }
+    for (size_t i = 0; i < db_size; i++) {
+        bta_gattc_fill_gatt_db_el_from_index(curr_db_attr++, &p_srvc_cb->p_attr_index[first + i]);
     }
 
     *db = buffer;
@@ -1899,8 +1823,7 @@ void bta_gattc_rebuild_cache(tBTA_GATTC_SERV *p_srvc_cb, UINT16 num_attr,
     /* first attribute loading, initialize buffer */
     APPL_TRACE_DEBUG("%s: bta_gattc_rebuild_cache, num_attr = %d", __func__, num_attr);
 
-    list_free(p_srvc_cb->p_srvc_cache);
-    p_srvc_cb->p_srvc_cache = NULL;
+    bta_gattc_free_srvc_cache(p_srvc_cb);
 
     while (num_attr > 0 && p_attr != NULL) {
         switch (p_attr->attr_type) {
@@ -1943,6 +1866,8 @@ void bta_gattc_rebuild_cache(tBTA_GATTC_SERV *p_srvc_cb, UINT16 num_attr,
         p_attr ++;
         num_attr --;
     }
+
+    bta_gattc_build_attr_index(p_srvc_cb);
 }
 
 /*******************************************************************************
@@ -1973,18 +1898,19 @@ void bta_gattc_fill_nv_attr(tBTA_GATTC_NV_ATTR *p_attr, UINT8 type, UINT16 s_han
 **
 ** Function         bta_gattc_cache_save
 **
-** Description      save the server cache into NV
+** Description      save the server cache into NV, with the Database Hash of
+**                  the server if known (db_hash is not NULL)
 **
 ** Returns          None.
 **
 *******************************************************************************/
-void bta_gattc_cache_save(tBTA_GATTC_SERV *p_srvc_cb, UINT16 conn_id)
+void bta_gattc_cache_save(tBTA_GATTC_SERV *p_srvc_cb, UINT16 conn_id, UINT8 *db_hash)
 {
     if (!p_srvc_cb->p_srvc_cache || list_is_empty(p_srvc_cb->p_srvc_cache))
         return;
 
     int i = 0;
-    size_t db_size = bta_gattc_get_db_size(p_srvc_cb->p_srvc_cache, 0x0000, 0xFFFF);
+    size_t db_size = bta_gattc_get_db_size(p_srvc_cb, 0x0000, 0xFFFF);
     tBTA_GATTC_NV_ATTR *nv_attr = osi_malloc(db_size * sizeof(tBTA_GATTC_NV_ATTR));
     // This step is very importent, if not clear the memory, the hasy key base on the attribute case will be not corret.
     if (nv_attr != NULL) {
@@ -2069,8 +1995,7 @@ void bta_gattc_cache_save(tBTA_GATTC_SERV *p_srvc_cb, UINT16 conn_id)
         }
     }
 
-    /* TODO: Gattc cache write/read need to be added in IDF 3.1*/
-    bta_gattc_cache_write(p_srvc_cb->server_bda, db_size, nv_attr);
+    bta_gattc_cache_write(p_srvc_cb->server_bda, db_size, db_hash, nv_attr);
     osi_free(nv_attr);
 }
 
@@ -2111,9 +2036,11 @@ bool bta_gattc_cache_load(tBTA_GATTC_CLCB *p_clcb)
     }
     if ((status = bta_gattc_co_cache_load(attr, index)) != BTA_GATT_OK) {
         APPL_TRACE_DEBUG("%s(), gattc cache load fail, status = %x", __func__, status);
+        osi_free(attr);
         return false;
     }
 
+    p_clcb->p_srcb->db_hash_valid = bta_gattc_co_cache_get_db_hash(index, p_clcb->p_srcb->db_hash);
     bta_gattc_rebuild_cache(p_clcb->p_srcb, num_attr, attr);
     //free the attr buffer after used.
     osi_free(attr);
@@ -2129,14 +2056,15 @@ bool bta_gattc_cache_load(tBTA_GATTC_CLCB *p_clcb)
 **
 ** Parameter        server_bda: server bd address of this cache belongs to
 **                  num_attr: number of attribute to be save.
+**                  db_hash: Database Hash of the server, NULL if unknown.
 **                  attr: pointer to the list of attributes to save.
 ** Returns
 **
 *******************************************************************************/
-static void bta_gattc_cache_write(BD_ADDR server_bda, UINT16 num_attr,
+static void bta_gattc_cache_write(BD_ADDR server_bda, UINT16 num_attr, UINT8 *db_hash,
                            tBTA_GATTC_NV_ATTR *attr)
 {
-    bta_gattc_co_cache_save(server_bda, num_attr, attr);
+    bta_gattc_co_cache_save(server_bda, num_attr, attr, db_hash);
 }
 
 /*******************************************************************************
@@ -2159,5 +2087,90 @@ void bta_gattc_cache_reset(BD_ADDR server_bda)
     bta_gattc_co_cache_reset(server_bda);
     //unlink(fname);
 }
+
+/*******************************************************************************
+**
+** Function         bta_gattc_read_db_hash
+**
+** Description      Read the Database Hash characteristic of the server, to
+**                  validate the cache or to save it with the cache. The result
+**                  is handled by bta_gattc_db_hash_cmpl.
+**
+** Parameter        p_clcb: connection the hash is read on.
+**
+** Returns          BTA_GATT_OK if the read was started.
+**
+*******************************************************************************/
+tBTA_GATT_STATUS bta_gattc_read_db_hash(tBTA_GATTC_CLCB *p_clcb)
+{
+    tGATT_READ_PARAM read_param;
+    tBTA_GATT_STATUS status;
+
+    memset(&read_param, 0, sizeof(tGATT_READ_PARAM));
+    read_param.service.auth_req = GATT_AUTH_REQ_NONE;
+    read_param.service.s_handle = 0x0001;
+    read_param.service.e_handle = 0xFFFF;
+    read_param.service.uuid.len = LEN_UUID_16;
+    read_param.service.uuid.uu.uuid16 = GATT_UUID_GATT_DB_HASH;
+
+    status = GATTC_Read(p_clcb->bta_conn_id, GATT_READ_BY_TYPE, &read_param);
+    if (status == BTA_GATT_OK) {
+        p_clcb->p_srcb->hash_conn_id = p_clcb->bta_conn_id;
+    }
+
+    APPL_TRACE_DEBUG("%s conn_id = %d, status = %d", __func__, p_clcb->bta_conn_id, status);
+    return status;
+}
+
+/*******************************************************************************
+**
+** Function         bta_gattc_db_hash_cmpl
+**
+** Description      Handle the completion of a Database Hash read started by
+**                  bta_gattc_read_db_hash. A cache loaded with a saved hash is
+**                  kept only if the same hash is read back, any failure to
+**                  read it drops the cache and starts discovery. A cache saved
+**                  without a hash keeps relying on Service Changed indications.
+**
+** Parameter        p_clcb: connection the operation completed on.
+**                  p_data: the operation complete event.
+**
+** Returns          TRUE if the event was the Database Hash read.
+**
+*******************************************************************************/
+BOOLEAN bta_gattc_db_hash_cmpl(tBTA_GATTC_CLCB *p_clcb, tBTA_GATTC_OP_CMPL *p_data)
+{
+    tBTA_GATTC_SERV *p_srcb = p_clcb->p_srcb;
+    UINT8 *p_hash = NULL;
+
+    if ((p_srcb->state != BTA_GATTC_SERV_HASH && p_srcb->state != BTA_GATTC_SERV_SAVE) ||
+            p_data->op_code != GATTC_OPTYPE_READ || p_srcb->hash_conn_id != p_clcb->bta_conn_id) {
+        return FALSE;
+    }
+
+    if (p_data->status == GATT_SUCCESS && p_data->p_cmpl != NULL &&
+            p_data->p_cmpl->att_value.len == BTA_GATTC_DB_HASH_LEN) {
+        p_hash = p_data->p_cmpl->att_value.value;
+    }
+    APPL_TRACE_DEBUG("%s srcb state = %d, status = %d, hash %s", __func__,
+                     p_srcb->state, p_data->status, p_hash ? "read" : "unavailable");
+
+    if (p_srcb->state == BTA_GATTC_SERV_SAVE) {
+        bta_gattc_cache_save(p_srcb, p_clcb->bta_conn_id, p_hash);
+        bta_gattc_reset_discover_st(p_srcb, BTA_GATT_OK);
+    } else if (p_hash != NULL && !memcmp(p_hash, p_srcb->db_hash, BTA_GATTC_DB_HASH_LEN)) {
+        /* the loaded cache is still valid */
+        p_srcb->state = BTA_GATTC_SERV_IDLE;
+        bta_gattc_reset_discover_st(p_srcb, BTA_GATT_OK);
+    } else {
+        /* the database of the server changed since it was cached, or the
+           hash can no longer be read, e.g. Attribute Not Found */
+        bta_gattc_free_srvc_cache(p_srcb);
+        bta_gattc_cache_reset(p_srcb->server_bda);
+        p_srcb->state = BTA_GATTC_SERV_DISC;
+        bta_gattc_start_discover(p_clcb, NULL);
+    }
+    return TRUE;
+}
 #endif /* BTA_GATT_INCLUDED */
 
@@ -15,204 +15,315 @@
  *  limitations under the License.
  *
  ******************************************************************************/
-#ifdef  BT_SUPPORT_NVM
-#include <unistd.h>
-#endif /* BT_SUPPORT_NVM */
 #include <string.h>
 #include <stdio.h>
 #include "bta/bta_gattc_co.h"
 #include "bta/bta_gattc_ci.h"
 
-// #include "btif_util.h"
 #include "btm_int.h"
 #include "osi/list.h"
-#include "yoc_err.h"
 #include "osi/allocator.h"
+#include "osi/bond_store.h"
+#if (BOND_STORE_KV_INCLUDED == TRUE)
+#include "aos/kv.h"
+#endif
 
 #if( defined BLE_INCLUDED ) && (BLE_INCLUDED == TRUE)
 #if( defined BTA_GATT_INCLUDED ) && (GATTC_INCLUDED == TRUE)
 
-#if 0
+/* The cache is kept in two parts: an index of the cached servers, keyed by
+** their identity address and kept in a bond store, and one blob per server
+** holding its attribute table in a compact encoding. With aos_kv the index
+** and the blobs are aos_kv values, otherwise files. The index is written
+** after the blob, and the hash it keeps of the blob content catches a blob
+** which does not match its index record. Saving a server makes it the
+** newest in the index, the least recently saved server is dropped first. */
 
-#define GATT_CACHE_PREFIX "gatt_"
 #define INVALID_ADDR_NUM 0xff
-#define MAX_DEVICE_IN_CACHE 50
-#define MAX_ADDR_LIST_CACHE_BUF 2048
 
-#ifdef BT_SUPPORT_NVM
-static FILE *sCacheFD = 0;
-static void getFilename(char *buffer, BD_ADDR bda)
+#if (BOND_STORE_KV_INCLUDED == TRUE)
+#define CACHE_BLOB_PREFIX       BTA_GATTC_CACHE_KV_PREFIX
+#else
+#define CACHE_BLOB_PREFIX       BTA_GATTC_CACHE_PATH_PREFIX
+#endif
+#define CACHE_BLOB_NAME_MAX     (sizeof(CACHE_BLOB_PREFIX) + 2 * BD_ADDR_LEN + 4)
+
+/* Every attribute is encoded as a flags byte, the attribute handle, the
+** fields used by its type (end handle of a service, properties of a
+** characteristic, handle range of an included service) and its UUID in
+** the shortest form it was discovered with. */
+#define CACHE_ATTR_TYPE_MASK    0x07
+#define CACHE_ATTR_PRIMARY      0x08
+#define CACHE_ATTR_UUID_16      0x00
+#define CACHE_ATTR_UUID_32      0x10
+#define CACHE_ATTR_UUID_128     0x20
+#define CACHE_ATTR_UUID_MASK    0x30
+
+/* largest encoded attribute, an included service with a 128-bit UUID */
+#define CACHE_ATTR_MAX_LEN      (1 + 2 + 4 + LEN_UUID_128)
+
+typedef struct {
+    UINT32      data_len;       /* length of the encoded attribute table */
+    UINT16      num_attr;
+    hash_key_t  hash_key;       /* hash of the encoded attribute table */
+    UINT8       db_hash[BTA_GATTC_DB_HASH_LEN];
+    UINT8       db_hash_valid;
+    UINT8       reserved;
+} cache_index_rec_t;
+
+typedef struct {
+    bond_store_backend_t    *backend;
+    bond_store_t            *index;
+    /* addresses sharing the cache of a server, by index slot */
+    list_t                  *assoc_addr[BTA_GATTC_CACHE_MAX_DEVICES];
+} cache_env_t;
+
+static cache_env_t cache_env;
+
+static void cache_identity_addr(BD_ADDR bda, BD_ADDR id_addr)
 {
-    sprintf(buffer, "%s%02x%02x%02x%02x%02x%02x", GATT_CACHE_PREFIX
-            , bda[0], bda[1], bda[2], bda[3], bda[4], bda[5]);
+    memcpy(id_addr, bda, BD_ADDR_LEN);
+#if (SMP_INCLUDED == TRUE)
+    tBTM_SEC_DEV_REC *p_dev_rec = btm_find_dev(bda);
+
+    /* a bonded peer using a private address is cached under its identity */
+    if (p_dev_rec != NULL && (p_dev_rec->ble.key_type & BTM_LE_KEY_PID)) {
+        memcpy(id_addr, p_dev_rec->ble.static_addr, BD_ADDR_LEN);
+    }
+#endif
 }
 
-static void cacheClose()
+static void cache_blob_name(char *buffer, const UINT8 *bda)
 {
-    if (sCacheFD != 0) {
-        fclose(sCacheFD);
-        sCacheFD = 0;
-    }
+    sprintf(buffer, "%s%02x%02x%02x%02x%02x%02x", CACHE_BLOB_PREFIX,
+            bda[0], bda[1], bda[2], bda[3], bda[4], bda[5]);
 }
 
-static bool cacheOpen(BD_ADDR bda, bool to_save)
+static UINT8 cache_find_index(BD_ADDR bda)
 {
-    char fname[255] = {0};
-    getFilename(fname, bda);
+    BD_ADDR id_addr;
+    int slot;
 
-    cacheClose();
-    sCacheFD = fopen(fname, to_save ? "w" : "r");
+    if (cache_env.index == NULL) {
+        return INVALID_ADDR_NUM;
+    }
 
-    return (sCacheFD != 0);
+    cache_identity_addr(bda, id_addr);
+    slot = bond_store_find(cache_env.index, id_addr);
+    return (slot >= 0) ? (UINT8)slot : INVALID_ADDR_NUM;
 }
 
-static void cacheReset(BD_ADDR bda)
+#if (BOND_STORE_KV_INCLUDED == TRUE)
+static BOOLEAN cache_blob_write(const UINT8 *bda, const UINT8 *p_data, UINT32 len)
 {
-    char fname[255] = {0};
-    getFilename(fname, bda);
-    unlink(fname);
+    char name[CACHE_BLOB_NAME_MAX];
+
+    cache_blob_name(name, bda);
+    if (aos_kv_set(name, (void *)p_data, len, 1) != 0) {
+        APPL_TRACE_ERROR("%s unable to write %s", __func__, name);
+        return FALSE;
+    }
+    return TRUE;
 }
 
+static BOOLEAN cache_blob_read(const UINT8 *bda, UINT8 *p_data, UINT32 len)
+{
+    char name[CACHE_BLOB_NAME_MAX];
+    int read_len = len;
+
+    cache_blob_name(name, bda);
+    return (aos_kv_get(name, p_data, &read_len) == 0 && read_len == (int)len);
+}
+
+static void cache_blob_remove(const UINT8 *bda)
+{
+    char name[CACHE_BLOB_NAME_MAX];
+
+    cache_blob_name(name, bda);
+    aos_kv_del(name);
+}
 #else
+static BOOLEAN cache_blob_write(const UINT8 *bda, const UINT8 *p_data, UINT32 len)
+{
+    char fname[CACHE_BLOB_NAME_MAX];
+    char tmp_fname[CACHE_BLOB_NAME_MAX + 4];
+    FILE *fp;
+    BOOLEAN ok;
 
-static const char *cache_key = "gattc_cache_key";
-static const char *cache_addr = "cache_addr_tab";
-nvs_handle nvs_fp;
+    cache_blob_name(fname, bda);
+    sprintf(tmp_fname, "%s.tmp", fname);
 
-typedef struct {
-    //save the service data in the list according to the address
-    nvs_handle cache_fp;
-    BOOLEAN is_open;
-    BD_ADDR addr;
-    hash_key_t hash_key;
-    list_t *assoc_addr;
-}cache_addr_info_t;
+    if ((fp = fopen(tmp_fname, "wb")) == NULL) {
+        APPL_TRACE_ERROR("%s unable to open %s", __func__, tmp_fname);
+        return FALSE;
+    }
+    ok = (fwrite(p_data, 1, len, fp) == len);
+    ok = (fclose(fp) == 0) && ok;
 
-typedef struct {
-    //save the address list in the cache
-    nvs_handle addr_fp;
-    BOOLEAN is_open;
-    UINT8 num_addr;
-    cache_addr_info_t cache_addr[MAX_DEVICE_IN_CACHE];
-}cache_env_t;
+    if (!ok || rename(tmp_fname, fname) != 0) {
+        APPL_TRACE_ERROR("%s unable to write %s", __func__, fname);
+        remove(tmp_fname);
+        return FALSE;
+    }
+    return TRUE;
+}
 
-cache_env_t cache_env;
+static BOOLEAN cache_blob_read(const UINT8 *bda, UINT8 *p_data, UINT32 len)
+{
+    char fname[CACHE_BLOB_NAME_MAX];
+    BOOLEAN ok = FALSE;
+    FILE *fp;
+
+    cache_blob_name(fname, bda);
+    if ((fp = fopen(fname, "rb")) != NULL) {
+        ok = (fread(p_data, 1, len, fp) == len);
+        fclose(fp);
+    }
+    return ok;
+}
 
-static void getFilename(char *buffer, hash_key_t hash)
+static void cache_blob_remove(const UINT8 *bda)
 {
-    sprintf(buffer, "%s%02x%02x%02x%02x", GATT_CACHE_PREFIX,
-            hash[0], hash[1], hash[2], hash[3]);
+    char fname[CACHE_BLOB_NAME_MAX];
+
+    cache_blob_name(fname, bda);
+    remove(fname);
 }
+#endif /* BOND_STORE_KV_INCLUDED == TRUE */
 
-static void cacheClose(BD_ADDR bda)
+static void cache_remove_index(int slot)
 {
-    UINT8 index = 0;
-    if ((index = bta_gattc_co_find_addr_in_cache(bda)) != INVALID_ADDR_NUM) {
-        if (cache_env.cache_addr[index].is_open) {
-            nvs_close(cache_env.cache_addr[index].cache_fp);
-            cache_env.cache_addr[index].is_open = FALSE;
-        }
+    cache_blob_remove(bond_store_id(cache_env.index, slot));
+
+    if (cache_env.assoc_addr[slot] != NULL) {
+        list_free(cache_env.assoc_addr[slot]);
+        cache_env.assoc_addr[slot] = NULL;
     }
+    bond_store_remove(cache_env.index, slot);
 }
 
-static bool cacheOpen(BD_ADDR bda, bool to_save, UINT8 *index)
+static void cache_encode_attr(UINT8 **pp, const tBTA_GATTC_NV_ATTR *p_attr)
 {
-    UNUSED(to_save);
-    char fname[255] = {0};
-    UINT8 *assoc_addr = NULL;
-    yoc_err_t status = YOC_FAIL;
-    hash_key_t hash_key = {0};
-    if (((*index = bta_gattc_co_find_addr_in_cache(bda)) != INVALID_ADDR_NUM) ||
-        ((assoc_addr = bta_gattc_co_cache_find_src_addr(bda, index)) != NULL)) {
-        if (cache_env.cache_addr[*index].is_open) {
-            return TRUE;
-        } else {
-            memcpy(hash_key, cache_env.cache_addr[*index].hash_key, sizeof(hash_key_t));
-            getFilename(fname, hash_key);
-            if ((status = nvs_open(fname, NVS_READWRITE, &cache_env.cache_addr[*index].cache_fp)) == YOC_OK) {
-                // Set the open flag to TRUE when success to open the hash file.
-                cache_env.cache_addr[*index].is_open = TRUE;
-            }
-        }
+    UINT8 *p = *pp;
+    UINT8 flags = p_attr->attr_type & CACHE_ATTR_TYPE_MASK;
+
+    if (p_attr->is_primary) {
+        flags |= CACHE_ATTR_PRIMARY;
+    }
+    if (p_attr->uuid.len == LEN_UUID_32) {
+        flags |= CACHE_ATTR_UUID_32;
+    } else if (p_attr->uuid.len == LEN_UUID_128) {
+        flags |= CACHE_ATTR_UUID_128;
+    }
+
+    UINT8_TO_STREAM(p, flags);
+    UINT16_TO_STREAM(p, p_attr->s_handle);
+
+    switch (p_attr->attr_type) {
+    case BTA_GATTC_ATTR_TYPE_SRVC:
+        UINT16_TO_STREAM(p, p_attr->e_handle);
+        break;
+    case BTA_GATTC_ATTR_TYPE_CHAR:
+        UINT8_TO_STREAM(p, p_attr->prop);
+        break;
+    case BTA_GATTC_ATTR_TYPE_INCL_SRVC:
+        UINT16_TO_STREAM(p, p_attr->incl_srvc_s_handle);
+        UINT16_TO_STREAM(p, p_attr->incl_srvc_e_handle);
+        break;
+    default:
+        break;
+    }
+
+    if (p_attr->uuid.len == LEN_UUID_32) {
+        UINT32_TO_STREAM(p, p_attr->uuid.uu.uuid32);
+    } else if (p_attr->uuid.len == LEN_UUID_128) {
+        ARRAY_TO_STREAM(p, p_attr->uuid.uu.uuid128, LEN_UUID_128);
+    } else {
+        UINT16_TO_STREAM(p, p_attr->uuid.uu.uuid16);
     }
-    
-    return ((status == YOC_OK) ? true : false);
+
+    *pp = p;
 }
 
-static void cacheReset(BD_ADDR bda)
+static BOOLEAN cache_decode_attrs(const UINT8 *p, UINT32 len, tBTA_GATTC_NV_ATTR *p_attr,
+                                  UINT16 num_attr)
 {
-    char fname[255] = {0};
-    getFilename(fname, bda);
-    UINT8 index = 0;
-    //cache_env.cache_addr
-    if ((index = bta_gattc_co_find_addr_in_cache(bda)) != INVALID_ADDR_NUM) {
-        //clear the association address pending in the source address.
-        bta_gattc_co_cache_clear_assoc_addr(bda);
-        if (cache_env.cache_addr[index].is_open) {
-            nvs_erase_all(cache_env.cache_addr[index].cache_fp);
-            nvs_close(cache_env.cache_addr[index].cache_fp);
-            cache_env.cache_addr[index].is_open = FALSE;
-        } else {
-            cacheOpen(bda, false, &index);
-            if (cache_env.cache_addr[index].is_open) {
-                nvs_erase_all(cache_env.cache_addr[index].cache_fp);
-                nvs_close(cache_env.cache_addr[index].cache_fp);
-                cache_env.cache_addr[index].is_open = FALSE;
-            } else {
-                APPL_TRACE_ERROR("%s cacheOpen failed", __func__);
-                return;
-            }
+    const UINT8 *p_end = p + len;
+    UINT8 flags;
+    UINT16 field_len;
+
+    for (; num_attr > 0; num_attr--, p_attr++) {
+        if (p_end - p < 3) {
+            return FALSE;
         }
-        if(cache_env.num_addr == 0) {
-            APPL_TRACE_ERROR("%s cache addr list error", __func__);
-            return;
+        memset(p_attr, 0, sizeof(tBTA_GATTC_NV_ATTR));
+        STREAM_TO_UINT8(flags, p);
+        STREAM_TO_UINT16(p_attr->s_handle, p);
+        p_attr->attr_type = flags & CACHE_ATTR_TYPE_MASK;
+        p_attr->is_primary = (flags & CACHE_ATTR_PRIMARY) ? TRUE : FALSE;
+
+        switch (p_attr->attr_type) {
+        case BTA_GATTC_ATTR_TYPE_SRVC:
+            field_len = 2;
+            break;
+        case BTA_GATTC_ATTR_TYPE_CHAR:
+            field_len = 1;
+            break;
+        case BTA_GATTC_ATTR_TYPE_INCL_SRVC:
+            field_len = 4;
+            break;
+        case BTA_GATTC_ATTR_TYPE_CHAR_DESCR:
+            field_len = 0;
+            break;
+        default:
+            return FALSE;
         }
 
-        UINT8 num = cache_env.num_addr;
-        //delete the server_bda in the addr_info list.
-        for(UINT8 i = index; i < (num - 1); i++) {
-            memcpy(&cache_env.cache_addr[i], &cache_env.cache_addr[i+1], sizeof(cache_addr_info_t));
+        switch (flags & CACHE_ATTR_UUID_MASK) {
+        case CACHE_ATTR_UUID_16:
+            p_attr->uuid.len = LEN_UUID_16;
+            break;
+        case CACHE_ATTR_UUID_32:
+            p_attr->uuid.len = LEN_UUID_32;
+            break;
+        case CACHE_ATTR_UUID_128:
+            p_attr->uuid.len = LEN_UUID_128;
+            break;
+        default:
+            return FALSE;
         }
-        //reduced the number address counter also
-        cache_env.num_addr--;
-
-        //update addr list to nvs flash
-        if(cache_env.num_addr > 0) {
-            //update
-            UINT8 *p_buf = osi_malloc(MAX_ADDR_LIST_CACHE_BUF);
-            if(!p_buf) {
-                APPL_TRACE_ERROR("%s malloc error", __func__); 
-                return;  
-            }
-            UINT16 length = cache_env.num_addr*(sizeof(BD_ADDR) + sizeof(hash_key_t));
-            for (UINT8 i = 0; i < cache_env.num_addr; i++) {
-                //copy the address to the buffer.
-                memcpy(p_buf + i*(sizeof(BD_ADDR) + sizeof(hash_key_t)), cache_env.cache_addr[i].addr, sizeof(BD_ADDR));
-                //copy the hash key to the buffer.
-                memcpy(p_buf + i*(sizeof(BD_ADDR) + sizeof(hash_key_t)) + sizeof(BD_ADDR),
-                        cache_env.cache_addr[i].hash_key, sizeof(hash_key_t));
-            }
-            if (cache_env.is_open) {
-                if (nvs_set_blob(cache_env.addr_fp, cache_key, p_buf, length) != YOC_OK) {
-                    APPL_TRACE_WARNING("%s, nvs set blob failed", __func__);
-                }
-            }
-            osi_free(p_buf);
-        
+
+        if (p_end - p < field_len + p_attr->uuid.len) {
+            return FALSE;
+        }
+
+        switch (p_attr->attr_type) {
+        case BTA_GATTC_ATTR_TYPE_SRVC:
+            STREAM_TO_UINT16(p_attr->e_handle, p);
+            break;
+        case BTA_GATTC_ATTR_TYPE_CHAR:
+            STREAM_TO_UINT8(p_attr->prop, p);
+            break;
+        case BTA_GATTC_ATTR_TYPE_INCL_SRVC:
+            STREAM_TO_UINT16(p_attr->incl_srvc_s_handle, p);
+            STREAM_TO_UINT16(p_attr->incl_srvc_e_handle, p);
+            break;
+        default:
+            break;
+        }
+
+        if (p_attr->uuid.len == LEN_UUID_32) {
+            STREAM_TO_UINT32(p_attr->uuid.uu.uuid32, p);
+        } else if (p_attr->uuid.len == LEN_UUID_128) {
+            STREAM_TO_ARRAY(p_attr->uuid.uu.uuid128, p, LEN_UUID_128);
         } else {
-            //erase
-            if (cache_env.is_open) {
-                nvs_erase_all(cache_env.addr_fp);
-                nvs_close(cache_env.addr_fp);
-                cache_env.is_open = FALSE;
-            } else {
-                APPL_TRACE_WARNING("cache_env status is error");
-            }
+            STREAM_TO_UINT16(p_attr->uuid.uu.uuid16, p);
         }
     }
+
+    return (p == p_end);
 }
 
-#endif /* BT_SUPPORT_NVM */
 /*****************************************************************************
 **  Function Declarations
 *****************************************************************************/
@@ -225,18 +336,20 @@ static void cacheReset(BD_ADDR bda)
 **                  cache is ready to be sent.
 **
 ** Parameter        server_bda: server bd address of this cache belongs to
-**                  evt: call in event to be passed in when cache open is done.
-**                  conn_id: connection ID of this cache operation attach to.
 **                  to_save: open cache to save or to load.
+**                  index: filled with the index of the cache.
 **
-** Returns          void.
+** Returns          BTA_GATT_OK if there is a cache for the server.
 **
 *******************************************************************************/
 tBTA_GATT_STATUS bta_gattc_co_cache_open(BD_ADDR server_bda, BOOLEAN to_save, UINT8 *index)
 {
-    /* open NV cache and send call in */
     tBTA_GATT_STATUS status = BTA_GATT_OK;
-    if (!cacheOpen(server_bda, to_save, index)) {
+    UNUSED(to_save);
+
+    /* a server without its own cache may share the one of another server */
+    if ((*index = cache_find_index(server_bda)) == INVALID_ADDR_NUM &&
+            bta_gattc_co_cache_find_src_addr(server_bda, index) == NULL) {
         status = BTA_GATT_ERROR;
     }
 
@@ -251,41 +364,83 @@ tBTA_GATT_STATUS bta_gattc_co_cache_open(BD_ADDR server_bda, BOOLEAN to_save, UI
 ** Description      This callout function is executed by GATT when server cache
 **                  is required to load.
 **
-** Parameter        server_bda: server bd address of this cache belongs to
-**                  evt: call in event to be passed in when cache save is done.
-**                  num_attr: number of attribute to be save.
-**                  attr_index: starting attribute index of the save operation.
-**                  conn_id: connection ID of this cache operation attach to.
-** Returns
+** Parameter        attr: filled with the attributes of the cache, room for
+**                        bta_gattc_get_cache_attr_length bytes.
+**                  index: index of the cache, from bta_gattc_co_cache_open.
+**
+** Returns          BTA_GATT_OK if the cache was read and is intact.
 **
 *******************************************************************************/
 tBTA_GATT_STATUS bta_gattc_co_cache_load(tBTA_GATTC_NV_ATTR *attr, UINT8 index)
 {
-    UINT16              num_attr = 0;
     tBTA_GATT_STATUS    status = BTA_GATT_ERROR;
-    size_t length = 0;
-    // Read the size of memory space required for blob
-    nvs_get_blob(cache_env.cache_addr[index].cache_fp, cache_key, NULL, &length);
-    // Read previously saved blob if available
-    yoc_err_t err_code = nvs_get_blob(cache_env.cache_addr[index].cache_fp, cache_key, attr, &length);
-    num_attr = length / sizeof(tBTA_GATTC_NV_ATTR);
-    status = (err_code == YOC_OK && length != 0) ? BTA_GATT_OK : BTA_GATT_ERROR;
-    APPL_TRACE_DEBUG("%s() - read=%d, status=%d, err_code = %d",
-                     __func__, num_attr, status, err_code);
+    const cache_index_rec_t *rec;
+    hash_key_t hash_key;
+    UINT8 *p_buf;
+
+    if (cache_env.index == NULL || index == INVALID_ADDR_NUM) {
+        return BTA_GATT_ERROR;
+    }
+
+    rec = bond_store_data(cache_env.index, index);
+    if ((p_buf = osi_malloc(rec->data_len)) == NULL) {
+        APPL_TRACE_ERROR("%s, No Memory.", __func__);
+        return BTA_GATT_NO_RESOURCES;
+    }
 
+    if (cache_blob_read(bond_store_id(cache_env.index, index), p_buf, rec->data_len)) {
+        memset(hash_key, 0, sizeof(hash_key_t));
+        hash_function_blob(p_buf, rec->data_len, hash_key);
+        if (!memcmp(hash_key, rec->hash_key, sizeof(hash_key_t)) &&
+                cache_decode_attrs(p_buf, rec->data_len, attr, rec->num_attr)) {
+            status = BTA_GATT_OK;
+        }
+    }
+    osi_free(p_buf);
+
+    APPL_TRACE_DEBUG("%s() - read=%d, status=%d", __func__, rec->num_attr, status);
     return status;
- }
+}
 
 size_t bta_gattc_get_cache_attr_length(UINT8 index)
 {
-    size_t length = 0;
-    if (index == INVALID_ADDR_NUM) {
+    const cache_index_rec_t *rec;
+
+    if (cache_env.index == NULL || index == INVALID_ADDR_NUM) {
         return 0;
     }
 
-    // Read the size of memory space required for blob
-    nvs_get_blob(cache_env.cache_addr[index].cache_fp, cache_key, NULL, &length);
-    return length;
+    rec = bond_store_data(cache_env.index, index);
+    return rec->num_attr * sizeof(tBTA_GATTC_NV_ATTR);
+}
+
+/*******************************************************************************
+**
+** Function         bta_gattc_co_cache_get_db_hash
+**
+** Description      This callout function is executed by GATTC to get the
+**                  Database Hash of the server a cache was built from.
+**
+** Parameter        index: index of the cache, from bta_gattc_co_cache_open.
+**                  db_hash: filled with the BTA_GATTC_DB_HASH_LEN bytes hash.
+**
+** Returns          TRUE if the hash was saved with the cache.
+**
+*******************************************************************************/
+BOOLEAN bta_gattc_co_cache_get_db_hash(UINT8 index, UINT8 *db_hash)
+{
+    const cache_index_rec_t *rec;
+
+    if (cache_env.index == NULL || index == INVALID_ADDR_NUM) {
+        return FALSE;
+    }
+
+    rec = bond_store_data(cache_env.index, index);
+    if (!rec->db_hash_valid) {
+        return FALSE;
+    }
+    memcpy(db_hash, rec->db_hash, BTA_GATTC_DB_HASH_LEN);
+    return TRUE;
 }
 
 /*******************************************************************************
@@ -296,34 +451,73 @@ size_t bta_gattc_get_cache_attr_length(UINT8 index)
 **                  is available to save.
 **
 ** Parameter        server_bda: server bd address of this cache belongs to
-**                  evt: call in event to be passed in when cache save is done.
 **                  num_attr: number of attribute to be save.
-**                  p_attr: pointer to the list of attributes to save.
-**                  attr_index: starting attribute index of the save operation.
-**                  conn_id: connection ID of this cache operation attach to.
+**                  p_attr_list: pointer to the list of attributes to save.
+**                  db_hash: Database Hash of the server, NULL if unknown.
 ** Returns
 **
 *******************************************************************************/
 void bta_gattc_co_cache_save (BD_ADDR server_bda, UINT16 num_attr,
-                              tBTA_GATTC_NV_ATTR *p_attr_list)
-{
-    tBTA_GATT_STATUS    status = BTA_GATT_OK;
-    hash_key_t hash_key = {0};
-    UINT8 index = INVALID_ADDR_NUM;
-    //calculate  the hash value of the attribute table which should be added to the nvs flash.
-    hash_function_blob((unsigned char *)p_attr_list, sizeof(tBTA_GATTC_NV_ATTR)*num_attr, hash_key);
-    //save the address list to the nvs flash
-    bta_gattc_co_cache_addr_save(server_bda, hash_key);
-
-    if (cacheOpen(server_bda, TRUE, &index)) {
-        yoc_err_t err_code = nvs_set_blob(cache_env.cache_addr[index].cache_fp, cache_key,
-                                          p_attr_list, sizeof(tBTA_GATTC_NV_ATTR)*num_attr);
-        status = (err_code == YOC_OK) ? BTA_GATT_OK : BTA_GATT_ERROR;
-    } else {
-        status = BTA_GATT_ERROR;
+                              tBTA_GATTC_NV_ATTR *p_attr_list, UINT8 *db_hash)
+{
+    tBTA_GATT_STATUS    status = BTA_GATT_ERROR;
+    cache_index_rec_t   *rec;
+    BD_ADDR id_addr;
+    UINT8 *p_buf, *p;
+    int slot, oldest;
+
+    if (cache_env.index == NULL) {
+        APPL_TRACE_WARNING("%s(), cache is not initialized.", __func__);
+        return;
+    }
+    if ((p_buf = osi_malloc(num_attr * CACHE_ATTR_MAX_LEN)) == NULL) {
+        APPL_TRACE_ERROR("%s, No Memory.", __func__);
+        return;
+    }
+
+    p = p_buf;
+    for (UINT16 i = 0; i < num_attr; i++) {
+        cache_encode_attr(&p, &p_attr_list[i]);
+    }
+
+    cache_identity_addr(server_bda, id_addr);
+    if ((slot = bond_store_find(cache_env.index, id_addr)) < 0 &&
+            (slot = bond_store_add(cache_env.index, id_addr)) < 0) {
+        /* the cache is full, make room by dropping the least recently saved server */
+        for (slot = oldest = bond_store_first(cache_env.index); slot >= 0;
+                slot = bond_store_next(cache_env.index, slot)) {
+            oldest = slot;
+        }
+        if (oldest >= 0) {
+            cache_remove_index(oldest);
+            slot = bond_store_add(cache_env.index, id_addr);
+        }
+    }
+
+    if (slot >= 0) {
+        if (cache_blob_write(id_addr, p_buf, p - p_buf)) {
+            rec = bond_store_data(cache_env.index, slot);
+            memset(rec, 0, sizeof(cache_index_rec_t));
+            rec->data_len = p - p_buf;
+            rec->num_attr = num_attr;
+            hash_function_blob(p_buf, rec->data_len, rec->hash_key);
+            if (db_hash != NULL) {
+                memcpy(rec->db_hash, db_hash, BTA_GATTC_DB_HASH_LEN);
+                rec->db_hash_valid = TRUE;
+            }
+            /* the server just discovered is the last one to be dropped */
+            bond_store_touch(cache_env.index, slot);
+            if (bond_store_flush(cache_env.index)) {
+                status = BTA_GATT_OK;
+            }
+        } else {
+            cache_remove_index(slot);
+        }
     }
+    osi_free(p_buf);
 
-    APPL_TRACE_DEBUG("%s() wrote hash_key = %x%x%x%x, num_attr = %d, status = %d.", __func__, hash_key[0], hash_key[1], hash_key[2], hash_key[3], num_attr, status);
+    APPL_TRACE_DEBUG("%s() num_attr = %d, db_hash = %d, status = %d.", __func__,
+                     num_attr, db_hash != NULL, status);
 }
 
 /*******************************************************************************
@@ -341,14 +535,12 @@ void bta_gattc_co_cache_save (BD_ADDR server_bda, UINT16 num_attr,
 *******************************************************************************/
 void bta_gattc_co_cache_close(BD_ADDR server_bda, UINT16 conn_id)
 {
+    UNUSED(server_bda);
     UNUSED(conn_id);
-//#ifdef BT_SUPPORT_NVM
-    cacheClose(server_bda);
-//#endif /* BT_SUPPORT_NVM */
-    /* close NV when server cache is done saving or loading,
-       does not need to do anything for now on Insight */
+    /* the cache blobs are only open while they are read or written,
+       nothing to do */
 
-    BTIF_TRACE_DEBUG("%s()", __FUNCTION__);
+    APPL_TRACE_DEBUG("%s()", __FUNCTION__);
 }
 
 /*******************************************************************************
@@ -365,109 +557,90 @@ void bta_gattc_co_cache_close(BD_ADDR server_bda, UINT16 conn_id)
 *******************************************************************************/
 void bta_gattc_co_cache_reset(BD_ADDR server_bda)
 {
-    cacheReset(server_bda);
+    UINT8 index;
+
+    if ((index = cache_find_index(server_bda)) != INVALID_ADDR_NUM) {
+        cache_remove_index(index);
+    }
+}
+
+static void cache_backend_free(void)
+{
+#if (BOND_STORE_KV_INCLUDED == TRUE)
+    bond_store_kv_backend_free(cache_env.backend);
+#else
+    bond_store_file_backend_free(cache_env.backend);
+#endif
+    cache_env.backend = NULL;
 }
 
 void bta_gattc_co_cache_addr_init(void)
 {
-    nvs_handle fp;
-    yoc_err_t err_code;
-    UINT8 num_addr;
-    UINT8 *p_buf = osi_malloc(MAX_ADDR_LIST_CACHE_BUF);
-    size_t length = MAX_ADDR_LIST_CACHE_BUF;
-
-    if ((err_code = nvs_open(cache_addr, NVS_READWRITE, &fp)) == YOC_OK) {
-        cache_env.addr_fp = fp;
-        cache_env.is_open = TRUE;
-        // Read previously saved blob if available
-        if ((err_code = nvs_get_blob(fp, cache_key, p_buf, &length)) != YOC_OK) {
-            if(err_code != YOC_ERR_NVS_NOT_FOUND) {
-                APPL_TRACE_ERROR("%s, Line = %d, nvs flash get blob data fail, err_code = 0x%x", __func__, __LINE__, err_code);
-            }
-            osi_free(p_buf);
-            return;
-        }
-        num_addr = length / (sizeof(BD_ADDR) + sizeof(hash_key_t));
-        cache_env.num_addr = num_addr;
-        //read the address from nvs flash to cache address list.
-        for (UINT8 i = 0; i < num_addr; i++) {
-            memcpy(cache_env.cache_addr[i].addr, p_buf + i*(sizeof(BD_ADDR) + sizeof(hash_key_t)), sizeof(BD_ADDR));
-            memcpy(cache_env.cache_addr[i].hash_key,
-                    p_buf + i*(sizeof(BD_ADDR) + sizeof(hash_key_t)) + sizeof(BD_ADDR), sizeof(hash_key_t));
-
-            APPL_TRACE_DEBUG("cache_addr[%x] = %x:%x:%x:%x:%x:%x", i, cache_env.cache_addr[i].addr[0], cache_env.cache_addr[i].addr[1], cache_env.cache_addr[i].addr[2],
-                             cache_env.cache_addr[i].addr[3], cache_env.cache_addr[i].addr[4], cache_env.cache_addr[i].addr[5]);
-            APPL_TRACE_DEBUG("hash_key[%x] = %x%x%x%x", i, cache_env.cache_addr[i].hash_key[0], cache_env.cache_addr[i].hash_key[1],
-                             cache_env.cache_addr[i].hash_key[2], cache_env.cache_addr[i].hash_key[3]);
-            bta_gattc_co_cache_new_assoc_list(cache_env.cache_addr[i].addr, i);
-        }
-    } else {
-        APPL_TRACE_ERROR("%s, Line = %d, nvs flash open fail, err_code = %x", __func__, __LINE__, err_code);
-        osi_free(p_buf);
+    if (cache_env.index != NULL) {
         return;
     }
 
-    osi_free(p_buf);
-    return;
+#if (BOND_STORE_KV_INCLUDED == TRUE)
+    cache_env.backend = bond_store_kv_backend_new(BTA_GATTC_CACHE_INDEX_KEY);
+#else
+    cache_env.backend = bond_store_file_backend_new(BTA_GATTC_CACHE_INDEX_PATH);
+#endif
+    if (cache_env.backend == NULL) {
+        APPL_TRACE_ERROR("%s, unable to allocate the cache backend", __func__);
+        return;
+    }
+    cache_env.index = bond_store_new(cache_env.backend, sizeof(cache_index_rec_t),
+                                     BTA_GATTC_CACHE_MAX_DEVICES);
+    if (cache_env.index == NULL) {
+        APPL_TRACE_ERROR("%s, unable to load the cache index", __func__);
+        cache_backend_free();
+        return;
+    }
+
+    APPL_TRACE_DEBUG("%s, %d servers in cache", __func__, bta_gattc_co_get_addr_num());
 }
 
 void bta_gattc_co_cache_addr_deinit(void)
 {
-    if(!cache_env.is_open) {
+    if (cache_env.index == NULL) {
         return;
-    }  
-    nvs_close(cache_env.addr_fp);
-    cache_env.is_open = false;
-    
-    for(UINT8 i = 0; i< cache_env.num_addr; i++) {
-        cache_addr_info_t *addr_info = &cache_env.cache_addr[i];
-        if(addr_info) {
-            nvs_close(addr_info->cache_fp);
-            addr_info->is_open = false;
-            if(addr_info->assoc_addr) {
-                list_free(addr_info->assoc_addr);
-            }
+    }
+
+    for (UINT8 i = 0; i < BTA_GATTC_CACHE_MAX_DEVICES; i++) {
+        if (cache_env.assoc_addr[i] != NULL) {
+            list_free(cache_env.assoc_addr[i]);
+            cache_env.assoc_addr[i] = NULL;
         }
     }
+    bond_store_flush(cache_env.index);
+    bond_store_free(cache_env.index);
+    cache_env.index = NULL;
+    cache_backend_free();
 }
 
 BOOLEAN bta_gattc_co_addr_in_cache(BD_ADDR bda)
 {
-    UINT8 addr_index = 0;
-    UINT8 num = cache_env.num_addr;
-    cache_addr_info_t *addr_info = &cache_env.cache_addr[0];
-    for (addr_index = 0; addr_index < num; addr_index++) {
-        if (!memcmp(addr_info->addr, bda, sizeof(BD_ADDR))) {
-            return TRUE;
-        }
-    }
-
-    return FALSE;
+    return (cache_find_index(bda) != INVALID_ADDR_NUM);
 }
 
 UINT8 bta_gattc_co_find_addr_in_cache(BD_ADDR bda)
 {
-    UINT8 addr_index = 0;
-    UINT8 num = cache_env.num_addr;
-    cache_addr_info_t *addr_info = &cache_env.cache_addr[0];
-
-    for (addr_index = 0; addr_index < num; addr_index++, addr_info++) {
-        if (!memcmp(addr_info->addr, bda, sizeof(BD_ADDR))) {
-            return addr_index;
-        }
-    }
-
-    return INVALID_ADDR_NUM;
+    return cache_find_index(bda);
 }
 
 UINT8 bta_gattc_co_find_hash_in_cache(hash_key_t hash_key)
 {
-    UINT8 index = 0;
-    UINT8 num = cache_env.num_addr;
-    cache_addr_info_t *addr_info = &cache_env.cache_addr[0];
-    for (index = 0; index < num; index++) {
-        if (!memcmp(addr_info->hash_key, hash_key, sizeof(hash_key_t))) {
-            return index;
+    const cache_index_rec_t *rec;
+
+    if (cache_env.index == NULL) {
+        return INVALID_ADDR_NUM;
+    }
+
+    for (int slot = bond_store_first(cache_env.index); slot >= 0;
+            slot = bond_store_next(cache_env.index, slot)) {
+        rec = bond_store_data(cache_env.index, slot);
+        if (!memcmp(rec->hash_key, hash_key, sizeof(hash_key_t))) {
+            return (UINT8)slot;
         }
     }
 
@@ -476,115 +649,75 @@ UINT8 bta_gattc_co_find_hash_in_cache(hash_key_t hash_key)
 
 UINT8 bta_gattc_co_get_addr_num(void)
 {
-    return cache_env.num_addr;
-}
+    UINT8 num = 0;
 
-void bta_gattc_co_get_addr_list(BD_ADDR *addr_list)
-{
-    UINT8 num = cache_env.num_addr;
-    for (UINT8 i = 0; i < num; i++) {
-        memcpy(addr_list[i], cache_env.cache_addr[i].addr, sizeof(BD_ADDR));
+    if (cache_env.index == NULL) {
+        return 0;
     }
-}
 
-void bta_gattc_co_cache_addr_save(BD_ADDR bd_addr, hash_key_t hash_key)
-{
-    yoc_err_t err_code;
-    UINT8 num = ++cache_env.num_addr;
-    UINT8 index = 0;
-    UINT8 *p_buf = osi_malloc(MAX_ADDR_LIST_CACHE_BUF);
-    // check the address list has the same hash key or not
-    if (bta_gattc_co_find_hash_in_cache(hash_key) != INVALID_ADDR_NUM) {
-        APPL_TRACE_DEBUG("%s(), the hash key already in the cache list.", __func__);
-        if ((index = bta_gattc_co_find_addr_in_cache(bd_addr)) != INVALID_ADDR_NUM) {
-            APPL_TRACE_DEBUG("%s(), the hash bd_addr already in the cache list, index = %x", __func__, index);
-            //if the bd_addr already in the address list, update the hash key in it.
-            memcpy(cache_env.cache_addr[index].addr, bd_addr, sizeof(BD_ADDR));
-            memcpy(cache_env.cache_addr[index].hash_key, hash_key, sizeof(hash_key_t));
-        } else {
-            //if the bd_addr didn't in the address list, added the bd_addr to the last of the address list.
-            memcpy(cache_env.cache_addr[num - 1].hash_key, hash_key, sizeof(hash_key_t));
-            memcpy(cache_env.cache_addr[num - 1].addr, bd_addr, sizeof(BD_ADDR));
-        }
-
-    } else {
-        APPL_TRACE_DEBUG("%s(), num = %d", __func__, num);
-        memcpy(cache_env.cache_addr[num - 1].addr, bd_addr, sizeof(BD_ADDR));
-        memcpy(cache_env.cache_addr[num - 1].hash_key, hash_key, sizeof(hash_key_t));
+    for (int slot = bond_store_first(cache_env.index); slot >= 0;
+            slot = bond_store_next(cache_env.index, slot)) {
+        num++;
     }
+    return num;
+}
 
-    nvs_handle *fp = &cache_env.addr_fp;
-    UINT16 length = num*(sizeof(BD_ADDR) + sizeof(hash_key_t));
-
-    for (UINT8 i = 0; i < num; i++) {
-        //copy the address to the buffer.
-        memcpy(p_buf + i*(sizeof(BD_ADDR) + sizeof(hash_key_t)), cache_env.cache_addr[i].addr, sizeof(BD_ADDR));
-        //copy the hash key to the buffer.
-        memcpy(p_buf + i*(sizeof(BD_ADDR) + sizeof(hash_key_t)) + sizeof(BD_ADDR),
-                cache_env.cache_addr[i].hash_key, sizeof(hash_key_t));
+void bta_gattc_co_get_addr_list(BD_ADDR *addr_list)
+{
+    if (cache_env.index == NULL) {
+        return;
     }
 
-    if (cache_env.is_open) {
-        if ((err_code = nvs_set_blob(cache_env.addr_fp, cache_key, p_buf, length)) != YOC_OK) {
-            APPL_TRACE_WARNING("%s(), nvs set blob fail, err %d", __func__, err_code);
-        }
-    } else {
-        if ((err_code = nvs_open(cache_addr, NVS_READWRITE , fp)) == YOC_OK) {
-            cache_env.is_open = true;
-            if (( err_code = nvs_set_blob(cache_env.addr_fp, cache_key, p_buf, length)) != YOC_OK) {
-                APPL_TRACE_WARNING("%s(), nvs set blob fail, err %d", __func__, err_code);
-            }
-        } else {
-            APPL_TRACE_ERROR("%s, Line = %d, nvs flash open fail, err_code = %x", __func__, __LINE__, err_code);
-        }
+    for (int slot = bond_store_first(cache_env.index); slot >= 0;
+            slot = bond_store_next(cache_env.index, slot)) {
+        memcpy(*addr_list++, bond_store_id(cache_env.index, slot), sizeof(BD_ADDR));
     }
-    //free the buffer after used.
-    osi_free(p_buf);
-    return;
-
 }
 
 BOOLEAN bta_gattc_co_cache_new_assoc_list(BD_ADDR src_addr, UINT8 index)
 {
-    cache_addr_info_t *addr_info = &cache_env.cache_addr[index];
-    addr_info->assoc_addr = list_new(osi_free_func);
-    return (addr_info->assoc_addr != NULL ? TRUE : FALSE);
+    UNUSED(src_addr);
+
+    if (index >= BTA_GATTC_CACHE_MAX_DEVICES) {
+        return FALSE;
+    }
+    if (cache_env.assoc_addr[index] == NULL) {
+        cache_env.assoc_addr[index] = list_new(osi_free_func);
+    }
+    return (cache_env.assoc_addr[index] != NULL ? TRUE : FALSE);
 }
 
 BOOLEAN bta_gattc_co_cache_append_assoc_addr(BD_ADDR src_addr, BD_ADDR assoc_addr)
 {
     UINT8 addr_index = 0;
-    cache_addr_info_t *addr_info;
-    UINT8 *p_assoc_buf = osi_malloc(sizeof(BD_ADDR));
-    memcpy(p_assoc_buf, assoc_addr, sizeof(BD_ADDR));
-    if ((addr_index = bta_gattc_co_find_addr_in_cache(src_addr)) != INVALID_ADDR_NUM) {
-        addr_info = &cache_env.cache_addr[addr_index];
-        if (addr_info->assoc_addr == NULL) {
-            addr_info->assoc_addr =list_new(NULL);
-        }
-        return list_append(addr_info->assoc_addr, p_assoc_buf);
+    UINT8 *p_assoc_buf;
+
+    if ((addr_index = bta_gattc_co_find_addr_in_cache(src_addr)) == INVALID_ADDR_NUM ||
+            !bta_gattc_co_cache_new_assoc_list(src_addr, addr_index)) {
+        return FALSE;
     }
 
-    return FALSE;
+    if ((p_assoc_buf = osi_malloc(sizeof(BD_ADDR))) == NULL) {
+        return FALSE;
+    }
+    memcpy(p_assoc_buf, assoc_addr, sizeof(BD_ADDR));
+    return list_append(cache_env.assoc_addr[addr_index], p_assoc_buf);
 }
 
 BOOLEAN bta_gattc_co_cache_remove_assoc_addr(BD_ADDR src_addr, BD_ADDR assoc_addr)
 {
     UINT8 addr_index = 0;
-    cache_addr_info_t *addr_info;
-    if ((addr_index = bta_gattc_co_find_addr_in_cache(src_addr)) != INVALID_ADDR_NUM) {
-        addr_info = &cache_env.cache_addr[addr_index];
-        if (addr_info->assoc_addr != NULL) {
-            for (list_node_t *sn = list_begin(addr_info->assoc_addr);
-             sn != list_end(addr_info->assoc_addr); sn = list_next(sn)) {
-                void *addr = list_node(sn);
-                if (!memcmp(addr, assoc_addr, sizeof(BD_ADDR))) {
-                    return list_remove(addr_info->assoc_addr, addr);
-                }
-            }
-            //return list_remove(addr_info->assoc_addr, assoc_addr);
-        } else {
-            return FALSE;
+    list_t *assoc_list;
+
+    if ((addr_index = bta_gattc_co_find_addr_in_cache(src_addr)) == INVALID_ADDR_NUM ||
+            (assoc_list = cache_env.assoc_addr[addr_index]) == NULL) {
+        return FALSE;
+    }
+
+    for (list_node_t *sn = list_begin(assoc_list); sn != list_end(assoc_list); sn = list_next(sn)) {
+        void *addr = list_node(sn);
+        if (!memcmp(addr, assoc_addr, sizeof(BD_ADDR))) {
+            return list_remove(assoc_list, addr);
         }
     }
 
@@ -593,55 +726,42 @@ BOOLEAN bta_gattc_co_cache_remove_assoc_addr(BD_ADDR src_addr, BD_ADDR assoc_add
 
 UINT8* bta_gattc_co_cache_find_src_addr(BD_ADDR assoc_addr, UINT8 *index)
 {
-    UINT8 num = cache_env.num_addr;
-    cache_addr_info_t *addr_info = &cache_env.cache_addr[0];
-    UINT8 *addr_data;
-    //Check the assoc_addr list is NULL or not
-    if (addr_info->assoc_addr == NULL) {
-        *index = INVALID_ADDR_NUM;
+    *index = INVALID_ADDR_NUM;
+
+    if (cache_env.index == NULL) {
         return NULL;
     }
 
-    for (int i = 0; i < num; i++) {
-       for (const list_node_t *node = list_begin(addr_info->assoc_addr); node != list_end(addr_info->assoc_addr); 
-            node = list_next(node)) {
-            addr_data = (UINT8 *)list_node(node);
-           if (!memcmp(addr_data, assoc_addr, sizeof(BD_ADDR))) {
-               *index = i;
-               return (UINT8 *)addr_info->addr;
-           }
-       }
-       addr_info++;
-
-       if (addr_info->assoc_addr == NULL) {
-           *index = INVALID_ADDR_NUM;
-           return NULL;
-       }
+    for (int slot = bond_store_first(cache_env.index); slot >= 0;
+            slot = bond_store_next(cache_env.index, slot)) {
+        list_t *assoc_list = cache_env.assoc_addr[slot];
+        if (assoc_list == NULL) {
+            continue;
+        }
+        for (const list_node_t *node = list_begin(assoc_list); node != list_end(assoc_list);
+                node = list_next(node)) {
+            if (!memcmp(list_node(node), assoc_addr, sizeof(BD_ADDR))) {
+                *index = (UINT8)slot;
+                return (UINT8 *)bond_store_id(cache_env.index, slot);
+            }
+        }
     }
 
-    *index = INVALID_ADDR_NUM;
     return NULL;
 }
 
 BOOLEAN bta_gattc_co_cache_clear_assoc_addr(BD_ADDR src_addr)
 {
     UINT8 addr_index = 0;
-    cache_addr_info_t *addr_info;
-    if ((addr_index = bta_gattc_co_find_addr_in_cache(src_addr)) != INVALID_ADDR_NUM) {
-        addr_info = &cache_env.cache_addr[addr_index];
-        if (addr_info->assoc_addr != NULL) {
-            list_clear(addr_info->assoc_addr);
-        } else {
-            return FALSE;
-        }
-        return TRUE;
+
+    if ((addr_index = bta_gattc_co_find_addr_in_cache(src_addr)) == INVALID_ADDR_NUM ||
+            cache_env.assoc_addr[addr_index] == NULL) {
+        return FALSE;
     }
 
-    return FALSE;
+    list_clear(cache_env.assoc_addr[addr_index]);
+    return TRUE;
 }
 
-#endif
-
 #endif /* #if( defined BLE_INCLUDED ) && (BLE_INCLUDED == TRUE) */
 #endif /* #if( defined BTA_GATT_INCLUDED ) && (BTA_GATT_INCLUDED == TRUE) */
-
@@ -312,8 +312,7 @@ void bta_gattc_clcb_dealloc(tBTA_GATTC_CLCB *p_clcb)
 
             /* clean up cache */
             if (p_srcb->p_srvc_cache) {
-                list_free(p_srcb->p_srvc_cache);
-                p_srcb->p_srvc_cache = NULL;
+                bta_gattc_free_srvc_cache(p_srcb);
             }
         }
 
@@ -427,9 +426,7 @@ tBTA_GATTC_SERV *bta_gattc_srcb_alloc(BD_ADDR bda)
     }
 
     if (p_tcb != NULL) {
-        if (p_tcb->p_srvc_cache != NULL) {
-            list_free(p_tcb->p_srvc_cache);
-        }
+        bta_gattc_free_srvc_cache(p_tcb);
 
         osi_free(p_tcb->p_srvc_list);
         p_tcb->p_srvc_list = NULL;
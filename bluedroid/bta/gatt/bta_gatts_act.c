@@ -713,6 +713,65 @@ void bta_gatts_indicate_handle (tBTA_GATTS_CB *p_cb, tBTA_GATTS_DATA *p_msg)
     }
 }
 
+/*******************************************************************************
+**
+** Function         bta_gatts_indicate_buf_handle
+**
+** Description      GATTS send handle value indication or notification from a
+**                  PDU buffer filled in place by the application. The buffer
+**                  is given to GATT as is, so the value is not reported back
+**                  in BTA_GATTS_CONF_EVT on failure.
+**
+** Returns          none.
+**
+*******************************************************************************/
+void bta_gatts_indicate_buf_handle (tBTA_GATTS_CB *p_cb, tBTA_GATTS_DATA *p_msg)
+{
+    tBTA_GATTS_API_INDICATION_BUF *p_ind = &p_msg->api_indicate_buf;
+    tBTA_GATTS_SRVC_CB  *p_srvc_cb;
+    tBTA_GATTS_RCB      *p_rcb = NULL;
+    tBTA_GATT_STATUS    status = BTA_GATT_ILLEGAL_PARAMETER;
+    tGATT_IF            gatt_if;
+    BD_ADDR             remote_bda;
+    tBTA_TRANSPORT      transport;
+    tBTA_GATTS          cb_data;
+
+    p_srvc_cb = bta_gatts_find_srvc_cb_by_attr_id (p_cb, p_ind->attr_id);
+
+    if (p_srvc_cb == NULL) {
+        APPL_TRACE_ERROR("Not an registered servce attribute ID: 0x%04x", p_ind->attr_id);
+        osi_free(p_ind->p_buf);
+        return;
+    }
+
+    if (GATT_GetConnectionInfor(p_ind->hdr.layer_specific, &gatt_if, remote_bda, &transport)) {
+        p_rcb = bta_gatts_find_app_rcb_by_app_if(gatt_if);
+
+        status = GATTS_SendHandleValueBuf (p_ind->hdr.layer_specific, p_ind->attr_id,
+                                           p_ind->p_buf, p_ind->need_confirm);
+
+        /* if over BR_EDR, inform PM for mode change */
+        if (transport == BTA_TRANSPORT_BR_EDR) {
+            bta_sys_busy(BTA_ID_GATTS, BTA_ALL_APP_ID, remote_bda);
+            bta_sys_idle(BTA_ID_GATTS, BTA_ALL_APP_ID, remote_bda);
+        }
+    } else {
+        APPL_TRACE_ERROR("Unknown connection ID: %d fail sending notification",
+                         p_ind->hdr.layer_specific);
+        osi_free(p_ind->p_buf);
+    }
+
+    if ((status != GATT_SUCCESS || !p_ind->need_confirm) &&
+            p_rcb && p_cb->rcb[p_srvc_cb->rcb_idx].p_cback) {
+        cb_data.req_data.status = status;
+        cb_data.req_data.conn_id = p_ind->hdr.layer_specific;
+        cb_data.req_data.data_len = 0;
+        cb_data.req_data.value = NULL;
+
+        (*p_rcb->p_cback)(BTA_GATTS_CONF_EVT, &cb_data);
+    }
+}
+
 
 /*******************************************************************************
 **
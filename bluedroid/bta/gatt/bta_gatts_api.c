@@ -431,6 +431,41 @@ void BTA_GATTS_HandleValueIndication (UINT16 conn_id, UINT16 attr_id, UINT16 dat
     return;
 
 }
+
+/*******************************************************************************
+**
+** Function         BTA_GATTS_HandleValueBuf
+**
+** Description      This function is called to send a notification or
+**                  indication whose PDU was allocated with
+**                  GATTS_AllocHandleValueBuf and filled in place. Only the
+**                  buffer pointer is passed on, the value is not copied.
+**
+** Parameters       conn_id - connection identifier.
+**                  attr_id - attribute ID to indicate.
+**                  p_buf - PDU buffer, ownership is taken in all cases.
+**                  need_confirm - if this indication expects a confirmation or not.
+**
+** Returns          None
+**
+*******************************************************************************/
+void BTA_GATTS_HandleValueBuf (UINT16 conn_id, UINT16 attr_id, BT_HDR *p_buf,
+                               BOOLEAN need_confirm)
+{
+    tBTA_GATTS_API_INDICATION_BUF  *p_msg;
+
+    if ((p_msg = (tBTA_GATTS_API_INDICATION_BUF *) osi_malloc(sizeof(tBTA_GATTS_API_INDICATION_BUF))) != NULL) {
+        p_msg->hdr.event = BTA_GATTS_API_INDICATION_BUF_EVT;
+        p_msg->hdr.layer_specific = conn_id;
+        p_msg->attr_id = attr_id;
+        p_msg->need_confirm = need_confirm;
+        p_msg->p_buf = p_buf;
+
+        bta_sys_sendmsg(p_msg);
+    } else {
+        osi_free(p_buf);
+    }
+}
 /*******************************************************************************
 **
 ** Function         BTA_GATTS_SendRsp
@@ -271,6 +271,14 @@ enum {
 };
 typedef UINT8 tBTA_GATTC_STATE;
 
+/* one attribute of the server cache in the handle index */
+typedef struct {
+    UINT16                      handle;     /* start handle of a service */
+    bt_gatt_db_attribute_type_t type;
+    tBTA_GATTC_SERVICE          *p_service; /* service the attribute belongs to */
+    void                        *p_attr;    /* service, characteristic, descriptor or included service */
+} tBTA_GATTC_ATTR_INDEX;
+
 typedef struct {
     BOOLEAN             in_use;
     BD_ADDR             server_bda;
@@ -281,10 +289,13 @@ typedef struct {
 #define BTA_GATTC_SERV_SAVE     2
 #define BTA_GATTC_SERV_DISC     3
 #define BTA_GATTC_SERV_DISC_ACT 4
+#define BTA_GATTC_SERV_HASH     5   /* reading the Database Hash to validate the loaded cache */
 
     UINT8               state;
 
     list_t              *p_srvc_cache;  /* list of tBTA_GATTC_SERVICE */
+    tBTA_GATTC_ATTR_INDEX *p_attr_index; /* attributes of p_srvc_cache sorted by handle */
+    UINT16              num_attr_index;
     UINT8               update_count;   /* indication received */
     UINT8               num_clcb;       /* number of associated CLCB */
 
@@ -301,6 +312,10 @@ typedef struct {
 
     UINT16              mtu;
     bool                update_incl_srvc;
+
+    BOOLEAN             db_hash_valid;  /* db_hash was saved with the loaded cache */
+    UINT8               db_hash[BTA_GATTC_DB_HASH_LEN];
+    UINT16              hash_conn_id;   /* connection the Database Hash is read on */
 } tBTA_GATTC_SERV;
 
 #ifndef BTA_GATTC_NOTIF_REG_MAX
@@ -525,7 +540,8 @@ extern void bta_gattc_get_gatt_db(UINT16 conn_id, UINT16 start_handle, UINT16 en
 
 extern tBTA_GATT_STATUS bta_gattc_init_cache(tBTA_GATTC_SERV *p_srvc_cb);
 extern void bta_gattc_rebuild_cache(tBTA_GATTC_SERV *p_srcv, UINT16 num_attr, tBTA_GATTC_NV_ATTR *attr);
-extern void bta_gattc_cache_save(tBTA_GATTC_SERV *p_srvc_cb, UINT16 conn_id);
+extern void bta_gattc_free_srvc_cache(tBTA_GATTC_SERV *p_srvc_cb);
+extern void bta_gattc_cache_save(tBTA_GATTC_SERV *p_srvc_cb, UINT16 conn_id, UINT8 *db_hash);
 extern void bta_gattc_reset_discover_st(tBTA_GATTC_SERV *p_srcb, tBTA_GATT_STATUS status);
 
 extern tBTA_GATTC_CONN *bta_gattc_conn_alloc(BD_ADDR remote_bda);
@@ -535,6 +551,8 @@ extern BOOLEAN bta_gattc_conn_dealloc(BD_ADDR remote_bda);
 
 extern bool bta_gattc_cache_load(tBTA_GATTC_CLCB *p_clcb);
 extern void bta_gattc_cache_reset(BD_ADDR server_bda);
+extern tBTA_GATT_STATUS bta_gattc_read_db_hash(tBTA_GATTC_CLCB *p_clcb);
+extern BOOLEAN bta_gattc_db_hash_cmpl(tBTA_GATTC_CLCB *p_clcb, tBTA_GATTC_OP_CMPL *p_data);
 extern void bta_gattc_deinit(void);
 
 #endif /* BTA_GATTC_INT_H */
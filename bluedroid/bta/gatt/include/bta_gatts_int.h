@@ -39,6 +39,7 @@ enum {
     BTA_GATTS_API_DEREG_EVT,
     BTA_GATTS_API_CREATE_SRVC_EVT,
     BTA_GATTS_API_INDICATION_EVT,
+    BTA_GATTS_API_INDICATION_BUF_EVT,
 
     BTA_GATTS_API_ADD_INCL_SRVC_EVT,
     BTA_GATTS_API_ADD_CHAR_EVT,
@@ -116,6 +117,14 @@ typedef struct {
     UINT8   value[BTA_GATT_MAX_ATTR_LEN];
 } tBTA_GATTS_API_INDICATION;
 
+/* notification/indication whose PDU was built in place by the application */
+typedef struct {
+    BT_HDR  hdr;
+    UINT16  attr_id;
+    BOOLEAN need_confirm;
+    BT_HDR  *p_buf;
+} tBTA_GATTS_API_INDICATION_BUF;
+
 typedef struct {
     BT_HDR              hdr;
     UINT32              trans_id;
@@ -163,6 +172,7 @@ typedef union {
     tBTA_GATTS_API_ADD_DESCR        api_add_char_descr;
     tBTA_GATTS_API_START            api_start;
     tBTA_GATTS_API_INDICATION       api_indicate;
+    tBTA_GATTS_API_INDICATION_BUF   api_indicate_buf;
     tBTA_GATTS_API_RSP              api_rsp;
     tBTA_GATTS_API_SET_ATTR_VAL     api_set_val;
     tBTA_GATTS_API_OPEN             api_open;
@@ -236,6 +246,7 @@ extern void bta_gatts_stop_service(tBTA_GATTS_SRVC_CB *p_srvc_cb, tBTA_GATTS_DAT
 
 extern void bta_gatts_send_rsp(tBTA_GATTS_CB *p_cb, tBTA_GATTS_DATA *p_msg);
 extern void bta_gatts_indicate_handle (tBTA_GATTS_CB *p_cb, tBTA_GATTS_DATA *p_msg);
+extern void bta_gatts_indicate_buf_handle (tBTA_GATTS_CB *p_cb, tBTA_GATTS_DATA *p_msg);
 
 
 extern void bta_gatts_open (tBTA_GATTS_CB *p_cb, tBTA_GATTS_DATA *p_msg);
@@ -0,0 +1,307 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks the GATT client cache callouts across a restart: a saved attribute
+// table and Database Hash load back unchanged, a blob that no longer matches
+// the hash in its index record is refused, and a full cache drops the least
+// recently saved server. The Makefile builds this with the cache in files
+// and in the in-memory host aos_kv.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/bt_target.h"
+#include "bta/bta_gattc_co.h"
+#include "btm_int.h"
+#include "host_bench.h"
+#if (BOND_STORE_KV_INCLUDED == TRUE)
+#include "aos/kv.h"
+#endif
+
+#define TEST_NUM_ATTR           6
+
+UINT8 appl_trace_level = BT_TRACE_LEVEL_WARNING;
+
+// no bonded peers, every server is cached under the address it connects with
+tBTM_SEC_DEV_REC *btm_find_dev(BD_ADDR bd_addr)
+{
+    (void)bd_addr;
+    return NULL;
+}
+
+static void test_addr(BD_ADDR bda, UINT8 n)
+{
+    for (int i = 0; i < BD_ADDR_LEN; i++) {
+        bda[i] = 0xC0 + n + i;
+    }
+}
+
+static void test_hash(UINT8 *db_hash, UINT8 n)
+{
+    for (int i = 0; i < BTA_GATTC_DB_HASH_LEN; i++) {
+        db_hash[i] = n * 7 + i;
+    }
+}
+
+// A battery service, a 128-bit UUID service including it and a few
+// characteristics, the handles shifted by |n|
+static void test_attrs(tBTA_GATTC_NV_ATTR *attr, UINT8 n)
+{
+    memset(attr, 0, TEST_NUM_ATTR * sizeof(tBTA_GATTC_NV_ATTR));
+
+    attr[0].attr_type = BTA_GATTC_ATTR_TYPE_SRVC;
+    attr[0].is_primary = TRUE;
+    attr[0].s_handle = 1 + n;
+    attr[0].e_handle = 4 + n;
+    attr[0].uuid.len = LEN_UUID_16;
+    attr[0].uuid.uu.uuid16 = 0x180F;
+
+    attr[1].attr_type = BTA_GATTC_ATTR_TYPE_CHAR;
+    attr[1].s_handle = 3 + n;
+    attr[1].prop = 0x12;
+    attr[1].uuid.len = LEN_UUID_16;
+    attr[1].uuid.uu.uuid16 = 0x2A19;
+
+    attr[2].attr_type = BTA_GATTC_ATTR_TYPE_CHAR_DESCR;
+    attr[2].s_handle = 4 + n;
+    attr[2].uuid.len = LEN_UUID_16;
+    attr[2].uuid.uu.uuid16 = 0x2902;
+
+    attr[3].attr_type = BTA_GATTC_ATTR_TYPE_SRVC;
+    attr[3].is_primary = TRUE;
+    attr[3].s_handle = 10 + n;
+    attr[3].e_handle = 20 + n;
+    attr[3].uuid.len = LEN_UUID_128;
+    for (int i = 0; i < LEN_UUID_128; i++) {
+        attr[3].uuid.uu.uuid128[i] = 0x10 + i + n;
+    }
+
+    attr[4].attr_type = BTA_GATTC_ATTR_TYPE_INCL_SRVC;
+    attr[4].s_handle = 11 + n;
+    attr[4].incl_srvc_s_handle = 1 + n;
+    attr[4].incl_srvc_e_handle = 4 + n;
+    attr[4].uuid.len = LEN_UUID_16;
+    attr[4].uuid.uu.uuid16 = 0x180F;
+
+    attr[5].attr_type = BTA_GATTC_ATTR_TYPE_CHAR;
+    attr[5].s_handle = 12 + n;
+    attr[5].prop = 0x08;
+    attr[5].uuid.len = LEN_UUID_32;
+    attr[5].uuid.uu.uuid32 = 0x12345678;
+}
+
+static BOOLEAN test_attr_equal(const tBTA_GATTC_NV_ATTR *a, const tBTA_GATTC_NV_ATTR *b)
+{
+    return a->attr_type == b->attr_type && a->is_primary == b->is_primary &&
+           a->s_handle == b->s_handle && a->e_handle == b->e_handle && a->prop == b->prop &&
+           a->incl_srvc_s_handle == b->incl_srvc_s_handle &&
+           a->incl_srvc_e_handle == b->incl_srvc_e_handle &&
+           a->uuid.len == b->uuid.len && !memcmp(&a->uuid.uu, &b->uuid.uu, a->uuid.len);
+}
+
+static void test_save(UINT8 n, BOOLEAN with_hash)
+{
+    tBTA_GATTC_NV_ATTR attr[TEST_NUM_ATTR];
+    UINT8 db_hash[BTA_GATTC_DB_HASH_LEN];
+    BD_ADDR bda;
+
+    test_addr(bda, n);
+    test_attrs(attr, n);
+    test_hash(db_hash, n);
+    bta_gattc_co_cache_save(bda, TEST_NUM_ATTR, attr, with_hash ? db_hash : NULL);
+}
+
+// Returns TRUE if server |n| is cached with its attributes and, if
+// |with_hash|, its Database Hash
+static BOOLEAN test_load(UINT8 n, BOOLEAN with_hash)
+{
+    tBTA_GATTC_NV_ATTR expect[TEST_NUM_ATTR], attr[TEST_NUM_ATTR];
+    UINT8 expect_hash[BTA_GATTC_DB_HASH_LEN], db_hash[BTA_GATTC_DB_HASH_LEN];
+    BD_ADDR bda;
+    UINT8 index;
+
+    test_addr(bda, n);
+    test_attrs(expect, n);
+    test_hash(expect_hash, n);
+
+    if (bta_gattc_co_cache_open(bda, FALSE, &index) != BTA_GATT_OK ||
+            bta_gattc_get_cache_attr_length(index) != sizeof(attr) ||
+            bta_gattc_co_cache_load(attr, index) != BTA_GATT_OK) {
+        return FALSE;
+    }
+    for (int i = 0; i < TEST_NUM_ATTR; i++) {
+        if (!test_attr_equal(&attr[i], &expect[i])) {
+            return FALSE;
+        }
+    }
+
+    if (!with_hash) {
+        return !bta_gattc_co_cache_get_db_hash(index, db_hash);
+    }
+    return bta_gattc_co_cache_get_db_hash(index, db_hash) &&
+           !memcmp(db_hash, expect_hash, sizeof(db_hash));
+}
+
+static void test_restart(void)
+{
+    bta_gattc_co_cache_addr_deinit();
+    bta_gattc_co_cache_addr_init();
+}
+
+static void test_reset(void)
+{
+    BD_ADDR *addr_list;
+    UINT8 num;
+
+    bta_gattc_co_cache_addr_init();
+    num = bta_gattc_co_get_addr_num();
+    if (num && (addr_list = malloc(num * sizeof(BD_ADDR))) != NULL) {
+        bta_gattc_co_get_addr_list(addr_list);
+        for (UINT8 i = 0; i < num; i++) {
+            bta_gattc_co_cache_reset(addr_list[i]);
+        }
+        free(addr_list);
+    }
+}
+
+// Rewrites the blob of server |n| with the attribute table of another server
+// of the same size
+static void test_corrupt_blob(UINT8 n)
+{
+    char name[64];
+    BD_ADDR bda;
+
+    test_addr(bda, n);
+    sprintf(name, "%s%02x%02x%02x%02x%02x%02x",
+#if (BOND_STORE_KV_INCLUDED == TRUE)
+            BTA_GATTC_CACHE_KV_PREFIX,
+#else
+            BTA_GATTC_CACHE_PATH_PREFIX,
+#endif
+            bda[0], bda[1], bda[2], bda[3], bda[4], bda[5]);
+
+#if (BOND_STORE_KV_INCLUDED == TRUE)
+    UINT8 buf[256];
+    int len = sizeof(buf);
+
+    if (aos_kv_get(name, buf, &len) == 0 && len > 3) {
+        buf[3] ^= 0x01;
+        aos_kv_set(name, buf, len, 1);
+    }
+#else
+    FILE *fp = fopen(name, "r+b");
+    int c;
+
+    if (fp) {
+        fseek(fp, 3, SEEK_SET);
+        c = fgetc(fp);
+        fseek(fp, 3, SEEK_SET);
+        fputc(c ^ 0x01, fp);
+        fclose(fp);
+    }
+#endif
+}
+
+static int test_round_trip(void)
+{
+    int fail = 0;
+
+    test_reset();
+    test_save(1, TRUE);
+    test_save(2, FALSE);
+    fail |= host_test_true("save", test_load(1, TRUE) && test_load(2, FALSE));
+
+    test_restart();
+    fail |= host_test_true("reload", bta_gattc_co_get_addr_num() == 2);
+    fail |= host_test_true("reload with db hash", test_load(1, TRUE));
+    fail |= host_test_true("reload without db hash", test_load(2, FALSE));
+
+    // saving again replaces the table and the hash
+    test_save(2, TRUE);
+    test_restart();
+    fail |= host_test_true("resave", bta_gattc_co_get_addr_num() == 2 && test_load(2, TRUE));
+    return fail;
+}
+
+static int test_hash_mismatch(void)
+{
+    int fail = 0;
+
+    test_reset();
+    test_save(1, TRUE);
+    test_save(2, TRUE);
+    test_restart();
+
+    // a blob changed behind the index is refused, the other server still loads
+    test_corrupt_blob(1);
+    fail |= host_test_true("blob hash mismatch refused", !test_load(1, TRUE));
+    fail |= host_test_true("blob hash mismatch other server", test_load(2, TRUE));
+
+    BD_ADDR bda;
+    test_addr(bda, 1);
+    bta_gattc_co_cache_reset(bda);
+    test_restart();
+    fail |= host_test_true("blob hash mismatch reset", bta_gattc_co_get_addr_num() == 1 &&
+                           !bta_gattc_co_addr_in_cache(bda));
+    return fail;
+}
+
+static int test_eviction(void)
+{
+    BD_ADDR bda;
+    int fail = 0;
+
+    test_reset();
+    for (UINT8 n = 0; n < BTA_GATTC_CACHE_MAX_DEVICES; n++) {
+        test_save(n, TRUE);
+    }
+    // server 0 is saved again, so server 1 is now the least recently saved
+    test_save(0, TRUE);
+    test_restart();
+    test_save(BTA_GATTC_CACHE_MAX_DEVICES, TRUE);
+
+    test_addr(bda, 1);
+    fail |= host_test_true("eviction count", bta_gattc_co_get_addr_num() == BTA_GATTC_CACHE_MAX_DEVICES);
+    fail |= host_test_true("eviction drops the oldest", !bta_gattc_co_addr_in_cache(bda));
+    fail |= host_test_true("eviction keeps the resaved", test_load(0, TRUE));
+    fail |= host_test_true("eviction adds the new", test_load(BTA_GATTC_CACHE_MAX_DEVICES, TRUE));
+
+    test_restart();
+    fail |= host_test_true("eviction reload", bta_gattc_co_get_addr_num() == BTA_GATTC_CACHE_MAX_DEVICES &&
+                           !bta_gattc_co_addr_in_cache(bda) && test_load(2, TRUE));
+#if (BOND_STORE_KV_INCLUDED == TRUE)
+    // one index record and one blob per server, and the index
+    fail |= host_test_true("eviction deletes the values", host_kv_count() == 2 * BTA_GATTC_CACHE_MAX_DEVICES + 1);
+#endif
+    return fail;
+}
+
+int main(int argc, char **argv)
+{
+    int fail = 0;
+
+    (void)argc;
+    (void)argv;
+
+    fail |= test_round_trip();
+    fail |= test_hash_mismatch();
+    fail |= test_eviction();
+    test_reset();
+    bta_gattc_co_cache_addr_deinit();
+
+    if (fail) {
+        printf("gattc cache: FAIL\n");
+        return 1;
+    }
+    return 0;
+}
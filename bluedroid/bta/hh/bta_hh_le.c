@@ -862,6 +862,10 @@ void bta_hh_le_open_cmpl(tBTA_HH_DEV_CB *p_cb)
         bta_hh_le_register_input_notif(p_cb, 0, p_cb->mode, TRUE);
         bta_hh_sm_execute(p_cb, BTA_HH_OPEN_CMPL_EVT, NULL);
 
+        if (p_cb->status == BTA_HH_OK) {
+            L2CA_SetAclSchedClass(p_cb->addr, BT_TRANSPORT_LE, L2CAP_ACL_CLASS_HID);
+        }
+
 #if (BTA_HH_LE_RECONN == TRUE)
         if (p_cb->status == BTA_HH_OK) {
             bta_hh_le_add_dev_bg_conn(p_cb, TRUE);
@@ -1356,6 +1356,25 @@ extern void BTA_GATTS_HandleValueIndication (UINT16 conn_id, UINT16 attr_id,
                                              UINT8 *p_data,
                                              BOOLEAN need_confirm);
 
+/*******************************************************************************
+**
+** Function         BTA_GATTS_HandleValueBuf
+**
+** Description      This function is called to send a notification or
+**                  indication built in place in a GATTS_AllocHandleValueBuf
+**                  buffer.
+**
+** Parameters       conn_id - connection identifier.
+**                  attr_id - attribute ID to indicate.
+**                  p_buf - PDU buffer, ownership is taken in all cases.
+**                  need_confirm - if this indication expects a confirmation or not.
+**
+** Returns          None
+**
+*******************************************************************************/
+extern void BTA_GATTS_HandleValueBuf (UINT16 conn_id, UINT16 attr_id, BT_HDR *p_buf,
+                                      BOOLEAN need_confirm);
+
 /*******************************************************************************
 **
 ** Function         BTA_GATTS_SendRsp
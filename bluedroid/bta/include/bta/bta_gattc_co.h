@@ -27,6 +27,9 @@
 #include "bta/bta_gatt_api.h"
 #include "osi/hash_functions.h"
 
+/* length of the Database Hash characteristic value */
+#define BTA_GATTC_DB_HASH_LEN   16
+
 /*******************************************************************************
 **
 ** Function         bta_gattc_co_cache_open
@@ -35,11 +38,10 @@
 **                  cache is ready to be sent.
 **
 ** Parameter        server_bda: server bd address of this cache belongs to
-**                  evt: call in event to be passed in when cache open is done.
-**                  conn_id: connection ID of this cache operation attach to.
 **                  to_save: open cache to save or to load.
+**                  index: filled with the index of the cache.
 **
-** Returns          void.
+** Returns          BTA_GATT_OK if there is a cache for the server.
 **
 *******************************************************************************/
 extern tBTA_GATT_STATUS bta_gattc_co_cache_open(BD_ADDR server_bda, BOOLEAN to_save, UINT8 *index);
@@ -67,16 +69,14 @@ extern void bta_gattc_co_cache_close(BD_ADDR server_bda, UINT16 conn_id);
 **                  is available to save.
 **
 ** Parameter        server_bda: server bd address of this cache belongs to
-**                  evt: call in event to be passed in when cache save is done.
 **                  num_attr: number of attribute to be save.
-**                  p_attr: pointer to the list of attributes to save.
-**                  attr_index: starting attribute index of the save operation.
-**                  conn_id: connection ID of this cache operation attach to.
+**                  p_attr_list: pointer to the list of attributes to save.
+**                  db_hash: Database Hash of the server, NULL if unknown.
 ** Returns
 **
 *******************************************************************************/
 extern void bta_gattc_co_cache_save (BD_ADDR server_bda, UINT16 num_attr,
-                              tBTA_GATTC_NV_ATTR *p_attr_list);
+                              tBTA_GATTC_NV_ATTR *p_attr_list, UINT8 *db_hash);
 
 /*******************************************************************************
 **
@@ -85,16 +85,30 @@ extern void bta_gattc_co_cache_save (BD_ADDR server_bda, UINT16 num_attr,
 ** Description      This callout function is executed by GATT when server cache
 **                  is required to load.
 **
-** Parameter        server_bda: server bd address of this cache belongs to
-**                  evt: call in event to be passed in when cache save is done.
-**                  num_attr: number of attribute to be save.
-**                  attr_index: starting attribute index of the save operation.
-**                  conn_id: connection ID of this cache operation attach to.
-** Returns
+** Parameter        attr: filled with the attributes of the cache, room for
+**                        bta_gattc_get_cache_attr_length bytes.
+**                  index: index of the cache, from bta_gattc_co_cache_open.
+**
+** Returns          BTA_GATT_OK if the cache was read and is intact.
 **
 *******************************************************************************/
 extern tBTA_GATT_STATUS bta_gattc_co_cache_load(tBTA_GATTC_NV_ATTR *attr, UINT8 index);
 
+/*******************************************************************************
+**
+** Function         bta_gattc_co_cache_get_db_hash
+**
+** Description      This callout function is executed by GATTC to get the
+**                  Database Hash of the server a cache was built from.
+**
+** Parameter        index: index of the cache, from bta_gattc_co_cache_open.
+**                  db_hash: filled with the BTA_GATTC_DB_HASH_LEN bytes hash.
+**
+** Returns          TRUE if the hash was saved with the cache.
+**
+*******************************************************************************/
+extern BOOLEAN bta_gattc_co_cache_get_db_hash(UINT8 index, UINT8 *db_hash);
+
 /*******************************************************************************
 **
 ** Function         bta_gattc_co_cache_reset
@@ -125,8 +139,6 @@ extern UINT8 bta_gattc_co_get_addr_num(void);
 
 extern void bta_gattc_co_get_addr_list(BD_ADDR *addr_list);
 
-extern void bta_gattc_co_cache_addr_save(BD_ADDR bd_addr, hash_key_t hash_key);
-
 extern BOOLEAN bta_gattc_co_cache_new_assoc_list(BD_ADDR src_addr, uint8_t index);
 
 extern BOOLEAN bta_gattc_co_cache_append_assoc_addr(BD_ADDR src_addr, BD_ADDR assoc_addr);
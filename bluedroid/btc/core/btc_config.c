@@ -12,84 +12,319 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#include <ctype.h>
-#include <stdio.h>
+#include <stddef.h>
 #include <string.h>
 
 #include "common/bt_defs.h"
 #include "common/bt_trace.h"
-#include "osi/alarm.h"
 #include "osi/allocator.h"
 #include "device/bdaddr.h"
+#include "btc/btc_ble_storage.h"
 #include "btc/btc_config.h"
+#include "btc/btc_storage.h"
 #include "btc/btc_util.h"
-#include "osi/config.h"
+#include "osi/bond_store.h"
 #include "osi/osi.h"
 #include "osi/mutex.h"
 
 #include "stack/bt_types.h"
+#include "stack/btm_api.h"
+
+#define BTC_CONFIG_MAX_KEYS     20      // entries of |btc_config_keys|, at most 32
+
+// Everything known about one bonded peer, or the local keys, as one fixed
+// size record of the bond store. Sections are peer addresses plus the local
+// adapter section, keys are fields of the record.
+typedef struct {
+    uint32_t present;                       // bit per entry of |btc_config_keys|
+    uint8_t len[BTC_CONFIG_MAX_KEYS];       // stored length of each key
+    union {
+        struct {
+            int32_t dev_type;
+            int32_t addr_type;
+            int32_t auth_mode;
+            int32_t link_key_type;
+            int32_t pin_length;
+            int32_t dev_class;
+            LINK_KEY link_key;
+            uint8_t le_penc[sizeof(tBTM_LE_PENC_KEYS)];
+            uint8_t le_pid[sizeof(tBTM_LE_PID_KEYS)];
+            uint8_t le_pcsrk[sizeof(tBTM_LE_PCSRK_KEYS)];
+            uint8_t le_lenc[sizeof(tBTM_LE_LENC_KEYS)];
+            uint8_t le_lcsrk[sizeof(tBTM_LE_LCSRK_KEYS)];
+        } peer;
+        struct {
+            BT_OCTET16 ir;
+            BT_OCTET16 irk;
+            BT_OCTET16 dhk;
+            BT_OCTET16 er;
+        } local;
+    } u;
+} btc_config_record_t;
+
+typedef struct {
+    const char *name;
+    bool local;                             // key of the local adapter section
+    bool is_int;
+    uint16_t offset;
+    uint16_t size;
+} btc_config_key_t;
+
+#define BTC_CONFIG_PEER_INT(name, field)   { name, false, true, offsetof(btc_config_record_t, u.peer.field), sizeof(int32_t) }
+#define BTC_CONFIG_PEER_BIN(name, field)   { name, false, false, offsetof(btc_config_record_t, u.peer.field), \
+                                             sizeof(((btc_config_record_t *)0)->u.peer.field) }
+#define BTC_CONFIG_LOCAL_BIN(name, field)  { name, true, false, offsetof(btc_config_record_t, u.local.field), sizeof(BT_OCTET16) }
+
+static const btc_config_key_t btc_config_keys[] = {
+    BTC_CONFIG_PEER_INT(BTC_STORAGE_LINK_KEY_TYPE_STR, link_key_type),
+    BTC_CONFIG_PEER_INT(BTC_STORAGE_PIN_LENGTH_STR, pin_length),
+    BTC_CONFIG_PEER_INT(BTC_STORAGE_DEV_CLASS_STR, dev_class),
+    BTC_CONFIG_PEER_BIN(BTC_STORAGE_LINK_KEY_STR, link_key),
+#if (SMP_INCLUDED == TRUE)
+    BTC_CONFIG_PEER_INT(BTC_BLE_STORAGE_DEV_TYPE_STR, dev_type),
+    BTC_CONFIG_PEER_INT(BTC_BLE_STORAGE_ADDR_TYPE_STR, addr_type),
+    BTC_CONFIG_PEER_INT(BTC_BLE_STORAGE_LE_AUTH_MODE_STR, auth_mode),
+    BTC_CONFIG_PEER_BIN(BTC_BLE_STORAGE_LE_KEY_PENC_STR, le_penc),
+    BTC_CONFIG_PEER_BIN(BTC_BLE_STORAGE_LE_KEY_PID_STR, le_pid),
+    BTC_CONFIG_PEER_BIN(BTC_BLE_STORAGE_LE_KEY_PCSRK_STR, le_pcsrk),
+    BTC_CONFIG_PEER_BIN(BTC_BLE_STORAGE_LE_KEY_LENC_STR, le_lenc),
+    BTC_CONFIG_PEER_BIN(BTC_BLE_STORAGE_LE_KEY_LCSRK_STR, le_lcsrk),
+    { BTC_BLE_STORAGE_LE_KEY_LID_STR, false, false, 0, 0 },    // presence only
+    BTC_CONFIG_LOCAL_BIN(BTC_BLE_STORAGE_LE_LOCAL_KEY_IR_STR, ir),
+    BTC_CONFIG_LOCAL_BIN(BTC_BLE_STORAGE_LE_LOCAL_KEY_IRK_STR, irk),
+    BTC_CONFIG_LOCAL_BIN(BTC_BLE_STORAGE_LE_LOCAL_KEY_DHK_STR, dhk),
+    BTC_CONFIG_LOCAL_BIN(BTC_BLE_STORAGE_LE_LOCAL_KEY_ER_STR, er),
+#endif  ///SMP_INCLUDED == TRUE
+};
+
+#define BTC_CONFIG_KEY_NUM      (sizeof(btc_config_keys) / sizeof(btc_config_keys[0]))
+
+#if (SMP_INCLUDED == TRUE)
+#define BTC_CONFIG_LOCAL_SECTION BTC_BLE_STORAGE_LOCAL_ADAPTER_STR
+#else
+#define BTC_CONFIG_LOCAL_SECTION "Adapter"
+#endif
+
+// The local adapter section is stored under an id no peer can have
+static const uint8_t btc_config_local_id[BOND_STORE_ID_LEN] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+
+#define BTC_CONFIG_BACKEND_NAME_MAX     64
+
+static osi_mutex_t lock;  // protects operations on |store|.
+static bond_store_t *store;
+static const bond_store_backend_t *app_backend;
+static bond_store_backend_t *own_backend;
+static bool backend_use_kv = (BTC_BOND_STORE_USE_KV == TRUE);
+static char backend_name[BTC_CONFIG_BACKEND_NAME_MAX];
+
+// Section names handed out by the iterator, one per record slot
+static bdstr_t section_names[BTC_BOND_STORE_MAX_RECORDS];
+
+static bool btc_config_section_id(const char *section, uint8_t *id)
+{
+    bt_bdaddr_t bd_addr;
 
-static const char *CONFIG_FILE_PATH = "bt_config.conf";
+    if (!strcmp(section, BTC_CONFIG_LOCAL_SECTION)) {
+        memcpy(id, btc_config_local_id, BOND_STORE_ID_LEN);
+        return true;
+    }
 
-static void btc_key_value_to_string(uint8_t *key_value, char *value_str, int key_length);
-static osi_mutex_t lock;  // protects operations on |config|.
-static config_t *config;
+    if (!string_to_bdaddr(section, &bd_addr)) {
+        return false;
+    }
+    memcpy(id, bd_addr.address, BOND_STORE_ID_LEN);
+    return true;
+}
 
-bool btc_compare_address_key_value(const char *section, const char *key_type, void *key_value, int key_length)
+static int btc_config_find_slot(const char *section)
 {
-    assert(key_value != NULL);
-    bool status = false;
-    char value_str[100] = {0};
-    if(key_length > sizeof(value_str)/2) {
+    uint8_t id[BOND_STORE_ID_LEN];
+
+    if (!btc_config_section_id(section, id)) {
+        return -1;
+    }
+    return bond_store_find(store, id);
+}
+
+static int btc_config_key_index(bool local, const char *key)
+{
+    for (int i = 0; i < (int)BTC_CONFIG_KEY_NUM; i++) {
+        if (btc_config_keys[i].local == local && !strcmp(btc_config_keys[i].name, key)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Returns the record holding |key| of |section|, or NULL if it is not set
+static btc_config_record_t *btc_config_find(const char *section, const char *key, int *key_index)
+{
+    int slot = btc_config_find_slot(section);
+    if (slot < 0) {
+        return NULL;
+    }
+
+    int index = btc_config_key_index(!strcmp(section, BTC_CONFIG_LOCAL_SECTION), key);
+    btc_config_record_t *record = bond_store_data(store, slot);
+    if (index < 0 || !(record->present & (1u << index))) {
+        return NULL;
+    }
+
+    *key_index = index;
+    return record;
+}
+
+static bool btc_config_set(const char *section, const char *key, const void *value, size_t length)
+{
+    uint8_t id[BOND_STORE_ID_LEN];
+    int index = btc_config_key_index(!strcmp(section, BTC_CONFIG_LOCAL_SECTION), key);
+
+    if (index < 0 || !btc_config_section_id(section, id)) {
+        BTC_TRACE_WARNING("%s unknown key %s in section %s\n", __func__, key, section);
         return false;
     }
-    btc_key_value_to_string((uint8_t *)key_value, value_str, key_length);
-    if ((status = config_has_key_in_section(config, key_type, value_str)) == true) {
-        config_remove_section(config, section);
+
+    const btc_config_key_t *k = &btc_config_keys[index];
+    if (length > k->size) {
+        BTC_TRACE_ERROR("%s %s is %d bytes, at most %d fit\n", __func__, key, (int)length, k->size);
+        return false;
     }
-    return status;
+
+    int slot = bond_store_add(store, id);
+    if (slot < 0) {
+        BTC_TRACE_ERROR("%s bond store full, dropping %s\n", __func__, section);
+        return false;
+    }
+
+    btc_config_record_t *record = bond_store_data(store, slot);
+    memset((uint8_t *)record + k->offset, 0, k->size);
+    if (length) {
+        memcpy((uint8_t *)record + k->offset, value, length);
+    }
+    record->len[index] = length;
+    record->present |= (1u << index);
+    bond_store_mark_dirty(store, slot);
+    return true;
 }
 
-static void btc_key_value_to_string(uint8_t *key_value, char *value_str, int key_length)
+bool btc_config_set_backend(const bond_store_backend_t *backend)
 {
-    const char *lookup = "0123456789abcdef";
+    if (store) {
+        BTC_TRACE_ERROR("%s the bond store is already open\n", __func__);
+        return false;
+    }
+
+    app_backend = backend;
+    return true;
+}
+
+bool btc_config_select_backend(bool use_kv, const char *name)
+{
+    if (store) {
+        BTC_TRACE_ERROR("%s the bond store is already open\n", __func__);
+        return false;
+    }
+
+#if (BOND_STORE_KV_INCLUDED != TRUE)
+    if (use_kv) {
+        BTC_TRACE_ERROR("%s the aos_kv backend is not built in\n", __func__);
+        return false;
+    }
+#endif
+
+    if (name && strlen(name) >= sizeof(backend_name)) {
+        BTC_TRACE_ERROR("%s name too long\n", __func__);
+        return false;
+    }
+
+    backend_use_kv = use_kv;
+    if (name) {
+        strcpy(backend_name, name);
+    } else {
+        backend_name[0] = '\0';
+    }
+    return true;
+}
+
+static bond_store_backend_t *btc_config_backend_new(void)
+{
+#if (BOND_STORE_KV_INCLUDED == TRUE)
+    if (backend_use_kv) {
+        return bond_store_kv_backend_new(backend_name[0] ? backend_name : BTC_BOND_STORE_KV_KEY);
+    }
+#endif
+    return bond_store_file_backend_new(backend_name[0] ? backend_name : BTC_BOND_STORE_PATH);
+}
 
+static void btc_config_backend_free(void)
+{
+    if (!own_backend) {
+        return;
+    }
+
+#if (BOND_STORE_KV_INCLUDED == TRUE)
+    if (backend_use_kv) {
+        bond_store_kv_backend_free(own_backend);
+        own_backend = NULL;
+        return;
+    }
+#endif
+    bond_store_file_backend_free(own_backend);
+    own_backend = NULL;
+}
+
+bool btc_compare_address_key_value(const char *section, const char *key_type, void *key_value, int key_length)
+{
     assert(key_value != NULL);
-    assert(value_str != NULL);
+    bool status = false;
+
+    for (int slot = bond_store_first(store); slot >= 0 && !status; slot = bond_store_next(store, slot)) {
+        btc_config_record_t *record = bond_store_data(store, slot);
+        bool local = !memcmp(bond_store_id(store, slot), btc_config_local_id, BOND_STORE_ID_LEN);
+        int index = btc_config_key_index(local, key_type);
 
-    for (size_t i = 0; i < key_length; ++i) {
-        value_str[(i * 2) + 0] = lookup[(key_value[i] >> 4) & 0x0F];
-        value_str[(i * 2) + 1] = lookup[key_value[i] & 0x0F];
+        if (index >= 0 && (record->present & (1u << index)) && record->len[index] == key_length &&
+                !memcmp((uint8_t *)record + btc_config_keys[index].offset, key_value, key_length)) {
+            status = true;
+        }
     }
 
-    return;
+    if (status) {
+        btc_config_remove_section(section);
+    }
+    return status;
 }
 
 // Module lifecycle functions
 
 bool btc_config_init(void)
 {
+    const bond_store_backend_t *backend = app_backend;
+
+    assert(BTC_CONFIG_KEY_NUM <= BTC_CONFIG_MAX_KEYS);
+
     osi_mutex_new(&lock);
 
-    config = config_new(CONFIG_FILE_PATH);
-    if (!config) {
-        BTC_TRACE_WARNING("%s unable to load config file; starting unconfigured.\n", __func__);
-        config = config_new_empty();
-        if (!config) {
-            BTC_TRACE_ERROR("%s unable to allocate a config object.\n", __func__);
+    if (!backend) {
+        own_backend = btc_config_backend_new();
+        if (!own_backend) {
+            BTC_TRACE_ERROR("%s unable to allocate the %s backend.\n", __func__, backend_use_kv ? "aos_kv" : "file");
             goto error;
         }
+        backend = own_backend;
     }
-    if (config_save(config, CONFIG_FILE_PATH)) {
-        // unlink(LEGACY_CONFIG_FILE_PATH);
+
+    store = bond_store_new(backend, sizeof(btc_config_record_t), BTC_BOND_STORE_MAX_RECORDS);
+    if (!store) {
+        BTC_TRACE_ERROR("%s unable to allocate the bond store.\n", __func__);
+        goto error;
     }
 
     return true;
 
 error:;
-    //config_free(config);
+    btc_config_backend_free();
     osi_mutex_free(&lock);
-    config = NULL;
     BTC_TRACE_ERROR("%s failed\n", __func__);
     return false;
 }
@@ -104,141 +339,126 @@ bool btc_config_clean_up(void)
 {
     btc_config_flush();
 
-    config_free(config);
+    bond_store_free(store);
+    store = NULL;
+    btc_config_backend_free();
     osi_mutex_free(&lock);
-    config = NULL;
     return true;
 }
 
 bool btc_config_has_section(const char *section)
 {
-    assert(config != NULL);
+    assert(store != NULL);
     assert(section != NULL);
 
-    return config_has_section(config, section);
+    return (btc_config_find_slot(section) >= 0);
 }
 
 bool btc_config_exist(const char *section, const char *key)
 {
-    assert(config != NULL);
+    assert(store != NULL);
     assert(section != NULL);
     assert(key != NULL);
 
-    return config_has_key(config, section, key);
+    int index;
+    return (btc_config_find(section, key, &index) != NULL);
 }
 
 bool btc_config_get_int(const char *section, const char *key, int *value)
 {
-    assert(config != NULL);
+    assert(store != NULL);
     assert(section != NULL);
     assert(key != NULL);
     assert(value != NULL);
 
-    bool ret = config_has_key(config, section, key);
-    if (ret) {
-        *value = config_get_int(config, section, key, *value);
+    int index;
+    btc_config_record_t *record = btc_config_find(section, key, &index);
+    if (!record || !btc_config_keys[index].is_int) {
+        return false;
     }
 
-    return ret;
+    int32_t stored;
+    memcpy(&stored, (uint8_t *)record + btc_config_keys[index].offset, sizeof(stored));
+    *value = stored;
+    return true;
 }
 
 bool btc_config_set_int(const char *section, const char *key, int value)
 {
-    assert(config != NULL);
+    assert(store != NULL);
     assert(section != NULL);
     assert(key != NULL);
 
-    config_set_int(config, section, key, value);
+    int index = btc_config_key_index(!strcmp(section, BTC_CONFIG_LOCAL_SECTION), key);
+    if (index >= 0 && !btc_config_keys[index].is_int) {
+        return false;
+    }
 
-    return true;
+    int32_t stored = value;
+    return btc_config_set(section, key, &stored, sizeof(stored));
 }
 
 bool btc_config_get_str(const char *section, const char *key, char *value, int *size_bytes)
 {
-    assert(config != NULL);
+    assert(store != NULL);
     assert(section != NULL);
     assert(key != NULL);
     assert(value != NULL);
     assert(size_bytes != NULL);
 
-    const char *stored_value = config_get_string(config, section, key, NULL);
-
-    if (!stored_value) {
-        return false;
-    }
-
-    strlcpy(value, stored_value, *size_bytes);
-    *size_bytes = strlen(value) + 1;
-
-    return true;
+    // the bond store has no string keys
+    BTC_TRACE_WARNING("%s %s is not a bond store key\n", __func__, key);
+    return false;
 }
 
 bool btc_config_set_str(const char *section, const char *key, const char *value)
 {
-    assert(config != NULL);
+    assert(store != NULL);
     assert(section != NULL);
     assert(key != NULL);
     assert(value != NULL);
 
-    config_set_string(config, section, key, value, false);
-
-    return true;
+    BTC_TRACE_WARNING("%s %s is not a bond store key\n", __func__, key);
+    return false;
 }
 
 bool btc_config_get_bin(const char *section, const char *key, uint8_t *value, size_t *length)
 {
-    assert(config != NULL);
+    assert(store != NULL);
     assert(section != NULL);
     assert(key != NULL);
     assert(value != NULL);
     assert(length != NULL);
 
-    const char *value_str = config_get_string(config, section, key, NULL);
-
-    if (!value_str) {
-        return false;
-    }
-
-    size_t value_len = strlen(value_str);
-    if ((value_len % 2) != 0 || *length < (value_len / 2)) {
+    int index;
+    btc_config_record_t *record = btc_config_find(section, key, &index);
+    if (!record || btc_config_keys[index].is_int || *length < record->len[index]) {
         return false;
     }
 
-    for (size_t i = 0; i < value_len; ++i)
-        if (!isxdigit((unsigned char)value_str[i])) {
-            return false;
-        }
-
-    for (*length = 0; *value_str; value_str += 2, *length += 1) {
-        unsigned int val;
-        sscanf(value_str, "%02x", &val);
-        value[*length] = (uint8_t)(val);
-    }
-
+    *length = record->len[index];
+    memcpy(value, (uint8_t *)record + btc_config_keys[index].offset, *length);
     return true;
 }
 
 size_t btc_config_get_bin_length(const char *section, const char *key)
 {
-    assert(config != NULL);
+    assert(store != NULL);
     assert(section != NULL);
     assert(key != NULL);
 
-    const char *value_str = config_get_string(config, section, key, NULL);
-
-    if (!value_str) {
+    int index;
+    btc_config_record_t *record = btc_config_find(section, key, &index);
+    if (!record || btc_config_keys[index].is_int) {
         return 0;
     }
 
-    size_t value_len = strlen(value_str);
-    return ((value_len % 2) != 0) ? 0 : (value_len / 2);
+    return record->len[index];
 }
 
 bool btc_config_set_bin(const char *section, const char *key, const uint8_t *value, size_t length)
 {
-    const char *lookup = "0123456789abcdef";
-
-    assert(config != NULL);
+    assert(store != NULL);
     assert(section != NULL);
     assert(key != NULL);
 
@@ -246,86 +466,107 @@ bool btc_config_set_bin(const char *section, const char *key, const uint8_t *val
         assert(value != NULL);
     }
 
-    char *str = (char *)osi_calloc(length * 2 + 1);
-    if (!str) {
+    int index = btc_config_key_index(!strcmp(section, BTC_CONFIG_LOCAL_SECTION), key);
+    if (index >= 0 && btc_config_keys[index].is_int) {
         return false;
     }
 
-    for (size_t i = 0; i < length; ++i) {
-        str[(i * 2) + 0] = lookup[(value[i] >> 4) & 0x0F];
-        str[(i * 2) + 1] = lookup[value[i] & 0x0F];
+    return btc_config_set(section, key, value, length);
+}
+
+static const btc_config_section_iter_t *btc_config_section_iter(int slot)
+{
+    const uint8_t *id;
+
+    if (slot < 0) {
+        return NULL;
     }
 
-    config_set_string(config, section, key, str, false);
+    id = bond_store_id(store, slot);
+    if (!memcmp(id, btc_config_local_id, BOND_STORE_ID_LEN)) {
+        strlcpy(section_names[slot], BTC_CONFIG_LOCAL_SECTION, sizeof(bdstr_t));
+    } else {
+        bdaddr_to_string((const bt_bdaddr_t *)id, section_names[slot], sizeof(bdstr_t));
+    }
 
-    osi_free(str);
-    return true;
+    return (const btc_config_section_iter_t *)section_names[slot];
 }
 
 const btc_config_section_iter_t *btc_config_section_begin(void)
 {
-    assert(config != NULL);
-    return (const btc_config_section_iter_t *)config_section_begin(config);
+    assert(store != NULL);
+    return btc_config_section_iter(bond_store_first(store));
 }
 
 const btc_config_section_iter_t *btc_config_section_end(void)
 {
-    assert(config != NULL);
-    return (const btc_config_section_iter_t *)config_section_end(config);
+    assert(store != NULL);
+    return NULL;
 }
 
 const btc_config_section_iter_t *btc_config_section_next(const btc_config_section_iter_t *section)
 {
-    assert(config != NULL);
+    assert(store != NULL);
     assert(section != NULL);
-    return (const btc_config_section_iter_t *)config_section_next((const config_section_node_t *)section);
+
+    int slot = ((const char *)section - section_names[0]) / sizeof(bdstr_t);
+    return btc_config_section_iter(bond_store_next(store, slot));
 }
 
 const char *btc_config_section_name(const btc_config_section_iter_t *section)
 {
-    assert(config != NULL);
+    assert(store != NULL);
     assert(section != NULL);
-    return config_section_name((const config_section_node_t *)section);
+    return (const char *)section;
 }
 
 
 
 bool btc_config_remove(const char *section, const char *key)
 {
-    assert(config != NULL);
+    assert(store != NULL);
     assert(section != NULL);
     assert(key != NULL);
 
-    return config_remove_key(config, section, key);
+    int index;
+    btc_config_record_t *record = btc_config_find(section, key, &index);
+    if (!record) {
+        return false;
+    }
+
+    int slot = btc_config_find_slot(section);
+    record->present &= ~(1u << index);
+    record->len[index] = 0;
+    memset((uint8_t *)record + btc_config_keys[index].offset, 0, btc_config_keys[index].size);
+
+    // a section without keys does not exist
+    if (!record->present) {
+        return bond_store_remove(store, slot);
+    }
+    bond_store_mark_dirty(store, slot);
+    return true;
 }
 
 bool btc_config_remove_section(const char *section)
 {
-    assert(config != NULL);
+    assert(store != NULL);
     assert(section != NULL);
 
-    return config_remove_section(config, section);
+    return bond_store_remove(store, btc_config_find_slot(section));
 }
 
 void btc_config_flush(void)
 {
-    assert(config != NULL);
+    assert(store != NULL);
 
-    config_save(config, CONFIG_FILE_PATH);
+    bond_store_flush(store);
 }
 
 int btc_config_clear(void)
 {
-    assert(config != NULL);
-
-    config_free(config);
+    assert(store != NULL);
 
-    config = config_new_empty();
-    if (config == NULL) {
-        return false;
-    }
-    int ret = config_save(config, CONFIG_FILE_PATH);
-    return ret;
+    return bond_store_clear(store);
 }
 
 void btc_config_lock(void)
@@ -337,4 +578,3 @@ void btc_config_unlock(void)
 {
     osi_mutex_unlock(&lock);
 }
-
@@ -21,6 +21,7 @@
 #include "osi/alarm.h"
 #include "btc/btc_ble_storage.h"
 #include "btc_gap_ble.h"
+#include "btc_gatts.h"
 #include "bta_gattc_int.h"
 #include "bta_gatts_int.h"
 #include "bta_dm_int.h"
@@ -81,6 +82,9 @@ static void btc_deinit_bluetooth(void)
     bta_gatts_deinit();
 #endif /* #if (GATTS_INCLUDED) */
     bte_main_shutdown();
+#if (GATTS_INCLUDED)
+    btc_gatts_deinit();
+#endif /* #if (GATTS_INCLUDED) */
 #if (SMP_INCLUDED)
     btc_config_clean_up();
 #endif
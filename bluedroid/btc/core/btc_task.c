@@ -187,6 +187,9 @@ int btc_init(void)
     btc_gap_callback_init();
 #if SCAN_QUEUE_CONGEST_CHECK
     btc_adv_list_init();
+#endif
+#if (BTC_SCAN_RPT_FILTER_INCLUDED == TRUE)
+    btc_scan_rpt_init();
 #endif
     /* TODO: initial the profile_tab */
     return BT_STATUS_SUCCESS;
@@ -203,6 +206,9 @@ void btc_deinit(void)
 #if SCAN_QUEUE_CONGEST_CHECK
     btc_adv_list_deinit();
 #endif
+#if (BTC_SCAN_RPT_FILTER_INCLUDED == TRUE)
+    btc_scan_rpt_deinit();
+#endif
 }
 
 bool btc_check_queue_is_congest(void)
@@ -18,10 +18,23 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+#include "osi/bond_store.h"
 #include "stack/bt_types.h"
 
 typedef struct btc_config_section_iter_t btc_config_section_iter_t;
 
+// Sets the storage used for the bonds instead of the built-in backends.
+// Must be called before |btc_config_init|; |backend| must stay valid until
+// |btc_config_clean_up|.
+bool btc_config_set_backend(const bond_store_backend_t *backend);
+
+// Selects the built-in backend used for the bonds: the aos_kv value |name|
+// if |use_kv|, otherwise the file |name|. A NULL |name| selects the default
+// BTC_BOND_STORE_KV_KEY or BTC_BOND_STORE_PATH. Must be called before
+// |btc_config_init|. Returns false if the backend is not built in or |name|
+// is too long.
+bool btc_config_select_backend(bool use_kv, const char *name);
+
 bool btc_config_init(void);
 bool btc_config_shut_down(void);
 bool btc_config_clean_up(void);
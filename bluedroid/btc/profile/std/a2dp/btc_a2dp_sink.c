@@ -27,6 +27,7 @@
 #include "osi/mutex.h"
 #include "osi/thread.h"
 #include "osi/fixed_queue.h"
+#include "osi/spsc_queue.h"
 #include "stack/a2d_api.h"
 #include "stack/a2d_sbc.h"
 #include "bta/bta_av_api.h"
@@ -104,13 +105,13 @@ typedef struct {
 typedef struct {
     BOOLEAN rx_flush; /* discards any incoming data when true */
     UINT8   channel_count;
-    fixed_queue_t *RxSbcQ;
+    spsc_queue_t *RxSbcQ;
     UINT32  sample_rate;
 } tBTC_A2DP_SINK_CB;
 
 static void btc_a2dp_sink_thread_init(UNUSED_ATTR void *context);
 static void btc_a2dp_sink_thread_cleanup(UNUSED_ATTR void *context);
-static void btc_a2dp_sink_flush_q(fixed_queue_t *p_q);
+static void btc_a2dp_sink_flush_q(spsc_queue_t *p_q);
 static void btc_a2dp_sink_rx_flush(void);
 static int btc_a2dp_sink_get_track_frequency(UINT8 frequency);
 static int btc_a2dp_sink_get_track_channel_count(UINT8 channeltype);
@@ -467,7 +468,7 @@ static void btc_a2dp_sink_data_ready(UNUSED_ATTR void *context)
 {
     tBT_SBC_HDR *p_msg;
 
-    if (fixed_queue_is_empty(btc_aa_snk_cb.RxSbcQ)) {
+    if (spsc_queue_is_empty(btc_aa_snk_cb.RxSbcQ)) {
         APPL_TRACE_DEBUG("  QUE  EMPTY ");
     } else {
         if (btc_aa_snk_cb.rx_flush == TRUE) {
@@ -475,13 +476,13 @@ static void btc_a2dp_sink_data_ready(UNUSED_ATTR void *context)
             return;
         }
 
-        while ((p_msg = (tBT_SBC_HDR *)fixed_queue_try_peek_first(btc_aa_snk_cb.RxSbcQ)) != NULL) {
+        while ((p_msg = (tBT_SBC_HDR *)spsc_queue_try_peek_first(btc_aa_snk_cb.RxSbcQ)) != NULL) {
             if (btc_a2dp_sink_state != BTC_A2DP_SINK_STATE_ON) {
                 return;
             }
 
             btc_a2dp_sink_handle_inc_media(p_msg);
-            p_msg = (tBT_SBC_HDR *)fixed_queue_try_dequeue(btc_aa_snk_cb.RxSbcQ);
+            p_msg = (tBT_SBC_HDR *)spsc_queue_try_dequeue(btc_aa_snk_cb.RxSbcQ);
 
             if (p_msg == NULL) {
                 APPL_TRACE_ERROR("Insufficient data in que ");
@@ -661,14 +662,12 @@ static void btc_a2dp_sink_handle_decoder_reset(tBTC_MEDIA_SINK_CFG_UPDATE *p_msg
  *******************************************************************************/
 static void btc_a2dp_sink_handle_inc_media(tBT_SBC_HDR *p_msg)
 {
-    UINT8 *sbc_start_frame = ((UINT8 *)(p_msg + 1) + p_msg->offset + 1);
-    int count;
-    UINT32 pcmBytes, availPcmBytes;
-    OI_INT16 *pcmDataPointer = btc_sbc_pcm_data; /*Will be overwritten on next packet receipt*/
+    const OI_BYTE *sbc_start_frame = ((const OI_BYTE *)(p_msg + 1) + p_msg->offset + 1);
+    OI_UINT32 pcmBytes = BTC_SBC_DEC_PCM_DATA_LEN * sizeof(OI_INT16);
     OI_STATUS status;
+    OI_UINT frames_decoded = 0;
     int num_sbc_frames = p_msg->num_frames_to_be_processed;
-    UINT32 sbc_frame_len = p_msg->len - 1;
-    availPcmBytes = BTC_SBC_DEC_PCM_DATA_LEN * sizeof(OI_INT16);
+    OI_UINT32 sbc_frame_len = p_msg->len - 1;
 
     /* XXX: Check if the below check is correct, we are checking for peer to be sink when we are sink */
     if (btc_av_get_peer_sep() == AVDT_TSEP_SNK || (btc_aa_snk_cb.rx_flush)) {
@@ -681,27 +680,20 @@ static void btc_a2dp_sink_handle_inc_media(tBT_SBC_HDR *p_msg)
         return;
     }
 
-    APPL_TRACE_DEBUG("Number of sbc frames %d, frame_len %d\n", num_sbc_frames, sbc_frame_len);
+    APPL_TRACE_DEBUG("Number of sbc frames %d, frame_len %d\n", num_sbc_frames, (int)sbc_frame_len);
 
-    for (count = 0; count < num_sbc_frames && sbc_frame_len != 0; count ++) {
-        pcmBytes = availPcmBytes;
-        status = OI_CODEC_SBC_DecodeFrame(&btc_sbc_decoder_context, (const OI_BYTE **)&sbc_start_frame,
-                                          (OI_UINT32 *)&sbc_frame_len,
-                                          (OI_INT16 *)pcmDataPointer,
-                                          (OI_UINT32 *)&pcmBytes);
-
-        if (!OI_SUCCESS(status)) {
-            APPL_TRACE_ERROR("Decoding failure: %d\n", status);
-            break;
-        }
-
-        availPcmBytes -= pcmBytes;
-        pcmDataPointer += pcmBytes / 2;
-        p_msg->offset += (p_msg->len - 1) - sbc_frame_len;
-        p_msg->len = sbc_frame_len + 1;
+    /* Decode the whole media packet in one call; the PCM of all frames is written back to back */
+    status = OI_CODEC_SBC_DecodeFrames(&btc_sbc_decoder_context, &sbc_start_frame, &sbc_frame_len,
+                                       (num_sbc_frames > 0) ? (OI_UINT)num_sbc_frames : 0, btc_sbc_pcm_data, &pcmBytes,
+                                       &frames_decoded);
+    if (!OI_SUCCESS(status)) {
+        APPL_TRACE_ERROR("Decoding failure: %d after %d of %d frames\n", status, frames_decoded, num_sbc_frames);
     }
 
-    btc_a2d_data_cb_to_app((uint8_t *)btc_sbc_pcm_data, (BTC_SBC_DEC_PCM_DATA_LEN * sizeof(OI_INT16) - availPcmBytes));
+    p_msg->offset += (p_msg->len - 1) - sbc_frame_len;
+    p_msg->len = sbc_frame_len + 1;
+
+    btc_a2d_data_cb_to_app((uint8_t *)btc_sbc_pcm_data, pcmBytes);
 }
 
 /*******************************************************************************
@@ -715,7 +707,7 @@ static void btc_a2dp_sink_handle_inc_media(tBT_SBC_HDR *p_msg)
  *******************************************************************************/
 BOOLEAN btc_a2dp_sink_rx_flush_req(void)
 {
-    if (fixed_queue_is_empty(btc_aa_snk_cb.RxSbcQ) == TRUE) { /*  Que is already empty */
+    if (spsc_queue_is_empty(btc_aa_snk_cb.RxSbcQ) == TRUE) { /*  Que is already empty */
         return TRUE;
     }
 
@@ -802,12 +794,12 @@ UINT8 btc_a2dp_sink_enque_buf(BT_HDR *p_pkt)
     }
 
     if (btc_aa_snk_cb.rx_flush == TRUE) { /* Flush enabled, do not enque*/
-        return fixed_queue_length(btc_aa_snk_cb.RxSbcQ);
+        return spsc_queue_length(btc_aa_snk_cb.RxSbcQ);
     }
 
-    if (fixed_queue_length(btc_aa_snk_cb.RxSbcQ) >= MAX_OUTPUT_A2DP_SNK_FRAME_QUEUE_SZ) {
+    if (spsc_queue_length(btc_aa_snk_cb.RxSbcQ) >= MAX_OUTPUT_A2DP_SNK_FRAME_QUEUE_SZ) {
         APPL_TRACE_WARNING("Pkt dropped\n");
-        return fixed_queue_length(btc_aa_snk_cb.RxSbcQ);
+        return spsc_queue_length(btc_aa_snk_cb.RxSbcQ);
     }
 
     APPL_TRACE_DEBUG("btc_a2dp_sink_enque_buf + ");
@@ -818,14 +810,14 @@ UINT8 btc_a2dp_sink_enque_buf(BT_HDR *p_pkt)
         memcpy(p_msg, p_pkt, (sizeof(BT_HDR) + p_pkt->offset + p_pkt->len));
         p_msg->num_frames_to_be_processed = (*((UINT8 *)(p_msg + 1) + p_msg->offset)) & 0x0f;
         APPL_TRACE_VERBOSE("btc_a2dp_sink_enque_buf %d + \n", p_msg->num_frames_to_be_processed);
-        fixed_queue_enqueue(btc_aa_snk_cb.RxSbcQ, p_msg);
+        spsc_queue_enqueue(btc_aa_snk_cb.RxSbcQ, p_msg);
         btc_a2dp_sink_data_post(BTC_A2DP_SINK_DATA_EVT);
     } else {
         /* let caller deal with a failed allocation */
         APPL_TRACE_WARNING("btc_a2dp_sink_enque_buf No Buffer left - ");
     }
 
-    return fixed_queue_length(btc_aa_snk_cb.RxSbcQ);
+    return spsc_queue_length(btc_aa_snk_cb.RxSbcQ);
 }
 
 static void btc_a2dp_sink_handle_clear_track(void)
@@ -842,10 +834,10 @@ static void btc_a2dp_sink_handle_clear_track(void)
  ** Returns          void
  **
  *******************************************************************************/
-static void btc_a2dp_sink_flush_q(fixed_queue_t *p_q)
+static void btc_a2dp_sink_flush_q(spsc_queue_t *p_q)
 {
-    while (! fixed_queue_is_empty(p_q)) {
-        osi_free(fixed_queue_try_dequeue(p_q));
+    while (! spsc_queue_is_empty(p_q)) {
+        osi_free(spsc_queue_try_dequeue(p_q));
     }
 }
 
@@ -856,7 +848,7 @@ static void btc_a2dp_sink_thread_init(UNUSED_ATTR void *context)
 
     btc_a2dp_sink_state = BTC_A2DP_SINK_STATE_ON;
 
-    btc_aa_snk_cb.RxSbcQ = fixed_queue_new(QUEUE_SIZE_MAX);
+    btc_aa_snk_cb.RxSbcQ = spsc_queue_new(QUEUE_SIZE_MAX);
 
     btc_a2dp_control_init();
 }
@@ -869,7 +861,7 @@ static void btc_a2dp_sink_thread_cleanup(UNUSED_ATTR void *context)
 
     btc_a2dp_control_cleanup();
 
-    fixed_queue_free(btc_aa_snk_cb.RxSbcQ, osi_free_func);
+    spsc_queue_free(btc_aa_snk_cb.RxSbcQ, osi_free_func);
 
     future_ready(btc_a2dp_sink_future, NULL);
 }
@@ -30,6 +30,7 @@
 #include "osi/thread.h"
 #include "osi/mutex.h"
 #include "osi/fixed_queue.h"
+#include "osi/spsc_queue.h"
 #include "stack/a2d_api.h"
 #include "stack/a2d_sbc.h"
 #include "bta/bta_av_api.h"
@@ -152,7 +153,7 @@ typedef struct {
     BOOLEAN is_tx_timer;
     UINT16 TxAaMtuSize;
     UINT32 timestamp;
-    fixed_queue_t *TxAaQ;
+    spsc_queue_t *TxAaQ;
     tBTC_AV_FEEDING_MODE feeding_mode;
     tBTC_AV_MEDIA_FEEDINGS_STATE media_feeding_state;
     tBTC_AV_MEDIA_FEEDINGS media_feeding;
@@ -161,7 +162,7 @@ typedef struct {
 
 static void btc_a2dp_source_thread_init(UNUSED_ATTR void *context);
 static void btc_a2dp_source_thread_cleanup(UNUSED_ATTR void *context);
-static void btc_a2dp_source_flush_q(fixed_queue_t *p_q);
+static void btc_a2dp_source_flush_q(spsc_queue_t *p_q);
 
 static void btc_a2dp_source_feeding_state_reset(void);
 static void btc_a2dp_source_send_aa_frame(void);
@@ -480,7 +481,7 @@ static void log_tstamps_us(char *comment)
     const UINT64 now_us = time_now_us();
     (void)prev_us;
     APPL_TRACE_DEBUG("[%s] ts %08llu, diff : %08llu, queue sz %d", comment, now_us, now_us - prev_us,
-                     fixed_queue_length(btc_aa_src_cb.TxAaQ));
+                     spsc_queue_length(btc_aa_src_cb.TxAaQ));
     prev_us = now_us;
 }
 
@@ -547,7 +548,7 @@ BT_HDR *btc_a2dp_source_audio_readbuf(void)
     if (btc_a2dp_source_state != BTC_A2DP_SOURCE_STATE_ON){
         return NULL;
     }
-    return fixed_queue_try_dequeue(btc_aa_src_cb.TxAaQ);
+    return spsc_queue_try_dequeue(btc_aa_src_cb.TxAaQ);
 }
 
 /*******************************************************************************
@@ -1332,7 +1333,7 @@ static void btc_media_aa_prep_sbc_2_send(UINT8 nb_frame)
     while (nb_frame) {
         if (NULL == (p_buf = osi_malloc(BTC_MEDIA_AA_BUF_SIZE))) {
             APPL_TRACE_ERROR ("ERROR btc_media_aa_prep_sbc_2_send no buffer TxCnt %d ",
-                              fixed_queue_length(btc_aa_src_cb.TxAaQ));
+                              spsc_queue_length(btc_aa_src_cb.TxAaQ));
             return;
         }
 
@@ -1389,7 +1390,7 @@ static void btc_media_aa_prep_sbc_2_send(UINT8 nb_frame)
             if (btc_aa_src_cb.tx_flush) {
                 APPL_TRACE_DEBUG("### tx suspended, discarded frame ###");
 
-                if (fixed_queue_length(btc_aa_src_cb.TxAaQ) > 0) {
+                if (spsc_queue_length(btc_aa_src_cb.TxAaQ) > 0) {
                     btc_a2dp_source_flush_q(btc_aa_src_cb.TxAaQ);
                 }
 
@@ -1398,7 +1399,7 @@ static void btc_media_aa_prep_sbc_2_send(UINT8 nb_frame)
             }
 
             /* Enqueue the encoded SBC frame in AA Tx Queue */
-            fixed_queue_enqueue(btc_aa_src_cb.TxAaQ, p_buf);
+            spsc_queue_enqueue(btc_aa_src_cb.TxAaQ, p_buf);
         } else {
             osi_free(p_buf);
         }
@@ -1421,13 +1422,13 @@ static void btc_a2dp_source_prep_2_send(UINT8 nb_frame)
         nb_frame = MAX_OUTPUT_A2DP_SRC_FRAME_QUEUE_SZ;
     }
 
-    if (fixed_queue_length(btc_aa_src_cb.TxAaQ) > (MAX_OUTPUT_A2DP_SRC_FRAME_QUEUE_SZ - nb_frame)) {
+    if (spsc_queue_length(btc_aa_src_cb.TxAaQ) > (MAX_OUTPUT_A2DP_SRC_FRAME_QUEUE_SZ - nb_frame)) {
         APPL_TRACE_WARNING("TX Q overflow: %d/%d",
-                           fixed_queue_length(btc_aa_src_cb.TxAaQ), MAX_OUTPUT_A2DP_SRC_FRAME_QUEUE_SZ - nb_frame);
+                           spsc_queue_length(btc_aa_src_cb.TxAaQ), MAX_OUTPUT_A2DP_SRC_FRAME_QUEUE_SZ - nb_frame);
     }
 
-    while (fixed_queue_length(btc_aa_src_cb.TxAaQ) > (MAX_OUTPUT_A2DP_SRC_FRAME_QUEUE_SZ - nb_frame)) {
-        osi_free(fixed_queue_try_dequeue(btc_aa_src_cb.TxAaQ));
+    while (spsc_queue_length(btc_aa_src_cb.TxAaQ) > (MAX_OUTPUT_A2DP_SRC_FRAME_QUEUE_SZ - nb_frame)) {
+        osi_free(spsc_queue_try_dequeue(btc_aa_src_cb.TxAaQ));
     }
 
     // Transcode frame
@@ -1541,7 +1542,7 @@ static void btc_a2dp_source_aa_start_tx(void)
 
     assert(btc_aa_src_cb.media_alarm == NULL);
 
-    btc_aa_src_cb.media_alarm = osi_alarm_new("aaTx", btc_a2dp_source_alarm_cb, NULL, BTC_MEDIA_TIME_TICK_MS);
+    btc_aa_src_cb.media_alarm = osi_alarm_new_ext("aaTx", btc_a2dp_source_alarm_cb, NULL, NULL);
 
     if (!btc_aa_src_cb.media_alarm) {
         BTC_TRACE_ERROR("%s unable to allocate media alarm.", __func__);
@@ -1606,10 +1607,10 @@ static void btc_a2dp_source_aa_stop_tx(void)
  ** Returns          void
  **
  *******************************************************************************/
-static void btc_a2dp_source_flush_q(fixed_queue_t *p_q)
+static void btc_a2dp_source_flush_q(spsc_queue_t *p_q)
 {
-    while (! fixed_queue_is_empty(p_q)) {
-        osi_free(fixed_queue_try_dequeue(p_q));
+    while (! spsc_queue_is_empty(p_q)) {
+        osi_free(spsc_queue_try_dequeue(p_q));
     }
 }
 
@@ -1620,7 +1621,7 @@ static void btc_a2dp_source_thread_init(UNUSED_ATTR void *context)
 
     btc_a2dp_source_state = BTC_A2DP_SOURCE_STATE_ON;
 
-    btc_aa_src_cb.TxAaQ = fixed_queue_new(QUEUE_SIZE_MAX);
+    btc_aa_src_cb.TxAaQ = spsc_queue_new(QUEUE_SIZE_MAX);
 
     btc_a2dp_control_init();
 }
@@ -1633,7 +1634,7 @@ static void btc_a2dp_source_thread_cleanup(UNUSED_ATTR void *context)
 
     btc_a2dp_control_cleanup();
 
-    fixed_queue_free(btc_aa_src_cb.TxAaQ, osi_free_func);
+    spsc_queue_free(btc_aa_src_cb.TxAaQ, osi_free_func);
 
     future_ready(btc_a2dp_source_future, NULL);
 }
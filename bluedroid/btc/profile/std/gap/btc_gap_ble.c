@@ -29,6 +29,9 @@
 #include "btc/btc_dm.h"
 #include "btc/btc_util.h"
 #include "osi/mutex.h"
+#include "osi/alarm.h"
+#include "osi/thread.h"
+#include "stack/btu.h"
 
 static tBTA_BLE_ADV_DATA gl_bta_adv_data;
 static tBTA_BLE_ADV_DATA gl_bta_scan_rsp_data;
@@ -519,6 +522,378 @@ static void btc_ble_set_scan_params(yoc_ble_scan_params_t *scan_params, tBLE_SCA
     }
 }
 
+#if (BTC_SCAN_RPT_FILTER_INCLUDED == TRUE)
+/* Scan report filter, written by the BTC task and read by the BTU task under scan_rpt_lock */
+typedef struct {
+    uint8_t         mask;
+    int8_t          rssi_floor;
+    uint8_t         uuid_len;
+    uint8_t         uuid[LEN_UUID_128];         /* little endian, as found in the advertising data */
+    uint8_t         manuf_prefix_len;
+    uint8_t         manuf_prefix[YOC_BLE_SCAN_RPT_MANUF_PREFIX_MAX];
+    uint8_t         addr_num;
+    BD_ADDR         addr_list[YOC_BLE_SCAN_RPT_ADDR_LIST_MAX];
+    uint16_t        rate_limit_ms;
+    uint8_t         batch_num;
+    uint16_t        batch_timeout_ms;
+} btc_scan_rpt_cfg_t;
+
+/* Last time a device was reported, for the rate limit */
+typedef struct {
+    BD_ADDR         bda;
+    uint32_t        last_ms;
+} btc_scan_rpt_rate_t;
+
+static osi_mutex_t scan_rpt_lock;
+static volatile bool scan_rpt_active;
+static btc_scan_rpt_cfg_t scan_rpt_cfg;
+static btc_scan_rpt_rate_t *scan_rpt_rate;
+
+/* Batch being filled, only touched by the BTU task */
+static yoc_ble_gap_cb_param_t *scan_rpt_batch;
+static uint16_t scan_rpt_batch_num;
+static uint16_t scan_rpt_batch_cap;
+static uint32_t scan_rpt_batch_start;
+static osi_alarm_t *scan_rpt_alarm;
+static TIMER_LIST_ENT scan_rpt_flush_tle;
+
+static void btc_scan_rpt_flush_timeout(TIMER_LIST_ENT *p_tle);
+
+static void btc_scan_rpt_alarm_cb(void *data)
+{
+    UNUSED(data);
+
+    /* flush in the BTU task, which owns the batch */
+    scan_rpt_flush_tle.event = BTU_TTYPE_USER_FUNC;
+    scan_rpt_flush_tle.param = (TIMER_PARAM_TYPE)btc_scan_rpt_flush_timeout;
+    if (btu_task_post(SIG_BTU_GENERAL_ALARM, &scan_rpt_flush_tle, TASK_POST_NON_BLOCKING) != TASK_POST_SUCCESS) {
+        BTC_TRACE_WARNING("%s post failed, batch flushed by next report", __func__);
+    }
+}
+
+static void btc_scan_rpt_fill(yoc_ble_gap_cb_param_t *param, tBTA_DM_SEARCH *p_data)
+{
+    param->scan_rst.search_evt = BTA_DM_INQ_RES_EVT;
+    bdcpy(param->scan_rst.bda, p_data->inq_res.bd_addr);
+    param->scan_rst.dev_type = p_data->inq_res.device_type;
+    param->scan_rst.rssi = p_data->inq_res.rssi;
+    param->scan_rst.ble_addr_type = p_data->inq_res.ble_addr_type;
+    param->scan_rst.ble_evt_type = p_data->inq_res.ble_evt_type;
+    param->scan_rst.flag = p_data->inq_res.flag;
+    param->scan_rst.num_resps = 1;
+    param->scan_rst.adv_data_len = p_data->inq_res.adv_data_len;
+    param->scan_rst.scan_rsp_len = p_data->inq_res.scan_rsp_len;
+    memcpy(param->scan_rst.ble_adv, p_data->inq_res.p_eir, sizeof(param->scan_rst.ble_adv));
+}
+
+/* Runs in the BTU task. Hands the scan results gathered so far to the BTC task in one message. */
+static void btc_scan_rpt_flush(void)
+{
+    btc_msg_t msg;
+    btc_ble_scan_rpt_batch_t batch;
+
+    if (scan_rpt_batch_num == 0) {
+        return;
+    }
+
+    if (scan_rpt_alarm) {
+        osi_alarm_cancel(scan_rpt_alarm);
+    }
+
+    msg.sig = BTC_SIG_API_CB;
+    msg.pid = BTC_PID_GAP_BLE;
+    msg.act = BTC_GAP_BLE_SCAN_RPT_BATCH_EVT;
+    batch.num = scan_rpt_batch_num;
+    batch.rst = scan_rpt_batch;
+
+    scan_rpt_batch = NULL;
+    scan_rpt_batch_num = 0;
+    scan_rpt_batch_cap = 0;
+
+    if (btc_transfer_context(&msg, &batch, sizeof(btc_ble_scan_rpt_batch_t), NULL) != BT_STATUS_SUCCESS) {
+        BTC_TRACE_ERROR("%s btc_transfer_context failed, %d results lost\n", __func__, batch.num);
+        osi_free(batch.rst);
+    }
+}
+
+static void btc_scan_rpt_flush_timeout(TIMER_LIST_ENT *p_tle)
+{
+    UNUSED(p_tle);
+
+    btc_scan_rpt_flush();
+}
+
+static bool btc_scan_rpt_has_uuid(const btc_scan_rpt_cfg_t *cfg, const uint8_t *p_val, uint8_t val_len)
+{
+    for (; val_len >= cfg->uuid_len; p_val += cfg->uuid_len, val_len -= cfg->uuid_len) {
+        if (memcmp(p_val, cfg->uuid, cfg->uuid_len) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Walks the AD structures of one advertising or scan response payload once,
+   looking for the service UUID and the manufacturer data prefix */
+static void btc_scan_rpt_check_data(const btc_scan_rpt_cfg_t *cfg, const uint8_t *p_data, uint16_t data_len,
+                                    bool *p_uuid_found, bool *p_manuf_found)
+{
+    const uint8_t *p = p_data;
+    const uint8_t *p_end = p_data + data_len;
+    uint8_t len, type, uuid_len;
+
+    while (p < p_end && !(*p_uuid_found && *p_manuf_found)) {
+        len = p[0];
+        if (len == 0 || p + 1 + len > p_end) {
+            break;
+        }
+        type = p[1];
+
+        switch (type) {
+        case BTM_BLE_AD_TYPE_16SRV_PART:
+        case BTM_BLE_AD_TYPE_16SRV_CMPL:
+            uuid_len = LEN_UUID_16;
+            break;
+        case BTM_BLE_AD_TYPE_32SRV_PART:
+        case BTM_BLE_AD_TYPE_32SRV_CMPL:
+            uuid_len = LEN_UUID_32;
+            break;
+        case BTM_BLE_AD_TYPE_128SRV_PART:
+        case BTM_BLE_AD_TYPE_128SRV_CMPL:
+            uuid_len = LEN_UUID_128;
+            break;
+        case BTM_BLE_AD_TYPE_MANU:
+            if (!*p_manuf_found && len - 1 >= cfg->manuf_prefix_len) {
+                *p_manuf_found = (memcmp(p + 2, cfg->manuf_prefix, cfg->manuf_prefix_len) == 0);
+            }
+            uuid_len = 0;
+            break;
+        default:
+            uuid_len = 0;
+            break;
+        }
+
+        if (uuid_len != 0 && uuid_len == cfg->uuid_len && !*p_uuid_found) {
+            *p_uuid_found = btc_scan_rpt_has_uuid(cfg, p + 2, len - 1);
+        }
+        p += 1 + len;
+    }
+}
+
+/* Runs in the BTU task with scan_rpt_lock held. Returns true if the scan result is to be reported. */
+static bool btc_scan_rpt_check(const btc_scan_rpt_cfg_t *cfg, tBTA_DM_INQ_RES *p_res)
+{
+    if ((cfg->mask & YOC_BLE_SCAN_RPT_FILTER_RSSI) && p_res->rssi < cfg->rssi_floor) {
+        return false;
+    }
+
+    if (cfg->mask & YOC_BLE_SCAN_RPT_FILTER_ADDR) {
+        uint8_t i;
+        for (i = 0; i < cfg->addr_num; i++) {
+            if (bdcmp(p_res->bd_addr, cfg->addr_list[i]) == 0) {
+                break;
+            }
+        }
+        if (i == cfg->addr_num) {
+            return false;
+        }
+    }
+
+    if (cfg->mask & (YOC_BLE_SCAN_RPT_FILTER_UUID | YOC_BLE_SCAN_RPT_FILTER_MANUF)) {
+        bool uuid_found = !(cfg->mask & YOC_BLE_SCAN_RPT_FILTER_UUID);
+        bool manuf_found = !(cfg->mask & YOC_BLE_SCAN_RPT_FILTER_MANUF);
+
+        if (p_res->p_eir) {
+            btc_scan_rpt_check_data(cfg, p_res->p_eir, p_res->adv_data_len, &uuid_found, &manuf_found);
+            btc_scan_rpt_check_data(cfg, p_res->p_eir + p_res->adv_data_len, p_res->scan_rsp_len,
+                                    &uuid_found, &manuf_found);
+        }
+        if (!uuid_found || !manuf_found) {
+            return false;
+        }
+    }
+
+    if ((cfg->mask & YOC_BLE_SCAN_RPT_FILTER_RATE) && scan_rpt_rate) {
+        const uint8_t *a = p_res->bd_addr;
+        uint32_t now = osi_time_get_os_boottime_ms();
+        btc_scan_rpt_rate_t *p_set = &scan_rpt_rate[((a[3] ^ a[4] ^ a[5]) & (BTC_SCAN_RPT_RATE_SLOTS / 2 - 1)) * 2];
+        btc_scan_rpt_rate_t *p_rate;
+
+        /* two way set, the limit only applies to the device owning the slot */
+        if (bdcmp(p_set[0].bda, p_res->bd_addr) == 0) {
+            p_rate = &p_set[0];
+        } else if (bdcmp(p_set[1].bda, p_res->bd_addr) == 0) {
+            p_rate = &p_set[1];
+        } else {
+            /* new device, replace the one reported longest ago */
+            p_rate = (now - p_set[0].last_ms >= now - p_set[1].last_ms) ? &p_set[0] : &p_set[1];
+            bdcpy(p_rate->bda, p_res->bd_addr);
+            p_rate->last_ms = now;
+            return true;
+        }
+
+        if (now - p_rate->last_ms < cfg->rate_limit_ms) {
+            return false;
+        }
+        p_rate->last_ms = now;
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+**
+** Function         btc_scan_rpt_filter
+**
+** Description      Filter a scan result in the BTU task.
+**
+** Returns          false if the scan result is dropped, true if it passes. The
+**                  batch settings to use for it are returned in p_batch_num
+**                  and p_batch_timeout_ms.
+**
+*******************************************************************************/
+static bool btc_scan_rpt_filter(tBTA_DM_SEARCH *p_data, uint16_t *p_batch_num, uint16_t *p_batch_timeout_ms)
+{
+    *p_batch_num = 0;
+    *p_batch_timeout_ms = 0;
+
+    if (!scan_rpt_active) {
+        /* results batched before the filter was cleared go first */
+        btc_scan_rpt_flush();
+        return true;
+    }
+
+    osi_mutex_lock(&scan_rpt_lock, OSI_MUTEX_MAX_TIMEOUT);
+    if (!btc_scan_rpt_check(&scan_rpt_cfg, &p_data->inq_res)) {
+        osi_mutex_unlock(&scan_rpt_lock);
+        return false;
+    }
+    *p_batch_num = scan_rpt_cfg.batch_num;
+    *p_batch_timeout_ms = scan_rpt_cfg.batch_timeout_ms;
+    osi_mutex_unlock(&scan_rpt_lock);
+
+    return true;
+}
+
+/*******************************************************************************
+**
+** Function         btc_scan_rpt_batch
+**
+** Description      Add a scan result that passed the filter to the current
+**                  batch.
+**
+** Returns          true if the scan result was consumed, false if it is to be
+**                  sent to the BTC task on its own.
+**
+*******************************************************************************/
+static bool btc_scan_rpt_batch(tBTA_DM_SEARCH *p_data, uint16_t batch_num, uint16_t batch_timeout_ms)
+{
+    uint32_t now;
+
+    if (batch_num <= 1) {
+        btc_scan_rpt_flush();
+        return false;
+    }
+
+    now = osi_time_get_os_boottime_ms();
+    if (scan_rpt_batch_num == 0) {
+        scan_rpt_batch = (yoc_ble_gap_cb_param_t *)osi_malloc(batch_num * sizeof(yoc_ble_gap_cb_param_t));
+        if (scan_rpt_batch == NULL) {
+            return false;
+        }
+        scan_rpt_batch_cap = batch_num;
+        scan_rpt_batch_start = now;
+        if (batch_timeout_ms && scan_rpt_alarm) {
+            osi_alarm_set(scan_rpt_alarm, batch_timeout_ms);
+        }
+    }
+
+    btc_scan_rpt_fill(&scan_rpt_batch[scan_rpt_batch_num++], p_data);
+
+    if (scan_rpt_batch_num >= scan_rpt_batch_cap
+        || (batch_timeout_ms && now - scan_rpt_batch_start >= batch_timeout_ms)) {
+        btc_scan_rpt_flush();
+    }
+    return true;
+}
+
+static void btc_ble_set_scan_rpt_filter(const yoc_ble_scan_report_filter_t *filter)
+{
+    btc_scan_rpt_rate_t *p_rate_free = NULL;
+
+    osi_mutex_lock(&scan_rpt_lock, OSI_MUTEX_MAX_TIMEOUT);
+    memset(&scan_rpt_cfg, 0, sizeof(btc_scan_rpt_cfg_t));
+    if (filter) {
+        scan_rpt_cfg.mask = filter->filter_mask;
+        scan_rpt_cfg.rssi_floor = filter->rssi_floor;
+        if (filter->filter_mask & YOC_BLE_SCAN_RPT_FILTER_UUID) {
+            uint8_t *p = scan_rpt_cfg.uuid;
+            scan_rpt_cfg.uuid_len = (uint8_t)filter->service_uuid.len;
+            if (filter->service_uuid.len == LEN_UUID_16) {
+                UINT16_TO_STREAM(p, filter->service_uuid.uuid.uuid16);
+            } else if (filter->service_uuid.len == LEN_UUID_32) {
+                UINT32_TO_STREAM(p, filter->service_uuid.uuid.uuid32);
+            } else {
+                memcpy(p, filter->service_uuid.uuid.uuid128, LEN_UUID_128);
+            }
+        }
+        scan_rpt_cfg.manuf_prefix_len = filter->manuf_prefix_len;
+        memcpy(scan_rpt_cfg.manuf_prefix, filter->manuf_prefix, filter->manuf_prefix_len);
+        scan_rpt_cfg.addr_num = filter->addr_num;
+        memcpy(scan_rpt_cfg.addr_list, filter->addr_list, filter->addr_num * sizeof(BD_ADDR));
+        scan_rpt_cfg.rate_limit_ms = filter->rate_limit_ms;
+        scan_rpt_cfg.batch_num = filter->batch_num;
+        scan_rpt_cfg.batch_timeout_ms = filter->batch_timeout_ms;
+    }
+
+    if (scan_rpt_cfg.mask & YOC_BLE_SCAN_RPT_FILTER_RATE) {
+        if (scan_rpt_rate == NULL) {
+            scan_rpt_rate = (btc_scan_rpt_rate_t *)osi_calloc(BTC_SCAN_RPT_RATE_SLOTS * sizeof(btc_scan_rpt_rate_t));
+        }
+    } else {
+        p_rate_free = scan_rpt_rate;
+        scan_rpt_rate = NULL;
+    }
+
+    if (scan_rpt_cfg.batch_num > 1 && scan_rpt_alarm == NULL) {
+        scan_rpt_alarm = osi_alarm_new_ext("scan_rpt", btc_scan_rpt_alarm_cb, NULL, NULL);
+    }
+
+    scan_rpt_active = (scan_rpt_cfg.mask != 0 || scan_rpt_cfg.batch_num > 1);
+    osi_mutex_unlock(&scan_rpt_lock);
+
+    if (p_rate_free) {
+        osi_free(p_rate_free);
+    }
+}
+
+void btc_scan_rpt_init(void)
+{
+    osi_mutex_new(&scan_rpt_lock);
+    scan_rpt_active = false;
+}
+
+void btc_scan_rpt_deinit(void)
+{
+    scan_rpt_active = false;
+    if (scan_rpt_alarm) {
+        osi_alarm_free(scan_rpt_alarm);
+        scan_rpt_alarm = NULL;
+    }
+    if (scan_rpt_batch) {
+        osi_free(scan_rpt_batch);
+        scan_rpt_batch = NULL;
+        scan_rpt_batch_num = 0;
+        scan_rpt_batch_cap = 0;
+    }
+    if (scan_rpt_rate) {
+        osi_free(scan_rpt_rate);
+        scan_rpt_rate = NULL;
+    }
+    osi_mutex_free(&scan_rpt_lock);
+}
+#endif /* BTC_SCAN_RPT_FILTER_INCLUDED == TRUE */
+
 static void btc_search_callback(tBTA_DM_SEARCH_EVT event, tBTA_DM_SEARCH *p_data)
 {
     yoc_ble_gap_cb_param_t param;
@@ -531,6 +906,14 @@ static void btc_search_callback(tBTA_DM_SEARCH_EVT event, tBTA_DM_SEARCH *p_data
     param.scan_rst.search_evt = event;
     switch (event) {
     case BTA_DM_INQ_RES_EVT: {
+#if (BTC_SCAN_RPT_FILTER_INCLUDED == TRUE)
+        uint16_t batch_num, batch_timeout_ms;
+
+        /* filtered out results neither load the BTC queue nor count as reported */
+        if (!btc_scan_rpt_filter(p_data, &batch_num, &batch_timeout_ms)) {
+            return;
+        }
+#endif
 #if SCAN_QUEUE_CONGEST_CHECK
         if(btc_check_queue_is_congest()) {
             BTC_TRACE_DEBUG("BtcQueue is congested");
@@ -544,6 +927,12 @@ static void btc_search_callback(tBTA_DM_SEARCH_EVT event, tBTA_DM_SEARCH *p_data
         }
         btc_adv_list_count ++;
 #endif
+#if (BTC_SCAN_RPT_FILTER_INCLUDED == TRUE)
+        if (btc_scan_rpt_batch(p_data, batch_num, batch_timeout_ms)) {
+            return;
+        }
+        btc_scan_rpt_fill(&param, p_data);
+#else
         bdcpy(param.scan_rst.bda, p_data->inq_res.bd_addr);
         param.scan_rst.dev_type = p_data->inq_res.device_type;
         param.scan_rst.rssi = p_data->inq_res.rssi;
@@ -554,9 +943,13 @@ static void btc_search_callback(tBTA_DM_SEARCH_EVT event, tBTA_DM_SEARCH *p_data
         param.scan_rst.adv_data_len = p_data->inq_res.adv_data_len;
         param.scan_rst.scan_rsp_len = p_data->inq_res.scan_rsp_len;
         memcpy(param.scan_rst.ble_adv, p_data->inq_res.p_eir, sizeof(param.scan_rst.ble_adv));
+#endif
         break;
     }
     case BTA_DM_INQ_CMPL_EVT: {
+#if (BTC_SCAN_RPT_FILTER_INCLUDED == TRUE)
+        btc_scan_rpt_flush();
+#endif
         param.scan_rst.num_resps = p_data->inq_cmpl.num_resps;
         BTC_TRACE_DEBUG("%s  BLE observe complete. Num Resp %d\n", __FUNCTION__, p_data->inq_cmpl.num_resps);
         break;
@@ -613,6 +1006,10 @@ static void btc_stop_scan_callback(tBTA_STATUS status)
     msg.act = YOC_GAP_BLE_SCAN_STOP_COMPLETE_EVT;
     param.scan_stop_cmpl.status = status;
 
+#if (BTC_SCAN_RPT_FILTER_INCLUDED == TRUE)
+    btc_scan_rpt_flush();
+#endif
+
     ret = btc_transfer_context(&msg, &param,
                                sizeof(yoc_ble_gap_cb_param_t), NULL);
 
@@ -860,6 +1257,13 @@ void btc_gap_ble_cb_handler(btc_msg_t *msg)
 
     if (msg->act < YOC_GAP_BLE_EVT_MAX) {
         btc_gap_ble_cb_to_app(msg->act, param);
+#if (BTC_SCAN_RPT_FILTER_INCLUDED == TRUE)
+    } else if (msg->act == BTC_GAP_BLE_SCAN_RPT_BATCH_EVT) {
+        btc_ble_scan_rpt_batch_t *batch = (btc_ble_scan_rpt_batch_t *)msg->arg;
+        for (uint16_t i = 0; i < batch->num; i++) {
+            btc_gap_ble_cb_to_app(YOC_GAP_BLE_SCAN_RESULT_EVT, &batch->rst[i]);
+        }
+#endif
     } else {
         BTC_TRACE_ERROR("%s, unknow msg->act = %d", __func__, msg->act);
     }
@@ -931,6 +1335,20 @@ void btc_gap_ble_arg_deep_copy(btc_msg_t *msg, void *p_dest, void *p_src)
         }
         break;
     }
+    case BTC_GAP_BLE_ACT_SET_SCAN_RPT_FILTER: {
+        btc_ble_gap_args_t *src = (btc_ble_gap_args_t *)p_src;
+        btc_ble_gap_args_t *dst = (btc_ble_gap_args_t *) p_dest;
+
+        if (src->set_scan_rpt_filter.filter) {
+            dst->set_scan_rpt_filter.filter = osi_malloc(sizeof(yoc_ble_scan_report_filter_t));
+            if (dst->set_scan_rpt_filter.filter) {
+                memcpy(dst->set_scan_rpt_filter.filter, src->set_scan_rpt_filter.filter, sizeof(yoc_ble_scan_report_filter_t));
+            } else {
+                BTC_TRACE_ERROR("%s %d no mem\n",__func__, msg->act);
+            }
+        }
+        break;
+    }
     default:
         BTC_TRACE_ERROR("Unhandled deep copy %d\n", msg->act);
         break;
@@ -986,6 +1404,13 @@ void btc_gap_ble_arg_deep_free(btc_msg_t *msg)
         }
         break;
     }
+    case BTC_GAP_BLE_ACT_SET_SCAN_RPT_FILTER: {
+        yoc_ble_scan_report_filter_t *filter = ((btc_ble_gap_args_t *)msg->arg)->set_scan_rpt_filter.filter;
+        if (filter) {
+            osi_free(filter);
+        }
+        break;
+    }
     default:
         BTC_TRACE_DEBUG("Unhandled deep free %d\n", msg->act);
         break;
@@ -996,6 +1421,11 @@ void btc_gap_ble_cb_deep_free(btc_msg_t *msg)
 {
     BTC_TRACE_DEBUG("%s", __func__);
     switch (msg->act) {
+#if (BTC_SCAN_RPT_FILTER_INCLUDED == TRUE)
+        case BTC_GAP_BLE_SCAN_RPT_BATCH_EVT:
+            osi_free(((btc_ble_scan_rpt_batch_t *)msg->arg)->rst);
+            break;
+#endif
         default:
             BTC_TRACE_DEBUG("Unhandled deep free %d", msg->act);
             break;
@@ -1060,6 +1490,11 @@ void btc_gap_ble_call_handler(btc_msg_t *msg)
     case BTC_GAP_BLE_ACT_READ_RSSI:
         BTA_DmBleReadRSSI(arg->read_rssi.remote_addr, BTA_TRANSPORT_LE, btc_read_ble_rssi_cmpl_callback);
         break;
+#if (BTC_SCAN_RPT_FILTER_INCLUDED == TRUE)
+    case BTC_GAP_BLE_ACT_SET_SCAN_RPT_FILTER:
+        btc_ble_set_scan_rpt_filter(arg->set_scan_rpt_filter.filter);
+        break;
+#endif
     case BTC_GAP_BLE_ACT_SET_CONN_PARAMS:
         BTA_DmSetBlePrefConnParams(arg->set_conn_params.bd_addr, arg->set_conn_params.min_conn_int,
                                                         arg->set_conn_params.max_conn_int, arg->set_conn_params.slave_latency,
@@ -16,6 +16,7 @@
 
 #include "stack/btm_ble_api.h"
 #include "btc_gattc.h"
+#include "btc_gatts.h"
 #include "btc_gatt_util.h"
 #include "btc/btc_manage.h"
 #include "bta/bta_gatt_api.h"
@@ -928,6 +929,10 @@ void btc_gattc_cb_handler(btc_msg_t *msg)
         param.cfg_mtu.conn_id = BTC_GATT_GET_CONN_ID(cfg_mtu->conn_id);
         param.cfg_mtu.status = cfg_mtu->status;
         param.cfg_mtu.mtu = cfg_mtu->mtu;
+        if (cfg_mtu->status == BTA_GATT_OK) {
+            /* the MTU is per link, the server side sizes its indications with it too */
+            btc_gatts_set_mtu(param.cfg_mtu.conn_id, cfg_mtu->mtu);
+        }
         btc_gattc_cb_to_app(YOC_GATTC_CFG_MTU_EVT, gattc_if, &param);
         break;
     }
@@ -22,6 +22,7 @@
 #include "btc_gatt_util.h"
 #include "osi/future.h"
 #include "osi/allocator.h"
+#include "osi/fixed_queue.h"
 #include "btc/btc_main.h"
 #include "yoc_gatts_api.h"
 
@@ -43,6 +44,11 @@ typedef struct {
 
 static yoc_btc_creat_tab_t btc_creat_tab_env;
 
+/* ATT MTU of each connection, indexed by the connection id reported to the
+ * app and 0 while not connected. Written only from the BTC task, so the app
+ * task can size indication buffers without reading the GATT TCB. */
+static uint16_t btc_gatts_mtu[GATT_MAX_PHY_CHANNEL];
+
 
 static yoc_gatt_status_t btc_gatts_check_valid_attr_tab(yoc_gatts_attr_db_t *gatts_attr_db,
                                                                           uint8_t max_nb_attr);
@@ -475,6 +481,19 @@ static yoc_gatt_status_t btc_gatts_check_valid_attr_tab(yoc_gatts_attr_db_t *gat
     return YOC_GATT_OK;
 }
 
+/* conn_id is the connection id reported to the app. Only updates a known connection. */
+void btc_gatts_set_mtu(uint16_t conn_id, uint16_t mtu)
+{
+    if (conn_id < GATT_MAX_PHY_CHANNEL && btc_gatts_mtu[conn_id] != 0) {
+        btc_gatts_mtu[conn_id] = mtu;
+    }
+}
+
+uint16_t btc_gatts_get_mtu(uint16_t conn_id)
+{
+    return conn_id < GATT_MAX_PHY_CHANNEL ? btc_gatts_mtu[conn_id] : 0;
+}
+
 yoc_gatt_status_t btc_gatts_get_attr_value(uint16_t attr_handle, uint16_t *length, uint8_t **value)
 {
     
@@ -537,6 +556,102 @@ static void btc_gatts_cb_param_copy_free(btc_msg_t *msg, tBTA_GATTS *p_data)
 }
 
 
+#if (GATTS_SR_FAST_PATH == TRUE)
+/* BTA callbacks waiting for the BTC task. They are queued from the BTU task
+   and drained by one BTC_GATTS_BATCH_EVT message, so a burst of requests from
+   several connections costs one task switch instead of one per request. */
+typedef struct {
+    uint16_t event;
+    tBTA_GATTS data;
+} btc_gatts_batch_item_t;
+
+static fixed_queue_t *btc_gatts_batch_queue;
+static volatile bool btc_gatts_batch_posted;
+
+static bt_status_t btc_gatts_batch_cb(tBTA_GATTS_EVT event, tBTA_GATTS *p_data)
+{
+    btc_gatts_batch_item_t *p_item;
+    btc_msg_t msg;
+    bt_status_t status = BT_STATUS_SUCCESS;
+
+    if (btc_gatts_batch_queue == NULL) {
+        btc_gatts_batch_queue = fixed_queue_new(QUEUE_SIZE_MAX);
+        if (btc_gatts_batch_queue == NULL) {
+            return BT_STATUS_NOMEM;
+        }
+    }
+
+    p_item = (btc_gatts_batch_item_t *)osi_malloc(sizeof(btc_gatts_batch_item_t));
+    if (p_item == NULL) {
+        return BT_STATUS_NOMEM;
+    }
+
+    msg.sig = BTC_SIG_API_CB;
+    msg.pid = BTC_PID_GATTS;
+    msg.act = event;
+    p_item->event = event;
+    memset(&p_item->data, 0, sizeof(tBTA_GATTS));
+    btc_gatts_cb_param_copy_req(&msg, &p_item->data, p_data);
+
+    fixed_queue_enqueue(btc_gatts_batch_queue, p_item);
+
+    /* one message in flight is enough, the BTC task drains everything queued */
+    if (!btc_gatts_batch_posted) {
+        btc_gatts_batch_posted = true;
+        msg.act = BTC_GATTS_BATCH_EVT;
+        status = btc_transfer_context(&msg, NULL, 0, NULL);
+        if (status != BT_STATUS_SUCCESS) {
+            btc_gatts_batch_posted = false;
+        }
+    }
+
+    return status;
+}
+
+static void btc_gatts_batch_drain(void)
+{
+    btc_gatts_batch_item_t *p_item;
+    btc_msg_t msg;
+
+    /* clear first, anything queued from now on posts a new message */
+    btc_gatts_batch_posted = false;
+
+    /* the queue is gone if GATTS was deinitialized after the post */
+    if (btc_gatts_batch_queue == NULL) {
+        return;
+    }
+
+    while ((p_item = fixed_queue_try_dequeue(btc_gatts_batch_queue)) != NULL) {
+        msg.sig = BTC_SIG_API_CB;
+        msg.pid = BTC_PID_GATTS;
+        msg.act = p_item->event;
+        msg.arg = &p_item->data;
+        btc_gatts_cb_handler(&msg);
+        osi_free(p_item);
+    }
+}
+
+static void btc_gatts_batch_free(void)
+{
+    btc_gatts_batch_item_t *p_item;
+    btc_msg_t msg;
+
+    if (btc_gatts_batch_queue == NULL) {
+        return;
+    }
+
+    /* callbacks still queued are dropped, they belong to the stack going away */
+    while ((p_item = fixed_queue_try_dequeue(btc_gatts_batch_queue)) != NULL) {
+        msg.act = p_item->event;
+        btc_gatts_cb_param_copy_free(&msg, &p_item->data);
+        osi_free(p_item);
+    }
+    fixed_queue_free(btc_gatts_batch_queue, NULL);
+    btc_gatts_batch_queue = NULL;
+    btc_gatts_batch_posted = false;
+}
+#endif  ///GATTS_SR_FAST_PATH == TRUE
+
 static void btc_gatts_inter_cb(tBTA_GATTS_EVT event, tBTA_GATTS *p_data)
 {
     bt_status_t status;
@@ -579,8 +694,12 @@ static void btc_gatts_inter_cb(tBTA_GATTS_EVT event, tBTA_GATTS *p_data)
         future_ready(btc_creat_tab_env.complete_future, FUTURE_SUCCESS);
         return;
     }
+#if (GATTS_SR_FAST_PATH == TRUE)
+    status = btc_gatts_batch_cb(event, p_data);
+#else
     status = btc_transfer_context(&msg, p_data,
                                   sizeof(tBTA_GATTS), btc_gatts_cb_param_copy_req);
+#endif
 
     if (status != BT_STATUS_SUCCESS) {
         BTC_TRACE_ERROR("%s btc_transfer_context failed\n", __func__);
@@ -653,6 +772,11 @@ void btc_gatts_call_handler(btc_msg_t *msg)
         BTA_GATTS_HandleValueIndication(arg->send_ind.conn_id, arg->send_ind.attr_handle,
                                         arg->send_ind.value_len, arg->send_ind.value, arg->send_ind.need_confirm);
         break;
+    case BTC_GATTS_ACT_SEND_INDICATE_BUF:
+        ((BT_HDR *)arg->send_ind_buf.p_buf)->len = GATT_HDR_SIZE + arg->send_ind_buf.value_len;
+        BTA_GATTS_HandleValueBuf(arg->send_ind_buf.conn_id, arg->send_ind_buf.attr_handle,
+                                 (BT_HDR *)arg->send_ind_buf.p_buf, arg->send_ind_buf.need_confirm);
+        break;
     case BTC_GATTS_ACT_SEND_RYOCONSE: {
         yoc_ble_gatts_cb_param_t param;
         yoc_gatt_rsp_t *p_rsp = arg->send_rsp.rsp;
@@ -727,6 +851,11 @@ void btc_gatts_cb_handler(btc_msg_t *msg)
     yoc_gatt_if_t gatts_if;
 
     switch (msg->act) {
+#if (GATTS_SR_FAST_PATH == TRUE)
+    case BTC_GATTS_BATCH_EVT:
+        btc_gatts_batch_drain();
+        return;
+#endif  ///GATTS_SR_FAST_PATH == TRUE
     case BTA_GATTS_REG_EVT: {
         gatts_if = p_data->reg_oper.server_if;
         param.reg.status = p_data->reg_oper.status;
@@ -789,6 +918,7 @@ void btc_gatts_cb_handler(btc_msg_t *msg)
         gatts_if = BTC_GATT_GET_GATT_IF(p_data->req_data.conn_id);
         param.mtu.conn_id = BTC_GATT_GET_CONN_ID(p_data->req_data.conn_id);
         param.mtu.mtu = p_data->req_data.p_data->mtu;
+        btc_gatts_set_mtu(param.mtu.conn_id, param.mtu.mtu);
 
         btc_gatts_cb_to_app(YOC_GATTS_MTU_EVT, gatts_if, &param);
         break;
@@ -866,6 +996,9 @@ void btc_gatts_cb_handler(btc_msg_t *msg)
         gatts_if = p_data->conn.server_if;
         param.connect.conn_id = BTC_GATT_GET_CONN_ID(p_data->conn.conn_id);
         memcpy(param.connect.remote_bda, p_data->conn.remote_bda, YOC_BD_ADDR_LEN);
+        if (param.connect.conn_id < GATT_MAX_PHY_CHANNEL && btc_gatts_mtu[param.connect.conn_id] == 0) {
+            btc_gatts_mtu[param.connect.conn_id] = GATT_DEF_BLE_MTU_SIZE;
+        }
 
         btc_gatts_cb_to_app(YOC_GATTS_CONNECT_EVT, gatts_if, &param);
         break;
@@ -874,6 +1007,9 @@ void btc_gatts_cb_handler(btc_msg_t *msg)
         param.disconnect.conn_id = BTC_GATT_GET_CONN_ID(p_data->conn.conn_id);
         param.disconnect.reason = p_data->conn.reason;
         memcpy(param.disconnect.remote_bda, p_data->conn.remote_bda, YOC_BD_ADDR_LEN);
+        if (param.disconnect.conn_id < GATT_MAX_PHY_CHANNEL) {
+            btc_gatts_mtu[param.disconnect.conn_id] = 0;
+        }
 
         btc_gatts_cb_to_app(YOC_GATTS_DISCONNECT_EVT, gatts_if, &param);
         break;
@@ -923,3 +1059,10 @@ void btc_gatts_cb_handler(btc_msg_t *msg)
 }
 
 #endif  ///GATTS_INCLUDED
+
+void btc_gatts_deinit(void)
+{
+#if (GATTS_SR_FAST_PATH == TRUE)
+    btc_gatts_batch_free();
+#endif  ///GATTS_SR_FAST_PATH == TRUE
+}
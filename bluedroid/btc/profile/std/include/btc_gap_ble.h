@@ -45,8 +45,19 @@ typedef enum {
     BTC_GAP_BLE_CONFIRM_REPLY_EVT,
     BTC_GAP_BLE_DISCONNECT_EVT,
     BTC_GAP_BLE_REMOVE_BOND_DEV_EVT,
+    BTC_GAP_BLE_ACT_SET_SCAN_RPT_FILTER,
 } btc_gap_ble_act_t;
 
+/* Callback message carrying a batch of scan results,
+   outside the range of yoc_gap_ble_cb_event_t */
+#define BTC_GAP_BLE_SCAN_RPT_BATCH_EVT  0xFF
+
+/* Argument of BTC_GAP_BLE_SCAN_RPT_BATCH_EVT */
+typedef struct {
+    uint16_t num;
+    yoc_ble_gap_cb_param_t *rst;
+} btc_ble_scan_rpt_batch_t;
+
 /* btc_ble_gap_args_t */
 typedef union {
     //BTC_GAP_BLE_ACT_CFG_ADV_DATA = 0,
@@ -155,6 +166,10 @@ typedef union {
     struct read_rssi_args {
         yoc_bd_addr_t remote_addr;
     } read_rssi;
+    //BTC_GAP_BLE_ACT_SET_SCAN_RPT_FILTER
+    struct set_scan_rpt_filter_args {
+        yoc_ble_scan_report_filter_t *filter;
+    } set_scan_rpt_filter;
 } btc_ble_gap_args_t;
 
 void btc_gap_ble_call_handler(btc_msg_t *msg);
@@ -168,5 +183,7 @@ void btc_gap_callback_init(void);
 void btc_gap_ble_deinit(void);
 void btc_adv_list_init(void);
 void btc_adv_list_deinit(void);
+void btc_scan_rpt_init(void);
+void btc_scan_rpt_deinit(void);
 
 #endif /* __BTC_GAP_BLE_H__ */
@@ -36,8 +36,13 @@ typedef enum {
     BTC_GATTS_ACT_SET_ATTR_VALUE,
     BTC_GATTS_ACT_OPEN,
     BTC_GATTS_ACT_CLOSE,
+    BTC_GATTS_ACT_SEND_INDICATE_BUF,
 } btc_gatts_act_t;
 
+/* Callback message carrying a batch of queued BTA GATTS events,
+   outside the range of tBTA_GATTS_EVT */
+#define BTC_GATTS_BATCH_EVT     0xFF
+
 /* btc_ble_gatts_args_t */
 typedef union {
     //BTC_GATTS_ACT_APP_REGISTER = 0,
@@ -141,6 +146,15 @@ typedef union {
         uint16_t conn_id;
     } close;
 
+    //BTC_GATTS_ACT_SEND_INDICATE_BUF,
+    struct send_indicate_buf_args {
+        uint16_t conn_id;
+        uint16_t attr_handle;
+        bool need_confirm;
+        uint16_t value_len;
+        void *p_buf;            /* BT_HDR from GATTS_AllocHandleValueBuf, owned by the message */
+    } send_ind_buf;
+
 } btc_ble_gatts_args_t;
 
 
@@ -148,6 +162,9 @@ void btc_gatts_call_handler(btc_msg_t *msg);
 void btc_gatts_cb_handler(btc_msg_t *msg);
 void btc_gatts_arg_deep_copy(btc_msg_t *msg, void *p_dest, void *p_src);
 yoc_gatt_status_t btc_gatts_get_attr_value(uint16_t attr_handle, uint16_t *length, uint8_t **value);
+void btc_gatts_set_mtu(uint16_t conn_id, uint16_t mtu);
+uint16_t btc_gatts_get_mtu(uint16_t conn_id);
+void btc_gatts_deinit(void);
 
 
 #endif /* __BTC_GATTS_H__ */
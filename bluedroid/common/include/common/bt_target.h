@@ -118,8 +118,9 @@
 #define CLASSIC_BT_INCLUDED         FALSE
 #endif /* CLASSIC_BT_INCLUDED */
 
+/* Keep the GATT client cache of known servers across reconnections and reboots */
 #ifndef CONFIG_GATTC_CACHE_NVS_FLASH
-#define CONFIG_GATTC_CACHE_NVS_FLASH         FALSE
+#define CONFIG_GATTC_CACHE_NVS_FLASH         TRUE
 #endif /* CONFIG_GATTC_CACHE_NVS_FLASH */
 
 /******************************************************************************
@@ -232,6 +233,57 @@
 #define SBC_ENC_INCLUDED FALSE
 #endif
 
+/* Build the aos_kv backend of the bond store, host builds without aos_kv set it to FALSE */
+#ifndef BOND_STORE_KV_INCLUDED
+#define BOND_STORE_KV_INCLUDED TRUE
+#endif
+
+/* Where the bond store is kept unless yoc_bluedroid_set_bond_store() selects otherwise:
+** aos_kv values under BTC_BOND_STORE_KV_KEY, or the file BTC_BOND_STORE_PATH on host builds */
+#ifndef BTC_BOND_STORE_USE_KV
+#define BTC_BOND_STORE_USE_KV BOND_STORE_KV_INCLUDED
+#endif
+
+/* aos_kv key of the bond store index, each record is kept under this key, "_" and its address */
+#ifndef BTC_BOND_STORE_KV_KEY
+#define BTC_BOND_STORE_KV_KEY "bt_bond"
+#endif
+
+/* File holding the bond store log, used by the file backend */
+#ifndef BTC_BOND_STORE_PATH
+#define BTC_BOND_STORE_PATH "bt_bond_store.bin"
+#endif
+
+/* Records in the bond store: the bonded peers, one over the limit while it is trimmed, and the local keys */
+#ifndef BTC_BOND_STORE_MAX_RECORDS
+#define BTC_BOND_STORE_MAX_RECORDS (BTM_SEC_MAX_DEVICE_RECORDS + 2)
+#endif
+
+/* aos_kv key of the index of the GATT client cache, each index record is kept under this key, "_" and its address */
+#ifndef BTA_GATTC_CACHE_INDEX_KEY
+#define BTA_GATTC_CACHE_INDEX_KEY "bt_gattc_idx"
+#endif
+
+/* Prefix of the aos_kv keys holding the attribute table of each cached server, followed by its address */
+#ifndef BTA_GATTC_CACHE_KV_PREFIX
+#define BTA_GATTC_CACHE_KV_PREFIX "bt_gattc_"
+#endif
+
+/* File holding the index of the GATT client cache, without aos_kv */
+#ifndef BTA_GATTC_CACHE_INDEX_PATH
+#define BTA_GATTC_CACHE_INDEX_PATH "bt_gattc_cache.bin"
+#endif
+
+/* Prefix of the files holding the attribute table of each cached server, without aos_kv */
+#ifndef BTA_GATTC_CACHE_PATH_PREFIX
+#define BTA_GATTC_CACHE_PATH_PREFIX "bt_gattc_"
+#endif
+
+/* Servers kept in the GATT client cache, the least recently saved one is dropped first */
+#ifndef BTA_GATTC_CACHE_MAX_DEVICES
+#define BTA_GATTC_CACHE_MAX_DEVICES 16
+#endif
+
 /******************************************************************************
 **
 ** BTA-layer components
@@ -357,6 +409,19 @@
 #define SCAN_QUEUE_CONGEST_CHECK  CONFIG_BLE_HOST_QUEUE_CONGESTION_CHECK
 #endif
 
+/* Host side filtering and batching of LE scan results in the BTU task, set up at run time
+** with yoc_ble_gap_set_scan_report_filter(). Scan results are not touched until it is called. */
+#ifndef BTC_SCAN_RPT_FILTER_INCLUDED
+#define BTC_SCAN_RPT_FILTER_INCLUDED    TRUE
+#endif
+
+/* Number of devices tracked by the per device rate limit of the scan report filter,
+** in sets of two, must be a power of 2 and at least 2. A device evicted by two newer ones
+** in its set may be reported again before its limit expires. */
+#ifndef BTC_SCAN_RPT_RATE_SLOTS
+#define BTC_SCAN_RPT_RATE_SLOTS         32
+#endif
+
 #ifndef CONFIG_BLE_ACTIVE_SCAN_REPORT_ADV_SCAN_RSP_INDIVIDUALLY
 #define BTM_BLE_ACTIVE_SCAN_REPORT_ADV_SCAN_RSP_INDIVIDUALLY    FALSE
 #else
@@ -607,6 +672,23 @@
 #define BTM_INQ_DB_SIZE             5
 #endif
 
+/* Number of hash buckets indexing the inquiry database by address, must be a power of 2.
+** Raise it with BTM_INQ_DB_SIZE, about half the database size keeps the chains short. */
+#ifndef BTM_INQ_DB_HASH_SIZE
+#define BTM_INQ_DB_HASH_SIZE        8
+#endif
+
+/* Number of resolvable private addresses remembered with the bonded device they resolve to,
+** or as not resolvable, must be a power of 2. 0 checks every address against all IRKs. */
+#ifndef BTM_BLE_RPA_CACHE_SIZE
+#define BTM_BLE_RPA_CACHE_SIZE      16
+#endif
+
+/* Lifetime of a cached address resolution, the 15 minute RPA rotation interval */
+#ifndef BTM_BLE_RPA_CACHE_TIMEOUT_MS
+#define BTM_BLE_RPA_CACHE_TIMEOUT_MS    (900 * 1000)
+#endif
+
 /* The default scan mode */
 #ifndef BTM_DEFAULT_SCAN_TYPE
 #define BTM_DEFAULT_SCAN_TYPE       BTM_SCAN_TYPE_INTERLACED
@@ -1134,6 +1216,32 @@
 #define GATT_MAX_BG_CONN_DEV        8 /*MAX is 32*/
 #endif
 
+/* GATT server fast path: reads of attributes with stack managed values (GATT_RSP_BY_STACK)
+** are answered in the BTU task without the informational read callback to the application,
+** and the requests that do reach the application are handed to the BTC task in batches.
+*/
+#ifndef GATTS_SR_FAST_PATH
+#define GATTS_SR_FAST_PATH          FALSE
+#endif
+
+/* Keep per connection GATT server request latency and queueing histograms */
+#ifndef GATTS_SR_STATS_INCLUDED
+#define GATTS_SR_STATS_INCLUDED     FALSE
+#endif
+
+/* Queue GATT server notifications per connection and send them together once the BTU task
+** is idle, as Multiple Handle Value Notifications when the client has enabled them in the
+** Client Supported Features characteristic.
+*/
+#ifndef GATTS_NOTIF_BATCH_INCLUDED
+#define GATTS_NOTIF_BATCH_INCLUDED  FALSE
+#endif
+
+/* Number of notifications queued on one connection before they are sent without waiting */
+#ifndef GATTS_NOTIF_BATCH_MAX
+#define GATTS_NOTIF_BATCH_MAX       16
+#endif
+
 /******************************************************************************
 **
 ** GATT
@@ -1205,6 +1313,30 @@
 #define SMP_LINK_TOUT_MIN               2
 #endif
 #endif
+
+/* AES encryption with a 1 KB table of 32-bit round words instead of the byte oriented rounds,
+** used by SMP, CMAC signing and resolvable private address matching */
+#ifndef SMP_AES_TTABLE
+#define SMP_AES_TTABLE                  TRUE
+#endif
+
+/* Run the P-256 key pair generation and DHKey computation of LE Secure Connections
+** in a low priority worker task, so the BTU task keeps serving HCI and ACL traffic */
+#ifndef SMP_ECC_WORKER_INCLUDED
+#define SMP_ECC_WORKER_INCLUDED         TRUE
+#endif
+
+/* Keep one local key pair computed ahead of time by the ECC worker, so the public key
+** exchange of the next pairing does not wait for the point multiplication */
+#ifndef SMP_ECC_PRECOMPUTE_KEY
+#define SMP_ECC_PRECOMPUTE_KEY          TRUE
+#endif
+
+/* Fixed-base comb table for the P-256 generator (31 affine points, about 2 KB of ROM) used
+** to compute the local public key. When FALSE the variable-base window NAF is used for it */
+#ifndef SMP_P256_COMB_TABLE
+#define SMP_P256_COMB_TABLE             TRUE
+#endif
 /******************************************************************************
 **
 ** SDP
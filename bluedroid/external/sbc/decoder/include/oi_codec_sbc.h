@@ -360,6 +360,48 @@ OI_STATUS OI_CODEC_SBC_DecodeFrame(OI_CODEC_SBC_DECODER_CONTEXT *context,
                                    OI_INT16 *pcmData,
                                    OI_UINT32 *pcmBytes);
 
+/**
+ * Decode consecutive SBC frames, e.g. all frames of one A2DP media packet,
+ * into a single PCM buffer. Decoding stops after @a frameCount frames, when
+ * the frame data runs out, or at the first frame that fails to decode.
+ *
+ * @param context       Pointer to a decoder context structure. The same context
+ *                      must be used each time when decoding from the same stream.
+ *
+ * @param frameData     Address of a pointer to the SBC data to decode. This
+ *                      value will be updated to point past the last frame
+ *                      that was successfully decoded.
+ *
+ * @param frameBytes    Pointer to a UINT32 containing the number of available
+ *                      bytes of frame data. This value will be updated to reflect
+ *                      the number of bytes remaining after the decoding operation.
+ *
+ * @param frameCount    Maximum number of frames to decode.
+ *
+ * @param pcmData       Address of an array of OI_INT16 pairs, which will be
+ *                      populated with the decoded audio data of all frames
+ *                      back to back. This address is not updated.
+ *
+ * @param pcmBytes      Pointer to a UINT32 in/out parameter. On input, it
+ *                      should contain the number of bytes available for pcm
+ *                      data. On output, it will contain the total number of
+ *                      bytes written.
+ *
+ * @param framesDecoded Optional pointer that receives the number of frames
+ *                      decoded. May be NULL.
+ *
+ * @return OI_OK if @a frameCount frames were decoded or the frame data was
+ *         consumed exactly, otherwise the status of the frame that stopped
+ *         the batch.
+ */
+OI_STATUS OI_CODEC_SBC_DecodeFrames(OI_CODEC_SBC_DECODER_CONTEXT *context,
+                                    const OI_BYTE **frameData,
+                                    OI_UINT32 *frameBytes,
+                                    OI_UINT frameCount,
+                                    OI_INT16 *pcmData,
+                                    OI_UINT32 *pcmBytes,
+                                    OI_UINT *framesDecoded);
+
 /**
  * Calculate the number of SBC frames but don't decode. CRC's are not checked,
  * but the Sync word is found prior to count calculation.
@@ -331,6 +331,41 @@ OI_STATUS OI_CODEC_SBC_DecodeFrame(OI_CODEC_SBC_DECODER_CONTEXT *context,
     return status;
 }
 
+OI_STATUS OI_CODEC_SBC_DecodeFrames(OI_CODEC_SBC_DECODER_CONTEXT *context,
+                                    const OI_BYTE **frameData,
+                                    OI_UINT32 *frameBytes,
+                                    OI_UINT frameCount,
+                                    OI_INT16 *pcmData,
+                                    OI_UINT32 *pcmBytes,
+                                    OI_UINT *framesDecoded)
+{
+    OI_STATUS status = OI_OK;
+    OI_UINT32 pcmAvail = *pcmBytes;
+    OI_UINT32 pcmUsed = 0;
+    OI_UINT32 framePcmBytes;
+    OI_UINT decoded = 0;
+
+    TRACE(("+OI_CODEC_SBC_DecodeFrames: %d", frameCount));
+
+    while (decoded < frameCount && *frameBytes != 0) {
+        framePcmBytes = pcmAvail - pcmUsed;
+        status = OI_CODEC_SBC_DecodeFrame(context, frameData, frameBytes,
+                                          pcmData + pcmUsed / sizeof(OI_INT16), &framePcmBytes);
+        if (!OI_SUCCESS(status)) {
+            break;
+        }
+        pcmUsed += framePcmBytes;
+        decoded++;
+    }
+
+    *pcmBytes = pcmUsed;
+    if (framesDecoded) {
+        *framesDecoded = decoded;
+    }
+    TRACE(("-OI_CODEC_SBC_DecodeFrames: %d frames, %d", decoded, status));
+    return status;
+}
+
 OI_STATUS OI_CODEC_SBC_SkipFrame(OI_CODEC_SBC_DECODER_CONTEXT *context,
                                  const OI_BYTE **frameData,
                                  OI_UINT32 *frameBytes)
@@ -0,0 +1,220 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2014 The Android Open Source Project
+ *  Copyright 2003 - 2004 Open Interface North America, Inc. All rights reserved.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/**
+ @file
+
+ Stereo variant of SynthWindow80_generated() for an interleaved (stride 2)
+ output buffer. Both channels are windowed in the same pass, term for term in
+ the order used by the mono routine, so the output is bit exact with calling
+ SynthWindow80_generated() once per channel. Each window coefficient is set
+ up once for the two multiply-accumulates and the PCM offsets are constant.
+
+ Derived line by line from synthesis-8-generated.c; keep the two in sync.
+
+ */
+#include "common/bt_target.h"
+#include <oi_codec_sbc_private.h>
+
+#if (defined(SBC_DEC_INCLUDED) && SBC_DEC_INCLUDED == TRUE)
+
+#ifndef CLIP_INT16
+#define CLIP_INT16(x) do { if (x > OI_INT16_MAX) { x = OI_INT16_MAX; } else if (x < OI_INT16_MIN) { x = OI_INT16_MIN; } } while (0)
+#endif
+
+#define MUL_16S_16S(_x, _y) ((_x) * (_y))
+
+PRIVATE void SynthWindow80_stereo(OI_INT16 *pcm, SBC_BUFFER_T const *RESTRICT bufL, SBC_BUFFER_T const *RESTRICT bufR)
+{
+    OI_INT32 pcm_aL, pcm_bL, pcm_aR, pcm_bR;
+    /* 1 - stage 0 */ pcm_bL = 0; pcm_bR = 0;
+    /* 1 - stage 0 */ pcm_bL += (MUL_16S_16S(8235, bufL[ 12])) >> 3;
+    /* 1 - stage 0 */ pcm_bR += (MUL_16S_16S(8235, bufR[ 12])) >> 3;
+    /* 1 - stage 0 */ pcm_bL += (MUL_16S_16S(-23167, bufL[ 20])) >> 3;
+    /* 1 - stage 0 */ pcm_bR += (MUL_16S_16S(-23167, bufR[ 20])) >> 3;
+    /* 1 - stage 0 */ pcm_bL += (MUL_16S_16S(26479, bufL[ 28])) >> 2;
+    /* 1 - stage 0 */ pcm_bR += (MUL_16S_16S(26479, bufR[ 28])) >> 2;
+    /* 1 - stage 0 */ pcm_bL += (MUL_16S_16S(-17397, bufL[ 36])) << 1;
+    /* 1 - stage 0 */ pcm_bR += (MUL_16S_16S(-17397, bufR[ 36])) << 1;
+    /* 1 - stage 0 */ pcm_bL += (MUL_16S_16S(9399, bufL[ 44])) << 3;
+    /* 1 - stage 0 */ pcm_bR += (MUL_16S_16S(9399, bufR[ 44])) << 3;
+    /* 1 - stage 0 */ pcm_bL += (MUL_16S_16S(17397, bufL[ 52])) << 1;
+    /* 1 - stage 0 */ pcm_bR += (MUL_16S_16S(17397, bufR[ 52])) << 1;
+    /* 1 - stage 0 */ pcm_bL += (MUL_16S_16S(26479, bufL[ 60])) >> 2;
+    /* 1 - stage 0 */ pcm_bR += (MUL_16S_16S(26479, bufR[ 60])) >> 2;
+    /* 1 - stage 0 */ pcm_bL += (MUL_16S_16S(23167, bufL[ 68])) >> 3;
+    /* 1 - stage 0 */ pcm_bR += (MUL_16S_16S(23167, bufR[ 68])) >> 3;
+    /* 1 - stage 0 */ pcm_bL += (MUL_16S_16S(8235, bufL[ 76])) >> 3;
+    /* 1 - stage 0 */ pcm_bR += (MUL_16S_16S(8235, bufR[ 76])) >> 3;
+    /* 1 - stage 0 */ pcm_bL /= 32768; CLIP_INT16(pcm_bL); pcm[ 0] = (OI_INT16)pcm_bL;
+    /* 1 - stage 0 */ pcm_bR /= 32768; CLIP_INT16(pcm_bR); pcm[ 1] = (OI_INT16)pcm_bR;
+    /* 1 - stage 1 */ pcm_aL = 0; pcm_aR = 0;
+    /* 1 - stage 1 */ pcm_bL = 0; pcm_bR = 0;
+    /* 1 - stage 1 */ pcm_aL += (MUL_16S_16S(-3263, bufL[  5])) >> 5;
+    /* 1 - stage 1 */ pcm_aR += (MUL_16S_16S(-3263, bufR[  5])) >> 5;
+    /* 1 - stage 1 */ pcm_bL += (MUL_16S_16S(9293, bufL[  5])) >> 3;
+    /* 1 - stage 1 */ pcm_bR += (MUL_16S_16S(9293, bufR[  5])) >> 3;
+    /* 1 - stage 1 */ pcm_aL += (MUL_16S_16S(29293, bufL[ 11])) >> 5;
+    /* 1 - stage 1 */ pcm_aR += (MUL_16S_16S(29293, bufR[ 11])) >> 5;
+    /* 1 - stage 1 */ pcm_bL += (MUL_16S_16S(-6087, bufL[ 11])) >> 2;
+    /* 1 - stage 1 */ pcm_bR += (MUL_16S_16S(-6087, bufR[ 11])) >> 2;
+    /* 1 - stage 1 */ pcm_aL += (MUL_16S_16S(-5229, bufL[ 21]));
+    /* 1 - stage 1 */ pcm_aR += (MUL_16S_16S(-5229, bufR[ 21]));
+    /* 1 - stage 1 */ pcm_bL += (MUL_16S_16S(1247, bufL[ 21])) << 3;
+    /* 1 - stage 1 */ pcm_bR += (MUL_16S_16S(1247, bufR[ 21])) << 3;
+    /* 1 - stage 1 */ pcm_aL += (MUL_16S_16S(30835, bufL[ 27])) >> 3;
+    /* 1 - stage 1 */ pcm_aR += (MUL_16S_16S(30835, bufR[ 27])) >> 3;
+    /* 1 - stage 1 */ pcm_bL += (MUL_16S_16S(-2893, bufL[ 27])) << 3;
+    /* 1 - stage 1 */ pcm_bR += (MUL_16S_16S(-2893, bufR[ 27])) << 3;
+    /* 1 - stage 1 */ pcm_aL += (MUL_16S_16S(-27021, bufL[ 37])) << 1;
+    /* 1 - stage 1 */ pcm_aR += (MUL_16S_16S(-27021, bufR[ 37])) << 1;
+    /* 1 - stage 1 */ pcm_bL += (MUL_16S_16S(23671, bufL[ 37])) << 2;
+    /* 1 - stage 1 */ pcm_bR += (MUL_16S_16S(23671, bufR[ 37])) << 2;
+    /* 1 - stage 1 */ pcm_aL += (MUL_16S_16S(31633, bufL[ 43])) << 1;
+    /* 1 - stage 1 */ pcm_aR += (MUL_16S_16S(31633, bufR[ 43])) << 1;
+    /* 1 - stage 1 */ pcm_bL += (MUL_16S_16S(18055, bufL[ 43])) << 1;
+    /* 1 - stage 1 */ pcm_bR += (MUL_16S_16S(18055, bufR[ 43])) << 1;
+    /* 1 - stage 1 */ pcm_aL += (MUL_16S_16S(17319, bufL[ 53])) << 1;
+    /* 1 - stage 1 */ pcm_aR += (MUL_16S_16S(17319, bufR[ 53])) << 1;
+    /* 1 - stage 1 */ pcm_bL += (MUL_16S_16S(11537, bufL[ 53])) >> 1;
+    /* 1 - stage 1 */ pcm_bR += (MUL_16S_16S(11537, bufR[ 53])) >> 1;
+    /* 1 - stage 1 */ pcm_aL += (MUL_16S_16S(26663, bufL[ 59])) >> 2;
+    /* 1 - stage 1 */ pcm_aR += (MUL_16S_16S(26663, bufR[ 59])) >> 2;
+    /* 1 - stage 1 */ pcm_bL += (MUL_16S_16S(1747, bufL[ 59])) << 1;
+    /* 1 - stage 1 */ pcm_bR += (MUL_16S_16S(1747, bufR[ 59])) << 1;
+    /* 1 - stage 1 */ pcm_aL += (MUL_16S_16S(4555, bufL[ 69])) >> 1;
+    /* 1 - stage 1 */ pcm_aR += (MUL_16S_16S(4555, bufR[ 69])) >> 1;
+    /* 1 - stage 1 */ pcm_bL += (MUL_16S_16S(685, bufL[ 69])) << 1;
+    /* 1 - stage 1 */ pcm_bR += (MUL_16S_16S(685, bufR[ 69])) << 1;
+    /* 1 - stage 1 */ pcm_aL += (MUL_16S_16S(12419, bufL[ 75])) >> 4;
+    /* 1 - stage 1 */ pcm_aR += (MUL_16S_16S(12419, bufR[ 75])) >> 4;
+    /* 1 - stage 1 */ pcm_bL += (MUL_16S_16S(8721, bufL[ 75])) >> 7;
+    /* 1 - stage 1 */ pcm_bR += (MUL_16S_16S(8721, bufR[ 75])) >> 7;
+    /* 1 - stage 1 */ pcm_aL /= 32768; CLIP_INT16(pcm_aL); pcm[ 2] = (OI_INT16)pcm_aL;
+    /* 1 - stage 1 */ pcm_aR /= 32768; CLIP_INT16(pcm_aR); pcm[ 3] = (OI_INT16)pcm_aR;
+    /* 1 - stage 1 */ pcm_bL /= 32768; CLIP_INT16(pcm_bL); pcm[14] = (OI_INT16)pcm_bL;
+    /* 1 - stage 1 */ pcm_bR /= 32768; CLIP_INT16(pcm_bR); pcm[15] = (OI_INT16)pcm_bR;
+    /* 1 - stage 2 */ pcm_aL = 0; pcm_aR = 0;
+    /* 1 - stage 2 */ pcm_bL = 0; pcm_bR = 0;
+    /* 1 - stage 2 */ pcm_aL += (MUL_16S_16S(-10385, bufL[  6])) >> 6;
+    /* 1 - stage 2 */ pcm_aR += (MUL_16S_16S(-10385, bufR[  6])) >> 6;
+    /* 1 - stage 2 */ pcm_bL += (MUL_16S_16S(11167, bufL[  6])) >> 4;
+    /* 1 - stage 2 */ pcm_bR += (MUL_16S_16S(11167, bufR[  6])) >> 4;
+    /* 1 - stage 2 */ pcm_aL += (MUL_16S_16S(24995, bufL[ 10])) >> 5;
+    /* 1 - stage 2 */ pcm_aR += (MUL_16S_16S(24995, bufR[ 10])) >> 5;
+    /* 1 - stage 2 */ pcm_bL += (MUL_16S_16S(-10337, bufL[ 10])) >> 4;
+    /* 1 - stage 2 */ pcm_bR += (MUL_16S_16S(-10337, bufR[ 10])) >> 4;
+    /* 1 - stage 2 */ pcm_aL += (MUL_16S_16S(-309, bufL[ 22])) << 4;
+    /* 1 - stage 2 */ pcm_aR += (MUL_16S_16S(-309, bufR[ 22])) << 4;
+    /* 1 - stage 2 */ pcm_bL += (MUL_16S_16S(1917, bufL[ 22])) << 2;
+    /* 1 - stage 2 */ pcm_bR += (MUL_16S_16S(1917, bufR[ 22])) << 2;
+    /* 1 - stage 2 */ pcm_aL += (MUL_16S_16S(9161, bufL[ 26])) >> 3;
+    /* 1 - stage 2 */ pcm_aR += (MUL_16S_16S(9161, bufR[ 26])) >> 3;
+    /* 1 - stage 2 */ pcm_bL += (MUL_16S_16S(-30605, bufL[ 26])) >> 1;
+    /* 1 - stage 2 */ pcm_bR += (MUL_16S_16S(-30605, bufR[ 26])) >> 1;
+    /* 1 - stage 2 */ pcm_aL += (MUL_16S_16S(-23063, bufL[ 38])) << 1;
+    /* 1 - stage 2 */ pcm_aR += (MUL_16S_16S(-23063, bufR[ 38])) << 1;
+    /* 1 - stage 2 */ pcm_bL += (MUL_16S_16S(8317, bufL[ 38])) << 3;
+    /* 1 - stage 2 */ pcm_bR += (MUL_16S_16S(8317, bufR[ 38])) << 3;
+    /* 1 - stage 2 */ pcm_aL += (MUL_16S_16S(27561, bufL[ 42])) << 1;
+    /* 1 - stage 2 */ pcm_aR += (MUL_16S_16S(27561, bufR[ 42])) << 1;
+    /* 1 - stage 2 */ pcm_bL += (MUL_16S_16S(9553, bufL[ 42])) << 2;
+    /* 1 - stage 2 */ pcm_bR += (MUL_16S_16S(9553, bufR[ 42])) << 2;
+    /* 1 - stage 2 */ pcm_aL += (MUL_16S_16S(2309, bufL[ 54])) << 3;
+    /* 1 - stage 2 */ pcm_aR += (MUL_16S_16S(2309, bufR[ 54])) << 3;
+    /* 1 - stage 2 */ pcm_bL += (MUL_16S_16S(22117, bufL[ 54])) >> 4;
+    /* 1 - stage 2 */ pcm_bR += (MUL_16S_16S(22117, bufR[ 54])) >> 4;
+    /* 1 - stage 2 */ pcm_aL += (MUL_16S_16S(12705, bufL[ 58])) >> 1;
+    /* 1 - stage 2 */ pcm_aR += (MUL_16S_16S(12705, bufR[ 58])) >> 1;
+    /* 1 - stage 2 */ pcm_bL += (MUL_16S_16S(16383, bufL[ 58])) >> 2;
+    /* 1 - stage 2 */ pcm_bR += (MUL_16S_16S(16383, bufR[ 58])) >> 2;
+    /* 1 - stage 2 */ pcm_aL += (MUL_16S_16S(6239, bufL[ 70])) >> 3;
+    /* 1 - stage 2 */ pcm_aR += (MUL_16S_16S(6239, bufR[ 70])) >> 3;
+    /* 1 - stage 2 */ pcm_bL += (MUL_16S_16S(7543, bufL[ 70])) >> 3;
+    /* 1 - stage 2 */ pcm_bR += (MUL_16S_16S(7543, bufR[ 70])) >> 3;
+    /* 1 - stage 2 */ pcm_aL += (MUL_16S_16S(9251, bufL[ 74])) >> 4;
+    /* 1 - stage 2 */ pcm_aR += (MUL_16S_16S(9251, bufR[ 74])) >> 4;
+    /* 1 - stage 2 */ pcm_bL += (MUL_16S_16S(8603, bufL[ 74])) >> 6;
+    /* 1 - stage 2 */ pcm_bR += (MUL_16S_16S(8603, bufR[ 74])) >> 6;
+    /* 1 - stage 2 */ pcm_aL /= 32768; CLIP_INT16(pcm_aL); pcm[ 4] = (OI_INT16)pcm_aL;
+    /* 1 - stage 2 */ pcm_aR /= 32768; CLIP_INT16(pcm_aR); pcm[ 5] = (OI_INT16)pcm_aR;
+    /* 1 - stage 2 */ pcm_bL /= 32768; CLIP_INT16(pcm_bL); pcm[12] = (OI_INT16)pcm_bL;
+    /* 1 - stage 2 */ pcm_bR /= 32768; CLIP_INT16(pcm_bR); pcm[13] = (OI_INT16)pcm_bR;
+    /* 1 - stage 3 */ pcm_aL = 0; pcm_aR = 0;
+    /* 1 - stage 3 */ pcm_bL = 0; pcm_bR = 0;
+    /* 1 - stage 3 */ pcm_aL += (MUL_16S_16S(-16457, bufL[  7])) >> 6;
+    /* 1 - stage 3 */ pcm_aR += (MUL_16S_16S(-16457, bufR[  7])) >> 6;
+    /* 1 - stage 3 */ pcm_bL += (MUL_16S_16S(16913, bufL[  7])) >> 5;
+    /* 1 - stage 3 */ pcm_bR += (MUL_16S_16S(16913, bufR[  7])) >> 5;
+    /* 1 - stage 3 */ pcm_aL += (MUL_16S_16S(19083, bufL[  9])) >> 5;
+    /* 1 - stage 3 */ pcm_aR += (MUL_16S_16S(19083, bufR[  9])) >> 5;
+    /* 1 - stage 3 */ pcm_bL += (MUL_16S_16S(-8443, bufL[  9])) >> 7;
+    /* 1 - stage 3 */ pcm_bR += (MUL_16S_16S(-8443, bufR[  9])) >> 7;
+    /* 1 - stage 3 */ pcm_aL += (MUL_16S_16S(-23641, bufL[ 23])) >> 2;
+    /* 1 - stage 3 */ pcm_aR += (MUL_16S_16S(-23641, bufR[ 23])) >> 2;
+    /* 1 - stage 3 */ pcm_bL += (MUL_16S_16S(3687, bufL[ 23])) << 1;
+    /* 1 - stage 3 */ pcm_bR += (MUL_16S_16S(3687, bufR[ 23])) << 1;
+    /* 1 - stage 3 */ pcm_aL += (MUL_16S_16S(-29015, bufL[ 25])) >> 4;
+    /* 1 - stage 3 */ pcm_aR += (MUL_16S_16S(-29015, bufR[ 25])) >> 4;
+    /* 1 - stage 3 */ pcm_bL += (MUL_16S_16S(-301, bufL[ 25])) << 5;
+    /* 1 - stage 3 */ pcm_bR += (MUL_16S_16S(-301, bufR[ 25])) << 5;
+    /* 1 - stage 3 */ pcm_aL += (MUL_16S_16S(-12889, bufL[ 39])) << 2;
+    /* 1 - stage 3 */ pcm_aR += (MUL_16S_16S(-12889, bufR[ 39])) << 2;
+    /* 1 - stage 3 */ pcm_bL += (MUL_16S_16S(15447, bufL[ 39])) << 2;
+    /* 1 - stage 3 */ pcm_bR += (MUL_16S_16S(15447, bufR[ 39])) << 2;
+    /* 1 - stage 3 */ pcm_aL += (MUL_16S_16S(6145, bufL[ 41])) << 3;
+    /* 1 - stage 3 */ pcm_aR += (MUL_16S_16S(6145, bufR[ 41])) << 3;
+    /* 1 - stage 3 */ pcm_bL += (MUL_16S_16S(10255, bufL[ 41])) << 2;
+    /* 1 - stage 3 */ pcm_bR += (MUL_16S_16S(10255, bufR[ 41])) << 2;
+    /* 1 - stage 3 */ pcm_aL += (MUL_16S_16S(24211, bufL[ 55])) >> 1;
+    /* 1 - stage 3 */ pcm_aR += (MUL_16S_16S(24211, bufR[ 55])) >> 1;
+    /* 1 - stage 3 */ pcm_bL += (MUL_16S_16S(-18233, bufL[ 55])) >> 3;
+    /* 1 - stage 3 */ pcm_bR += (MUL_16S_16S(-18233, bufR[ 55])) >> 3;
+    /* 1 - stage 3 */ pcm_aL += (MUL_16S_16S(23469, bufL[ 57])) >> 2;
+    /* 1 - stage 3 */ pcm_aR += (MUL_16S_16S(23469, bufR[ 57])) >> 2;
+    /* 1 - stage 3 */ pcm_bL += (MUL_16S_16S(9405, bufL[ 57])) >> 1;
+    /* 1 - stage 3 */ pcm_bR += (MUL_16S_16S(9405, bufR[ 57])) >> 1;
+    /* 1 - stage 3 */ pcm_aL += (MUL_16S_16S(21223, bufL[ 71])) >> 8;
+    /* 1 - stage 3 */ pcm_aR += (MUL_16S_16S(21223, bufR[ 71])) >> 8;
+    /* 1 - stage 3 */ pcm_bL += (MUL_16S_16S(1499, bufL[ 71])) >> 1;
+    /* 1 - stage 3 */ pcm_bR += (MUL_16S_16S(1499, bufR[ 71])) >> 1;
+    /* 1 - stage 3 */ pcm_aL += (MUL_16S_16S(26913, bufL[ 73])) >> 6;
+    /* 1 - stage 3 */ pcm_aR += (MUL_16S_16S(26913, bufR[ 73])) >> 6;
+    /* 1 - stage 3 */ pcm_bL += (MUL_16S_16S(26189, bufL[ 73])) >> 7;
+    /* 1 - stage 3 */ pcm_bR += (MUL_16S_16S(26189, bufR[ 73])) >> 7;
+    /* 1 - stage 3 */ pcm_aL /= 32768; CLIP_INT16(pcm_aL); pcm[ 6] = (OI_INT16)pcm_aL;
+    /* 1 - stage 3 */ pcm_aR /= 32768; CLIP_INT16(pcm_aR); pcm[ 7] = (OI_INT16)pcm_aR;
+    /* 1 - stage 3 */ pcm_bL /= 32768; CLIP_INT16(pcm_bL); pcm[10] = (OI_INT16)pcm_bL;
+    /* 1 - stage 3 */ pcm_bR /= 32768; CLIP_INT16(pcm_bR); pcm[11] = (OI_INT16)pcm_bR;
+    /* 1 - stage 4 */ pcm_aL = 0; pcm_aR = 0;
+    /* 1 - stage 4 */ pcm_aL += (MUL_16S_16S(10445, bufL[  8])) >> 4;
+    /* 1 - stage 4 */ pcm_aR += (MUL_16S_16S(10445, bufR[  8])) >> 4;
+    /* 1 - stage 4 */ pcm_aL += (MUL_16S_16S(-5297, bufL[ 24])) << 1;
+    /* 1 - stage 4 */ pcm_aR += (MUL_16S_16S(-5297, bufR[ 24])) << 1;
+    /* 1 - stage 4 */ pcm_aL += (MUL_16S_16S(22299, bufL[ 40])) << 2;
+    /* 1 - stage 4 */ pcm_aR += (MUL_16S_16S(22299, bufR[ 40])) << 2;
+    /* 1 - stage 4 */ pcm_aL += (MUL_16S_16S(10603, bufL[ 56]));
+    /* 1 - stage 4 */ pcm_aR += (MUL_16S_16S(10603, bufR[ 56]));
+    /* 1 - stage 4 */ pcm_aL += (MUL_16S_16S(9539, bufL[ 72])) >> 4;
+    /* 1 - stage 4 */ pcm_aR += (MUL_16S_16S(9539, bufR[ 72])) >> 4;
+    /* 1 - stage 4 */ pcm_aL /= 32768; CLIP_INT16(pcm_aL); pcm[ 8] = (OI_INT16)pcm_aL;
+    /* 1 - stage 4 */ pcm_aR /= 32768; CLIP_INT16(pcm_aR); pcm[ 9] = (OI_INT16)pcm_aR;
+}
+
+#endif /* #if (defined(SBC_DEC_INCLUDED) && SBC_DEC_INCLUDED == TRUE) */
@@ -236,6 +236,7 @@ INLINE OI_INT32 default_mul_16s_32s_hi(OI_INT16 u, OI_INT32 v)
 #define LONG_MULT_DCT(K, sample) (MUL_16S_32S_HI(K, sample)<<2)
 
 PRIVATE void SynthWindow80_generated(OI_INT16 *pcm, SBC_BUFFER_T const *RESTRICT buffer, OI_UINT strideShift);
+PRIVATE void SynthWindow80_stereo(OI_INT16 *pcm, SBC_BUFFER_T const *RESTRICT bufL, SBC_BUFFER_T const *RESTRICT bufR);
 PRIVATE void SynthWindow112_generated(OI_INT16 *pcm, SBC_BUFFER_T const *RESTRICT buffer, OI_UINT strideShift);
 PRIVATE void dct2_8(SBC_BUFFER_T *RESTRICT out, OI_INT32 const *RESTRICT x);
 
@@ -253,6 +254,16 @@ typedef void (*SYNTH_FRAME)(OI_CODEC_SBC_DECODER_CONTEXT *context, OI_INT16 *pcm
 #define SYNTH80 SynthWindow80_generated
 #endif
 
+#ifndef SYNTH80_STEREO
+#define SYNTH80_STEREO SynthWindow80_stereo
+#endif
+
+/* Set OI_SBC_SYNTH80_STEREO to FALSE to window stereo 8-subband frames one
+   channel at a time, e.g. to compare against the stereo kernel */
+#ifndef OI_SBC_SYNTH80_STEREO
+#define OI_SBC_SYNTH80_STEREO TRUE
+#endif
+
 #ifndef SYNTH112
 #define SYNTH112 SynthWindow112_generated
 #endif
@@ -288,6 +299,44 @@ PRIVATE void OI_SBC_SynthFrame_80(OI_CODEC_SBC_DECODER_CONTEXT *context, OI_INT1
     context->common.filterBufferOffset = offset;
 }
 
+/**
+ * Stereo 8-subband synthesis into an interleaved buffer. Both channels of a
+ * block are transformed back to back and windowed in a single pass; see
+ * synthesis-8-stereo.c. Falls back to the per-channel loop for any other
+ * PCM stride.
+ */
+PRIVATE void OI_SBC_SynthFrame_80_Stereo(OI_CODEC_SBC_DECODER_CONTEXT *context, OI_INT16 *pcm, OI_UINT blkstart, OI_UINT blkcount)
+{
+    OI_UINT blk;
+    OI_UINT offset = context->common.filterBufferOffset;
+    OI_INT32 *s = context->common.subdata + 8 * 2 * blkstart;
+    OI_UINT blkstop = blkstart + blkcount;
+    SBC_BUFFER_T *bufL = context->common.filterBuffer[0];
+    SBC_BUFFER_T *bufR = context->common.filterBuffer[1];
+
+    if (context->common.pcmStride != 2) {
+        OI_SBC_SynthFrame_80(context, pcm, blkstart, blkcount);
+        return;
+    }
+
+    for (blk = blkstart; blk < blkstop; blk++) {
+        if (offset == 0) {
+            COPY_BACKWARD_32BIT_ALIGNED_72_HALFWORDS(bufL + context->common.filterBufferLen - 72, bufL);
+            COPY_BACKWARD_32BIT_ALIGNED_72_HALFWORDS(bufR + context->common.filterBufferLen - 72, bufR);
+            offset = context->common.filterBufferLen - 80;
+        } else {
+            offset -= 1 * 8;
+        }
+
+        DCT2_8(bufL + offset, s);
+        DCT2_8(bufR + offset, s + 8);
+        SYNTH80_STEREO(pcm, bufL + offset, bufR + offset);
+        s += 16;
+        pcm += 16;
+    }
+    context->common.filterBufferOffset = offset;
+}
+
 PRIVATE void OI_SBC_SynthFrame_4SB(OI_CODEC_SBC_DECODER_CONTEXT *context, OI_INT16 *pcm, OI_UINT blkstart, OI_UINT blkcount)
 {
     OI_UINT blk;
@@ -363,7 +412,11 @@ static const SYNTH_FRAME SynthFrameEnhanced[] = {
 static const SYNTH_FRAME SynthFrame8SB[] = {
     NULL,             /* invalid */
     OI_SBC_SynthFrame_80, /* mono */
+#if (OI_SBC_SYNTH80_STEREO == TRUE)
+    OI_SBC_SynthFrame_80_Stereo /* stereo */
+#else
     OI_SBC_SynthFrame_80  /* stereo */
+#endif
 };
 
 
@@ -108,6 +108,27 @@
 #define SBC_IS_64_MULT_IN_WINDOW_ACCU  FALSE
 #endif /*SBC_IS_64_MULT_IN_WINDOW_ACCU */
 
+/* Set SBC_ANALYSIS_PAIRED_MAC to TRUE to run the SBC_IPAQ_OPT windowing two subbands at a time, */
+/* with one 32 bit load per pair of samples and coefficients. Output is bit exact with WINDOW_PARTIAL_x. */
+/* Enabled by default on ARM cores with the DSP extension, where the pairs go to SMLABB/SMLATT; */
+/* elsewhere it can still be forced to TRUE and falls back to a portable C kernel. */
+#ifndef SBC_ANALYSIS_PAIRED_MAC
+#if defined(__ARM_FEATURE_DSP)
+#define SBC_ANALYSIS_PAIRED_MAC TRUE
+#else
+#define SBC_ANALYSIS_PAIRED_MAC FALSE
+#endif
+#endif /* SBC_ANALYSIS_PAIRED_MAC */
+
+/* Use the ACLE DSP intrinsics for SBC_ANALYSIS_PAIRED_MAC (little endian ARM with DSP extension only) */
+#ifndef SBC_ANALYSIS_USE_ACLE
+#if defined(__ARM_FEATURE_DSP) && !defined(__ARM_BIG_ENDIAN)
+#define SBC_ANALYSIS_USE_ACLE TRUE
+#else
+#define SBC_ANALYSIS_USE_ACLE FALSE
+#endif
+#endif /* SBC_ANALYSIS_USE_ACLE */
+
 /* Set SBC_IS_64_MULT_IN_IDCT to TRUE to use 64 bits multiplication in the DCT of Matrixing */
 /* -> more MIPS required for a better audio quality. comparasion with the SIG utilities shows a division by 10 of the RMS */
 /* CAUTION: It only apply in the if SBC_FAST_DCT is set to TRUE */
@@ -34,7 +34,9 @@
 #include "stack/bt_types.h"
 
 typedef short SINT16;
-typedef long SINT32;
+/* The analysis filter addresses pairs of SINT16 as one SINT32, so SINT32 has
+   to be exactly 32 bits, also on LP64 hosts */
+typedef int32_t SINT32;
 
 #if (SBC_IPAQ_OPT == TRUE)
 
@@ -26,6 +26,9 @@
 #include <string.h>
 #include "sbc_encoder.h"
 #include "sbc_enc_func_declare.h"
+#if (SBC_ANALYSIS_USE_ACLE == TRUE)
+#include <arm_acle.h>
+#endif
 /*#include <math.h>*/
 #if (defined(SBC_ENC_INCLUDED) && SBC_ENC_INCLUDED == TRUE)
 
@@ -899,6 +902,121 @@ static SINT16   *s16X = (SINT16 *) s32X;   /* s16X must be 32 bits aligned cf  S
 #endif
 #endif
 
+#if (SBC_ANALYSIS_PAIRED_MAC == TRUE)
+#if (SBC_IPAQ_OPT == FALSE) || (SBC_ARM_ASM_OPT == TRUE) || (SBC_IS_64_MULT_IN_WINDOW_ACCU == TRUE)
+#error "SBC_ANALYSIS_PAIRED_MAC replaces the SBC_IPAQ_OPT windowing with 16 bit coefficients"
+#endif
+
+/* Window coefficients in sample order, two neighbouring subbands per word  */
+/* (low half = even subband). Entry i of tap k multiplies s16X[ChOffset+i+k*2*NumOfSubBands], */
+/* which folds the symmetric pairs of WINDOW_ACCU_x_y into one coefficient per sample. */
+#define SBC_PAIR16(lo, hi) (SINT32)(((UINT32)(UINT16)(hi) << 16) | (UINT32)(UINT16)(lo))
+
+static const SINT32 gas32WindPairs4[20] = {
+    /* s16X[0..7] */
+    SBC_PAIR16(0, WIND_4_SUBBANDS_1_0), SBC_PAIR16(WIND_4_SUBBANDS_2_0, WIND_4_SUBBANDS_3_0),
+    SBC_PAIR16(WIND_4_SUBBANDS_4_0, WIND_4_SUBBANDS_3_4), SBC_PAIR16(WIND_4_SUBBANDS_2_4, WIND_4_SUBBANDS_1_4),
+    /* s16X[8..15] */
+    SBC_PAIR16(WIND_4_SUBBANDS_0_1, WIND_4_SUBBANDS_1_1), SBC_PAIR16(WIND_4_SUBBANDS_2_1, WIND_4_SUBBANDS_3_1),
+    SBC_PAIR16(WIND_4_SUBBANDS_4_1, WIND_4_SUBBANDS_3_3), SBC_PAIR16(WIND_4_SUBBANDS_2_3, WIND_4_SUBBANDS_1_3),
+    /* s16X[16..23] */
+    SBC_PAIR16(WIND_4_SUBBANDS_0_2, WIND_4_SUBBANDS_1_2), SBC_PAIR16(WIND_4_SUBBANDS_2_2, WIND_4_SUBBANDS_3_2),
+    SBC_PAIR16(WIND_4_SUBBANDS_4_2, WIND_4_SUBBANDS_3_2), SBC_PAIR16(WIND_4_SUBBANDS_2_2, WIND_4_SUBBANDS_1_2),
+    /* s16X[24..31] */
+    SBC_PAIR16(-WIND_4_SUBBANDS_0_2, WIND_4_SUBBANDS_1_3), SBC_PAIR16(WIND_4_SUBBANDS_2_3, WIND_4_SUBBANDS_3_3),
+    SBC_PAIR16(WIND_4_SUBBANDS_4_1, WIND_4_SUBBANDS_3_1), SBC_PAIR16(WIND_4_SUBBANDS_2_1, WIND_4_SUBBANDS_1_1),
+    /* s16X[32..39] */
+    SBC_PAIR16(-WIND_4_SUBBANDS_0_1, WIND_4_SUBBANDS_1_4), SBC_PAIR16(WIND_4_SUBBANDS_2_4, WIND_4_SUBBANDS_3_4),
+    SBC_PAIR16(WIND_4_SUBBANDS_4_0, WIND_4_SUBBANDS_3_0), SBC_PAIR16(WIND_4_SUBBANDS_2_0, WIND_4_SUBBANDS_1_0)
+};
+
+static const SINT32 gas32WindPairs8[40] = {
+    /* s16X[0..15] */
+    SBC_PAIR16(0, WIND_8_SUBBANDS_1_0), SBC_PAIR16(WIND_8_SUBBANDS_2_0, WIND_8_SUBBANDS_3_0),
+    SBC_PAIR16(WIND_8_SUBBANDS_4_0, WIND_8_SUBBANDS_5_0), SBC_PAIR16(WIND_8_SUBBANDS_6_0, WIND_8_SUBBANDS_7_0),
+    SBC_PAIR16(WIND_8_SUBBANDS_8_0, WIND_8_SUBBANDS_7_4), SBC_PAIR16(WIND_8_SUBBANDS_6_4, WIND_8_SUBBANDS_5_4),
+    SBC_PAIR16(WIND_8_SUBBANDS_4_4, WIND_8_SUBBANDS_3_4), SBC_PAIR16(WIND_8_SUBBANDS_2_4, WIND_8_SUBBANDS_1_4),
+    /* s16X[16..31] */
+    SBC_PAIR16(WIND_8_SUBBANDS_0_1, WIND_8_SUBBANDS_1_1), SBC_PAIR16(WIND_8_SUBBANDS_2_1, WIND_8_SUBBANDS_3_1),
+    SBC_PAIR16(WIND_8_SUBBANDS_4_1, WIND_8_SUBBANDS_5_1), SBC_PAIR16(WIND_8_SUBBANDS_6_1, WIND_8_SUBBANDS_7_1),
+    SBC_PAIR16(WIND_8_SUBBANDS_8_1, WIND_8_SUBBANDS_7_3), SBC_PAIR16(WIND_8_SUBBANDS_6_3, WIND_8_SUBBANDS_5_3),
+    SBC_PAIR16(WIND_8_SUBBANDS_4_3, WIND_8_SUBBANDS_3_3), SBC_PAIR16(WIND_8_SUBBANDS_2_3, WIND_8_SUBBANDS_1_3),
+    /* s16X[32..47] */
+    SBC_PAIR16(WIND_8_SUBBANDS_0_2, WIND_8_SUBBANDS_1_2), SBC_PAIR16(WIND_8_SUBBANDS_2_2, WIND_8_SUBBANDS_3_2),
+    SBC_PAIR16(WIND_8_SUBBANDS_4_2, WIND_8_SUBBANDS_5_2), SBC_PAIR16(WIND_8_SUBBANDS_6_2, WIND_8_SUBBANDS_7_2),
+    SBC_PAIR16(WIND_8_SUBBANDS_8_2, WIND_8_SUBBANDS_7_2), SBC_PAIR16(WIND_8_SUBBANDS_6_2, WIND_8_SUBBANDS_5_2),
+    SBC_PAIR16(WIND_8_SUBBANDS_4_2, WIND_8_SUBBANDS_3_2), SBC_PAIR16(WIND_8_SUBBANDS_2_2, WIND_8_SUBBANDS_1_2),
+    /* s16X[48..63] */
+    SBC_PAIR16(-WIND_8_SUBBANDS_0_2, WIND_8_SUBBANDS_1_3), SBC_PAIR16(WIND_8_SUBBANDS_2_3, WIND_8_SUBBANDS_3_3),
+    SBC_PAIR16(WIND_8_SUBBANDS_4_3, WIND_8_SUBBANDS_5_3), SBC_PAIR16(WIND_8_SUBBANDS_6_3, WIND_8_SUBBANDS_7_3),
+    SBC_PAIR16(WIND_8_SUBBANDS_8_1, WIND_8_SUBBANDS_7_1), SBC_PAIR16(WIND_8_SUBBANDS_6_1, WIND_8_SUBBANDS_5_1),
+    SBC_PAIR16(WIND_8_SUBBANDS_4_1, WIND_8_SUBBANDS_3_1), SBC_PAIR16(WIND_8_SUBBANDS_2_1, WIND_8_SUBBANDS_1_1),
+    /* s16X[64..79] */
+    SBC_PAIR16(-WIND_8_SUBBANDS_0_1, WIND_8_SUBBANDS_1_4), SBC_PAIR16(WIND_8_SUBBANDS_2_4, WIND_8_SUBBANDS_3_4),
+    SBC_PAIR16(WIND_8_SUBBANDS_4_4, WIND_8_SUBBANDS_5_4), SBC_PAIR16(WIND_8_SUBBANDS_6_4, WIND_8_SUBBANDS_7_4),
+    SBC_PAIR16(WIND_8_SUBBANDS_8_0, WIND_8_SUBBANDS_7_0), SBC_PAIR16(WIND_8_SUBBANDS_6_0, WIND_8_SUBBANDS_5_0),
+    SBC_PAIR16(WIND_8_SUBBANDS_4_0, WIND_8_SUBBANDS_3_0), SBC_PAIR16(WIND_8_SUBBANDS_2_0, WIND_8_SUBBANDS_1_0)
+};
+
+#if (SBC_ANALYSIS_USE_ACLE == TRUE)
+/* One word load fetches the samples of both subbands, SMLABB/SMLATT pick the halves */
+#define SBC_PAIR_MAC(ps16In, s32Coeff, s32Acc0, s32Acc1)                         \
+{                                                                               \
+    SINT32 s32Pair = *(const SINT32 *)(ps16In);                                 \
+    s32Acc0 = __smlabb(s32Pair, s32Coeff, s32Acc0);                             \
+    s32Acc1 = __smlatt(s32Pair, s32Coeff, s32Acc1);                             \
+}
+#else
+#define SBC_PAIR_MAC(ps16In, s32Coeff, s32Acc0, s32Acc1)                         \
+{                                                                               \
+    s32Acc0 += (SINT32)(SINT16)(s32Coeff) * (SINT32)(ps16In)[0];                \
+    s32Acc1 += (SINT32)(SINT16)((s32Coeff) >> 16) * (SINT32)(ps16In)[1];        \
+}
+#endif
+
+/* Same sums as WINDOW_PARTIAL_4, ps16In must be 32 bits aligned */
+static void SbcWindowPaired4(const SINT16 *ps16In, SINT32 *ps32Out)
+{
+    const SINT32 *ps32Coeff = gas32WindPairs4;
+    SINT32 s32Acc0, s32Acc1;
+    SINT32 i;
+
+    for (i = 0; i < 8; i += 2) {
+        s32Acc0 = 0;
+        s32Acc1 = 0;
+        SBC_PAIR_MAC(ps16In + i,      ps32Coeff[0],  s32Acc0, s32Acc1);
+        SBC_PAIR_MAC(ps16In + i + 8,  ps32Coeff[4],  s32Acc0, s32Acc1);
+        SBC_PAIR_MAC(ps16In + i + 16, ps32Coeff[8],  s32Acc0, s32Acc1);
+        SBC_PAIR_MAC(ps16In + i + 24, ps32Coeff[12], s32Acc0, s32Acc1);
+        SBC_PAIR_MAC(ps16In + i + 32, ps32Coeff[16], s32Acc0, s32Acc1);
+        ps32Out[i] = s32Acc0;
+        ps32Out[i + 1] = s32Acc1;
+        ps32Coeff++;
+    }
+}
+
+/* Same sums as WINDOW_PARTIAL_8, ps16In must be 32 bits aligned */
+static void SbcWindowPaired8(const SINT16 *ps16In, SINT32 *ps32Out)
+{
+    const SINT32 *ps32Coeff = gas32WindPairs8;
+    SINT32 s32Acc0, s32Acc1;
+    SINT32 i;
+
+    for (i = 0; i < 16; i += 2) {
+        s32Acc0 = 0;
+        s32Acc1 = 0;
+        SBC_PAIR_MAC(ps16In + i,      ps32Coeff[0],  s32Acc0, s32Acc1);
+        SBC_PAIR_MAC(ps16In + i + 16, ps32Coeff[8],  s32Acc0, s32Acc1);
+        SBC_PAIR_MAC(ps16In + i + 32, ps32Coeff[16], s32Acc0, s32Acc1);
+        SBC_PAIR_MAC(ps16In + i + 48, ps32Coeff[24], s32Acc0, s32Acc1);
+        SBC_PAIR_MAC(ps16In + i + 64, ps32Coeff[32], s32Acc0, s32Acc1);
+        ps32Out[i] = s32Acc0;
+        ps32Out[i + 1] = s32Acc1;
+        ps32Coeff++;
+    }
+}
+#endif /* SBC_ANALYSIS_PAIRED_MAC */
+
 static SINT16 ShiftCounter = 0;
 extern SINT16 EncMaxShiftCounter;
 /****************************************************************************
@@ -920,7 +1038,7 @@ void SbcAnalysisFilter4(SBC_ENC_PARAMS *pstrEncParams)
 #if (SBC_IPAQ_OPT==TRUE)
 #if (SBC_IS_64_MULT_IN_WINDOW_ACCU == TRUE)
     register SINT64 s64Temp, s64Temp2;
-#else
+#elif (SBC_ANALYSIS_PAIRED_MAC == FALSE)
     register SINT32 s32Temp, s32Temp2;
 #endif
 #else
@@ -960,7 +1078,11 @@ void SbcAnalysisFilter4(SBC_ENC_PARAMS *pstrEncParams)
         for (s32Ch = 0; s32Ch < s32NumOfChannels; s32Ch++) {
             ChOffset = s32Ch * Offset2 + Offset;
 
+#if (SBC_ANALYSIS_PAIRED_MAC == TRUE)
+            SbcWindowPaired4(s16X + ChOffset, s32DCTY);
+#else
             WINDOW_PARTIAL_4
+#endif
 
             SBC_FastIDCT4(s32DCTY, ps32SbBuf);
 
@@ -1000,7 +1122,7 @@ void SbcAnalysisFilter8 (SBC_ENC_PARAMS *pstrEncParams)
 #if (SBC_IPAQ_OPT==TRUE)
 #if (SBC_IS_64_MULT_IN_WINDOW_ACCU == TRUE)
     register SINT64 s64Temp, s64Temp2;
-#else
+#elif (SBC_ANALYSIS_PAIRED_MAC == FALSE)
     register SINT32 s32Temp, s32Temp2;
 #endif
 #else
@@ -1050,7 +1172,11 @@ void SbcAnalysisFilter8 (SBC_ENC_PARAMS *pstrEncParams)
         for (s32Ch = 0; s32Ch < s32NumOfChannels; s32Ch++) {
             ChOffset = s32Ch * Offset2 + Offset;
 
+#if (SBC_ANALYSIS_PAIRED_MAC == TRUE)
+            SbcWindowPaired8(s16X + ChOffset, s32DCTY);
+#else
             WINDOW_PARTIAL_8
+#endif
 
             SBC_FastIDCT8 (s32DCTY, ps32SbBuf);
 
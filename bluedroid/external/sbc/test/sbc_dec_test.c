@@ -0,0 +1,138 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Decodes the SBC stream in argv[1] one frame at a time and through
+// OI_CODEC_SBC_DecodeFrames, checks that both produce the same PCM and writes
+// it to argv[2]. The Makefile builds this once per synthesis kernel and
+// compares the PCM byte for byte. Reports frames/s for both entry points and
+// the per-frame decode time distribution, overall and for 8 subband stereo.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "oi_codec_sbc.h"
+#include "oi_status.h"
+#include "host_bench.h"
+#include "sbc_test_signal.h"
+
+#define SBC_TEST_MAX_STREAM     (4 << 20)
+#define SBC_TEST_MAX_FRAMES     32768
+#define SBC_TEST_BATCH          4
+#define SBC_TEST_REPEAT         10
+#define SBC_TEST_FRAME_PCM      (SBC_MAX_BLOCKS * SBC_MAX_BANDS * SBC_MAX_CHANNELS)
+
+unsigned char appl_trace_level;
+
+static OI_CODEC_SBC_DECODER_CONTEXT ctx;
+static OI_UINT32 ctx_data[CODEC_DATA_WORDS(2, SBC_CODEC_FAST_FILTER_BUFFERS)];
+static OI_BYTE stream[SBC_TEST_MAX_STREAM];
+static OI_INT16 pcm_frame[SBC_TEST_MAX_FRAMES * SBC_TEST_FRAME_PCM];
+static OI_INT16 pcm_batch[SBC_TEST_MAX_FRAMES * SBC_TEST_FRAME_PCM];
+static uint64_t ticks_all[SBC_TEST_MAX_FRAMES * SBC_TEST_REPEAT];
+static uint64_t ticks_8ste[SBC_TEST_MAX_FRAMES * SBC_TEST_REPEAT];
+
+// Decodes the whole stream, |batch| frames per call, into |pcm|. Returns the
+// number of PCM bytes or -1 on a decode error.
+static long decode_stream(size_t len, OI_UINT batch, OI_INT16 *pcm, size_t *frames, uint64_t *ns,
+                          size_t *n_all, size_t *n_8ste)
+{
+    const OI_BYTE *p = stream;
+    OI_UINT32 left = len;
+    OI_BYTE *out = (OI_BYTE *)pcm;
+    OI_UINT32 pcm_bytes;
+    OI_UINT decoded;
+    OI_STATUS status;
+    uint64_t t0, c0, c;
+
+    OI_CODEC_SBC_DecoderReset(&ctx, ctx_data, sizeof(ctx_data), 2, 2, FALSE);
+    while (left) {
+        pcm_bytes = batch * SBC_TEST_FRAME_PCM * sizeof(OI_INT16);
+        decoded = 1;
+        t0 = host_bench_now_ns();
+        c0 = host_bench_ticks();
+        if (batch == 1) {
+            status = OI_CODEC_SBC_DecodeFrame(&ctx, &p, &left, (OI_INT16 *)out, &pcm_bytes);
+        } else {
+            status = OI_CODEC_SBC_DecodeFrames(&ctx, &p, &left, batch, (OI_INT16 *)out, &pcm_bytes, &decoded);
+        }
+        c = host_bench_ticks() - c0;
+        *ns += host_bench_now_ns() - t0;
+        if (!OI_SUCCESS(status)) {
+            fprintf(stderr, "decode failed with status %d, %u bytes left\n", (int)status, (unsigned)left);
+            return -1;
+        }
+        if (n_all) {
+            ticks_all[(*n_all)++] = c;
+            if (ctx.common.frameInfo.nrof_subbands == 8 && ctx.common.frameInfo.nrof_channels == 2) {
+                ticks_8ste[(*n_8ste)++] = c;
+            }
+        }
+        out += pcm_bytes;
+        *frames += decoded;
+    }
+    return out - (OI_BYTE *)pcm;
+}
+
+int main(int argc, char **argv)
+{
+    FILE *f;
+    size_t len;
+    size_t frames_one = 0, frames_batch = 0, n_all = 0, n_8ste = 0;
+    uint64_t ns_one = 0, ns_batch = 0;
+    long bytes_one = 0, bytes_batch = 0;
+    int rep;
+
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <in.sbc> <out.pcm>\n", argv[0]);
+        return 2;
+    }
+    f = fopen(argv[1], "rb");
+    if (!f) {
+        perror(argv[1]);
+        return 2;
+    }
+    len = fread(stream, 1, sizeof(stream), f);
+    fclose(f);
+    if (len == sizeof(stream)) {
+        fprintf(stderr, "%s: stream too long\n", argv[1]);
+        return 2;
+    }
+
+    for (rep = 0; rep < SBC_TEST_REPEAT; rep++) {
+        bytes_one = decode_stream(len, 1, pcm_frame, &frames_one, &ns_one, &n_all, &n_8ste);
+        bytes_batch = decode_stream(len, SBC_TEST_BATCH, pcm_batch, &frames_batch, &ns_batch, NULL, NULL);
+        if (bytes_one < 0 || bytes_batch < 0) {
+            return 1;
+        }
+    }
+    if (bytes_one != bytes_batch || memcmp(pcm_frame, pcm_batch, bytes_one) != 0) {
+        fprintf(stderr, "FAIL: OI_CODEC_SBC_DecodeFrames output differs from OI_CODEC_SBC_DecodeFrame\n");
+        return 1;
+    }
+
+    f = fopen(argv[2], "wb");
+    if (!f) {
+        perror(argv[2]);
+        return 2;
+    }
+    fwrite(pcm_frame, 1, bytes_one, f);
+    fclose(f);
+
+    printf("%s: %zu frames, crc32 %08x\n", argv[2], frames_one / SBC_TEST_REPEAT,
+           (unsigned)sbc_test_crc32(0, pcm_frame, bytes_one));
+    printf("  DecodeFrame      %.0f frames/s\n", frames_one * 1e9 / (double)ns_one);
+    printf("  DecodeFrames(%d)  %.0f frames/s\n", SBC_TEST_BATCH, frames_batch * 1e9 / (double)ns_batch);
+    host_bench_report_dist("decode frame", ticks_all, n_all, HOST_BENCH_TICK_UNIT);
+    host_bench_report_dist("decode frame 8sb stereo", ticks_8ste, n_8ste, HOST_BENCH_TICK_UNIT);
+    return 0;
+}
@@ -0,0 +1,75 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef _SBC_TEST_SIGNAL_H_
+#define _SBC_TEST_SIGNAL_H_
+
+// Deterministic PCM corpus for the SBC host tests: a tone sweep per channel
+// mixed with noise, with a burst of full scale square wave every 32 frames to
+// exercise clipping and the top of the scale factor range.
+
+#include <math.h>
+#include <stdint.h>
+
+typedef struct {
+    uint32_t seed;
+    uint32_t sample;
+} sbc_test_signal_t;
+
+static inline void sbc_test_signal_init(sbc_test_signal_t *sig)
+{
+    sig->seed = 1;
+    sig->sample = 0;
+}
+
+// Fills one frame of |samples_per_ch| interleaved samples per channel
+static inline void sbc_test_signal_frame(sbc_test_signal_t *sig, uint32_t frame, int16_t *pcm,
+                                         int channels, int samples_per_ch)
+{
+    int n, ch;
+    int32_t v;
+
+    for (n = 0; n < samples_per_ch; n++, sig->sample++) {
+        for (ch = 0; ch < channels; ch++) {
+            sig->seed = sig->seed * 1103515245u + 12345u;
+            if ((frame & 31) == 7) {
+                v = (sig->seed & 0x10000) ? 32767 : -32768;
+            } else {
+                double phase = (double)sig->sample * (0.013 + 0.00001 * (sig->sample % 4096)) * (1 + ch);
+                v = (int32_t)(12000.0 * sin(phase)) + (int32_t)((sig->seed >> 16) & 0x3fff) - 0x2000;
+            }
+            if (v > 32767) {
+                v = 32767;
+            } else if (v < -32768) {
+                v = -32768;
+            }
+            pcm[n * channels + ch] = (int16_t)v;
+        }
+    }
+}
+
+static inline uint32_t sbc_test_crc32(uint32_t crc, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    int k;
+
+    crc = ~crc;
+    while (len--) {
+        crc ^= *p++;
+        for (k = 0; k < 8; k++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+#endif /* _SBC_TEST_SIGNAL_H_ */
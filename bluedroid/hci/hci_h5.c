@@ -2168,7 +2168,7 @@ static osi_alarm_t *OsAllocateTimer(tTIMER_HANDLE_CBACK timer_callback)
     //HCI_TRACE_DEBUG("OsAllocateTimer rtk_parse sigev.sigev_notify_thread_id = syscall(__NR_gettid)!");
     //Create the Timer using timer_create signal
 
-    if ((ret = osi_alarm_new("hci_h5", timer_callback, NULL, 0)) != NULL) {
+    if ((ret = osi_alarm_new_ext("hci_h5", timer_callback, NULL, NULL)) != NULL) {
         return ret;
     } else {
         HCI_TRACE_ERROR("timer_create error!");
@@ -45,8 +45,25 @@
 #define CONFIG_HCI_UART_BAUDRATE 115200
 #endif
 
+// Drain the UART in bulk into a ring buffer on every wakeup and run the H4
+// parser on that, instead of one driver call per header/payload fragment.
+#ifndef CONFIG_HCI_H4_RX_BULK
+#define CONFIG_HCI_H4_RX_BULK 1
+#endif
+
+// Must be a power of two.
+#ifndef CONFIG_HCI_H4_RX_RING_SIZE
+#define CONFIG_HCI_H4_RX_RING_SIZE 2048
+#endif
+
+#if (CONFIG_HCI_H4_RX_RING_SIZE & (CONFIG_HCI_H4_RX_RING_SIZE - 1))
+#error "CONFIG_HCI_H4_RX_RING_SIZE must be a power of two"
+#endif
+
 #define HCI_HAL_SERIAL_BUFFER_SIZE 1026
 #define HCI_BLE_EVENT 0x3e
+#define ACL_START_PACKET_BOUNDARY 2
+#define ACL_L2CAP_HEADER_SIZE 4
 #define PACKET_TYPE_TO_INBOUND_INDEX(type) ((type) - 2)
 #define PACKET_TYPE_TO_INDEX(type) ((type) - 1)
 extern bool BTU_check_queue_is_congest(void);
@@ -84,7 +101,7 @@ struct bt_hci_acl_hdr {
 };
 
 typedef struct rx_t {
-    uint8_t *buf;
+    BT_HDR *buf;
     uint16_t cur_len;
 
     uint16_t remaining;
@@ -99,16 +116,34 @@ typedef struct rx_t {
     union {
         struct bt_hci_evt_hdr evt;
         struct bt_hci_acl_hdr acl;
-        uint8_t hdr[4];
+        /* ACL start fragments also take the L2CAP length, see get_acl_hdr() */
+        uint8_t hdr[sizeof(struct bt_hci_acl_hdr) + 2];
     };
 
     uint8_t ongoing;
 } rx_t;
 
+#if CONFIG_HCI_H4_RX_BULK
+typedef struct rx_ring_t {
+    uint8_t  buf[CONFIG_HCI_H4_RX_RING_SIZE];
+    uint32_t head;  /* free running, written by the uart drain */
+    uint32_t tail;  /* free running, consumed by the H4 parser */
+} rx_ring_t;
+
+#define RX_RING_MASK            (CONFIG_HCI_H4_RX_RING_SIZE - 1)
+#define RX_RING_USED(r)         ((r)->head - (r)->tail)
+#define RX_RING_FREE(r)         (CONFIG_HCI_H4_RX_RING_SIZE - RX_RING_USED(r))
+#endif /* CONFIG_HCI_H4_RX_BULK */
+
 typedef struct h4_dev_t {
     dev_t *dev;
 
     rx_t rx;
+#if CONFIG_HCI_H4_RX_BULK
+    rx_ring_t ring;
+#endif
+    hci_hal_h4_rx_stats_t stats;
+    uint32_t wakeup_packets;
 } h4_dev_t;
 
 
@@ -126,7 +161,7 @@ static aos_queue_t hcih4_queue;
 static char queue_buf[HCI_H4_QUEUE_LEN * sizeof(BtTaskEvt_t)];
 
 //static void host_send_pkt_available_cb(void);
-static int host_recv_pkt_cb(uint8_t *data, uint16_t len);
+static int host_recv_pkt_cb(BT_HDR *pkt);
 
 static void hci_hal_h4_rx_handler(void *arg);
 
@@ -189,13 +224,81 @@ static void hci_hal_env_init(
     return;
 }
 
+#if CONFIG_HCI_H4_RX_BULK
+static uint32_t rx_ring_fill(void)
+{
+    rx_ring_t *ring = &h4_dev.ring;
+    uint32_t total = 0;
+    uint32_t space;
+    int32_t read_len;
+
+    while ((space = RX_RING_FREE(ring)) > 0) {
+        uint32_t pos = ring->head & RX_RING_MASK;
+
+        if (space > CONFIG_HCI_H4_RX_RING_SIZE - pos) {
+            space = CONFIG_HCI_H4_RX_RING_SIZE - pos;
+        }
+
+        read_len = uart_recv(h4_dev.dev, ring->buf + pos, space, 0);
+        if (read_len <= 0) {
+            break;
+        }
+
+        ring->head += read_len;
+        total += read_len;
+
+        if ((uint32_t)read_len < space) {
+            break;
+        }
+    }
+
+    if (RX_RING_FREE(ring) == 0) {
+        h4_dev.stats.ring_full++;
+    }
+
+    return total;
+}
+
+static uint32_t rx_ring_read(uint8_t *data, uint32_t len)
+{
+    rx_ring_t *ring = &h4_dev.ring;
+    uint32_t used = RX_RING_USED(ring);
+    uint32_t pos = ring->tail & RX_RING_MASK;
+    uint32_t first;
+
+    if (len > used) {
+        len = used;
+    }
+
+    if (data) {
+        first = CONFIG_HCI_H4_RX_RING_SIZE - pos;
+        if (first > len) {
+            first = len;
+        }
+        memcpy(data, ring->buf + pos, first);
+        memcpy(data + first, ring->buf, len - first);
+    }
+
+    ring->tail += len;
+
+    return len;
+}
+#endif /* CONFIG_HCI_H4_RX_BULK */
+
 static uint32_t read_byte(uint8_t *data, uint32_t len)
 {
     int32_t read_len;
 
+#if CONFIG_HCI_H4_RX_BULK
+    read_len = rx_ring_read(data, len);
+#else
     read_len = uart_recv(h4_dev.dev, data, len, 0);
+#endif
 
-    BTTRC_DUMP_BUFFER("recv data", data, read_len);
+    /* data is NULL when the bytes are discarded */
+    if (data) {
+        BTTRC_DUMP_BUFFER("recv data", data, read_len);
+    }
 
     if (read_len == 0) {
         h4_dev.rx.ongoing = 0;
@@ -248,13 +351,22 @@ static inline void h4_get_type(void)
 static inline void get_acl_hdr(void)
 {
     struct bt_hci_acl_hdr *hdr = &h4_dev.rx.acl;
-    int to_read = sizeof(*hdr) - h4_dev.rx.remaining;
+    int to_read = h4_dev.rx.hdr_len - h4_dev.rx.remaining;
 
-    h4_dev.rx.remaining -= read_byte((uint8_t *)hdr + to_read,
+    h4_dev.rx.remaining -= read_byte(h4_dev.rx.hdr + to_read,
                                      h4_dev.rx.remaining);
 
     if (!h4_dev.rx.remaining) {
-        h4_dev.rx.remaining = hdr->len;
+        if (h4_dev.rx.hdr_len == sizeof(*hdr) && hdr->len > 2 &&
+            ((hdr->handle >> 12) & 0x0003) == ACL_START_PACKET_BOUNDARY) {
+            /* Read the L2CAP length of a start fragment with the header,
+               so its buffer can be sized for the whole L2CAP packet */
+            h4_dev.rx.hdr_len += 2;
+            h4_dev.rx.remaining = 2;
+            return;
+        }
+
+        h4_dev.rx.remaining = hdr->len - (h4_dev.rx.hdr_len - sizeof(*hdr));
         HCI_TRACE_DEBUG("Got ACL header. Payload %u bytes", h4_dev.rx.remaining);
         h4_dev.rx.have_hdr = true;
     }
@@ -323,18 +435,56 @@ static struct net_buf *get_rx(int timeout)
 
 static size_t h4_discard(size_t len)
 {
+#if CONFIG_HCI_H4_RX_BULK
+    // Just skip over the bytes in the ring, no need to copy them out
+    return read_byte(NULL, len);
+#else
     uint8_t buf[33];
 
     return read_byte(buf, min(len, sizeof(buf)));
+#endif
+}
+
+// Returns the length of the whole L2CAP packet, ACL preamble included, an
+// ACL start fragment begins if the fragment doesn't hold all of it, else 0.
+static uint32_t acl_l2cap_full_len(void)
+{
+    uint32_t full_len;
+
+    if (h4_dev.rx.type != DATA_TYPE_ACL || h4_dev.rx.hdr_len != sizeof(h4_dev.rx.hdr)) {
+        return 0;
+    }
+
+    full_len = (h4_dev.rx.hdr[4] | (h4_dev.rx.hdr[5] << 8)) + ACL_L2CAP_HEADER_SIZE +
+               HCI_ACL_PREAMBLE_SIZE;
+    if (full_len <= h4_dev.rx.acl.len + HCI_ACL_PREAMBLE_SIZE || full_len > 0xFFFF) {
+        return 0;
+    }
+    return full_len;
 }
 
 static inline void read_payload(void)
 {
+    uint32_t full_len;
     int read;
 
     if (!h4_dev.rx.buf) {
-        h4_dev.rx.buf = hci_hal_env.allocator->alloc(h4_dev.rx.remaining +
-                                                     h4_dev.rx.hdr_len + 1);
+        // Allocate the final BT_HDR up front, so the payload is read straight
+        // into place and handed upwards without another copy. A start
+        // fragment gets room for its whole L2CAP packet, so the fragmenter
+        // can append the continuation fragments to it.
+        if ((full_len = acl_l2cap_full_len()) != 0) {
+            h4_dev.rx.buf = hci_hal_env.allocator->alloc(BT_HDR_SIZE + full_len + 1);
+        }
+        if (h4_dev.rx.buf) {
+            h4_dev.rx.buf->layer_specific = HCI_ACL_RX_L2CAP_ROOM;
+        } else {
+            h4_dev.rx.buf = hci_hal_env.allocator->alloc(BT_HDR_SIZE + h4_dev.rx.remaining +
+                                                         h4_dev.rx.hdr_len + 1);
+            if (h4_dev.rx.buf) {
+                h4_dev.rx.buf->layer_specific = 0;
+            }
+        }
 
         if (!h4_dev.rx.buf) {
             if (h4_dev.rx.discardable) {
@@ -358,12 +508,13 @@ static inline void read_payload(void)
             return;
         }
 #endif
-        set_hdr_type(h4_dev.rx.buf);
-        copy_hdr(h4_dev.rx.buf + 1);
+        h4_dev.rx.buf->offset = 0;
+        set_hdr_type(h4_dev.rx.buf->data);
+        copy_hdr(h4_dev.rx.buf->data + 1);
         h4_dev.rx.cur_len = h4_dev.rx.hdr_len + 1;
     }
 
-    read = read_byte(h4_dev.rx.buf + h4_dev.rx.cur_len, h4_dev.rx.remaining);
+    read = read_byte(h4_dev.rx.buf->data + h4_dev.rx.cur_len, h4_dev.rx.remaining);
     h4_dev.rx.cur_len += read;
     h4_dev.rx.remaining -= read;
 
@@ -373,7 +524,9 @@ static inline void read_payload(void)
         return;
     }
 
-    host_recv_pkt_cb(h4_dev.rx.buf, h4_dev.rx.cur_len);
+    h4_dev.rx.buf->len = h4_dev.rx.cur_len;
+    h4_dev.wakeup_packets++;
+    host_recv_pkt_cb(h4_dev.rx.buf);
 
     reset_rx();
 
@@ -420,10 +573,51 @@ static inline void process_rx(void)
 
 static void recv_data()
 {
+    uint32_t bytes = 0;
+#if CONFIG_HCI_H4_RX_BULK
+    uint32_t filled;
+#endif
+
+    h4_dev.wakeup_packets = 0;
+
+    if (callbacks->rx_batch_begin) {
+        callbacks->rx_batch_begin();
+    }
+
+#if CONFIG_HCI_H4_RX_BULK
+    // Drain everything the UART holds, parse as many packets as the ring
+    // contains, and go again until the driver has nothing left.
+    do {
+        filled = rx_ring_fill();
+        bytes += filled;
+
+        do {
+            h4_dev.rx.ongoing = 1;
+            process_rx();
+        } while (h4_dev.rx.ongoing);
+    } while (filled);
+#else
     do {
         h4_dev.rx.ongoing = 1;
         process_rx();
     } while (h4_dev.rx.ongoing);
+#endif
+
+    if (callbacks->rx_batch_end) {
+        callbacks->rx_batch_end();
+    }
+
+    h4_dev.stats.wakeups++;
+    h4_dev.stats.rx_bytes += bytes;
+    h4_dev.stats.rx_packets += h4_dev.wakeup_packets;
+    h4_dev.stats.last_bytes_per_wakeup = bytes;
+    h4_dev.stats.last_packets_per_wakeup = h4_dev.wakeup_packets;
+    if (bytes > h4_dev.stats.max_bytes_per_wakeup) {
+        h4_dev.stats.max_bytes_per_wakeup = bytes;
+    }
+    if (h4_dev.wakeup_packets > h4_dev.stats.max_packets_per_wakeup) {
+        h4_dev.stats.max_packets_per_wakeup = h4_dev.wakeup_packets;
+    }
 }
 
 static void uart_event(dev_t *dev, int event_id, void *priv)
@@ -703,33 +897,17 @@ static void host_send_pkt_available_cb(void)
 }
 #endif
 
-static int host_recv_pkt_cb(uint8_t *data, uint16_t len)
+static int host_recv_pkt_cb(BT_HDR *pkt)
 {
-    //Target has packet to host, malloc new buffer for packet
-    BT_HDR *pkt;
-    size_t pkt_size;
-
+    //Target has packet to host, the H4 reassembly already built it in place
     //if (hci_hal_env.rx_q == NULL) {
     //    return 0;
     //}
 
-    pkt_size = BT_HDR_SIZE + len;
-    pkt = (BT_HDR *)hci_hal_env.allocator->alloc(pkt_size);
-    if (!pkt) {
-        HCI_TRACE_ERROR("%s couldn't aquire memory for inbound data buffer.\n", __func__);
-        return -1;
-    }
-    pkt->offset = 0;
-    pkt->len = len;
-    pkt->layer_specific = 0;
-    memcpy(pkt->data, data, len);
-
-    hci_hal_env.allocator->free(data);
-
-    BTTRC_DUMP_BUFFER("Recv Pkt", pkt->data, len);
+    BTTRC_DUMP_BUFFER("Recv Pkt", pkt->data, pkt->len);
 
 #if CONFIG_WIRESHARK_DUMP == TRUE
-    tcpdump_buffer_print(aos_now_ms(), pkt->data, len);
+    tcpdump_buffer_print(aos_now_ms(), pkt->data, pkt->len);
 #endif
 
     hci_hal_h4_hdl_rx_packet(pkt);
@@ -757,3 +935,10 @@ const hci_hal_t *hci_hal_h4_get_interface()
     return &interface;
 }
 
+void hci_hal_h4_get_rx_stats(hci_hal_h4_rx_stats_t *stats)
+{
+    assert(stats != NULL);
+
+    *stats = h4_dev.stats;
+}
+
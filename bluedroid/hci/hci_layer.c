@@ -33,9 +33,57 @@
 #include "osi/thread.h"
 #include "osi/mutex.h"
 #include "osi/fixed_queue.h"
+#include "osi/spsc_queue.h"
+
+// Max number of inbound packets collected before they are posted to BTU
+#ifndef HCI_RX_BATCH_MAX
+#define HCI_RX_BATCH_MAX 16
+#endif
+
+// Number of distinct opcodes with their own latency statistics, must be a
+// power of two
+#ifndef HCI_CMD_LATENCY_STATS_MAX
+#define HCI_CMD_LATENCY_STATS_MAX 32
+#endif
+
+#if (HCI_CMD_LATENCY_STATS_MAX & (HCI_CMD_LATENCY_STATS_MAX - 1))
+#error "HCI_CMD_LATENCY_STATS_MAX must be a power of two"
+#endif
+
+// Outbound ACL/SCO data is sorted into per connection queues and sent
+// weighted round robin, so one bulk link can't starve the others. Packets
+// beyond HCI_ACL_SCHED_LINK_QUEUE_LEN wait in an overflow list of their link.
+#ifndef HCI_ACL_SCHED_MAX_LINKS
+#define HCI_ACL_SCHED_MAX_LINKS 8
+#endif
+
+#ifndef HCI_ACL_SCHED_LINK_QUEUE_LEN
+#define HCI_ACL_SCHED_LINK_QUEUE_LEN 16
+#endif
+
+#if (HCI_ACL_SCHED_LINK_QUEUE_LEN & (HCI_ACL_SCHED_LINK_QUEUE_LEN - 1))
+#error "HCI_ACL_SCHED_LINK_QUEUE_LEN must be a power of two"
+#endif
+
+// Packets (fragments) a link may send per round, by class
+#ifndef HCI_ACL_WEIGHT_DEFAULT
+#define HCI_ACL_WEIGHT_DEFAULT  2
+#endif
+#ifndef HCI_ACL_WEIGHT_MEDIA
+#define HCI_ACL_WEIGHT_MEDIA    4
+#endif
+#ifndef HCI_ACL_WEIGHT_HID
+#define HCI_ACL_WEIGHT_HID      4
+#endif
+#ifndef HCI_ACL_WEIGHT_BULK
+#define HCI_ACL_WEIGHT_BULK     1
+#endif
+
+#define HCI_ACL_HANDLE_MASK     0x0FFF
 
 typedef struct {
     uint16_t opcode;
+    int64_t enqueue_us;
     future_t *complete_future;
     command_complete_cb complete_callback;
     command_status_cb status_callback;
@@ -43,6 +91,37 @@ typedef struct {
     BT_HDR *command;
 } waiting_command_t;
 
+typedef struct {
+    BT_HDR *packet;
+    int64_t enqueue_us;
+} acl_sched_entry_t;
+
+typedef struct {
+    // Only written under acl_sched_lock, read freely by the host task
+    bool in_use;
+    uint8_t link_class;
+    uint16_t handle;
+
+    // Only touched by the host task
+    uint16_t head;
+    uint16_t tail;
+    acl_sched_entry_t queue[HCI_ACL_SCHED_LINK_QUEUE_LEN];
+    // acl_sched_entry_t's that didn't fit in queue, oldest first
+    list_t *overflow;
+
+    hci_acl_link_stats_t stats;
+} acl_sched_link_t;
+
+typedef struct {
+    osi_mutex_t lock;
+    acl_sched_link_t links[HCI_ACL_SCHED_MAX_LINKS];
+    // acl_sched_entry_t's of connections that found no free link slot,
+    // oldest first. Only touched by the host task.
+    list_t *unassigned;
+    uint8_t rr_cur;
+    uint8_t rr_budget;
+} acl_sched_t;
+
 typedef struct {
     bool timer_is_set;
     osi_alarm_t *command_response_timer;
@@ -53,10 +132,25 @@ typedef struct {
 typedef struct {
     int command_credits;
     fixed_queue_t *command_queue;
-    fixed_queue_t *packet_queue;
+    // Only BTU enqueues outbound data and only the HCI host task sends it
+    spsc_queue_t *packet_queue;
+    acl_sched_t acl_sched;
 
     command_waiting_response_t cmd_waiting_q;
 
+    // Set while a SIG_HCI_HOST_SEND_AVAILABLE is queued and not yet handled,
+    // so back to back transmits don't each cost a post
+    bool send_kicked;
+
+    // Guarded by cmd_waiting_q.commands_pending_response_lock
+    hci_cmd_latency_t cmd_latency[HCI_CMD_LATENCY_STATS_MAX];
+
+    // Inbound packets held back while the HAL reports a receive batch.
+    // Only touched from the HAL receive context.
+    bool rx_batch_active;
+    uint16_t rx_batch_count;
+    BT_HDR *rx_batch[HCI_RX_BATCH_MAX];
+
     /*
       non_repeating_timer_t *command_response_timer;
       list_t *commands_pending_response;
@@ -90,14 +184,23 @@ static int hci_layer_init_env(void);
 static void hci_layer_deinit_env(void);
 static void hci_host_thread_handler(void *arg);
 static void event_command_ready(fixed_queue_t *queue);
-static void event_packet_ready(fixed_queue_t *queue);
 static void restart_command_waiting_response_timer(command_waiting_response_t *cmd_wait_q);
+static void hci_host_send_kick(void);
+static void hci_host_send_pending(void);
+static void record_command_latency(waiting_command_t *wait_entry);
+static void acl_sched_init(void);
+static void acl_sched_deinit(void);
+static bool acl_sched_send_one(void);
 static void command_timed_out(void *context);
 static void hal_says_packet_ready(BT_HDR *packet);
 static bool filter_incoming_event(BT_HDR *packet);
 static serial_data_type_t event_to_data_type(uint16_t event);
 static waiting_command_t *get_waiting_command(command_opcode_t opcode);
 static void dispatch_reassembled(BT_HDR *packet);
+static void dispatch_reassembled_batched(BT_HDR *packet);
+static void hal_says_rx_batch_begin(void);
+static void hal_says_rx_batch_end(void);
+static void rx_batch_flush(void);
 
 // Module lifecycle functions
 int hci_start_up(void)
@@ -167,6 +270,8 @@ static int hci_layer_init_env(void)
     // as per the Bluetooth spec, Volume 2, Part E, 4.4 (Command Flow Control)
     // This value can change when you get a command complete or command status event.
     hci_host_env.command_credits = 1;
+    hci_host_env.send_kicked = false;
+    memset(hci_host_env.cmd_latency, 0, sizeof(hci_host_env.cmd_latency));
     hci_host_env.command_queue = fixed_queue_new(QUEUE_SIZE_MAX);
 
     if (hci_host_env.command_queue) {
@@ -176,14 +281,13 @@ static int hci_layer_init_env(void)
         return -1;
     }
 
-    hci_host_env.packet_queue = fixed_queue_new(QUEUE_SIZE_MAX);
+    hci_host_env.packet_queue = spsc_queue_new(QUEUE_SIZE_MAX);
 
-    if (hci_host_env.packet_queue) {
-        fixed_queue_register_dequeue(hci_host_env.packet_queue, event_packet_ready);
-    } else {
+    if (!hci_host_env.packet_queue) {
         HCI_TRACE_ERROR("%s unable to create pending packet queue.", __func__);
         return -1;
     }
+    acl_sched_init();
 
 #if 0
     hci_host_env.recv_queue = fixed_queue_new(QUEUE_SIZE_MAX);
@@ -227,7 +331,8 @@ static void hci_layer_deinit_env(void)
     }
 
     if (hci_host_env.packet_queue) {
-        fixed_queue_free(hci_host_env.packet_queue, buffer_allocator->free);
+        acl_sched_deinit();
+        spsc_queue_free(hci_host_env.packet_queue, buffer_allocator->free);
     }
 
     cmd_wait_q = &hci_host_env.cmd_waiting_q;
@@ -256,20 +361,335 @@ static void hci_host_thread_handler(void *arg)
         if (0 == aos_queue_recv(&hcihost_queue, AOS_WAIT_FOREVER, &e, &len)) {
 
             if (e.sig == SIG_HCI_HOST_SEND_AVAILABLE) {
-                BT_HDR *pkt = packet_fragmenter->fragment_current_packet();
-
-                if (pkt != NULL) {
-                    packet_fragmenter->fragment_and_dispatch(pkt);
-                } else {
-                    if (!fixed_queue_is_empty(hci_host_env.command_queue) &&
-                        hci_host_env.command_credits > 0) {
-                        fixed_queue_process(hci_host_env.command_queue);
-                    } else if (!fixed_queue_is_empty(hci_host_env.packet_queue)) {
-                        fixed_queue_process(hci_host_env.packet_queue);
-                    }
-                }
+                // Anything enqueued from here on needs a new post
+                __atomic_store_n(&hci_host_env.send_kicked, false, __ATOMIC_RELEASE);
+                hci_host_send_pending();
+            }
+        }
+    }
+}
+
+// Sends as many commands as the controller has credits for, alternating
+// with one ACL packet (or fragment) per command so neither side starves.
+static void hci_host_send_pending(void)
+{
+    bool progress;
+
+    do {
+        progress = false;
+
+        if (hci_host_env.command_credits > 0 &&
+            !fixed_queue_is_empty(hci_host_env.command_queue)) {
+            fixed_queue_process(hci_host_env.command_queue);
+            progress = true;
+        }
+
+        if (acl_sched_send_one()) {
+            progress = true;
+        }
+    } while (progress);
+}
+
+static void acl_sched_init(void)
+{
+    acl_sched_t *sched = &hci_host_env.acl_sched;
+    int i;
+
+    memset(sched->links, 0, sizeof(sched->links));
+    for (i = 0; i < HCI_ACL_SCHED_MAX_LINKS; i++) {
+        sched->links[i].overflow = list_new(NULL);
+    }
+    sched->unassigned = list_new(NULL);
+    sched->rr_cur = 0;
+    sched->rr_budget = 0;
+    osi_mutex_new(&sched->lock);
+}
+
+static void acl_sched_free_entries(list_t *entries)
+{
+    acl_sched_entry_t *entry;
+
+    if (!entries) {
+        return;
+    }
+    while (!list_is_empty(entries)) {
+        entry = list_front(entries);
+        list_remove(entries, entry);
+        buffer_allocator->free(entry->packet);
+        osi_free(entry);
+    }
+    list_free(entries);
+}
+
+static void acl_sched_deinit(void)
+{
+    acl_sched_t *sched = &hci_host_env.acl_sched;
+    acl_sched_link_t *link;
+    int i;
+
+    for (i = 0; i < HCI_ACL_SCHED_MAX_LINKS; i++) {
+        link = &sched->links[i];
+        while (link->head != link->tail) {
+            buffer_allocator->free(link->queue[link->head++ & (HCI_ACL_SCHED_LINK_QUEUE_LEN - 1)].packet);
+        }
+        acl_sched_free_entries(link->overflow);
+    }
+    acl_sched_free_entries(sched->unassigned);
+    sched->unassigned = NULL;
+    memset(sched->links, 0, sizeof(sched->links));
+    osi_mutex_free(&sched->lock);
+}
+
+static uint8_t acl_sched_weight(uint8_t link_class)
+{
+    switch (link_class) {
+    case HCI_ACL_CLASS_MEDIA:
+        return HCI_ACL_WEIGHT_MEDIA;
+    case HCI_ACL_CLASS_HID:
+        return HCI_ACL_WEIGHT_HID;
+    case HCI_ACL_CLASS_BULK:
+        return HCI_ACL_WEIGHT_BULK;
+    default:
+        return HCI_ACL_WEIGHT_DEFAULT;
+    }
+}
+
+static inline bool acl_sched_link_idle(acl_sched_link_t *link)
+{
+    return link->head == link->tail && link->link_class == HCI_ACL_CLASS_DEFAULT;
+}
+
+// Finds the link for |handle|, taking a free or idle slot if there's none.
+// |create| is false when only an existing link is wanted.
+static acl_sched_link_t *acl_sched_get_link(uint16_t handle, bool create)
+{
+    acl_sched_t *sched = &hci_host_env.acl_sched;
+    acl_sched_link_t *link, *spare = NULL;
+    int i;
+
+    for (i = 0; i < HCI_ACL_SCHED_MAX_LINKS; i++) {
+        link = &sched->links[i];
+        if (link->in_use && link->handle == handle) {
+            return link;
+        }
+    }
+
+    if (!create) {
+        return NULL;
+    }
+
+    osi_mutex_lock(&sched->lock, OSI_MUTEX_MAX_TIMEOUT);
+    for (i = 0; i < HCI_ACL_SCHED_MAX_LINKS; i++) {
+        link = &sched->links[i];
+        if (link->in_use && link->handle == handle) {
+            spare = link;
+            break;
+        }
+        if (!spare && (!link->in_use || acl_sched_link_idle(link))) {
+            spare = link;
+        }
+    }
+
+    if (spare && (!spare->in_use || spare->handle != handle)) {
+        memset(&spare->stats, 0, sizeof(spare->stats));
+        spare->stats.handle = handle;
+        spare->link_class = HCI_ACL_CLASS_DEFAULT;
+        spare->handle = handle;
+        spare->in_use = true;
+    }
+    osi_mutex_unlock(&sched->lock);
+
+    return spare;
+}
+
+static void acl_sched_update_depth(acl_sched_link_t *link)
+{
+    uint16_t depth = (uint16_t)(link->tail - link->head) + list_length(link->overflow);
+
+    link->stats.queue_depth = depth;
+    if (depth > link->stats.max_queue_depth) {
+        link->stats.max_queue_depth = depth;
+    }
+}
+
+// Queues |packet| on the link of its connection, behind anything the link
+// already holds. Returns false if there's no link slot for it.
+static bool acl_sched_link_add(BT_HDR *packet, int64_t enqueue_us)
+{
+    acl_sched_link_t *link;
+    acl_sched_entry_t *entry;
+    uint16_t handle;
+
+    handle = (packet->data[packet->offset] | (packet->data[packet->offset + 1] << 8)) & HCI_ACL_HANDLE_MASK;
+    if ((link = acl_sched_get_link(handle, true)) == NULL) {
+        return false;
+    }
+
+    if ((uint16_t)(link->tail - link->head) < HCI_ACL_SCHED_LINK_QUEUE_LEN &&
+        list_is_empty(link->overflow)) {
+        entry = &link->queue[link->tail & (HCI_ACL_SCHED_LINK_QUEUE_LEN - 1)];
+        link->tail++;
+    } else if ((entry = osi_malloc(sizeof(acl_sched_entry_t))) == NULL ||
+               !list_append(link->overflow, entry)) {
+        HCI_TRACE_ERROR("%s dropping packet for handle 0x%x, no memory.", __func__, handle);
+        osi_free(entry);
+        buffer_allocator->free(packet);
+        return true;
+    }
+    entry->packet = packet;
+    entry->enqueue_us = enqueue_us;
+    acl_sched_update_depth(link);
+
+    return true;
+}
+
+// Parks |packet| until a link slot frees up.
+static void acl_sched_park(BT_HDR *packet, int64_t enqueue_us)
+{
+    acl_sched_entry_t *entry;
+
+    if ((entry = osi_malloc(sizeof(acl_sched_entry_t))) == NULL ||
+        !list_append(hci_host_env.acl_sched.unassigned, entry)) {
+        HCI_TRACE_ERROR("%s dropping packet, no memory.", __func__);
+        osi_free(entry);
+        buffer_allocator->free(packet);
+        return;
+    }
+    entry->packet = packet;
+    entry->enqueue_us = enqueue_us;
+}
+
+// Moves everything BTU queued into the per link queues, so a full link
+// never holds up the packets of other links queued behind it. Per
+// connection order holds: slots only free up when the host task sends, so
+// a connection that finds no slot here keeps finding none until the end.
+static void acl_sched_ingest(void)
+{
+    list_t *unassigned = hci_host_env.acl_sched.unassigned;
+    acl_sched_entry_t *entry;
+    list_node_t *node;
+    BT_HDR *packet;
+
+    // Packets parked for a slot were queued before anything in packet_queue
+    for (node = list_begin(unassigned); node != list_end(unassigned); ) {
+        entry = list_node(node);
+        if (acl_sched_link_add(entry->packet, entry->enqueue_us)) {
+            node = list_free_node(unassigned, node);
+            osi_free(entry);
+        } else {
+            node = list_next(node);
+        }
+    }
+
+    while ((packet = spsc_queue_try_dequeue(hci_host_env.packet_queue)) != NULL) {
+        if (!acl_sched_link_add(packet, aos_now() / 1000)) {
+            acl_sched_park(packet, aos_now() / 1000);
+        }
+    }
+}
+
+// Sends one packet or fragment from the link whose turn it is. Returns
+// false if there was nothing to send.
+static bool acl_sched_send_one(void)
+{
+    acl_sched_t *sched = &hci_host_env.acl_sched;
+    acl_sched_link_t *link;
+    acl_sched_entry_t *entry;
+    uint32_t wait_us;
+    int i;
+
+    acl_sched_ingest();
+
+    link = &sched->links[sched->rr_cur];
+    if (sched->rr_budget == 0 || link->head == link->tail) {
+        // Move on to the next link with data and give it a fresh quantum
+        for (i = 1; i <= HCI_ACL_SCHED_MAX_LINKS; i++) {
+            link = &sched->links[(sched->rr_cur + i) % HCI_ACL_SCHED_MAX_LINKS];
+            if (link->head != link->tail) {
+                break;
             }
         }
+        if (i > HCI_ACL_SCHED_MAX_LINKS) {
+            return false;
+        }
+        sched->rr_cur = (sched->rr_cur + i) % HCI_ACL_SCHED_MAX_LINKS;
+        sched->rr_budget = acl_sched_weight(link->link_class);
+    }
+
+    entry = &link->queue[link->head & (HCI_ACL_SCHED_LINK_QUEUE_LEN - 1)];
+    if (entry->enqueue_us) {
+        // First fragment of this packet, account for the time it waited
+        wait_us = (uint32_t)(aos_now() / 1000 - entry->enqueue_us);
+        link->stats.total_wait_us += wait_us;
+        if (wait_us > link->stats.max_wait_us) {
+            link->stats.max_wait_us = wait_us;
+        }
+        entry->enqueue_us = 0;
+    }
+
+    // The fragmenter keeps the packet as its current one while fragments are
+    // left; once it lets go the packet has been freed or handed back to L2CAP
+    packet_fragmenter->fragment_and_dispatch(entry->packet);
+    link->stats.tx_fragments++;
+    if (packet_fragmenter->fragment_current_packet() != entry->packet) {
+        link->head++;
+        link->stats.tx_packets++;
+        if (!list_is_empty(link->overflow)) {
+            entry = list_front(link->overflow);
+            list_remove(link->overflow, entry);
+            link->queue[link->tail++ & (HCI_ACL_SCHED_LINK_QUEUE_LEN - 1)] = *entry;
+            osi_free(entry);
+        }
+        acl_sched_update_depth(link);
+    }
+    sched->rr_budget--;
+
+    return true;
+}
+
+void hci_acl_set_link_class(uint16_t handle, uint8_t link_class)
+{
+    acl_sched_link_t *link;
+
+    if (!hci_host_startup_flag || handle == 0xFFFF) {
+        return;
+    }
+    handle &= HCI_ACL_HANDLE_MASK;
+
+    link = acl_sched_get_link(handle, link_class != HCI_ACL_CLASS_DEFAULT);
+    if (link) {
+        osi_mutex_lock(&hci_host_env.acl_sched.lock, OSI_MUTEX_MAX_TIMEOUT);
+        if (link->in_use && link->handle == handle) {
+            link->link_class = link_class;
+            link->stats.link_class = link_class;
+        }
+        osi_mutex_unlock(&hci_host_env.acl_sched.lock);
+    }
+}
+
+int hci_acl_get_link_stats(hci_acl_link_stats_t *stats, int max)
+{
+    acl_sched_link_t *link;
+    int i, count = 0;
+
+    for (i = 0; i < HCI_ACL_SCHED_MAX_LINKS && count < max; i++) {
+        link = &hci_host_env.acl_sched.links[i];
+        if (link->in_use) {
+            stats[count++] = link->stats;
+        }
+    }
+
+    return count;
+}
+
+static void hci_host_send_kick(void)
+{
+    if (__atomic_exchange_n(&hci_host_env.send_kicked, true, __ATOMIC_ACQ_REL)) {
+        return;
+    }
+
+    if (hci_host_task_post(SIG_HCI_HOST_SEND_AVAILABLE, TASK_POST_BLOCKING) != TASK_POST_SUCCESS) {
+        __atomic_store_n(&hci_host_env.send_kicked, false, __ATOMIC_RELEASE);
     }
 }
 
@@ -293,6 +713,7 @@ static void transmit_command(
     wait_entry->status_callback = status_callback;
     wait_entry->command = command;
     wait_entry->context = context;
+    wait_entry->enqueue_us = aos_now() / 1000;
 
     // Store the command message type in the event field
     // in case the upper layer didn't already
@@ -301,7 +722,7 @@ static void transmit_command(
     //BTTRC_DUMP_BUFFER(NULL, command->data + command->offset, command->len);
 
     fixed_queue_enqueue(hci_host_env.command_queue, wait_entry);
-    hci_host_task_post(SIG_HCI_HOST_SEND_AVAILABLE, TASK_POST_BLOCKING);
+    hci_host_send_kick();
 
 }
 
@@ -316,13 +737,14 @@ static future_t *transmit_command_futured(BT_HDR *command)
     STREAM_TO_UINT16(wait_entry->opcode, stream);
     wait_entry->complete_future = future;
     wait_entry->command = command;
+    wait_entry->enqueue_us = aos_now() / 1000;
 
     // Store the command message type in the event field
     // in case the upper layer didn't already
     command->event = MSG_STACK_TO_HC_HCI_CMD;
 
     fixed_queue_enqueue(hci_host_env.command_queue, wait_entry);
-    hci_host_task_post(SIG_HCI_HOST_SEND_AVAILABLE, TASK_POST_BLOCKING);
+    hci_host_send_kick();
     return future;
 }
 
@@ -332,10 +754,9 @@ static void transmit_downward(uint16_t type, void *data)
         transmit_command((BT_HDR *)data, NULL, NULL, NULL);
         HCI_TRACE_WARNING("%s legacy transmit of command. Use transmit_command instead.\n", __func__);
     } else {
-        fixed_queue_enqueue(hci_host_env.packet_queue, data);
+        spsc_queue_enqueue(hci_host_env.packet_queue, data);
+        hci_host_send_kick();
     }
-
-    hci_host_task_post(SIG_HCI_HOST_SEND_AVAILABLE, TASK_POST_BLOCKING);
 }
 
 
@@ -366,14 +787,6 @@ static void event_command_ready(fixed_queue_t *queue)
     restart_command_waiting_response_timer(cmd_wait_q);
 }
 
-static void event_packet_ready(fixed_queue_t *queue)
-{
-    BT_HDR *packet = (BT_HDR *)fixed_queue_dequeue(queue);
-    // The queue may be the command queue or the packet queue, we don't care
-
-    packet_fragmenter->fragment_and_dispatch(packet);
-}
-
 // Callback for the fragmenter to send a fragment
 static void transmit_fragment(BT_HDR *packet, bool send_transmit_finished)
 {
@@ -449,10 +862,22 @@ static void command_timed_out(void *context)
 // Event/packet receiving functions
 static void hal_says_packet_ready(BT_HDR *packet)
 {
+    uint8_t event_code;
+
     if (packet->event != MSG_HC_TO_STACK_HCI_EVT) {
         packet_fragmenter->reassemble_and_dispatch(packet);
-    } else if (!filter_incoming_event(packet)) {
-        dispatch_reassembled(packet);
+        return;
+    }
+
+    // Command responses are consumed right here, so anything received
+    // before them has to reach BTU first to keep the event order.
+    event_code = packet->data[packet->offset];
+    if (event_code == HCI_COMMAND_COMPLETE_EVT || event_code == HCI_COMMAND_STATUS_EVT) {
+        rx_batch_flush();
+    }
+
+    if (!filter_incoming_event(packet)) {
+        dispatch_reassembled_batched(packet);
     }
 
     //hal->packet_finished(packet);
@@ -513,7 +938,7 @@ intercepted:
     /*Tell HCI Host Task to continue TX Pending commands*/
     if (hci_host_env.command_credits &&
         !fixed_queue_is_empty(hci_host_env.command_queue)) {
-        hci_host_task_post(SIG_HCI_HOST_SEND_AVAILABLE, TASK_POST_BLOCKING);
+        hci_host_send_kick();
     }
 
     if (wait_entry) {
@@ -546,6 +971,69 @@ static void dispatch_reassembled(BT_HDR *packet)
     }
 }
 
+// Inbound packets parsed within one HAL receive batch are collected and
+// posted to BTU as a single hci_msg_batch_t instead of one post each
+static void hal_says_rx_batch_begin(void)
+{
+    hci_host_env.rx_batch_active = true;
+}
+
+static void hal_says_rx_batch_end(void)
+{
+    rx_batch_flush();
+    hci_host_env.rx_batch_active = false;
+}
+
+static void dispatch_reassembled_batched(BT_HDR *packet)
+{
+    if (!hci_host_env.rx_batch_active) {
+        dispatch_reassembled(packet);
+        return;
+    }
+
+    hci_host_env.rx_batch[hci_host_env.rx_batch_count++] = packet;
+    if (hci_host_env.rx_batch_count == HCI_RX_BATCH_MAX) {
+        rx_batch_flush();
+    }
+}
+
+static void rx_batch_flush(void)
+{
+    hci_msg_batch_t *batch;
+    uint16_t count = hci_host_env.rx_batch_count;
+    uint16_t i;
+
+    if (count == 0) {
+        return;
+    }
+
+    hci_host_env.rx_batch_count = 0;
+
+    if (count == 1) {
+        dispatch_reassembled(hci_host_env.rx_batch[0]);
+        return;
+    }
+
+    batch = osi_malloc(sizeof(hci_msg_batch_t) + count * sizeof(BT_HDR *));
+    if (!batch) {
+        // Fall back to posting them one at a time
+        for (i = 0; i < count; i++) {
+            dispatch_reassembled(hci_host_env.rx_batch[i]);
+        }
+        return;
+    }
+
+    batch->count = count;
+    memcpy(batch->packets, hci_host_env.rx_batch, count * sizeof(BT_HDR *));
+
+    if (btu_task_post(SIG_BTU_HCI_MSG_BATCH, batch, TASK_POST_BLOCKING) != TASK_POST_SUCCESS) {
+        for (i = 0; i < count; i++) {
+            buffer_allocator->free(batch->packets[i]);
+        }
+        osi_free(batch);
+    }
+}
+
 // Misc internal functions
 
 // TODO(zachoverflow): we seem to do this a couple places, like the HCI inject module. #centralize
@@ -579,6 +1067,7 @@ static waiting_command_t *get_waiting_command(command_opcode_t opcode)
         }
 
         list_remove(cmd_wait_q->commands_pending_response, wait_entry);
+        record_command_latency(wait_entry);
 
         osi_mutex_unlock(&cmd_wait_q->commands_pending_response_lock);
         return wait_entry;
@@ -588,6 +1077,65 @@ static waiting_command_t *get_waiting_command(command_opcode_t opcode)
     return NULL;
 }
 
+// Must be called with commands_pending_response_lock held
+static void record_command_latency(waiting_command_t *wait_entry)
+{
+    hci_cmd_latency_t *stats;
+    uint32_t i, n, latency_us;
+
+    i = (wait_entry->opcode * 2654435761u) >> 16;
+    for (n = 0; n < HCI_CMD_LATENCY_STATS_MAX; n++, i++) {
+        stats = &hci_host_env.cmd_latency[i & (HCI_CMD_LATENCY_STATS_MAX - 1)];
+        if (stats->count == 0 || stats->opcode == wait_entry->opcode) {
+            break;
+        }
+    }
+
+    if (n == HCI_CMD_LATENCY_STATS_MAX) {
+        return;
+    }
+
+    latency_us = (uint32_t)(aos_now() / 1000 - wait_entry->enqueue_us);
+    if (stats->count == 0) {
+        stats->opcode = wait_entry->opcode;
+        stats->min_us = latency_us;
+    }
+    stats->count++;
+    stats->total_us += latency_us;
+    stats->last_us = latency_us;
+    if (latency_us < stats->min_us) {
+        stats->min_us = latency_us;
+    }
+    if (latency_us > stats->max_us) {
+        stats->max_us = latency_us;
+    }
+}
+
+int hci_get_cmd_latency_stats(hci_cmd_latency_t *stats, int max)
+{
+    command_waiting_response_t *cmd_wait_q = &hci_host_env.cmd_waiting_q;
+    int i, count = 0;
+
+    osi_mutex_lock(&cmd_wait_q->commands_pending_response_lock, OSI_MUTEX_MAX_TIMEOUT);
+    for (i = 0; i < HCI_CMD_LATENCY_STATS_MAX && count < max; i++) {
+        if (hci_host_env.cmd_latency[i].count) {
+            stats[count++] = hci_host_env.cmd_latency[i];
+        }
+    }
+    osi_mutex_unlock(&cmd_wait_q->commands_pending_response_lock);
+
+    return count;
+}
+
+void hci_reset_cmd_latency_stats(void)
+{
+    command_waiting_response_t *cmd_wait_q = &hci_host_env.cmd_waiting_q;
+
+    osi_mutex_lock(&cmd_wait_q->commands_pending_response_lock, OSI_MUTEX_MAX_TIMEOUT);
+    memset(hci_host_env.cmd_latency, 0, sizeof(hci_host_env.cmd_latency));
+    osi_mutex_unlock(&cmd_wait_q->commands_pending_response_lock);
+}
+
 static void init_layer_interface()
 {
     if (!interface_created) {
@@ -600,12 +1148,14 @@ static void init_layer_interface()
 }
 
 static const hci_hal_callbacks_t hal_callbacks = {
-    hal_says_packet_ready
+    hal_says_packet_ready,
+    hal_says_rx_batch_begin,
+    hal_says_rx_batch_end
 };
 
 static const packet_fragmenter_callbacks_t packet_fragmenter_callbacks = {
     transmit_fragment,
-    dispatch_reassembled,
+    dispatch_reassembled_batched,
     fragmenter_transmit_finished
 };
 
@@ -41,6 +41,13 @@ typedef struct {
     // Executes in the context of the thread supplied to |init|.
     packet_ready_cb packet_ready;
 
+    // Optional. Called around a group of inbound packets the HAL parsed in
+    // one go (e.g. one UART wakeup). Packets reported through |packet_ready|
+    // in between may be held back and delivered upwards together once
+    // |rx_batch_end| is called.
+    void (*rx_batch_begin)(void);
+    void (*rx_batch_end)(void);
+
     /*
     // Called when the HAL detects inbound astronauts named Dave.
     // HAL will deny all requests to open the pod bay doors after this.
@@ -82,9 +89,26 @@ typedef struct hci_hal_t {
 } hci_hal_t;
 
 
+// Receive counters of the H4 HAL, updated once per hciH4T wakeup.
+// rx_bytes is only accounted when the bulk ring buffer receive mode
+// (CONFIG_HCI_H4_RX_BULK) is enabled.
+typedef struct {
+    uint32_t wakeups;
+    uint32_t rx_bytes;
+    uint32_t rx_packets;
+    uint32_t last_bytes_per_wakeup;
+    uint32_t last_packets_per_wakeup;
+    uint32_t max_bytes_per_wakeup;
+    uint32_t max_packets_per_wakeup;
+    uint32_t ring_full;
+} hci_hal_h4_rx_stats_t;
+
 // Gets the correct hal implementation, as compiled for.
 
 const hci_hal_t *hci_hal_h4_get_interface(void);
 const hci_hal_t *hci_hal_get_interface(void);
 const hci_hal_t *hci_hal_h5_get_interface(void);
+
+// Copies the current H4 receive counters into |stats|.
+void hci_hal_h4_get_rx_stats(hci_hal_h4_rx_stats_t *stats);
 #endif /* _HCI_HAL_H */
@@ -28,4 +28,9 @@
 // 1 byte for event code, 1 byte for parameter length (Volume 2, Part E, 5.4.4)
 #define HCI_EVENT_PREAMBLE_SIZE 2
 
+// Set by the HAL in layer_specific of an inbound ACL start fragment whose
+// buffer has room for its whole L2CAP packet, so the packet fragmenter can
+// reassemble it in place
+#define HCI_ACL_RX_L2CAP_ROOM 0x0001
+
 #endif /* _HCI_INTERNALS_H_ */
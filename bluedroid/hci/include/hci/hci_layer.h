@@ -66,6 +66,44 @@ typedef enum {
 } low_power_command_t;
 
 
+// Inbound packets handed to the BTU task with a single SIG_BTU_HCI_MSG_BATCH
+// post. The receiver owns both the packets and the batch itself.
+typedef struct {
+    uint16_t count;
+    BT_HDR *packets[];
+} hci_msg_batch_t;
+
+// Time from handing a command to the HCI layer until its Command Complete
+// or Command Status event, per opcode
+typedef struct {
+    uint16_t opcode;
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint32_t last_us;
+    uint64_t total_us;
+} hci_cmd_latency_t;
+
+// Scheduling classes for outbound ACL data. Each class maps to the number
+// of packets a connection may send per round robin turn.
+enum {
+    HCI_ACL_CLASS_DEFAULT = 0,
+    HCI_ACL_CLASS_MEDIA,        // A2DP streaming
+    HCI_ACL_CLASS_HID,          // Latency sensitive links, e.g. LE HID
+    HCI_ACL_CLASS_BULK,         // Throughput links that may wait, e.g. SPP
+};
+
+typedef struct {
+    uint16_t handle;
+    uint8_t link_class;
+    uint16_t queue_depth;
+    uint16_t max_queue_depth;
+    uint32_t tx_packets;
+    uint32_t tx_fragments;
+    uint32_t max_wait_us;
+    uint64_t total_wait_us;
+} hci_acl_link_stats_t;
+
 typedef void (*command_complete_cb)(BT_HDR *response, void *context);
 typedef void (*command_status_cb)(uint8_t status, BT_HDR *command, void *context);
 
@@ -95,5 +133,19 @@ const hci_t *hci_layer_get_interface();
 int hci_start_up(void);
 void hci_shut_down(void);
 
+// Copies up to |max| per opcode latency records into |stats| and returns
+// how many were copied.
+int hci_get_cmd_latency_stats(hci_cmd_latency_t *stats, int max);
+void hci_reset_cmd_latency_stats(void);
+
+// Sets the ACL scheduling class of connection |handle|. Put it back to
+// HCI_ACL_CLASS_DEFAULT when the connection goes away.
+void hci_acl_set_link_class(uint16_t handle, uint8_t link_class);
+
+// Copies up to |max| per connection queue depth and wait time records into
+// |stats| and returns how many were copied. Must not race with the HCI
+// layer being shut down.
+int hci_acl_get_link_stats(hci_acl_link_stats_t *stats, int max);
+
 
 #endif /* _HCI_LAYER_H_ */
@@ -24,8 +24,6 @@
 #include "hci/hci_layer.h"
 #include "hci/packet_fragmenter.h"
 
-#include "osi/hash_map.h"
-#include "osi/hash_functions.h"
 #include "common/bt_trace.h"
 
 
@@ -39,28 +37,49 @@
 #define CONTINUATION_PACKET_BOUNDARY 1
 #define L2CAP_HEADER_SIZE       4
 
-// TODO(zachoverflow): find good value for this
-#define NUMBER_OF_BUCKETS 42
+// Inbound ACL packets are reassembled in the buffer of their start
+// fragment when the HAL gave it room for the whole packet
+// (HCI_ACL_RX_L2CAP_ROOM), so only the continuation fragments are copied.
+// Otherwise a buffer of the full length is allocated on the start fragment.
+
+// One reassembly slot per connection
+#ifndef PACKET_FRAGMENTER_MAX_LINKS
+#define PACKET_FRAGMENTER_MAX_LINKS MAX_L2CAP_LINKS
+#endif
+
+typedef struct {
+    bool in_use;
+    uint16_t handle;
+    uint16_t expected_len;  // full length including the ACL preamble
+    uint16_t cur_len;
+    BT_HDR *partial_packet;
+} partial_slot_t;
 
 // Our interface and callbacks
 static const packet_fragmenter_t interface;
 static const allocator_t *buffer_allocator;
 static const controller_t *controller;
 static const packet_fragmenter_callbacks_t *callbacks;
-static hash_map_t *partial_packets;
+static partial_slot_t partial_slots[PACKET_FRAGMENTER_MAX_LINKS];
 static BT_HDR *current_fragment_packet;
 
+static void partial_slot_release(partial_slot_t *slot);
+
 static void init(const packet_fragmenter_callbacks_t *result_callbacks)
 {
     current_fragment_packet = NULL;
     callbacks = result_callbacks;
-    partial_packets = hash_map_new(NUMBER_OF_BUCKETS, hash_function_naive, NULL, NULL, NULL);
+    memset(partial_slots, 0, sizeof(partial_slots));
 }
 
 static void cleanup()
 {
-    if (partial_packets) {
-        hash_map_free(partial_packets);
+    int i;
+
+    for (i = 0; i < PACKET_FRAGMENTER_MAX_LINKS; i++) {
+        if (partial_slots[i].in_use) {
+            partial_slot_release(&partial_slots[i]);
+        }
     }
 }
 
@@ -128,6 +147,74 @@ static void fragment_and_dispatch(BT_HDR *packet)
     }
 }
 
+static partial_slot_t *partial_slot_get(uint16_t handle, bool create)
+{
+    partial_slot_t *spare = NULL;
+    int i;
+
+    for (i = 0; i < PACKET_FRAGMENTER_MAX_LINKS; i++) {
+        if (partial_slots[i].in_use) {
+            if (partial_slots[i].handle == handle) {
+                return &partial_slots[i];
+            }
+        } else if (!spare) {
+            spare = &partial_slots[i];
+        }
+    }
+
+    if (!create || !spare) {
+        return NULL;
+    }
+
+    memset(spare, 0, sizeof(partial_slot_t));
+    spare->in_use = true;
+    spare->handle = handle;
+    return spare;
+}
+
+static void partial_slot_release(partial_slot_t *slot)
+{
+    if (slot->partial_packet) {
+        buffer_allocator->free(slot->partial_packet);
+    }
+    memset(slot, 0, sizeof(partial_slot_t));
+}
+
+// Returns a buffer holding the start fragment |packet| with room for
+// |full_length| bytes, which is |packet| itself if the HAL made room in it.
+// |packet| is freed if it isn't reused. Returns NULL if out of memory.
+static BT_HDR *partial_packet_new(BT_HDR *packet, uint16_t full_length)
+{
+    BT_HDR *partial_packet;
+    uint8_t *stream;
+
+    if (packet->layer_specific & HCI_ACL_RX_L2CAP_ROOM) {
+        partial_packet = packet;
+        partial_packet->layer_specific = 0;
+    } else {
+        partial_packet = (BT_HDR *)buffer_allocator->alloc(full_length + BT_HDR_SIZE);
+        if (partial_packet) {
+            partial_packet->event = packet->event;
+            partial_packet->offset = 0;
+            partial_packet->layer_specific = 0;
+            memcpy(partial_packet->data, packet->data + packet->offset, packet->len);
+        }
+        // Free the old packet buffer, since we don't need it anymore
+        buffer_allocator->free(packet);
+        if (!partial_packet) {
+            return NULL;
+        }
+    }
+    partial_packet->len = full_length;
+
+    // Update the ACL data size to indicate the full expected length
+    stream = partial_packet->data + partial_packet->offset;
+    STREAM_SKIP_UINT16(stream); // skip the handle
+    UINT16_TO_STREAM(stream, full_length - HCI_ACL_PREAMBLE_SIZE);
+
+    return partial_packet;
+}
+
 static void reassemble_and_dispatch(BT_HDR *packet)
 {
     HCI_TRACE_DEBUG("reassemble_and_dispatch\n");
@@ -149,13 +236,18 @@ static void reassemble_and_dispatch(BT_HDR *packet)
         uint8_t boundary_flag = GET_BOUNDARY_FLAG(handle);
         handle = handle & HANDLE_MASK;
 
-        BT_HDR *partial_packet = (BT_HDR *)hash_map_get(partial_packets, (void *)(uintptr_t)handle);
+        partial_slot_t *slot = partial_slot_get(handle, boundary_flag == START_PACKET_BOUNDARY);
 
         if (boundary_flag == START_PACKET_BOUNDARY) {
-            if (partial_packet) {
+            if (!slot) {
+                HCI_TRACE_ERROR("%s no reassembly slot left for handle 0x%x. Dropping.\n", __func__, handle);
+                buffer_allocator->free(packet);
+                return;
+            }
+
+            if (slot->partial_packet) {
                 HCI_TRACE_WARNING("%s found unfinished packet for handle with start packet. Dropping old.\n", __func__);
-                hash_map_erase(partial_packets, (void *)(uintptr_t)handle);
-                buffer_allocator->free(partial_packet);
+                partial_slot_release(slot);
             }
 
             uint16_t full_length = l2cap_length + L2CAP_HEADER_SIZE + HCI_ACL_PREAMBLE_SIZE;
@@ -164,27 +256,26 @@ static void reassemble_and_dispatch(BT_HDR *packet)
                     HCI_TRACE_WARNING("%s found l2cap full length %d less than the hci length %d.\n", __func__, l2cap_length, packet->len);
                 }
 
+                partial_slot_release(slot);
                 callbacks->reassembled(packet);
                 return;
             }
 
-            partial_packet = (BT_HDR *)buffer_allocator->alloc(full_length + sizeof(BT_HDR));
-            partial_packet->event = packet->event;
-            partial_packet->len = full_length;
-            partial_packet->offset = packet->len;
-
-            memcpy(partial_packet->data, packet->data + packet->offset, packet->len);
-
-            // Update the ACL data size to indicate the full expected length
-            stream = partial_packet->data;
-            STREAM_SKIP_UINT16(stream); // skip the handle
-            UINT16_TO_STREAM(stream, full_length - HCI_ACL_PREAMBLE_SIZE);
+            uint16_t start_len = packet->len;
+            BT_HDR *partial_packet = partial_packet_new(packet, full_length);
+            if (!partial_packet) {
+                HCI_TRACE_ERROR("%s unable to allocate %d bytes. Dropping.\n", __func__, full_length);
+                partial_slot_release(slot);
+                return;
+            }
 
-            hash_map_set(partial_packets, (void *)(uintptr_t)handle, partial_packet);
-            // Free the old packet buffer, since we don't need it anymore
-            buffer_allocator->free(packet);
+            slot->in_use = true;
+            slot->handle = handle;
+            slot->expected_len = full_length;
+            slot->cur_len = start_len;
+            slot->partial_packet = partial_packet;
         } else {
-            if (!partial_packet) {
+            if (!slot || !slot->partial_packet) {
                 HCI_TRACE_ERROR("%s got continuation for unknown packet. Dropping it.\n", __func__);
                 buffer_allocator->free(packet);
                 return;
@@ -192,26 +283,25 @@ static void reassemble_and_dispatch(BT_HDR *packet)
 
             packet->offset += HCI_ACL_PREAMBLE_SIZE; // skip ACL preamble
             packet->len -= HCI_ACL_PREAMBLE_SIZE;
-            uint16_t projected_offset = partial_packet->offset + packet->len;
-            if (projected_offset > partial_packet->len) { // len stores the expected length
-                HCI_TRACE_ERROR("%s got packet which would exceed expected length of %d. Truncating.\n", __func__, partial_packet->len);
-                packet->len = partial_packet->len - partial_packet->offset;
-                projected_offset = partial_packet->len;
+            uint16_t projected_len = slot->cur_len + packet->len;
+            if (projected_len > slot->expected_len) {
+                HCI_TRACE_ERROR("%s got packet which would exceed expected length of %d. Truncating.\n", __func__, slot->expected_len);
+                packet->len = slot->expected_len - slot->cur_len;
+                projected_len = slot->expected_len;
             }
 
-            memcpy(
-                partial_packet->data + partial_packet->offset,
-                packet->data + packet->offset,
-                packet->len
-            );
+            memcpy(slot->partial_packet->data + slot->partial_packet->offset + slot->cur_len,
+                   packet->data + packet->offset, packet->len);
 
             // Free the old packet buffer, since we don't need it anymore
             buffer_allocator->free(packet);
-            partial_packet->offset = projected_offset;
+            slot->cur_len = projected_len;
+
+            if (slot->cur_len == slot->expected_len) {
+                BT_HDR *partial_packet = slot->partial_packet;
 
-            if (partial_packet->offset == partial_packet->len) {
-                hash_map_erase(partial_packets, (void *)(uintptr_t)handle);
-                partial_packet->offset = 0;
+                slot->partial_packet = NULL;
+                partial_slot_release(slot);
                 callbacks->reassembled(partial_packet);
             }
         }
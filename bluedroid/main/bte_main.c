@@ -31,6 +31,7 @@
 #include "stack/btu.h"
 #include "common/bt_trace.h"
 #include "osi/osi.h"
+#include "osi/mem_pool.h"
 #include "osi/alarm.h"
 #include "osi/hash_map.h"
 #include "osi/hash_functions.h"
@@ -83,6 +84,7 @@ int bte_main_boot_entry(bluedroid_init_done_cb_t cb)
 
     bluedroid_init_done_cb = cb;
 
+    osi_mem_pool_init();
     osi_init();
 
     //Enbale HCI
@@ -108,6 +110,7 @@ void bte_main_shutdown(void)
     bte_main_disable();
 
     osi_deinit();
+    osi_mem_pool_deinit();
 }
 
 /******************************************************************************
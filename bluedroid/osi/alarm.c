@@ -29,12 +29,48 @@
 #include "btc/btc_alarm.h"
 #include "osi/mutex.h"
 
+// All alarms share one hashed timing wheel. Arm and cancel are O(1) list
+// operations on a wheel slot, and alarms are plain heap objects so there is
+// no cap on how many may exist. A single one-shot OS timer is programmed for
+// the earliest expiry only, so the CPU is not woken up every tick while long
+// timers are pending, and the timer is stopped when nothing is armed.
+#ifndef OSI_ALARM_TICK_MS
+#define OSI_ALARM_TICK_MS       10
+#endif
+
+#ifndef OSI_ALARM_WHEEL_SIZE
+#define OSI_ALARM_WHEEL_SIZE    256
+#endif
+
+#if (OSI_ALARM_WHEEL_SIZE & (OSI_ALARM_WHEEL_SIZE - 1))
+#error "OSI_ALARM_WHEEL_SIZE must be a power of two"
+#endif
+
+#define ALARM_TICK_BEFORE_EQ(a, b)  ((int32_t)((a) - (b)) <= 0)
+
 typedef struct alarm_t {
-    /* timer id point to here */
-    aos_timer_t alarm_hdl;
+    /* wheel slot membership */
+    struct alarm_t *next;
+    struct alarm_t **pprev;
+    /* all alarms, for deinit */
+    struct alarm_t *all_next;
+    struct alarm_t **all_pprev;
+    /* expired alarms collected by one tick */
+    struct alarm_t *fire_next;
+
     osi_alarm_callback_t cb;
     void *cb_data;
+    osi_alarm_dispatch_t dispatch;
+
+    uint32_t expire_tick;
+    uint32_t period_ticks;
     int64_t deadline;
+    /* bumped by every set/cancel, stale expiries are dropped */
+    uint32_t seq;
+    uint32_t fire_seq;
+    uint16_t inflight;
+    bool armed;
+    bool freed;
 } osi_alarm_t;
 
 enum {
@@ -45,10 +81,20 @@ enum {
 static osi_mutex_t alarm_mutex;
 static int alarm_state;
 
-static struct alarm_t alarm_cbs[ALARM_CBS_NUM];
-
-static osi_alarm_err_t alarm_free(osi_alarm_t *alarm);
+static aos_timer_t alarm_tick_timer;
+static bool alarm_tick_running;
+/* tick the one-shot timer is programmed for while alarm_tick_running */
+static uint32_t alarm_timer_tick;
+/* set while the tick handler walks the wheel, it reprograms the timer itself */
+static bool alarm_in_tick;
+static uint32_t alarm_wheel_tick;
+static uint32_t alarm_armed_count;
+static struct alarm_t *alarm_wheel[OSI_ALARM_WHEEL_SIZE];
+static struct alarm_t *alarm_all;
+
+static void alarm_free(osi_alarm_t *alarm);
 static osi_alarm_err_t alarm_set(osi_alarm_t *alarm, period_ms_t timeout, bool is_periodic);
+static void alarm_tick_handler(void *timer, void *argv);
 
 int osi_alarm_create_mux(void)
 {
@@ -79,7 +125,18 @@ void osi_alarm_init(void)
         OSI_TRACE_WARNING("%s, invalid state %d\n", __func__, alarm_state);
         goto end;
     }
-    memset(alarm_cbs, 0x00, sizeof(alarm_cbs));
+
+    int stat = aos_timer_new_ext(&alarm_tick_timer, alarm_tick_handler, NULL, OSI_ALARM_TICK_MS, 0, 0);
+    if (stat != 0) {
+        OSI_TRACE_ERROR("%s failed to create tick timer, err 0x%x\n", __func__, stat);
+        goto end;
+    }
+
+    memset(alarm_wheel, 0x00, sizeof(alarm_wheel));
+    alarm_all = NULL;
+    alarm_armed_count = 0;
+    alarm_tick_running = false;
+    alarm_in_tick = false;
     alarm_state = ALARM_STATE_OPEN;
 
 end:
@@ -96,10 +153,12 @@ void osi_alarm_deinit(void)
         goto end;
     }
 
-    for (int i = 0; i < ALARM_CBS_NUM; i++) {
-        if (!aos_timer_is_valid(&alarm_cbs[i].alarm_hdl)) {
-            alarm_free(&alarm_cbs[i]);
-        }
+    aos_timer_stop(&alarm_tick_timer);
+    aos_timer_free(&alarm_tick_timer);
+    alarm_tick_running = false;
+
+    while (alarm_all) {
+        alarm_free(alarm_all);
     }
     alarm_state = ALARM_STATE_IDLE;
 
@@ -107,45 +166,233 @@ end:
     osi_mutex_unlock(&alarm_mutex);
 }
 
-static struct alarm_t *alarm_cbs_lookfor_available(void)
+static inline uint32_t alarm_now_tick(void)
+{
+    return (uint32_t)(aos_now_ms() / OSI_ALARM_TICK_MS);
+}
+
+// Must be called with alarm_mutex held
+static void alarm_timer_stop(void)
 {
-    int i;
+    if (alarm_tick_running) {
+        aos_timer_stop(&alarm_tick_timer);
+        alarm_tick_running = false;
+    }
+}
+
+// Must be called with alarm_mutex held
+static void alarm_timer_program(uint32_t expire_tick)
+{
+    int64_t delay = (int64_t)expire_tick * OSI_ALARM_TICK_MS - aos_now_ms();
+
+    if (delay < 1) {
+        delay = 1;
+    }
 
-    for (i = 0; i < ALARM_CBS_NUM; i++) {
-        if (!aos_timer_is_valid(&alarm_cbs[i].alarm_hdl)) { //available
-            OSI_TRACE_DEBUG("%s %d %p\n", __func__, i, &alarm_cbs[i]);
-            return &alarm_cbs[i];
+    aos_timer_stop(&alarm_tick_timer);
+    aos_timer_change_once(&alarm_tick_timer, (int)delay);
+    aos_timer_start(&alarm_tick_timer);
+    alarm_tick_running = true;
+    alarm_timer_tick = expire_tick;
+}
+
+// Must be called with alarm_mutex held and at least one alarm armed. Every
+// armed alarm expires after alarm_wheel_tick, so the first slot holding an
+// alarm due in the current revolution has the earliest one.
+static uint32_t alarm_next_expire_tick(void)
+{
+    osi_alarm_t *alarm;
+    uint32_t tick, earliest = 0;
+    bool found = false;
+
+    for (tick = alarm_wheel_tick + 1; tick != alarm_wheel_tick + 1 + OSI_ALARM_WHEEL_SIZE; tick++) {
+        for (alarm = alarm_wheel[tick & (OSI_ALARM_WHEEL_SIZE - 1)]; alarm; alarm = alarm->next) {
+            if (alarm->expire_tick == tick) {
+                return tick;
+            }
+            if (!found || ALARM_TICK_BEFORE_EQ(alarm->expire_tick, earliest)) {
+                earliest = alarm->expire_tick;
+                found = true;
+            }
         }
     }
 
-    return NULL;
+    return earliest;
 }
 
-static void alarm_cb_handler(void *timer, void *argv)
+// Must be called with alarm_mutex held
+static void alarm_unlink(osi_alarm_t *alarm)
 {
-    struct alarm_t *alarm = (struct alarm_t *)argv;
-    OSI_TRACE_DEBUG("TimerID %p\n", alarm);
-    if (alarm_state != ALARM_STATE_OPEN) {
-        OSI_TRACE_WARNING("%s, invalid state %d\n", __func__, alarm_state);
+    if (!alarm->armed) {
         return;
     }
 
+    *alarm->pprev = alarm->next;
+    if (alarm->next) {
+        alarm->next->pprev = alarm->pprev;
+    }
+    alarm->next = NULL;
+    alarm->pprev = NULL;
+    alarm->armed = false;
+    alarm_armed_count--;
+
+    if (alarm_in_tick) {
+        return;
+    }
+    if (alarm_armed_count == 0) {
+        alarm_timer_stop();
+    } else if (alarm_tick_running && alarm->expire_tick == alarm_timer_tick) {
+        alarm_timer_program(alarm_next_expire_tick());
+    }
+}
+
+// Must be called with alarm_mutex held
+static void alarm_link(osi_alarm_t *alarm, uint32_t expire_tick)
+{
+    struct alarm_t **slot = &alarm_wheel[expire_tick & (OSI_ALARM_WHEEL_SIZE - 1)];
+
+    alarm->expire_tick = expire_tick;
+    alarm->next = *slot;
+    alarm->pprev = slot;
+    if (*slot) {
+        (*slot)->pprev = &alarm->next;
+    }
+    *slot = alarm;
+    alarm->armed = true;
+    alarm_armed_count++;
+
+    if (!alarm_in_tick &&
+            (!alarm_tick_running || !ALARM_TICK_BEFORE_EQ(alarm_timer_tick, expire_tick))) {
+        alarm_timer_program(expire_tick);
+    }
+}
+
+// Must be called with alarm_mutex held. The memory is only released once no
+// expiry is in flight towards the owner task any more.
+static void alarm_free(osi_alarm_t *alarm)
+{
+    alarm_unlink(alarm);
+    alarm->seq++;
+
+    if (alarm->all_pprev) {
+        *alarm->all_pprev = alarm->all_next;
+        if (alarm->all_next) {
+            alarm->all_next->all_pprev = alarm->all_pprev;
+        }
+        alarm->all_next = NULL;
+        alarm->all_pprev = NULL;
+    }
+
+    alarm->freed = true;
+    if (alarm->inflight == 0) {
+        osi_free(alarm);
+    }
+}
+
+// Runs in the owner task (or the timer task when there's no dispatcher)
+static void alarm_fire(void *arg)
+{
+    osi_alarm_t *alarm = (osi_alarm_t *)arg;
+    osi_alarm_callback_t cb = NULL;
+    void *cb_data = NULL;
 
-    /* FIXME: shoud not do callback in timer task */
-    if (alarm->cb)
-        alarm->cb(alarm->cb_data);
-#if 0
+    osi_mutex_lock(&alarm_mutex, OSI_MUTEX_MAX_TIMEOUT);
+    alarm->inflight--;
+    if (alarm->freed) {
+        if (alarm->inflight == 0) {
+            osi_free(alarm);
+        }
+    } else if (alarm->fire_seq == alarm->seq) {
+        cb = alarm->cb;
+        cb_data = alarm->cb_data;
+    }
+    osi_mutex_unlock(&alarm_mutex);
+
+    if (cb) {
+        cb(cb_data);
+    }
+}
+
+static bool alarm_dispatch_btc(osi_alarm_callback_t cb, void *data)
+{
     btc_msg_t msg;
     btc_alarm_args_t arg;
+
     msg.sig = BTC_SIG_API_CALL;
     msg.pid = BTC_PID_ALARM;
-    arg.cb = alarm->cb;
-    arg.cb_data = alarm->cb_data;
-    btc_transfer_context(&msg, &arg, sizeof(btc_alarm_args_t), NULL);
-#endif
+    msg.act = 0;
+    arg.cb = cb;
+    arg.cb_data = data;
+    return btc_transfer_context(&msg, &arg, sizeof(btc_alarm_args_t), NULL) == BT_STATUS_SUCCESS;
 }
 
-osi_alarm_t *osi_alarm_new(const char *alarm_name, osi_alarm_callback_t callback, void *data, period_ms_t timer_expire)
+static void alarm_tick_handler(void *timer, void *argv)
+{
+    osi_alarm_t *fire_list = NULL;
+    osi_alarm_t **fire_tail = &fire_list;
+    osi_alarm_t *alarm, *next;
+    uint32_t now, tick, last;
+
+    osi_mutex_lock(&alarm_mutex, OSI_MUTEX_MAX_TIMEOUT);
+    if (alarm_state != ALARM_STATE_OPEN) {
+        osi_mutex_unlock(&alarm_mutex);
+        return;
+    }
+
+    // The one-shot timer has fired
+    alarm_tick_running = false;
+    alarm_in_tick = true;
+
+    // Visit every slot passed since the last run, at most one revolution.
+    // The OS timer may have been delayed by higher priority tasks.
+    now = alarm_now_tick();
+    last = now;
+    if ((uint32_t)(now - alarm_wheel_tick) > OSI_ALARM_WHEEL_SIZE) {
+        last = alarm_wheel_tick + OSI_ALARM_WHEEL_SIZE;
+    }
+    for (tick = alarm_wheel_tick + 1; alarm_armed_count && ALARM_TICK_BEFORE_EQ(tick, last); tick++) {
+        for (alarm = alarm_wheel[tick & (OSI_ALARM_WHEEL_SIZE - 1)]; alarm; alarm = next) {
+            next = alarm->next;
+            if (!ALARM_TICK_BEFORE_EQ(alarm->expire_tick, now)) {
+                continue;
+            }
+
+            alarm_unlink(alarm);
+            if (alarm->period_ticks) {
+                // Periods missed while the timer was delayed are dropped
+                uint32_t expire_tick = alarm->expire_tick + alarm->period_ticks;
+                if (ALARM_TICK_BEFORE_EQ(expire_tick, now)) {
+                    expire_tick = now + 1;
+                }
+                alarm_link(alarm, expire_tick);
+            }
+
+            alarm->fire_seq = alarm->seq;
+            alarm->inflight++;
+            alarm->fire_next = NULL;
+            *fire_tail = alarm;
+            fire_tail = &alarm->fire_next;
+        }
+    }
+    if (ALARM_TICK_BEFORE_EQ(alarm_wheel_tick, now)) {
+        alarm_wheel_tick = now;
+    }
+
+    alarm_in_tick = false;
+    if (alarm_armed_count) {
+        alarm_timer_program(alarm_next_expire_tick());
+    }
+    osi_mutex_unlock(&alarm_mutex);
+
+    for (alarm = fire_list; alarm; alarm = next) {
+        next = alarm->fire_next;
+        if (alarm->dispatch == NULL || !alarm->dispatch(alarm_fire, alarm)) {
+            alarm_fire(alarm);
+        }
+    }
+}
+
+osi_alarm_t *osi_alarm_new_ext(const char *alarm_name, osi_alarm_callback_t callback, void *data, osi_alarm_dispatch_t dispatch)
 {
     //assert(alarm_mutex != NULL);
 
@@ -158,41 +405,32 @@ osi_alarm_t *osi_alarm_new(const char *alarm_name, osi_alarm_callback_t callback
         goto end;
     }
 
-    timer_id = alarm_cbs_lookfor_available();
-
+    timer_id = osi_calloc(sizeof(osi_alarm_t));
     if (!timer_id) {
-        OSI_TRACE_ERROR("%s alarm_cbs exhausted\n", __func__);
-        timer_id = NULL;
+        OSI_TRACE_ERROR("%s %s no memory\n", __func__, alarm_name);
         goto end;
     }
 
     timer_id->cb = callback;
     timer_id->cb_data = data;
+    timer_id->dispatch = dispatch;
     timer_id->deadline = 0;
 
-    int  stat = aos_timer_new_ext(&timer_id->alarm_hdl, alarm_cb_handler, timer_id, timer_expire == 0 ? 0xFFFFFFUL : timer_expire, 0, 0);
-    if (stat != 0) {
-        OSI_TRACE_ERROR("%s failed to create timer, err 0x%x\n", __func__, stat);
-        timer_id = NULL;
-        goto end;
+    timer_id->all_next = alarm_all;
+    timer_id->all_pprev = &alarm_all;
+    if (alarm_all) {
+        alarm_all->all_pprev = &timer_id->all_next;
     }
+    alarm_all = timer_id;
 
 end:
     osi_mutex_unlock(&alarm_mutex);
     return timer_id;
 }
 
-static osi_alarm_err_t alarm_free(osi_alarm_t *alarm)
+osi_alarm_t *osi_alarm_new(const char *alarm_name, osi_alarm_callback_t callback, void *data, period_ms_t timer_expire)
 {
-    if (!alarm || !aos_timer_is_valid(&alarm->alarm_hdl)) {
-        OSI_TRACE_ERROR("%s null\n", __func__);
-        return OSI_ALARM_ERR_INVALID_ARG;
-    }
-    aos_timer_stop(&alarm->alarm_hdl);
-    aos_timer_free(&alarm->alarm_hdl);
-
-    memset(alarm, 0, sizeof(osi_alarm_t));
-    return OSI_ALARM_ERR_PASS;
+    return osi_alarm_new_ext(alarm_name, callback, data, alarm_dispatch_btc);
 }
 
 void osi_alarm_free(osi_alarm_t *alarm)
@@ -204,6 +442,10 @@ void osi_alarm_free(osi_alarm_t *alarm)
         OSI_TRACE_ERROR("%s, invalid state %d\n", __func__, alarm_state);
         goto end;
     }
+
+    if (!alarm) {
+        goto end;
+    }
     alarm_free(alarm);
 
 end:
@@ -216,6 +458,9 @@ static osi_alarm_err_t alarm_set(osi_alarm_t *alarm, period_ms_t timeout, bool i
     //assert(alarm_mutex != NULL);
 
     osi_alarm_err_t ret = OSI_ALARM_ERR_PASS;
+    int64_t now;
+    uint32_t expire_tick;
+
     osi_mutex_lock(&alarm_mutex, OSI_MUTEX_MAX_TIMEOUT);
     if (alarm_state != ALARM_STATE_OPEN) {
         OSI_TRACE_ERROR("%s, invalid state %d\n", __func__, alarm_state);
@@ -223,23 +468,33 @@ static osi_alarm_err_t alarm_set(osi_alarm_t *alarm, period_ms_t timeout, bool i
         goto end;
     }
 
-    if (!alarm || !aos_timer_is_valid(&alarm->alarm_hdl)) {
+    if (!alarm || alarm->freed) {
         OSI_TRACE_ERROR("%s null\n", __func__);
         ret = OSI_ALARM_ERR_INVALID_ARG;
         goto end;
     }
 
-    aos_timer_stop(&alarm->alarm_hdl);
+    alarm_unlink(alarm);
+    alarm->seq++;
 
-    if (is_periodic) {
-        aos_timer_change(&alarm->alarm_hdl, timeout);
-    } else {
-        aos_timer_change_once(&alarm->alarm_hdl, timeout);
+    now = aos_now_ms();
+    if (alarm_armed_count == 0 && !alarm_tick_running) {
+        alarm_wheel_tick = (uint32_t)(now / OSI_ALARM_TICK_MS);
     }
 
-    aos_timer_start(&alarm->alarm_hdl);
+    // Round up so an alarm never fires early, and never lands in a slot the
+    // wheel has already passed
+    expire_tick = (uint32_t)((now + timeout + OSI_ALARM_TICK_MS - 1) / OSI_ALARM_TICK_MS);
+    if (ALARM_TICK_BEFORE_EQ(expire_tick, alarm_wheel_tick)) {
+        expire_tick = alarm_wheel_tick + 1;
+    }
+    alarm->period_ticks = is_periodic ? (uint32_t)((timeout + OSI_ALARM_TICK_MS - 1) / OSI_ALARM_TICK_MS) : 0;
+    if (is_periodic && alarm->period_ticks == 0) {
+        alarm->period_ticks = 1;
+    }
+    alarm_link(alarm, expire_tick);
 
-    alarm->deadline = is_periodic ? 0 : (timeout + aos_now_ms());
+    alarm->deadline = is_periodic ? 0 : (timeout + now);
 
 end:
     osi_mutex_unlock(&alarm_mutex);
@@ -266,13 +521,15 @@ osi_alarm_err_t osi_alarm_cancel(osi_alarm_t *alarm)
         goto end;
     }
 
-    if (!alarm || !aos_timer_is_valid(&alarm->alarm_hdl)) {
+    if (!alarm || alarm->freed) {
         OSI_TRACE_ERROR("%s null\n", __func__);
         ret = OSI_ALARM_ERR_INVALID_ARG;
         goto end;
     }
 
-    aos_timer_stop(&alarm->alarm_hdl);
+    alarm_unlink(alarm);
+    alarm->seq++;
+    alarm->deadline = 0;
 
 end:
     osi_mutex_unlock(&alarm_mutex);
@@ -282,13 +539,15 @@ end:
 period_ms_t osi_alarm_get_remaining_ms(const osi_alarm_t *alarm)
 {
     //assert(alarm_mutex != NULL);
-    int64_t dt_us = 0;
+    int64_t dt_ms = 0;
 
     osi_mutex_lock(&alarm_mutex, OSI_MUTEX_MAX_TIMEOUT);
-    dt_us = alarm->deadline - aos_now_ms();
+    if (alarm->armed && alarm->deadline) {
+        dt_ms = alarm->deadline - aos_now_ms();
+    }
     osi_mutex_unlock(&alarm_mutex);
 
-    return (dt_us > 0) ? (period_ms_t)(dt_us / 1000) : 0;
+    return (dt_ms > 0) ? (period_ms_t)dt_ms : 0;
 }
 
 uint32_t osi_time_get_os_boottime_ms(void)
@@ -20,98 +20,311 @@
 
 #include "common/bt_defs.h"
 #include "osi/allocator.h"
+#include "osi/mem_pool.h"
+#include "osi/mutex.h"
+#include "osi/alarm.h"
 
 extern void *pvPortZalloc(size_t size);
 extern void vPortFree(void *pv);
 
-#ifdef CONFIG_BLUEDROID_MEM_DEBUG
+#if CONFIG_BLUEDROID_MEM_DEBUG
+
+// Live allocations are kept in an open-addressed hash table keyed by the
+// pointer, so record/clean cost O(1) regardless of how much is in flight.
+// The table grows on demand and is allocated with plain malloc so that the
+// tracker never ends up tracking itself.
+#ifndef OSI_MEM_DBG_HASH_INIT_SIZE
+#define OSI_MEM_DBG_HASH_INIT_SIZE  1024
+#endif
+
+// Number of distinct allocation call sites (func, line) with their own
+// aggregate counters. Must be a power of two.
+#ifndef OSI_MEM_DBG_SITE_MAX
+#define OSI_MEM_DBG_SITE_MAX        256
+#endif
+
+#if (OSI_MEM_DBG_HASH_INIT_SIZE & (OSI_MEM_DBG_HASH_INIT_SIZE - 1)) || (OSI_MEM_DBG_SITE_MAX & (OSI_MEM_DBG_SITE_MAX - 1))
+#error "OSI_MEM_DBG_HASH_INIT_SIZE and OSI_MEM_DBG_SITE_MAX must be powers of two"
+#endif
+
+#define OSI_MEM_DBG_TOMBSTONE   ((void *)1)
+#define OSI_MEM_DBG_SITE_NONE   0xFFFF
 
-#define OSI_MEM_DBG_INFO_MAX    1024
 typedef struct {
     void *p;
-    int size;
+    uint32_t size;
+    uint16_t site;
+} osi_mem_dbg_info_t;
+
+typedef struct {
     const char *func;
     int line;
-} osi_mem_dbg_info_t;
+    uint32_t alloc_count;
+    uint32_t free_count;
+    uint32_t live_bytes;
+    uint32_t peak_bytes;
+    uint32_t rate_count;
+} osi_mem_dbg_site_t;
 
-static uint32_t mem_dbg_count = 0;
-static uint32_t mem_dbg_count2 = 0;
-static osi_mem_dbg_info_t mem_dbg_info[OSI_MEM_DBG_INFO_MAX];
+static osi_mutex_t mem_dbg_lock;
+static osi_mem_dbg_info_t *mem_dbg_info;
+static uint32_t mem_dbg_size;
+static uint32_t mem_dbg_count;
+static uint32_t mem_dbg_used;
+static uint32_t mem_dbg_untracked;
+static osi_mem_dbg_site_t mem_dbg_sites[OSI_MEM_DBG_SITE_MAX];
+static uint32_t mem_dbg_site_count;
+static uint32_t mem_dbg_rate_start_ms;
 
-void osi_mem_dbg_init(void)
+static inline uint32_t mem_dbg_hash_ptr(const void *p)
+{
+    return ((uint32_t)(uintptr_t)p >> 3) * 2654435761u;
+}
+
+static uint16_t mem_dbg_site_get(const char *func, int line)
+{
+    uint32_t i = (mem_dbg_hash_ptr(func) ^ (uint32_t)line) & (OSI_MEM_DBG_SITE_MAX - 1);
+    uint32_t n;
+
+    for (n = 0; n < OSI_MEM_DBG_SITE_MAX; n++, i = (i + 1) & (OSI_MEM_DBG_SITE_MAX - 1)) {
+        osi_mem_dbg_site_t *site = &mem_dbg_sites[i];
+        if (site->func == func && site->line == line) {
+            return i;
+        }
+        if (site->func == NULL) {
+            site->func = func;
+            site->line = line;
+            mem_dbg_site_count++;
+            return i;
+        }
+    }
+
+    return OSI_MEM_DBG_SITE_NONE;
+}
+
+static bool mem_dbg_rehash(uint32_t new_size)
 {
-    int i;
+    osi_mem_dbg_info_t *old = mem_dbg_info;
+    uint32_t old_size = mem_dbg_size;
+    uint32_t i, j;
 
-    for (i = 0; i < OSI_MEM_DBG_INFO_MAX; i++) {
-        mem_dbg_info[i].p = NULL;
-        mem_dbg_info[i].size = 0;
-        mem_dbg_info[i].func = NULL;
-        mem_dbg_info[i].line = 0;
+    mem_dbg_info = calloc(new_size, sizeof(osi_mem_dbg_info_t));
+    if (!mem_dbg_info) {
+        mem_dbg_info = old;
+        return false;
     }
+    mem_dbg_size = new_size;
+
+    for (i = 0; i < old_size; i++) {
+        if (old[i].p == NULL || old[i].p == OSI_MEM_DBG_TOMBSTONE) {
+            continue;
+        }
+        j = mem_dbg_hash_ptr(old[i].p) & (new_size - 1);
+        while (mem_dbg_info[j].p) {
+            j = (j + 1) & (new_size - 1);
+        }
+        mem_dbg_info[j] = old[i];
+    }
+    mem_dbg_used = mem_dbg_count;
+
+    free(old);
+    return true;
+}
+
+void osi_mem_dbg_init(void)
+{
+    if (mem_dbg_info == NULL) {
+        osi_mutex_new(&mem_dbg_lock);
+        mem_dbg_size = OSI_MEM_DBG_HASH_INIT_SIZE;
+        mem_dbg_info = calloc(mem_dbg_size, sizeof(osi_mem_dbg_info_t));
+        if (!mem_dbg_info) {
+            OSI_TRACE_ERROR("%s no memory for tracker\n", __func__);
+            osi_mutex_free(&mem_dbg_lock);
+            return;
+        }
+    } else {
+        osi_mutex_lock(&mem_dbg_lock, OSI_MUTEX_MAX_TIMEOUT);
+        memset(mem_dbg_info, 0, mem_dbg_size * sizeof(osi_mem_dbg_info_t));
+        osi_mutex_unlock(&mem_dbg_lock);
+    }
+
+    memset(mem_dbg_sites, 0, sizeof(mem_dbg_sites));
+    mem_dbg_site_count = 0;
     mem_dbg_count = 0;
-    mem_dbg_count2 = 0;
+    mem_dbg_used = 0;
+    mem_dbg_untracked = 0;
+    mem_dbg_rate_start_ms = osi_time_get_os_boottime_ms();
 }
 
 void osi_mem_dbg_record(void *p, int size, const char *func, int line)
 {
-    int i;
+    osi_mem_dbg_site_t *site;
+    uint32_t i, slot;
+    uint16_t site_idx;
 
     if (!p || size == 0) {
         OSI_TRACE_ERROR("%s invalid !!\n", __func__);
         return;
     }
 
-    for (i = 0; i < OSI_MEM_DBG_INFO_MAX; i++) {
-        if (mem_dbg_info[i].p == NULL) {
-            mem_dbg_info[i].p = p;
-            mem_dbg_info[i].size = size;
-            mem_dbg_info[i].func = func;
-            mem_dbg_info[i].line = line;
-            mem_dbg_count++;
-            break;
+    if (mem_dbg_info == NULL) {
+        return;
+    }
+
+    osi_mutex_lock(&mem_dbg_lock, OSI_MUTEX_MAX_TIMEOUT);
+
+    // Keep the load factor (tombstones included) under 3/4, growing only
+    // when the live entries alone need it
+    if ((mem_dbg_used + 1) * 4 > mem_dbg_size * 3) {
+        uint32_t new_size = (mem_dbg_count + 1) * 2 > mem_dbg_size ? mem_dbg_size * 2 : mem_dbg_size;
+        if (!mem_dbg_rehash(new_size) && mem_dbg_used + 1 >= mem_dbg_size) {
+            mem_dbg_untracked++;
+            osi_mutex_unlock(&mem_dbg_lock);
+            OSI_TRACE_ERROR("%s full %s %d !!\n", __func__, func, line);
+            return;
         }
     }
 
-    if (i >= OSI_MEM_DBG_INFO_MAX) {
-        OSI_TRACE_ERROR("%s full %s %d !!\n", __func__, func, line);
+    slot = mem_dbg_size;
+    i = mem_dbg_hash_ptr(p) & (mem_dbg_size - 1);
+    while (mem_dbg_info[i].p) {
+        if (mem_dbg_info[i].p == OSI_MEM_DBG_TOMBSTONE) {
+            if (slot == mem_dbg_size) {
+                slot = i;
+            }
+        } else if (mem_dbg_info[i].p == p) {
+            OSI_TRACE_ERROR("%s dup %p %s %d !!\n", __func__, p, func, line);
+            osi_mutex_unlock(&mem_dbg_lock);
+            return;
+        }
+        i = (i + 1) & (mem_dbg_size - 1);
+    }
+    if (slot == mem_dbg_size) {
+        slot = i;
+        mem_dbg_used++;
     }
+
+    site_idx = mem_dbg_site_get(func, line);
+    mem_dbg_info[slot].p = p;
+    mem_dbg_info[slot].size = size;
+    mem_dbg_info[slot].site = site_idx;
+    mem_dbg_count++;
+
+    if (site_idx != OSI_MEM_DBG_SITE_NONE) {
+        site = &mem_dbg_sites[site_idx];
+        site->alloc_count++;
+        site->rate_count++;
+        site->live_bytes += size;
+        if (site->live_bytes > site->peak_bytes) {
+            site->peak_bytes = site->live_bytes;
+        }
+    }
+
+    osi_mutex_unlock(&mem_dbg_lock);
 }
 
 void osi_mem_dbg_clean(void *p, const char *func, int line)
 {
-    int i;
+    osi_mem_dbg_site_t *site;
+    uint32_t i;
 
     if (!p) {
         OSI_TRACE_ERROR("%s invalid\n", __func__);
         return;
     }
 
-    for (i = 0; i < OSI_MEM_DBG_INFO_MAX; i++) {
-        if (mem_dbg_info[i].p == p) {
-            mem_dbg_info[i].p = NULL;
-            mem_dbg_info[i].size = 0;
-            mem_dbg_info[i].func = NULL;
-            mem_dbg_info[i].line = 0;
-            mem_dbg_count--;
-            break;
-        }
+    if (mem_dbg_info == NULL) {
+        return;
     }
 
-    if (i >= OSI_MEM_DBG_INFO_MAX) {
-        OSI_TRACE_ERROR("%s full %s %d !!\n", __func__, func, line);
+    osi_mutex_lock(&mem_dbg_lock, OSI_MUTEX_MAX_TIMEOUT);
+
+    i = mem_dbg_hash_ptr(p) & (mem_dbg_size - 1);
+    while (mem_dbg_info[i].p && mem_dbg_info[i].p != p) {
+        i = (i + 1) & (mem_dbg_size - 1);
     }
+
+    if (mem_dbg_info[i].p == NULL) {
+        // Allocated before the tracker was initialised, or not by osi_*alloc
+        mem_dbg_untracked++;
+        osi_mutex_unlock(&mem_dbg_lock);
+        return;
+    }
+
+    if (mem_dbg_info[i].site != OSI_MEM_DBG_SITE_NONE) {
+        site = &mem_dbg_sites[mem_dbg_info[i].site];
+        site->free_count++;
+        site->live_bytes -= mem_dbg_info[i].size;
+    }
+
+    mem_dbg_info[i].p = OSI_MEM_DBG_TOMBSTONE;
+    mem_dbg_info[i].size = 0;
+    mem_dbg_info[i].site = OSI_MEM_DBG_SITE_NONE;
+    mem_dbg_count--;
+
+    osi_mutex_unlock(&mem_dbg_lock);
 }
 
 void osi_mem_dbg_show(void)
 {
-    int i;
+    osi_mem_dbg_info_t *info;
+    uint32_t i;
+
+    if (mem_dbg_info == NULL) {
+        return;
+    }
 
-    for (i = 0; i < OSI_MEM_DBG_INFO_MAX; i++) {
-        if (mem_dbg_info[i].p || mem_dbg_info[i].size != 0 ) {
-            OSI_TRACE_ERROR("--> p %p, s %d, f %s, l %d\n", mem_dbg_info[i].p, mem_dbg_info[i].size, mem_dbg_info[i].func, mem_dbg_info[i].line);
+    osi_mutex_lock(&mem_dbg_lock, OSI_MUTEX_MAX_TIMEOUT);
+
+    for (i = 0; i < mem_dbg_size; i++) {
+        info = &mem_dbg_info[i];
+        if (info->p && info->p != OSI_MEM_DBG_TOMBSTONE) {
+            OSI_TRACE_ERROR("--> p %p, s %d, f %s, l %d\n", info->p, info->size,
+                            info->site != OSI_MEM_DBG_SITE_NONE ? mem_dbg_sites[info->site].func : "?",
+                            info->site != OSI_MEM_DBG_SITE_NONE ? mem_dbg_sites[info->site].line : 0);
         }
     }
-    OSI_TRACE_ERROR("--> count %d\n", mem_dbg_count);
+    OSI_TRACE_ERROR("--> count %d, table %d, untracked %d\n", mem_dbg_count, mem_dbg_size, mem_dbg_untracked);
+
+    osi_mutex_unlock(&mem_dbg_lock);
+
+    osi_mem_dbg_show_sites();
+}
+
+void osi_mem_dbg_show_sites(void)
+{
+    osi_mem_dbg_site_t *site;
+    uint32_t now, elapsed;
+    uint32_t i;
+
+    if (mem_dbg_info == NULL) {
+        return;
+    }
+
+    osi_mutex_lock(&mem_dbg_lock, OSI_MUTEX_MAX_TIMEOUT);
+
+    // Rates are per second since the previous dump
+    now = osi_time_get_os_boottime_ms();
+    elapsed = now - mem_dbg_rate_start_ms;
+    if (elapsed == 0) {
+        elapsed = 1;
+    }
+
+    for (i = 0; i < OSI_MEM_DBG_SITE_MAX; i++) {
+        site = &mem_dbg_sites[i];
+        if (site->func == NULL) {
+            continue;
+        }
+        OSI_TRACE_ERROR("--> f %s, l %d, live %d/%d B, peak %d B, allocs %d, frees %d, rate %d/s\n",
+                        site->func, site->line, site->alloc_count - site->free_count, site->live_bytes,
+                        site->peak_bytes, site->alloc_count, site->free_count,
+                        (int)((uint64_t)site->rate_count * 1000 / elapsed));
+        site->rate_count = 0;
+    }
+    OSI_TRACE_ERROR("--> sites %d\n", mem_dbg_site_count);
+    mem_dbg_rate_start_ms = now;
+
+    osi_mutex_unlock(&mem_dbg_lock);
 }
 #endif
 
@@ -128,38 +341,84 @@ char *osi_strdup(const char *str)
     return new_string;
 }
 
-void *osi_malloc_func(size_t size)
+static inline void *osi_mem_alloc(size_t size, bool zero)
 {
-#ifdef CONFIG_BLUEDROID_MEM_DEBUG
     void *p;
-    p = malloc(size);
-    osi_mem_dbg_record(p, size, __func__, __LINE__);
+
+    p = osi_mem_pool_alloc(size);
+    if (p) {
+        if (zero) {
+            memset(p, 0, size);
+        }
+    } else {
+        p = zero ? calloc(1, size) : malloc(size);
+    }
+
     return p;
-#else
-    return malloc(size);
-#endif /* #ifdef CONFIG_BLUEDROID_MEM_DEBUG */
 }
 
-void *osi_calloc_func(size_t size)
+static inline void osi_mem_free(void *ptr)
 {
-#ifdef CONFIG_BLUEDROID_MEM_DEBUG
-    void *p;
+    if (!osi_mem_pool_free(ptr)) {
+        free(ptr);
+    }
+}
+
+#if CONFIG_BLUEDROID_MEM_DEBUG
+void *osi_malloc_dbg(size_t size, const char *func, int line)
+{
+    void *p = osi_mem_alloc(size, false);
+
+    osi_mem_dbg_record(p, size, func, line);
+    return p;
+}
 
-    p = calloc(1, size);
+void *osi_calloc_dbg(size_t size, const char *func, int line)
+{
+    void *p = osi_mem_alloc(size, true);
 
-    osi_mem_dbg_record(p, size, __func__, __LINE__);
+    osi_mem_dbg_record(p, size, func, line);
     return p;
+}
+
+void osi_free_dbg(void *ptr, const char *func, int line)
+{
+    if (!ptr) {
+        return;
+    }
+
+    osi_mem_dbg_clean(ptr, func, line);
+    osi_mem_free(ptr);
+}
+#endif /* #if CONFIG_BLUEDROID_MEM_DEBUG */
+
+void *osi_malloc_func(size_t size)
+{
+#if CONFIG_BLUEDROID_MEM_DEBUG
+    return osi_malloc_dbg(size, __func__, __LINE__);
 #else
-    return calloc(1, size);
-#endif /* #ifdef CONFIG_BLUEDROID_MEM_DEBUG */
+    return osi_mem_alloc(size, false);
+#endif /* #if CONFIG_BLUEDROID_MEM_DEBUG */
+}
+
+void *osi_calloc_func(size_t size)
+{
+#if CONFIG_BLUEDROID_MEM_DEBUG
+    return osi_calloc_dbg(size, __func__, __LINE__);
+#else
+    return osi_mem_alloc(size, true);
+#endif /* #if CONFIG_BLUEDROID_MEM_DEBUG */
 }
 
 void osi_free_func(void *ptr)
 {
-#ifdef CONFIG_BLUEDROID_MEM_DEBUG
-    osi_mem_dbg_clean(ptr, __func__, __LINE__); 
-#endif
-    free(ptr);
+#if CONFIG_BLUEDROID_MEM_DEBUG
+    osi_free_dbg(ptr, __func__, __LINE__);
+#else
+    if (ptr) {
+        osi_mem_free(ptr);
+    }
+#endif /* #if CONFIG_BLUEDROID_MEM_DEBUG */
 }
 
 const allocator_t allocator_malloc = {
@@ -0,0 +1,939 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#define LOG_TAG "bt_osi_bond_store"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "common/bt_defs.h"
+#include "common/bt_trace.h"
+#include "osi/allocator.h"
+#include "osi/bond_store.h"
+#if (BOND_STORE_KV_INCLUDED == TRUE)
+#include "aos/kv.h"
+#endif
+
+#define BOND_STORE_LOG_MAGIC        0x53444E42      // "BNDS"
+#define BOND_STORE_LOG_VERSION      1
+#define BOND_STORE_LOG_HDR_LEN      8               // magic, version, record size
+
+// Index of a record backend: the same header, then the ids oldest first
+#define BOND_STORE_INDEX_MAGIC      0x49444E42      // "BNDI"
+#define BOND_STORE_INDEX_VERSION    1
+
+// Journal entry: magic, op, id, crc, then the record data for a put
+#define BOND_STORE_ENTRY_MAGIC      0xB5
+#define BOND_STORE_ENTRY_HDR_LEN    (2 + BOND_STORE_ID_LEN + 2)
+#define BOND_STORE_OP_PUT           1
+#define BOND_STORE_OP_DEL           2
+
+#define BOND_STORE_HASH_SIZE        16              // power of 2
+
+// The log is compacted once it holds this many entries per record slot
+#define BOND_STORE_COMPACT_FACTOR   4
+
+#define BOND_STORE_SLOT_IN_USE      0x01
+#define BOND_STORE_SLOT_DIRTY       0x02
+#define BOND_STORE_SLOT_MOVED       0x04    // made newest, journaled as a removal and a put
+
+// Links are slot index + 1, so 0 is the end of a list
+typedef struct {
+    uint8_t id[BOND_STORE_ID_LEN];
+    uint8_t flags;
+    uint16_t hash_next;
+    uint16_t newer;
+    uint16_t older;
+} bond_store_slot_t;
+
+struct bond_store_t {
+    const bond_store_backend_t *backend;
+    size_t record_size;
+    size_t entry_size;
+    size_t max_records;
+    size_t log_entries;     // entries in the log, live or not
+    bool need_compact;      // the log or the index no longer matches the records
+    uint16_t hash[BOND_STORE_HASH_SIZE];
+    uint16_t newest;
+    bond_store_slot_t *slots;
+    uint8_t *data;
+    uint8_t *entry;         // one journal entry
+};
+
+static uint16_t bond_store_crc16(uint16_t crc, const uint8_t *p, size_t len)
+{
+    // CRC-16/CCITT
+    while (len--) {
+        crc ^= (uint16_t)(*p++) << 8;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+static bool bond_store_per_record(const bond_store_t *store)
+{
+    return store->backend->put != NULL;
+}
+
+static uint32_t bond_store_hash(const uint8_t *id)
+{
+    uint32_t h = 0;
+
+    for (int i = 0; i < BOND_STORE_ID_LEN; i++) {
+        h = (h * 31) + id[i];
+    }
+    return h & (BOND_STORE_HASH_SIZE - 1);
+}
+
+static uint8_t *bond_store_slot_data(const bond_store_t *store, int slot)
+{
+    return store->data + (size_t)slot * store->record_size;
+}
+
+static void bond_store_link(bond_store_t *store, int slot, const uint8_t *id)
+{
+    bond_store_slot_t *s = &store->slots[slot];
+    uint32_t h = bond_store_hash(id);
+
+    memcpy(s->id, id, BOND_STORE_ID_LEN);
+    s->flags = BOND_STORE_SLOT_IN_USE;
+    s->hash_next = store->hash[h];
+    store->hash[h] = slot + 1;
+
+    s->newer = 0;
+    s->older = store->newest;
+    if (store->newest) {
+        store->slots[store->newest - 1].newer = slot + 1;
+    }
+    store->newest = slot + 1;
+}
+
+static void bond_store_unlink(bond_store_t *store, int slot)
+{
+    bond_store_slot_t *s = &store->slots[slot];
+    uint16_t *link = &store->hash[bond_store_hash(s->id)];
+
+    while (*link && *link != slot + 1) {
+        link = &store->slots[*link - 1].hash_next;
+    }
+    if (*link) {
+        *link = s->hash_next;
+    }
+
+    if (s->newer) {
+        store->slots[s->newer - 1].older = s->older;
+    } else {
+        store->newest = s->older;
+    }
+    if (s->older) {
+        store->slots[s->older - 1].newer = s->newer;
+    }
+
+    memset(s, 0, sizeof(bond_store_slot_t));
+    memset(bond_store_slot_data(store, slot), 0, store->record_size);
+}
+
+static uint16_t bond_store_oldest(const bond_store_t *store)
+{
+    uint16_t oldest = 0;
+
+    for (uint16_t i = store->newest; i; i = store->slots[i - 1].older) {
+        oldest = i;
+    }
+    return oldest;
+}
+
+static void bond_store_build_entry(bond_store_t *store, uint8_t op, const uint8_t *id, const uint8_t *data)
+{
+    uint8_t *p = store->entry;
+    uint16_t crc;
+
+    p[0] = BOND_STORE_ENTRY_MAGIC;
+    p[1] = op;
+    memcpy(&p[2], id, BOND_STORE_ID_LEN);
+    if (data) {
+        memcpy(&p[BOND_STORE_ENTRY_HDR_LEN], data, store->record_size);
+    } else {
+        memset(&p[BOND_STORE_ENTRY_HDR_LEN], 0, store->record_size);
+    }
+
+    crc = bond_store_crc16(0xFFFF, p, 2 + BOND_STORE_ID_LEN);
+    crc = bond_store_crc16(crc, &p[BOND_STORE_ENTRY_HDR_LEN], store->record_size);
+    p[2 + BOND_STORE_ID_LEN] = crc & 0xFF;
+    p[3 + BOND_STORE_ID_LEN] = crc >> 8;
+}
+
+static bool bond_store_check_entry(const bond_store_t *store, const uint8_t *p)
+{
+    uint16_t crc;
+
+    if (p[0] != BOND_STORE_ENTRY_MAGIC || (p[1] != BOND_STORE_OP_PUT && p[1] != BOND_STORE_OP_DEL)) {
+        return false;
+    }
+
+    crc = bond_store_crc16(0xFFFF, p, 2 + BOND_STORE_ID_LEN);
+    crc = bond_store_crc16(crc, &p[BOND_STORE_ENTRY_HDR_LEN], store->record_size);
+    return p[2 + BOND_STORE_ID_LEN] == (crc & 0xFF) && p[3 + BOND_STORE_ID_LEN] == (crc >> 8);
+}
+
+static void bond_store_build_log_hdr(const bond_store_t *store, uint8_t *p)
+{
+    uint32_t magic = bond_store_per_record(store) ? BOND_STORE_INDEX_MAGIC : BOND_STORE_LOG_MAGIC;
+    uint16_t version = bond_store_per_record(store) ? BOND_STORE_INDEX_VERSION : BOND_STORE_LOG_VERSION;
+
+    // little endian, like the rest of the log
+    p[0] = magic & 0xFF;
+    p[1] = (magic >> 8) & 0xFF;
+    p[2] = (magic >> 16) & 0xFF;
+    p[3] = (magic >> 24) & 0xFF;
+    p[4] = version & 0xFF;
+    p[5] = version >> 8;
+    p[6] = store->record_size & 0xFF;
+    p[7] = (store->record_size >> 8) & 0xFF;
+}
+
+// Replays the log into the empty |store|. Returns false if the log has to be
+// rewritten: it is missing, belongs to another layout or ends in a bad entry.
+static bool bond_store_load(bond_store_t *store)
+{
+    const bond_store_backend_t *backend = store->backend;
+    uint8_t hdr[BOND_STORE_LOG_HDR_LEN];
+    uint8_t expected[BOND_STORE_LOG_HDR_LEN];
+    size_t offset = BOND_STORE_LOG_HDR_LEN;
+    size_t len;
+    int slot;
+
+    len = backend->read(backend->ctx, 0, hdr, sizeof(hdr));
+    if (len == 0) {
+        return false;
+    }
+
+    bond_store_build_log_hdr(store, expected);
+    if (len != sizeof(hdr) || memcmp(hdr, expected, sizeof(hdr)) != 0) {
+        OSI_TRACE_WARNING("%s unknown log layout, discarding it\n", __func__);
+        return false;
+    }
+
+    for (;;) {
+        len = backend->read(backend->ctx, offset, store->entry, store->entry_size);
+        if (len == 0) {
+            return true;
+        }
+        if (len != store->entry_size || !bond_store_check_entry(store, store->entry)) {
+            OSI_TRACE_WARNING("%s bad entry at %d, dropping the rest of the log\n", __func__, (int)offset);
+            return false;
+        }
+        offset += len;
+        store->log_entries++;
+
+        slot = bond_store_find(store, &store->entry[2]);
+        if (store->entry[1] == BOND_STORE_OP_DEL) {
+            if (slot >= 0) {
+                bond_store_unlink(store, slot);
+            }
+            continue;
+        }
+
+        if (slot < 0) {
+            slot = bond_store_add(store, &store->entry[2]);
+            if (slot < 0) {
+                OSI_TRACE_WARNING("%s store full, dropping a record\n", __func__);
+                store->need_compact = true;
+                continue;
+            }
+        }
+        memcpy(bond_store_slot_data(store, slot), &store->entry[BOND_STORE_ENTRY_HDR_LEN], store->record_size);
+        store->slots[slot].flags &= ~BOND_STORE_SLOT_DIRTY;
+    }
+}
+
+// Loads the records listed in the index of a record backend into the empty
+// |store|. Returns false if the index has to be rewritten: it is missing,
+// belongs to another layout or lists records that are gone.
+static bool bond_store_load_index(bond_store_t *store)
+{
+    const bond_store_backend_t *backend = store->backend;
+    uint8_t hdr[BOND_STORE_LOG_HDR_LEN];
+    uint8_t expected[BOND_STORE_LOG_HDR_LEN];
+    uint8_t id[BOND_STORE_ID_LEN];
+    size_t offset = BOND_STORE_LOG_HDR_LEN;
+    bool same_layout, ret = true;
+    int slot;
+
+    if (backend->read(backend->ctx, 0, hdr, sizeof(hdr)) != sizeof(hdr)) {
+        return false;
+    }
+
+    // magic and version first, an unknown index says nothing about the records
+    bond_store_build_log_hdr(store, expected);
+    if (memcmp(hdr, expected, 6) != 0) {
+        OSI_TRACE_WARNING("%s unknown index layout, discarding it\n", __func__);
+        return false;
+    }
+    same_layout = !memcmp(&hdr[6], &expected[6], 2);
+    if (!same_layout) {
+        OSI_TRACE_WARNING("%s record size changed, discarding the records\n", __func__);
+    }
+
+    while (backend->read(backend->ctx, offset, id, sizeof(id)) == sizeof(id)) {
+        offset += sizeof(id);
+
+        if (!same_layout) {
+            backend->del(backend->ctx, id);
+            continue;
+        }
+
+        slot = bond_store_add(store, id);
+        if (slot < 0) {
+            OSI_TRACE_WARNING("%s store full, dropping a record\n", __func__);
+            backend->del(backend->ctx, id);
+            ret = false;
+            continue;
+        }
+        if (!backend->get(backend->ctx, id, bond_store_slot_data(store, slot), store->record_size)) {
+            OSI_TRACE_WARNING("%s record missing, dropping it\n", __func__);
+            bond_store_unlink(store, slot);
+            ret = false;
+        }
+    }
+
+    return same_layout && ret;
+}
+
+// Writes the dirty records of a record backend, then the index if
+// |write_index| is set.
+static bool bond_store_sync_records(bond_store_t *store, bool write_index)
+{
+    const bond_store_backend_t *backend = store->backend;
+    size_t count = 0;
+    bool ret = true;
+
+    for (uint16_t i = bond_store_oldest(store); i; i = store->slots[i - 1].newer) {
+        bond_store_slot_t *s = &store->slots[i - 1];
+
+        count++;
+        if (!(s->flags & BOND_STORE_SLOT_DIRTY)) {
+            continue;
+        }
+        if (!backend->put(backend->ctx, s->id, bond_store_slot_data(store, i - 1), store->record_size)) {
+            OSI_TRACE_ERROR("%s unable to write a record.\n", __func__);
+            ret = false;
+            continue;
+        }
+        s->flags &= ~(BOND_STORE_SLOT_DIRTY | BOND_STORE_SLOT_MOVED);
+    }
+
+    if (!write_index) {
+        return ret;
+    }
+
+    size_t len = BOND_STORE_LOG_HDR_LEN + count * BOND_STORE_ID_LEN;
+    uint8_t *buf = osi_malloc(len);
+    if (!buf) {
+        OSI_TRACE_ERROR("%s unable to allocate %d bytes.\n", __func__, (int)len);
+        store->need_compact = true;
+        return false;
+    }
+
+    uint8_t *p = buf;
+    bond_store_build_log_hdr(store, p);
+    p += BOND_STORE_LOG_HDR_LEN;
+    for (uint16_t i = bond_store_oldest(store); i; i = store->slots[i - 1].newer) {
+        memcpy(p, store->slots[i - 1].id, BOND_STORE_ID_LEN);
+        p += BOND_STORE_ID_LEN;
+    }
+
+    if (backend->rewrite(backend->ctx, buf, len)) {
+        store->need_compact = false;
+    } else {
+        OSI_TRACE_ERROR("%s unable to rewrite the index.\n", __func__);
+        store->need_compact = true;
+        ret = false;
+    }
+    osi_free(buf);
+    return ret;
+}
+
+bond_store_t *bond_store_new(const bond_store_backend_t *backend, size_t record_size, size_t max_records)
+{
+    assert(backend != NULL);
+    assert(!backend->put || (backend->get && backend->del));
+    assert(record_size > 0 && record_size <= 0xFFFF);
+    assert(max_records > 0 && max_records < 0xFFFF);
+
+    bond_store_t *store = osi_calloc(sizeof(bond_store_t));
+    if (!store) {
+        OSI_TRACE_ERROR("%s unable to allocate memory for bond_store_t.\n", __func__);
+        return NULL;
+    }
+
+    store->backend = backend;
+    store->record_size = record_size;
+    store->entry_size = BOND_STORE_ENTRY_HDR_LEN + record_size;
+    store->max_records = max_records;
+    store->slots = osi_calloc(max_records * sizeof(bond_store_slot_t));
+    store->data = osi_calloc(max_records * record_size);
+    store->entry = osi_malloc(store->entry_size);
+    if (!store->slots || !store->data || !store->entry) {
+        OSI_TRACE_ERROR("%s unable to allocate memory for the records.\n", __func__);
+        bond_store_free(store);
+        return NULL;
+    }
+
+    if (bond_store_per_record(store)) {
+        if (bond_store_load_index(store)) {
+            // loading added the records, which is not a change of the index
+            store->need_compact = false;
+        } else {
+            bond_store_compact(store);
+        }
+    } else if (!bond_store_load(store) || store->need_compact) {
+        bond_store_compact(store);
+    }
+
+    return store;
+}
+
+void bond_store_free(bond_store_t *store)
+{
+    if (!store) {
+        return;
+    }
+
+    if (store->data) {
+        memset(store->data, 0, store->max_records * store->record_size);
+    }
+    osi_free(store->slots);
+    osi_free(store->data);
+    osi_free(store->entry);
+    osi_free(store);
+}
+
+int bond_store_find(const bond_store_t *store, const uint8_t *id)
+{
+    assert(store != NULL);
+    assert(id != NULL);
+
+    for (uint16_t i = store->hash[bond_store_hash(id)]; i; i = store->slots[i - 1].hash_next) {
+        if (!memcmp(store->slots[i - 1].id, id, BOND_STORE_ID_LEN)) {
+            return i - 1;
+        }
+    }
+
+    return -1;
+}
+
+int bond_store_add(bond_store_t *store, const uint8_t *id)
+{
+    int slot = bond_store_find(store, id);
+
+    if (slot >= 0) {
+        return slot;
+    }
+
+    for (slot = 0; slot < (int)store->max_records; slot++) {
+        if (!(store->slots[slot].flags & BOND_STORE_SLOT_IN_USE)) {
+            bond_store_link(store, slot, id);
+            if (bond_store_per_record(store)) {
+                store->need_compact = true;
+            }
+            return slot;
+        }
+    }
+
+    return -1;
+}
+
+bool bond_store_remove(bond_store_t *store, int slot)
+{
+    assert(store != NULL);
+
+    if (slot < 0 || slot >= (int)store->max_records || !(store->slots[slot].flags & BOND_STORE_SLOT_IN_USE)) {
+        return false;
+    }
+
+    if (bond_store_per_record(store)) {
+        uint8_t id[BOND_STORE_ID_LEN];
+
+        // the index first, a listed record that is gone is dropped on load
+        memcpy(id, store->slots[slot].id, BOND_STORE_ID_LEN);
+        bond_store_unlink(store, slot);
+        bond_store_sync_records(store, true);
+        store->backend->del(store->backend->ctx, id);
+        return true;
+    }
+
+    bond_store_build_entry(store, BOND_STORE_OP_DEL, store->slots[slot].id, NULL);
+    if (store->backend->append(store->backend->ctx, store->entry, store->entry_size)) {
+        store->log_entries++;
+    } else {
+        OSI_TRACE_ERROR("%s unable to journal the removal.\n", __func__);
+        store->need_compact = true;
+    }
+
+    bond_store_unlink(store, slot);
+    return true;
+}
+
+bool bond_store_clear(bond_store_t *store)
+{
+    assert(store != NULL);
+
+    if (bond_store_per_record(store)) {
+        for (uint16_t i = store->newest; i; i = store->slots[i - 1].older) {
+            store->backend->del(store->backend->ctx, store->slots[i - 1].id);
+        }
+    }
+
+    memset(store->hash, 0, sizeof(store->hash));
+    memset(store->slots, 0, store->max_records * sizeof(bond_store_slot_t));
+    memset(store->data, 0, store->max_records * store->record_size);
+    store->newest = 0;
+
+    return bond_store_compact(store);
+}
+
+const uint8_t *bond_store_id(const bond_store_t *store, int slot)
+{
+    assert(store != NULL);
+    assert(slot >= 0 && slot < (int)store->max_records);
+
+    return store->slots[slot].id;
+}
+
+void *bond_store_data(bond_store_t *store, int slot)
+{
+    assert(store != NULL);
+    assert(slot >= 0 && slot < (int)store->max_records);
+
+    return bond_store_slot_data(store, slot);
+}
+
+void bond_store_mark_dirty(bond_store_t *store, int slot)
+{
+    assert(store != NULL);
+    assert(slot >= 0 && slot < (int)store->max_records);
+
+    store->slots[slot].flags |= BOND_STORE_SLOT_DIRTY;
+}
+
+void bond_store_touch(bond_store_t *store, int slot)
+{
+    assert(store != NULL);
+    assert(slot >= 0 && slot < (int)store->max_records);
+
+    bond_store_slot_t *s = &store->slots[slot];
+
+    if (!(s->flags & BOND_STORE_SLOT_IN_USE)) {
+        return;
+    }
+
+    if (store->newest != slot + 1) {
+        // not the newest, so there is a newer record
+        store->slots[s->newer - 1].older = s->older;
+        if (s->older) {
+            store->slots[s->older - 1].newer = s->newer;
+        }
+        s->newer = 0;
+        s->older = store->newest;
+        store->slots[store->newest - 1].newer = slot + 1;
+        store->newest = slot + 1;
+        s->flags |= BOND_STORE_SLOT_MOVED;
+        if (bond_store_per_record(store)) {
+            store->need_compact = true;
+        }
+    }
+    s->flags |= BOND_STORE_SLOT_DIRTY;
+}
+
+int bond_store_first(const bond_store_t *store)
+{
+    assert(store != NULL);
+
+    return (int)store->newest - 1;
+}
+
+int bond_store_next(const bond_store_t *store, int slot)
+{
+    assert(store != NULL);
+    assert(slot >= 0 && slot < (int)store->max_records);
+
+    return (int)store->slots[slot].older - 1;
+}
+
+bool bond_store_flush(bond_store_t *store)
+{
+    assert(store != NULL);
+
+    if (bond_store_per_record(store)) {
+        return bond_store_sync_records(store, store->need_compact);
+    }
+
+    if (store->need_compact) {
+        return bond_store_compact(store);
+    }
+
+    // Oldest first, so that a replay adds the records back in the same order
+    for (uint16_t i = bond_store_oldest(store); i; i = store->slots[i - 1].newer) {
+        bond_store_slot_t *s = &store->slots[i - 1];
+
+        if (!(s->flags & BOND_STORE_SLOT_DIRTY)) {
+            continue;
+        }
+
+        // a replay adds a record back where it was first put, unless it was removed in between
+        if (s->flags & BOND_STORE_SLOT_MOVED) {
+            bond_store_build_entry(store, BOND_STORE_OP_DEL, s->id, NULL);
+            if (!store->backend->append(store->backend->ctx, store->entry, store->entry_size)) {
+                OSI_TRACE_ERROR("%s unable to append to the log.\n", __func__);
+                return false;
+            }
+            s->flags &= ~BOND_STORE_SLOT_MOVED;
+            store->log_entries++;
+        }
+
+        bond_store_build_entry(store, BOND_STORE_OP_PUT, s->id, bond_store_slot_data(store, i - 1));
+        if (!store->backend->append(store->backend->ctx, store->entry, store->entry_size)) {
+            OSI_TRACE_ERROR("%s unable to append to the log.\n", __func__);
+            return false;
+        }
+        s->flags &= ~BOND_STORE_SLOT_DIRTY;
+        store->log_entries++;
+    }
+
+    if (store->log_entries > BOND_STORE_COMPACT_FACTOR * store->max_records) {
+        return bond_store_compact(store);
+    }
+
+    return true;
+}
+
+bool bond_store_compact(bond_store_t *store)
+{
+    assert(store != NULL);
+
+    if (bond_store_per_record(store)) {
+        return bond_store_sync_records(store, true);
+    }
+
+    size_t count = 0;
+
+    for (uint16_t i = store->newest; i; i = store->slots[i - 1].older) {
+        count++;
+    }
+
+    size_t len = BOND_STORE_LOG_HDR_LEN + count * store->entry_size;
+    uint8_t *buf = osi_malloc(len);
+    if (!buf) {
+        OSI_TRACE_ERROR("%s unable to allocate %d bytes.\n", __func__, (int)len);
+        store->need_compact = true;
+        return false;
+    }
+
+    uint8_t *p = buf;
+    bond_store_build_log_hdr(store, p);
+    p += BOND_STORE_LOG_HDR_LEN;
+    for (uint16_t i = bond_store_oldest(store); i; i = store->slots[i - 1].newer) {
+        bond_store_build_entry(store, BOND_STORE_OP_PUT, store->slots[i - 1].id, bond_store_slot_data(store, i - 1));
+        memcpy(p, store->entry, store->entry_size);
+        p += store->entry_size;
+    }
+
+    bool ret = store->backend->rewrite(store->backend->ctx, buf, len);
+    memset(buf, 0, len);
+    osi_free(buf);
+
+    if (!ret) {
+        OSI_TRACE_ERROR("%s unable to rewrite the log.\n", __func__);
+        store->need_compact = true;
+        return false;
+    }
+
+    for (uint16_t i = store->newest; i; i = store->slots[i - 1].older) {
+        store->slots[i - 1].flags &= ~(BOND_STORE_SLOT_DIRTY | BOND_STORE_SLOT_MOVED);
+    }
+    store->log_entries = count;
+    store->need_compact = false;
+    return true;
+}
+
+// File backend
+
+typedef struct {
+    bond_store_backend_t backend;
+    char *path;
+    char *tmp_path;
+} bond_store_file_t;
+
+static size_t bond_store_file_read(void *ctx, size_t offset, void *buf, size_t len)
+{
+    bond_store_file_t *file = ctx;
+    size_t ret = 0;
+
+    FILE *fp = fopen(file->path, "rb");
+    if (!fp) {
+        return 0;
+    }
+
+    if (fseek(fp, (long)offset, SEEK_SET) == 0) {
+        ret = fread(buf, 1, len, fp);
+    }
+    fclose(fp);
+    return ret;
+}
+
+static bool bond_store_file_append(void *ctx, const void *buf, size_t len)
+{
+    bond_store_file_t *file = ctx;
+    bool ret;
+
+    FILE *fp = fopen(file->path, "ab");
+    if (!fp) {
+        return false;
+    }
+
+    ret = (fwrite(buf, 1, len, fp) == len);
+    ret = (fflush(fp) == 0) && ret;
+    ret = (fclose(fp) == 0) && ret;
+    return ret;
+}
+
+static bool bond_store_file_rewrite(void *ctx, const void *buf, size_t len)
+{
+    bond_store_file_t *file = ctx;
+    bool ret;
+
+    FILE *fp = fopen(file->tmp_path, "wb");
+    if (!fp) {
+        return false;
+    }
+
+    ret = (fwrite(buf, 1, len, fp) == len);
+    ret = (fflush(fp) == 0) && ret;
+    ret = (fclose(fp) == 0) && ret;
+    if (!ret) {
+        remove(file->tmp_path);
+        return false;
+    }
+
+    if (rename(file->tmp_path, file->path) != 0) {
+        // some file systems do not rename over an existing file
+        remove(file->path);
+        if (rename(file->tmp_path, file->path) != 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bond_store_backend_t *bond_store_file_backend_new(const char *path)
+{
+    assert(path != NULL);
+
+    bond_store_file_t *file = osi_calloc(sizeof(bond_store_file_t));
+    if (!file) {
+        return NULL;
+    }
+
+    file->backend.ctx = file;
+    size_t len = strlen(path);
+    file->path = osi_strdup(path);
+    file->tmp_path = osi_malloc(len + sizeof(".tmp"));
+    if (!file->path || !file->tmp_path) {
+        bond_store_file_backend_free(&file->backend);
+        return NULL;
+    }
+    memcpy(file->tmp_path, path, len);
+    memcpy(file->tmp_path + len, ".tmp", sizeof(".tmp"));
+
+    file->backend.read = bond_store_file_read;
+    file->backend.append = bond_store_file_append;
+    file->backend.rewrite = bond_store_file_rewrite;
+    return &file->backend;
+}
+
+void bond_store_file_backend_free(bond_store_backend_t *backend)
+{
+    if (!backend) {
+        return;
+    }
+
+    bond_store_file_t *file = backend->ctx;
+    osi_free(file->path);
+    osi_free(file->tmp_path);
+    osi_free(file);
+}
+
+#if (BOND_STORE_KV_INCLUDED == TRUE)
+// aos_kv backend
+
+// Size of the first read of the index, doubled until the value fits
+#define BOND_STORE_KV_READ_MIN      128
+#define BOND_STORE_KV_READ_MAX      (8 * 1024)
+
+typedef struct {
+    bond_store_backend_t backend;
+    char *key;
+    char *record_key;   // |key|, "_" and the id in hex
+    uint8_t *index;     // copy of the index while the store is loaded from it
+    size_t index_len;
+} bond_store_kv_t;
+
+// Reads the whole value of |key| into a new buffer. Returns NULL if there is
+// no such value or it could not be read.
+static uint8_t *bond_store_kv_get(const char *key, size_t *len)
+{
+    for (int size = BOND_STORE_KV_READ_MIN; size <= BOND_STORE_KV_READ_MAX; size *= 2) {
+        uint8_t *buf = osi_malloc(size);
+        int buf_len = size;
+
+        if (!buf) {
+            return NULL;
+        }
+
+        // a value filling the whole buffer may have been truncated
+        if (aos_kv_get(key, buf, &buf_len) == 0 && buf_len >= 0 && buf_len < size) {
+            *len = buf_len;
+            return buf;
+        }
+        osi_free(buf);
+    }
+
+    return NULL;
+}
+
+static void bond_store_kv_drop_index(bond_store_kv_t *kv)
+{
+    osi_free(kv->index);
+    kv->index = NULL;
+    kv->index_len = 0;
+}
+
+static const char *bond_store_kv_record_key(bond_store_kv_t *kv, const uint8_t *id)
+{
+    char *p = kv->record_key + strlen(kv->key) + 1;
+
+    for (int i = 0; i < BOND_STORE_ID_LEN; i++) {
+        sprintf(p + 2 * i, "%02x", id[i]);
+    }
+    return kv->record_key;
+}
+
+static size_t bond_store_kv_read(void *ctx, size_t offset, void *buf, size_t len)
+{
+    bond_store_kv_t *kv = ctx;
+
+    // the store reads the index front to back once, when it is created
+    if (offset == 0) {
+        bond_store_kv_drop_index(kv);
+        kv->index = bond_store_kv_get(kv->key, &kv->index_len);
+    }
+    if (!kv->index || offset >= kv->index_len) {
+        bond_store_kv_drop_index(kv);
+        return 0;
+    }
+
+    if (len > kv->index_len - offset) {
+        len = kv->index_len - offset;
+    }
+    memcpy(buf, kv->index + offset, len);
+    return len;
+}
+
+static bool bond_store_kv_rewrite(void *ctx, const void *buf, size_t len)
+{
+    bond_store_kv_t *kv = ctx;
+
+    bond_store_kv_drop_index(kv);
+    return (aos_kv_set(kv->key, (void *)buf, len, 1) == 0);
+}
+
+static bool bond_store_kv_put(void *ctx, const uint8_t *id, const void *buf, size_t len)
+{
+    bond_store_kv_t *kv = ctx;
+
+    return (aos_kv_set(bond_store_kv_record_key(kv, id), (void *)buf, len, 1) == 0);
+}
+
+static bool bond_store_kv_record_get(void *ctx, const uint8_t *id, void *buf, size_t len)
+{
+    bond_store_kv_t *kv = ctx;
+    int value_len = len + 1;
+    uint8_t *value;
+    bool ret;
+
+    // one byte more than expected, to tell a longer value from a match
+    if ((value = osi_malloc(value_len)) == NULL) {
+        return false;
+    }
+
+    ret = (aos_kv_get(bond_store_kv_record_key(kv, id), value, &value_len) == 0 && value_len == (int)len);
+    if (ret) {
+        memcpy(buf, value, len);
+    }
+    memset(value, 0, len + 1);
+    osi_free(value);
+    return ret;
+}
+
+static bool bond_store_kv_del(void *ctx, const uint8_t *id)
+{
+    bond_store_kv_t *kv = ctx;
+
+    return (aos_kv_del(bond_store_kv_record_key(kv, id)) == 0);
+}
+
+bond_store_backend_t *bond_store_kv_backend_new(const char *key)
+{
+    assert(key != NULL);
+
+    bond_store_kv_t *kv = osi_calloc(sizeof(bond_store_kv_t));
+    if (!kv) {
+        return NULL;
+    }
+
+    kv->backend.ctx = kv;
+    size_t len = strlen(key);
+    kv->key = osi_strdup(key);
+    kv->record_key = osi_malloc(len + 1 + 2 * BOND_STORE_ID_LEN + 1);
+    if (!kv->key || !kv->record_key) {
+        bond_store_kv_backend_free(&kv->backend);
+        return NULL;
+    }
+    memcpy(kv->record_key, key, len);
+    kv->record_key[len] = '_';
+    kv->record_key[len + 1 + 2 * BOND_STORE_ID_LEN] = '\0';
+
+    kv->backend.read = bond_store_kv_read;
+    kv->backend.rewrite = bond_store_kv_rewrite;
+    kv->backend.put = bond_store_kv_put;
+    kv->backend.get = bond_store_kv_record_get;
+    kv->backend.del = bond_store_kv_del;
+    return &kv->backend;
+}
+
+void bond_store_kv_backend_free(bond_store_backend_t *backend)
+{
+    if (!backend) {
+        return;
+    }
+
+    bond_store_kv_t *kv = backend->ctx;
+    bond_store_kv_drop_index(kv);
+    osi_free(kv->key);
+    osi_free(kv->record_key);
+    osi_free(kv);
+}
+#endif /* BOND_STORE_KV_INCLUDED == TRUE */
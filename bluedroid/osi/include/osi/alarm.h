@@ -20,6 +20,7 @@
 #define _ALARM_H_
 
 #include <stdint.h>
+#include <stdbool.h>
 //#include "yoc_timer.h"
 
 typedef struct alarm_t osi_alarm_t;
@@ -28,6 +29,10 @@ typedef uint64_t period_ms_t;
 
 typedef void (*osi_alarm_callback_t)(void* arg);
 
+// Hands |cb|(|arg|) over to the task that owns an alarm. Returns false if
+// the call couldn't be posted, in which case it runs in the timer context.
+typedef bool (*osi_alarm_dispatch_t)(osi_alarm_callback_t cb, void *arg);
+
 typedef enum {
     OSI_ALARM_ERR_PASS = 0,
     OSI_ALARM_ERR_FAIL = -1,
@@ -35,7 +40,6 @@ typedef enum {
     OSI_ALARM_ERR_INVALID_STATE = -3,
 } osi_alarm_err_t;
 
-#define ALARM_CBS_NUM   30
 #define ALARM_ID_BASE   1000
 
 int osi_alarm_create_mux(void);
@@ -45,8 +49,14 @@ void osi_alarm_deinit(void);
 
 // Creates a new alarm object. The returned object must be freed by calling
 // |alarm_free|. Returns NULL on failure.
+// The callback is run in the BTC task.
 osi_alarm_t *osi_alarm_new(const char *alarm_name, osi_alarm_callback_t callback, void *data, period_ms_t timer_expire);
 
+// Same as |osi_alarm_new|, but the callback is handed to |dispatch| when the
+// alarm expires. With a NULL |dispatch| it runs directly in the timer context,
+// which is meant for callbacks that only post an event to their own task.
+osi_alarm_t *osi_alarm_new_ext(const char *alarm_name, osi_alarm_callback_t callback, void *data, osi_alarm_dispatch_t dispatch);
+
 // Frees an alarm object created by |alarm_new|. |alarm| may be NULL. If the
 // alarm is pending, it will be cancelled. It is not safe to call |alarm_free|
 // from inside the callback of |alarm|.
@@ -41,17 +41,35 @@ void *osi_malloc_func(size_t size);
 void *osi_calloc_func(size_t size);
 void osi_free_func(void *ptr);
 
-#ifdef CONFIG_BLUEDROID_MEM_DEBUG
+#if CONFIG_BLUEDROID_MEM_DEBUG
 
 void osi_mem_dbg_init(void);
 void osi_mem_dbg_record(void *p, int size, const char *func, int line);
 void osi_mem_dbg_clean(void *p, const char *func, int line);
+// Dumps every live allocation followed by the per call site counters
 void osi_mem_dbg_show(void);
+// Dumps live/peak bytes and allocation rate for each osi_*alloc call site.
+// The rate is averaged since the previous dump.
+void osi_mem_dbg_show_sites(void);
 
+void *osi_malloc_dbg(size_t size, const char *func, int line);
+void *osi_calloc_dbg(size_t size, const char *func, int line);
+void osi_free_dbg(void *ptr, const char *func, int line);
+
+#endif /* CONFIG_BLUEDROID_MEM_DEBUG */
+
+// Small and BT_HDR sized requests are served from the fixed block pools in
+// osi/mem_pool.h, everything else falls back to the heap. Memory obtained
+// here must be released with osi_free, never with free.
+#if CONFIG_BLUEDROID_MEM_DEBUG
+#define osi_malloc(size)                  osi_malloc_dbg((size), __func__, __LINE__)
+#define osi_calloc(size)                  osi_calloc_dbg((size), __func__, __LINE__)
+#define osi_free(p)                       osi_free_dbg((p), __func__, __LINE__)
+#else
+#define osi_malloc(size)                  osi_malloc_func((size))
+#define osi_calloc(size)                  osi_calloc_func((size))
+#define osi_free(p)                       osi_free_func((p))
 #endif /* CONFIG_BLUEDROID_MEM_DEBUG */
-#define osi_malloc(size)                  malloc((size))
-#define osi_calloc(size)                  calloc(1, (size))
-#define osi_free(p)                       free((p))
 
 
 
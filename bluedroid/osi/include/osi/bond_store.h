@@ -0,0 +1,136 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef _BOND_STORE_H_
+#define _BOND_STORE_H_
+
+// This module implements a small persistent store of fixed-size binary
+// records, each identified by a 6 byte id (a device address). All records
+// are kept in memory and found through a hash index on the id. With a log
+// backend, changes are persisted by appending one journal entry per changed
+// record to a log, and the log is rewritten with only the live records once
+// it has grown to a few times the size of the store. With a record backend,
+// every changed record is written under its own key and the log is replaced
+// by an index of the ids.
+//
+// Implementation notes:
+// - The log and the index start with a header carrying the record size. A
+//   log written with a different record size is discarded, and so are the
+//   records listed in such an index.
+// - Every journal entry is covered by a CRC. Replay stops at the first bad
+//   entry, e.g. one torn by a power loss, and the log is then compacted. A
+//   record listed in the index but missing from the backend is dropped.
+// - Records are iterated newest first, in the order they were added or
+//   last touched.
+// - The store is not thread safe, callers serialize access.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define BOND_STORE_ID_LEN        6
+
+// Storage used for the records. A log backend only needs to support reading
+// at an offset, appending at the end and replacing the whole log. A record
+// backend sets |put| and keeps every record under its own key. |read| and
+// |rewrite| then hold the index of the ids instead of the log, and |append|
+// is not used.
+typedef struct {
+    // Reads up to |len| bytes at |offset| of the log into |buf|. Returns the
+    // number of bytes read, 0 past the end of the log or if there is no log.
+    size_t (*read)(void *ctx, size_t offset, void *buf, size_t len);
+
+    // Appends |len| bytes of |buf| to the end of the log. Returns true on
+    // success.
+    bool (*append)(void *ctx, const void *buf, size_t len);
+
+    // Replaces the whole log with |len| bytes of |buf|. The old log should
+    // stay readable until the new one is complete. Returns true on success.
+    bool (*rewrite)(void *ctx, const void *buf, size_t len);
+
+    // Record backends only, NULL otherwise. Writes, reads back or deletes the
+    // |len| bytes of the record identified by |id|. |get| fails unless
+    // exactly |len| bytes are stored. Return true on success.
+    bool (*put)(void *ctx, const uint8_t *id, const void *buf, size_t len);
+    bool (*get)(void *ctx, const uint8_t *id, void *buf, size_t len);
+    bool (*del)(void *ctx, const uint8_t *id);
+
+    void *ctx;
+} bond_store_backend_t;
+
+typedef struct bond_store_t bond_store_t;
+
+// Creates a store of at most |max_records| records of |record_size| bytes
+// and loads it from |backend|. |backend| must stay valid until
+// |bond_store_free|. Returns NULL on error.
+bond_store_t *bond_store_new(const bond_store_backend_t *backend, size_t record_size, size_t max_records);
+
+// Frees the |store| without flushing it. |store| may be NULL.
+void bond_store_free(bond_store_t *store);
+
+// Returns the slot of the record identified by |id|, or -1 if there is none.
+int bond_store_find(const bond_store_t *store, const uint8_t *id);
+
+// Adds a zeroed record identified by |id| and returns its slot, or the slot
+// of the existing record. Returns -1 if the store is full.
+int bond_store_add(bond_store_t *store, const uint8_t *id);
+
+// Removes the record in |slot| and persists the removal right away. Returns
+// false if |slot| is not in use.
+bool bond_store_remove(bond_store_t *store, int slot);
+
+// Removes all records and rewrites an empty log or index.
+bool bond_store_clear(bond_store_t *store);
+
+// Returns the id or the data of the record in |slot|. The data may be
+// modified in place, followed by |bond_store_mark_dirty|.
+const uint8_t *bond_store_id(const bond_store_t *store, int slot);
+void *bond_store_data(bond_store_t *store, int slot);
+
+// Schedules the record in |slot| to be written by the next flush.
+void bond_store_mark_dirty(bond_store_t *store, int slot);
+
+// Makes the record in |slot| the newest one, in memory and in the log or
+// index, and schedules it to be written by the next flush. The slot does not change.
+void bond_store_touch(bond_store_t *store, int slot);
+
+// Returns the newest record, or the record added before |slot|. Returns -1
+// past the last one.
+int bond_store_first(const bond_store_t *store);
+int bond_store_next(const bond_store_t *store, int slot);
+
+// Appends one journal entry per dirty record, then compacts the log if it
+// has grown too large. A record backend instead gets one |put| per dirty
+// record, and the index is rewritten only if records were added, removed or
+// reordered. Returns false if a record could not be written.
+bool bond_store_flush(bond_store_t *store);
+
+// Rewrites the log with only the live records. A record backend gets the
+// dirty records and a new index.
+bool bond_store_compact(bond_store_t *store);
+
+// Returns a backend keeping the log in the file at |path|, e.g. for host
+// testing. Compaction writes |path| with a ".tmp" suffix and renames it.
+// Free it with |bond_store_file_backend_free| after the store is freed.
+bond_store_backend_t *bond_store_file_backend_new(const char *path);
+void bond_store_file_backend_free(bond_store_backend_t *backend);
+
+// Returns a record backend on aos_kv, the default storage on targets. The
+// index is kept in the value |key| and every record in its own value, named
+// |key| followed by "_" and the id in hex. aos_kv is journaled itself, so one
+// changed record costs one small write. Free it with
+// |bond_store_kv_backend_free| after the store is freed. Only built when
+// BOND_STORE_KV_INCLUDED is TRUE.
+bond_store_backend_t *bond_store_kv_backend_new(const char *key);
+void bond_store_kv_backend_free(bond_store_backend_t *backend);
+
+#endif /* _BOND_STORE_H_ */
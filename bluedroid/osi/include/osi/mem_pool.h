@@ -0,0 +1,108 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef _MEM_POOL_H_
+#define _MEM_POOL_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "bt_config.h"
+
+// Fixed size block pools sitting behind osi_malloc/osi_free. The stack
+// allocates the same few sizes over and over (HCI commands and events, ACL
+// packets, encoded media frames), so those requests are served from
+// preallocated per-size-class free lists instead of the system heap.
+// Requests that don't fit any class, or hit an exhausted class, fall back
+// to malloc.
+
+#ifndef CONFIG_BT_MEM_POOL_ENABLE
+#define CONFIG_BT_MEM_POOL_ENABLE 1
+#endif
+
+// Size classes, ascending. A class with a count of 0 is skipped.
+// Small control blocks, e.g. waiting_command_t, alarm and list nodes
+#ifndef OSI_MEM_POOL_0_SIZE
+#define OSI_MEM_POOL_0_SIZE     64
+#endif
+#ifndef OSI_MEM_POOL_0_COUNT
+#define OSI_MEM_POOL_0_COUNT    32
+#endif
+
+// BT_HDR + H4 type + HCI event of up to 255 bytes of parameters
+#ifndef OSI_MEM_POOL_1_SIZE
+#define OSI_MEM_POOL_1_SIZE     272
+#endif
+#ifndef OSI_MEM_POOL_1_COUNT
+#define OSI_MEM_POOL_1_COUNT    16
+#endif
+
+// HCI command buffers (HCI_CMD_BUF_SIZE)
+#ifndef OSI_MEM_POOL_2_SIZE
+#define OSI_MEM_POOL_2_SIZE     664
+#endif
+#ifndef OSI_MEM_POOL_2_COUNT
+#define OSI_MEM_POOL_2_COUNT    8
+#endif
+
+// BT_HDR + H4 type + ACL header + ACL MTU of the controller
+#ifndef OSI_MEM_POOL_3_SIZE
+#define OSI_MEM_POOL_3_SIZE     1040
+#endif
+#ifndef OSI_MEM_POOL_3_COUNT
+#define OSI_MEM_POOL_3_COUNT    8
+#endif
+
+// A2DP source encoded media buffers (BTC_MEDIA_AA_BUF_SIZE)
+#ifndef OSI_MEM_POOL_4_SIZE
+#define OSI_MEM_POOL_4_SIZE     (4096 + 16)
+#endif
+#ifndef OSI_MEM_POOL_4_COUNT
+#define OSI_MEM_POOL_4_COUNT    4
+#endif
+
+#define OSI_MEM_POOL_CLASS_NUM  5
+
+typedef struct {
+    uint32_t block_size;
+    uint32_t block_count;
+    uint32_t in_use;
+    uint32_t high_water;
+    uint32_t alloc_count;
+    // Requests for this class that found it empty and went to the heap
+    uint32_t fail_count;
+} osi_mem_pool_stats_t;
+
+// Allocates the pool memory. Returns 0 on success. If the memory can't be
+// allocated all requests simply keep going to the system heap.
+int osi_mem_pool_init(void);
+
+// Releases the pool memory. If blocks are still in use the memory is
+// kept, so late frees stay valid.
+void osi_mem_pool_deinit(void);
+
+// Returns a block of at least |size| bytes, or NULL if no class fits or
+// the fitting class is exhausted. Safe to call from any task.
+void *osi_mem_pool_alloc(size_t size);
+
+// Returns |ptr| to its pool. Returns false if |ptr| was not allocated from
+// a pool, in which case the caller owns freeing it.
+bool osi_mem_pool_free(void *ptr);
+
+// Fills |stats| for size class |class_idx|. Returns false if |class_idx|
+// is out of range.
+bool osi_mem_pool_get_stats(int class_idx, osi_mem_pool_stats_t *stats);
+
+// Dumps the statistics of every class to the trace log.
+void osi_mem_pool_show(void);
+
+#endif /* _MEM_POOL_H_ */
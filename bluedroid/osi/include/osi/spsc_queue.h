@@ -0,0 +1,92 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef _SPSC_QUEUE_H_
+#define _SPSC_QUEUE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// A bounded queue of pointers for the case where exactly one task enqueues
+// and one task dequeues, e.g. the A2DP media queues. Items live in a slot
+// array allocated up front and the indexes are updated atomically, so the
+// fast path takes no lock and does no allocation.
+//
+// Only one task may call the enqueue functions. Dequeue is safe against
+// other dequeuers, so the producer may still drop stale items from the
+// head (e.g. on overflow or flush) while the consumer is running.
+
+struct spsc_queue_t;
+
+typedef struct spsc_queue_t spsc_queue_t;
+
+typedef void (*spsc_queue_free_cb)(void *data);
+typedef void (*spsc_queue_cb)(spsc_queue_t *queue);
+
+// Creates a new queue that holds at least |capacity| elements. The slot
+// array is rounded up to a power of two. Returns NULL on failure. The caller
+// must free the returned queue with |spsc_queue_free|.
+spsc_queue_t *spsc_queue_new(size_t capacity);
+
+// Frees the |queue|, calling |free_cb| on every element still in it if
+// |free_cb| is not NULL. Freeing a queue that has blocked waiters results
+// in undefined behaviour. |queue| may be NULL.
+void spsc_queue_free(spsc_queue_t *queue, spsc_queue_free_cb free_cb);
+
+// Returns a value indicating whether the given |queue| is empty. If |queue|
+// is NULL, the return value is true.
+bool spsc_queue_is_empty(spsc_queue_t *queue);
+
+// Returns the length of the |queue|. If |queue| is NULL, the return value
+// is 0.
+size_t spsc_queue_length(spsc_queue_t *queue);
+
+// Returns the maximum number of elements this queue may hold. |queue| may
+// not be NULL.
+size_t spsc_queue_capacity(spsc_queue_t *queue);
+
+// Enqueues the given |data| into the |queue|. The caller will be blocked
+// if no more space is available in the queue. Neither |queue| nor |data|
+// may be NULL.
+void spsc_queue_enqueue(spsc_queue_t *queue, void *data);
+
+// Dequeues the next element from |queue|. If the queue is currently empty,
+// this function will block the caller until an item is enqueued. This
+// function will never return NULL. |queue| may not be NULL.
+void *spsc_queue_dequeue(spsc_queue_t *queue);
+
+// Tries to enqueue |data| into the |queue|. This function will never block
+// the caller. Returns false if the queue is full. Neither |queue| nor |data|
+// may be NULL.
+bool spsc_queue_try_enqueue(spsc_queue_t *queue, void *data);
+
+// Tries to dequeue an element from |queue|. This function will never block
+// the caller. Returns NULL if the queue is empty or |queue| is NULL.
+void *spsc_queue_try_dequeue(spsc_queue_t *queue);
+
+// Returns the first element from |queue|, if present, without dequeuing it.
+// Must only be called by the consumer. Returns NULL if there are no
+// elements in the queue or |queue| is NULL.
+void *spsc_queue_try_peek_first(spsc_queue_t *queue);
+
+// Registers a callback run by |spsc_queue_process| when the owner task
+// is told there is something to dequeue. Neither |queue| nor |ready_cb|
+// may be NULL.
+void spsc_queue_register_dequeue(spsc_queue_t *queue, spsc_queue_cb ready_cb);
+
+// Unregisters the dequeue ready callback for |queue|. This function is
+// idempotent.
+void spsc_queue_unregister_dequeue(spsc_queue_t *queue);
+
+void spsc_queue_process(spsc_queue_t *queue);
+
+#endif /* _SPSC_QUEUE_H_ */
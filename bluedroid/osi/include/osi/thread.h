@@ -56,6 +56,8 @@ typedef enum {
     SIG_BTU_GENERAL_ALARM,
     SIG_BTU_ONESHOT_ALARM,
     SIG_BTU_L2CAP_ALARM,
+    SIG_BTU_HCI_MSG_BATCH,
+    SIG_BTU_SMP_ECC_CMPL,
     SIG_BTU_NUM,
 } SIG_BTU_t;
 
@@ -89,6 +91,12 @@ typedef enum {
 #define BTU_TASK_NAME                   "btuT"
 #define BTU_QUEUE_LEN                   50
 
+#define SMP_ECC_TASK_STACK_SIZE         (3072 + BT_TASK_EXTRA_STACK_SIZE)
+#define SMP_ECC_TASK_PRIO               (AOS_DEFAULT_APP_PRI)
+#define SMP_ECC_TASK_NAME               "smpEccT"
+#define SMP_ECC_QUEUE_LEN               4
+#define SMP_ECC_POST_RETRY_MS           10
+
 #define BTC_TASK_STACK_SIZE             (CONFIG_BTC_TASK_STACK_SIZE + BT_TASK_EXTRA_STACK_SIZE)	//by menuconfig
 #define BTC_TASK_NAME                   "btcT"
 #define BTC_TASK_PRIO                   (AOS_DEFAULT_APP_PRI - 1)
@@ -0,0 +1,287 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/bt_defs.h"
+#include "common/bt_trace.h"
+#include "osi/mem_pool.h"
+
+#if CONFIG_BT_MEM_POOL_ENABLE
+
+#define POOL_ALIGN              8
+#define POOL_ROUND_UP(s)        (((s) + POOL_ALIGN - 1) & ~(POOL_ALIGN - 1))
+
+// The free list head packs a 16 bit block index with a 16 bit tag that is
+// bumped on every update, so a stale compare-exchange can't succeed (ABA).
+#define POOL_IDX_NONE           0xFFFF
+#define POOL_HEAD_IDX(h)        ((h) & 0xFFFF)
+#define POOL_HEAD_NEXT(h, idx)  ((((h) + 0x10000) & 0xFFFF0000) | (idx))
+
+typedef struct {
+    uint32_t block_size;
+    uint32_t block_count;
+    uint8_t *base;
+    uint8_t *end;
+    uint32_t free_head;
+
+    uint32_t in_use;
+    uint32_t high_water;
+    uint32_t alloc_count;
+    uint32_t fail_count;
+} osi_mem_pool_t;
+
+static const struct {
+    uint32_t size;
+    uint32_t count;
+} pool_cfg[OSI_MEM_POOL_CLASS_NUM] = {
+    { OSI_MEM_POOL_0_SIZE, OSI_MEM_POOL_0_COUNT },
+    { OSI_MEM_POOL_1_SIZE, OSI_MEM_POOL_1_COUNT },
+    { OSI_MEM_POOL_2_SIZE, OSI_MEM_POOL_2_COUNT },
+    { OSI_MEM_POOL_3_SIZE, OSI_MEM_POOL_3_COUNT },
+    { OSI_MEM_POOL_4_SIZE, OSI_MEM_POOL_4_COUNT },
+};
+
+static osi_mem_pool_t pools[OSI_MEM_POOL_CLASS_NUM];
+static uint8_t *pool_arena;
+static uint8_t *pool_arena_end;
+
+static inline uint32_t *pool_block(osi_mem_pool_t *pool, uint32_t idx)
+{
+    return (uint32_t *)(pool->base + idx * pool->block_size);
+}
+
+static void *pool_pop(osi_mem_pool_t *pool)
+{
+    uint32_t head = __atomic_load_n(&pool->free_head, __ATOMIC_ACQUIRE);
+    uint32_t idx, next;
+
+    do {
+        idx = POOL_HEAD_IDX(head);
+        if (idx == POOL_IDX_NONE) {
+            return NULL;
+        }
+        next = POOL_HEAD_NEXT(head, *pool_block(pool, idx) & 0xFFFF);
+    } while (!__atomic_compare_exchange_n(&pool->free_head, &head, next, false,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+    return pool_block(pool, idx);
+}
+
+static void pool_push(osi_mem_pool_t *pool, void *ptr)
+{
+    uint32_t idx = ((uint8_t *)ptr - pool->base) / pool->block_size;
+    uint32_t head = __atomic_load_n(&pool->free_head, __ATOMIC_ACQUIRE);
+    uint32_t next;
+
+    do {
+        *(uint32_t *)ptr = POOL_HEAD_IDX(head);
+        next = POOL_HEAD_NEXT(head, idx);
+    } while (!__atomic_compare_exchange_n(&pool->free_head, &head, next, false,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+}
+
+int osi_mem_pool_init(void)
+{
+    size_t total = 0;
+    uint8_t *p;
+    uint32_t i, j;
+
+    if (pool_arena) {
+        return 0;
+    }
+
+    for (i = 0; i < OSI_MEM_POOL_CLASS_NUM; i++) {
+        assert(pool_cfg[i].count < POOL_IDX_NONE);
+        assert(i == 0 || pool_cfg[i].size > pool_cfg[i - 1].size);
+        total += POOL_ROUND_UP(pool_cfg[i].size) * pool_cfg[i].count;
+    }
+
+    // Plain malloc, the arena itself must never go through the pools
+    pool_arena = malloc(total);
+    if (!pool_arena) {
+        OSI_TRACE_ERROR("%s unable to allocate %d bytes, using heap only\n", __func__, (int)total);
+        return -1;
+    }
+    pool_arena_end = pool_arena + total;
+
+    p = pool_arena;
+    for (i = 0; i < OSI_MEM_POOL_CLASS_NUM; i++) {
+        osi_mem_pool_t *pool = &pools[i];
+
+        memset(pool, 0, sizeof(osi_mem_pool_t));
+        pool->block_size = POOL_ROUND_UP(pool_cfg[i].size);
+        pool->block_count = pool_cfg[i].count;
+        pool->base = p;
+        pool->end = p + pool->block_size * pool->block_count;
+        pool->free_head = POOL_IDX_NONE;
+
+        for (j = 0; j < pool->block_count; j++) {
+            *pool_block(pool, j) = (j + 1 < pool->block_count) ? j + 1 : POOL_IDX_NONE;
+        }
+        if (pool->block_count) {
+            pool->free_head = 0;
+        }
+
+        p = pool->end;
+    }
+
+    return 0;
+}
+
+void osi_mem_pool_deinit(void)
+{
+    uint32_t i;
+
+    if (!pool_arena) {
+        return;
+    }
+
+    for (i = 0; i < OSI_MEM_POOL_CLASS_NUM; i++) {
+        if (pools[i].in_use) {
+            OSI_TRACE_WARNING("%s class %d still has %d blocks in use, keeping pools\n",
+                              __func__, i, pools[i].in_use);
+            return;
+        }
+    }
+
+    // Make sure nothing is handed out while the arena goes away
+    for (i = 0; i < OSI_MEM_POOL_CLASS_NUM; i++) {
+        __atomic_store_n(&pools[i].free_head, POOL_IDX_NONE, __ATOMIC_RELEASE);
+    }
+
+    free(pool_arena);
+    pool_arena = NULL;
+    pool_arena_end = NULL;
+}
+
+void *osi_mem_pool_alloc(size_t size)
+{
+    osi_mem_pool_t *pool;
+    uint32_t in_use, high;
+    void *ret;
+    int i;
+
+    if (!pool_arena) {
+        return NULL;
+    }
+
+    for (i = 0; i < OSI_MEM_POOL_CLASS_NUM; i++) {
+        if (size <= pools[i].block_size && pools[i].block_count) {
+            break;
+        }
+    }
+
+    if (i == OSI_MEM_POOL_CLASS_NUM) {
+        return NULL;
+    }
+
+    pool = &pools[i];
+    ret = pool_pop(pool);
+    if (!ret) {
+        __atomic_fetch_add(&pool->fail_count, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    __atomic_fetch_add(&pool->alloc_count, 1, __ATOMIC_RELAXED);
+    in_use = __atomic_add_fetch(&pool->in_use, 1, __ATOMIC_RELAXED);
+    high = __atomic_load_n(&pool->high_water, __ATOMIC_RELAXED);
+    while (in_use > high &&
+           !__atomic_compare_exchange_n(&pool->high_water, &high, in_use, false,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+
+    return ret;
+}
+
+bool osi_mem_pool_free(void *ptr)
+{
+    uint8_t *p = (uint8_t *)ptr;
+    int i;
+
+    if (p < pool_arena || p >= pool_arena_end) {
+        return false;
+    }
+
+    for (i = 0; i < OSI_MEM_POOL_CLASS_NUM; i++) {
+        if (p >= pools[i].base && p < pools[i].end) {
+            assert((p - pools[i].base) % pools[i].block_size == 0);
+            __atomic_fetch_sub(&pools[i].in_use, 1, __ATOMIC_RELAXED);
+            pool_push(&pools[i], ptr);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool osi_mem_pool_get_stats(int class_idx, osi_mem_pool_stats_t *stats)
+{
+    osi_mem_pool_t *pool;
+
+    if (class_idx < 0 || class_idx >= OSI_MEM_POOL_CLASS_NUM || !stats) {
+        return false;
+    }
+
+    pool = &pools[class_idx];
+    stats->block_size = pool_cfg[class_idx].size;
+    stats->block_count = pool_arena ? pool->block_count : 0;
+    stats->in_use = __atomic_load_n(&pool->in_use, __ATOMIC_RELAXED);
+    stats->high_water = __atomic_load_n(&pool->high_water, __ATOMIC_RELAXED);
+    stats->alloc_count = __atomic_load_n(&pool->alloc_count, __ATOMIC_RELAXED);
+    stats->fail_count = __atomic_load_n(&pool->fail_count, __ATOMIC_RELAXED);
+
+    return true;
+}
+
+#else /* CONFIG_BT_MEM_POOL_ENABLE */
+
+int osi_mem_pool_init(void)
+{
+    return 0;
+}
+
+void osi_mem_pool_deinit(void)
+{
+}
+
+void *osi_mem_pool_alloc(size_t size)
+{
+    return NULL;
+}
+
+bool osi_mem_pool_free(void *ptr)
+{
+    return false;
+}
+
+bool osi_mem_pool_get_stats(int class_idx, osi_mem_pool_stats_t *stats)
+{
+    return false;
+}
+
+#endif /* CONFIG_BT_MEM_POOL_ENABLE */
+
+void osi_mem_pool_show(void)
+{
+    osi_mem_pool_stats_t stats;
+    int i;
+
+    for (i = 0; i < OSI_MEM_POOL_CLASS_NUM; i++) {
+        if (osi_mem_pool_get_stats(i, &stats)) {
+            OSI_TRACE_ERROR("--> pool %d: size %d, count %d, in use %d, high %d, allocs %d, fails %d\n",
+                            i, stats.block_size, stats.block_count, stats.in_use,
+                            stats.high_water, stats.alloc_count, stats.fail_count);
+        }
+    }
+}
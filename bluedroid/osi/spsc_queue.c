@@ -0,0 +1,262 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdint.h>
+
+#include "common/bt_defs.h"
+#include "common/bt_trace.h"
+#include "osi/allocator.h"
+#include "osi/semaphore.h"
+#include "osi/spsc_queue.h"
+
+#define SPSC_LOAD(p)            __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define SPSC_STORE(p, v)        __atomic_store_n((p), (v), __ATOMIC_SEQ_CST)
+#define SPSC_CAS(p, e, v)       __atomic_compare_exchange_n((p), (e), (v), false, \
+                                                            __ATOMIC_SEQ_CST, __ATOMIC_ACQUIRE)
+
+typedef struct spsc_queue_t {
+    void **slots;
+    uint32_t mask;
+    uint32_t capacity;
+
+    // Free running indexes, |head| is only written by the producer
+    uint32_t head;
+    uint32_t tail;
+
+    // Set by a side that is about to block, so the other side knows it
+    // has to give the matching semaphore
+    uint8_t enqueue_waiting;
+    uint8_t dequeue_waiting;
+    osi_sem_t enqueue_sem;
+    osi_sem_t dequeue_sem;
+
+    spsc_queue_cb dequeue_ready;
+} spsc_queue_t;
+
+static inline void wake_if_waiting(uint8_t *waiting, osi_sem_t *sem)
+{
+    if (__atomic_load_n(waiting, __ATOMIC_SEQ_CST)) {
+        SPSC_STORE(waiting, 0);
+        osi_sem_give(sem);
+    }
+}
+
+spsc_queue_t *spsc_queue_new(size_t capacity)
+{
+    uint32_t slot_count = 1;
+    spsc_queue_t *ret;
+
+    if (capacity == 0) {
+        return NULL;
+    }
+
+    while (slot_count < capacity) {
+        slot_count <<= 1;
+    }
+
+    ret = osi_calloc(sizeof(spsc_queue_t));
+    if (!ret) {
+        goto error;
+    }
+
+    ret->slots = osi_calloc(slot_count * sizeof(void *));
+    if (!ret->slots) {
+        goto error;
+    }
+
+    ret->mask = slot_count - 1;
+    ret->capacity = capacity;
+
+    if (osi_sem_new(&ret->enqueue_sem, 1, 0) != 0) {
+        goto error;
+    }
+
+    if (osi_sem_new(&ret->dequeue_sem, 1, 0) != 0) {
+        goto error;
+    }
+
+    return ret;
+
+error:
+    OSI_TRACE_ERROR("%s unable to allocate queue of %d\n", __func__, (int)capacity);
+    spsc_queue_free(ret, NULL);
+    return NULL;
+}
+
+void spsc_queue_free(spsc_queue_t *queue, spsc_queue_free_cb free_cb)
+{
+    void *data;
+
+    if (queue == NULL) {
+        return;
+    }
+
+    spsc_queue_unregister_dequeue(queue);
+
+    if (queue->slots) {
+        while ((data = spsc_queue_try_dequeue(queue)) != NULL) {
+            if (free_cb) {
+                free_cb(data);
+            }
+        }
+        osi_free(queue->slots);
+    }
+
+    osi_sem_free(&queue->enqueue_sem);
+    osi_sem_free(&queue->dequeue_sem);
+    osi_free(queue);
+}
+
+bool spsc_queue_is_empty(spsc_queue_t *queue)
+{
+    return spsc_queue_length(queue) == 0;
+}
+
+size_t spsc_queue_length(spsc_queue_t *queue)
+{
+    uint32_t tail;
+
+    if (queue == NULL) {
+        return 0;
+    }
+
+    tail = SPSC_LOAD(&queue->tail);
+    return SPSC_LOAD(&queue->head) - tail;
+}
+
+size_t spsc_queue_capacity(spsc_queue_t *queue)
+{
+    assert(queue != NULL);
+
+    return queue->capacity;
+}
+
+bool spsc_queue_try_enqueue(spsc_queue_t *queue, void *data)
+{
+    uint32_t head;
+
+    assert(queue != NULL);
+    assert(data != NULL);
+
+    head = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+    if (head - SPSC_LOAD(&queue->tail) >= queue->capacity) {
+        return false;
+    }
+
+    queue->slots[head & queue->mask] = data;
+    SPSC_STORE(&queue->head, head + 1);
+
+    wake_if_waiting(&queue->dequeue_waiting, &queue->dequeue_sem);
+
+    return true;
+}
+
+void spsc_queue_enqueue(spsc_queue_t *queue, void *data)
+{
+    while (!spsc_queue_try_enqueue(queue, data)) {
+        SPSC_STORE(&queue->enqueue_waiting, 1);
+
+        // Re-check after announcing ourselves, space may have been made
+        // before the consumer could see the flag
+        if (spsc_queue_try_enqueue(queue, data)) {
+            SPSC_STORE(&queue->enqueue_waiting, 0);
+            return;
+        }
+
+        osi_sem_take(&queue->enqueue_sem, OSI_SEM_MAX_TIMEOUT);
+    }
+}
+
+void *spsc_queue_try_dequeue(spsc_queue_t *queue)
+{
+    uint32_t tail;
+    void *ret;
+
+    if (queue == NULL) {
+        return NULL;
+    }
+
+    // The slot is read before the tail is claimed. If another dequeuer
+    // wins the race the compare-exchange fails and we retry; the producer
+    // can only reuse the slot once the tail has moved past it.
+    tail = SPSC_LOAD(&queue->tail);
+    do {
+        if (SPSC_LOAD(&queue->head) == tail) {
+            return NULL;
+        }
+        ret = queue->slots[tail & queue->mask];
+    } while (!SPSC_CAS(&queue->tail, &tail, tail + 1));
+
+    wake_if_waiting(&queue->enqueue_waiting, &queue->enqueue_sem);
+
+    return ret;
+}
+
+void *spsc_queue_dequeue(spsc_queue_t *queue)
+{
+    void *ret;
+
+    assert(queue != NULL);
+
+    while ((ret = spsc_queue_try_dequeue(queue)) == NULL) {
+        SPSC_STORE(&queue->dequeue_waiting, 1);
+
+        if ((ret = spsc_queue_try_dequeue(queue)) != NULL) {
+            SPSC_STORE(&queue->dequeue_waiting, 0);
+            break;
+        }
+
+        osi_sem_take(&queue->dequeue_sem, OSI_SEM_MAX_TIMEOUT);
+    }
+
+    return ret;
+}
+
+void *spsc_queue_try_peek_first(spsc_queue_t *queue)
+{
+    uint32_t tail;
+
+    if (queue == NULL) {
+        return NULL;
+    }
+
+    tail = SPSC_LOAD(&queue->tail);
+    if (SPSC_LOAD(&queue->head) == tail) {
+        return NULL;
+    }
+
+    return queue->slots[tail & queue->mask];
+}
+
+void spsc_queue_register_dequeue(spsc_queue_t *queue, spsc_queue_cb ready_cb)
+{
+    assert(queue != NULL);
+    assert(ready_cb != NULL);
+
+    queue->dequeue_ready = ready_cb;
+}
+
+void spsc_queue_unregister_dequeue(spsc_queue_t *queue)
+{
+    assert(queue != NULL);
+
+    queue->dequeue_ready = NULL;
+}
+
+void spsc_queue_process(spsc_queue_t *queue)
+{
+    assert(queue != NULL);
+
+    if (queue->dequeue_ready) {
+        queue->dequeue_ready(queue);
+    }
+}
@@ -0,0 +1,328 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks that the bond store survives a reload: records, their order,
+// removals, a change of record size and, for the file backend, a torn last
+// entry and compaction. The Makefile builds this with the file backend (the
+// log is argv[1]) and with the aos_kv backend on the in-memory host aos_kv,
+// where it also checks that one changed record costs one write.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "common/bt_defs.h"
+#include "osi/bond_store.h"
+#include "host_bench.h"
+#if (BOND_STORE_KV_INCLUDED == TRUE)
+#include "aos/kv.h"
+#endif
+
+#define TEST_RECORD_SIZE        40
+#define TEST_MAX_RECORDS        4
+
+// journal entry: magic, op, id, crc, data
+#define TEST_LOG_HDR_LEN        8
+#define TEST_ENTRY_SIZE         (2 + BOND_STORE_ID_LEN + 2 + TEST_RECORD_SIZE)
+
+#define TEST_KV_KEY             "bt_test"
+
+static const char *test_path;
+static bond_store_backend_t *test_backend;
+
+static bond_store_t *test_open(size_t record_size)
+{
+#if (BOND_STORE_KV_INCLUDED == TRUE)
+    test_backend = bond_store_kv_backend_new(TEST_KV_KEY);
+#else
+    test_backend = bond_store_file_backend_new(test_path);
+#endif
+    return bond_store_new(test_backend, record_size, TEST_MAX_RECORDS);
+}
+
+static void test_close(bond_store_t *store)
+{
+    bond_store_free(store);
+#if (BOND_STORE_KV_INCLUDED == TRUE)
+    bond_store_kv_backend_free(test_backend);
+#else
+    bond_store_file_backend_free(test_backend);
+#endif
+    test_backend = NULL;
+}
+
+static void test_reset(void)
+{
+#if (BOND_STORE_KV_INCLUDED == TRUE)
+    host_kv_reset();
+#else
+    remove(test_path);
+#endif
+}
+
+static void test_id(uint8_t *id, uint8_t n)
+{
+    for (int i = 0; i < BOND_STORE_ID_LEN; i++) {
+        id[i] = 0xA0 + n + i;
+    }
+}
+
+static void test_fill(uint8_t *data, uint8_t n, uint8_t gen)
+{
+    for (int i = 0; i < TEST_RECORD_SIZE; i++) {
+        data[i] = n * 16 + gen + i;
+    }
+}
+
+// Writes record |n| of generation |gen| and marks it dirty
+static int test_put(bond_store_t *store, uint8_t n, uint8_t gen)
+{
+    uint8_t id[BOND_STORE_ID_LEN];
+    int slot;
+
+    test_id(id, n);
+    if ((slot = bond_store_add(store, id)) >= 0) {
+        test_fill(bond_store_data(store, slot), n, gen);
+        bond_store_mark_dirty(store, slot);
+    }
+    return slot;
+}
+
+// Returns 0 if |store| holds exactly the records |n| of generation |gen|,
+// newest first
+static int test_expect(const char *name, bond_store_t *store, const uint8_t *n, const uint8_t *gen, int count)
+{
+    uint8_t id[BOND_STORE_ID_LEN], data[TEST_RECORD_SIZE];
+    int slot = bond_store_first(store);
+    int i;
+
+    for (i = 0; i < count && slot >= 0; i++, slot = bond_store_next(store, slot)) {
+        test_id(id, n[i]);
+        test_fill(data, n[i], gen[i]);
+        if (memcmp(bond_store_id(store, slot), id, sizeof(id)) != 0
+                || memcmp(bond_store_data(store, slot), data, sizeof(data)) != 0) {
+            break;
+        }
+    }
+    return host_test_true(name, i == count && slot < 0);
+}
+
+static int test_round_trip(void)
+{
+    bond_store_t *store;
+    int fail = 0;
+
+    test_reset();
+    store = test_open(TEST_RECORD_SIZE);
+    test_put(store, 1, 0);
+    test_put(store, 2, 0);
+    test_put(store, 3, 0);
+    fail |= host_test_true("round trip flush", bond_store_flush(store));
+    test_close(store);
+
+    store = test_open(TEST_RECORD_SIZE);
+    fail |= test_expect("round trip reload", store, (const uint8_t[]){ 3, 2, 1 }, (const uint8_t[]){ 0, 0, 0 }, 3);
+
+    // an update of the oldest record, then make it the newest
+    test_put(store, 1, 1);
+    bond_store_flush(store);
+    bond_store_touch(store, test_put(store, 2, 2));
+    bond_store_flush(store);
+    test_close(store);
+
+    store = test_open(TEST_RECORD_SIZE);
+    fail |= test_expect("touch reload", store, (const uint8_t[]){ 2, 3, 1 }, (const uint8_t[]){ 2, 0, 1 }, 3);
+
+    bond_store_remove(store, test_put(store, 3, 0));
+    test_close(store);
+    store = test_open(TEST_RECORD_SIZE);
+    fail |= test_expect("remove reload", store, (const uint8_t[]){ 2, 1 }, (const uint8_t[]){ 2, 1 }, 2);
+
+    bond_store_clear(store);
+    test_close(store);
+    store = test_open(TEST_RECORD_SIZE);
+    fail |= test_expect("clear reload", store, NULL, NULL, 0);
+    test_close(store);
+    return fail;
+}
+
+static int test_layout_mismatch(void)
+{
+    bond_store_t *store;
+    int fail = 0;
+
+    test_reset();
+    store = test_open(TEST_RECORD_SIZE);
+    test_put(store, 1, 0);
+    test_put(store, 2, 0);
+    bond_store_flush(store);
+    test_close(store);
+
+    // a store of another record size starts empty
+    store = test_open(TEST_RECORD_SIZE + 1);
+    fail |= host_test_true("layout mismatch discards", bond_store_first(store) < 0);
+    test_close(store);
+
+    store = test_open(TEST_RECORD_SIZE);
+    fail |= host_test_true("layout mismatch stays discarded", bond_store_first(store) < 0);
+    test_close(store);
+#if (BOND_STORE_KV_INCLUDED == TRUE)
+    fail |= host_test_true("layout mismatch deletes the records", host_kv_count() == 1);
+#endif
+    return fail;
+}
+
+#if (BOND_STORE_KV_INCLUDED == TRUE)
+static int test_kv_records(void)
+{
+    bond_store_t *store;
+    int writes, fail = 0;
+
+    test_reset();
+    store = test_open(TEST_RECORD_SIZE);
+    test_put(store, 1, 0);
+    test_put(store, 2, 0);
+    test_put(store, 3, 0);
+    bond_store_flush(store);
+    fail |= host_test_true("kv one value per record", host_kv_count() == 4);
+    fail |= host_test_true("kv record size", host_kv_len(TEST_KV_KEY "_a2a3a4a5a6a7") == TEST_RECORD_SIZE);
+
+    // an update of a known record writes that record only
+    writes = host_kv_writes();
+    test_put(store, 2, 1);
+    bond_store_flush(store);
+    fail |= host_test_true("kv update writes one record", host_kv_writes() == writes + 1);
+    test_close(store);
+
+    // a record missing from aos_kv is dropped, and so is its index entry
+    aos_kv_del(TEST_KV_KEY "_a1a2a3a4a5a6");
+    store = test_open(TEST_RECORD_SIZE);
+    fail |= test_expect("kv missing record", store, (const uint8_t[]){ 3, 2 }, (const uint8_t[]){ 0, 1 }, 2);
+    fail |= host_test_true("kv index rewritten", host_kv_len(TEST_KV_KEY) == TEST_LOG_HDR_LEN + 2 * BOND_STORE_ID_LEN);
+    test_close(store);
+    return fail;
+}
+#else
+static long test_file_size(void)
+{
+    FILE *fp = fopen(test_path, "rb");
+    long size = -1;
+
+    if (fp) {
+        fseek(fp, 0, SEEK_END);
+        size = ftell(fp);
+        fclose(fp);
+    }
+    return size;
+}
+
+static int test_torn_tail(void)
+{
+    bond_store_t *store;
+    long size;
+    int fail = 0;
+
+    test_reset();
+    store = test_open(TEST_RECORD_SIZE);
+    test_put(store, 1, 0);
+    test_put(store, 2, 0);
+    bond_store_flush(store);
+    test_put(store, 1, 1);
+    bond_store_flush(store);
+    test_close(store);
+
+    // a power loss in the middle of the last entry
+    size = test_file_size();
+    fail |= host_test_true("torn tail log size", size == TEST_LOG_HDR_LEN + 3 * TEST_ENTRY_SIZE);
+    if (truncate(test_path, size - TEST_ENTRY_SIZE / 2) != 0) {
+        return 1;
+    }
+
+    store = test_open(TEST_RECORD_SIZE);
+    fail |= test_expect("torn tail reload", store, (const uint8_t[]){ 2, 1 }, (const uint8_t[]){ 0, 0 }, 2);
+    test_close(store);
+    fail |= host_test_true("torn tail compacted", test_file_size() == TEST_LOG_HDR_LEN + 2 * TEST_ENTRY_SIZE);
+
+    // a bad CRC is the same as a torn entry
+    FILE *fp = fopen(test_path, "r+b");
+    if (!fp) {
+        return 1;
+    }
+    fseek(fp, TEST_LOG_HDR_LEN + TEST_ENTRY_SIZE + 20, SEEK_SET);
+    fputc(0x55, fp);
+    fclose(fp);
+
+    store = test_open(TEST_RECORD_SIZE);
+    fail |= test_expect("bad crc reload", store, (const uint8_t[]){ 1 }, (const uint8_t[]){ 0 }, 1);
+    test_close(store);
+    return fail;
+}
+
+static int test_compaction(void)
+{
+    bond_store_t *store;
+    long size, max_size = 0;
+    int fail = 0;
+
+    test_reset();
+    store = test_open(TEST_RECORD_SIZE);
+    for (int gen = 0; gen < 100; gen++) {
+        test_put(store, gen % 3, gen);
+        bond_store_flush(store);
+        size = test_file_size();
+        if (size > max_size) {
+            max_size = size;
+        }
+    }
+    test_close(store);
+
+    // the log is compacted once it holds a few entries per record slot
+    fail |= host_test_true("compaction bounds the log", max_size <= TEST_LOG_HDR_LEN + 5 * TEST_MAX_RECORDS * TEST_ENTRY_SIZE);
+
+    store = test_open(TEST_RECORD_SIZE);
+    fail |= test_expect("compaction reload", store, (const uint8_t[]){ 2, 1, 0 }, (const uint8_t[]){ 98, 97, 99 }, 3);
+    bond_store_compact(store);
+    test_close(store);
+    fail |= host_test_true("compaction size", test_file_size() == TEST_LOG_HDR_LEN + 3 * TEST_ENTRY_SIZE);
+    return fail;
+}
+#endif /* BOND_STORE_KV_INCLUDED == TRUE */
+
+int main(int argc, char **argv)
+{
+    int fail = 0;
+
+#if (BOND_STORE_KV_INCLUDED != TRUE)
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <log file>\n", argv[0]);
+        return 2;
+    }
+    test_path = argv[1];
+#endif
+
+    fail |= test_round_trip();
+    fail |= test_layout_mismatch();
+#if (BOND_STORE_KV_INCLUDED == TRUE)
+    fail |= test_kv_records();
+#else
+    fail |= test_torn_tail();
+    fail |= test_compaction();
+#endif
+    test_reset();
+
+    if (fail) {
+        printf("bond store: FAIL\n");
+        return 1;
+    }
+    return 0;
+}
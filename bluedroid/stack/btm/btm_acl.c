@@ -45,6 +45,7 @@
 #include "btm_int.h"
 #include "l2c_int.h"
 #include "stack/hcidefs.h"
+#include "hci/hci_layer.h"
 //#include "bt_utils.h"
 
 static void btm_read_remote_features (UINT16 handle);
@@ -547,6 +548,37 @@ void btm_acl_update_busy_level (tBTM_BLI_EVENT event)
     }
 }
 
+/*******************************************************************************
+**
+** Function         btm_acl_set_sched_class
+**
+** Description      This function is called by L2CAP to set the class the HCI
+**                  layer schedules outbound data of a connection with.
+**
+** Returns          void
+**
+*******************************************************************************/
+void btm_acl_set_sched_class (UINT16 hci_handle, UINT8 sched_class)
+{
+    uint8_t link_class;
+
+    switch (sched_class) {
+    case L2CAP_ACL_CLASS_MEDIA:
+        link_class = HCI_ACL_CLASS_MEDIA;
+        break;
+    case L2CAP_ACL_CLASS_HID:
+        link_class = HCI_ACL_CLASS_HID;
+        break;
+    case L2CAP_ACL_CLASS_BULK:
+        link_class = HCI_ACL_CLASS_BULK;
+        break;
+    default:
+        link_class = HCI_ACL_CLASS_DEFAULT;
+        break;
+    }
+    hci_acl_set_link_class(hci_handle, link_class);
+}
+
 /*******************************************************************************
 **
 ** Function         BTM_GetRole
@@ -1212,6 +1212,8 @@ void btm_sec_save_le_key(BD_ADDR bd_addr, tBTM_LE_KEY_TYPE key_type, tBTM_LE_KEY
             memcpy(p_rec->ble.static_addr, p_keys->pid_key.static_addr, BD_ADDR_LEN);
             p_rec->ble.static_addr_type = p_keys->pid_key.addr_type;
             p_rec->ble.key_type |= BTM_LE_KEY_PID;
+            /* addresses cached as not resolvable may belong to this device */
+            btm_ble_rpa_cache_clear();
             BTM_TRACE_DEBUG("BTM_LE_KEY_PID key_type=0x%x save peer IRK",  p_rec->ble.key_type);
             /* update device record address as static address */
             memcpy(p_rec->bd_addr, p_keys->pid_key.static_addr, BD_ADDR_LEN);
@@ -34,6 +34,8 @@
 #if (defined BLE_INCLUDED && BLE_INCLUDED == TRUE)
 #include "btm_ble_int.h"
 #include "stack/smp_api.h"
+#include "osi/alarm.h"
+#include "aes.h"
 
 
 /*******************************************************************************
@@ -249,35 +251,105 @@ static void btm_ble_resolve_address_cmpl(void)
 }
 /*******************************************************************************
 **
-** Function         btm_ble_proc_resolve_x
+** Function         btm_ble_rpa_match_irk
 **
-** Description      This function compares the X with random address 3 MSO bytes
-**                  to find a match, if not match, continue for next record.
+** Description      This function checks a resolvable private address against
+**                  one IRK. The hash ah(irk, prand) is one AES-128 with on the
+**                  fly keying, without the buffer allocation of SMP_Encrypt.
 **
-** Returns          None.
+** Returns          TRUE if the hash matches the 3 LSB of the address.
 **
 *******************************************************************************/
-static BOOLEAN btm_ble_proc_resolve_x(tSMP_ENC *p)
+static BOOLEAN btm_ble_rpa_match_irk(const BT_OCTET16 irk, const BD_ADDR rpa)
 {
-    tBTM_LE_RANDOM_CB   *p_mgnt_cb = &btm_cb.ble_ctr_cb.addr_mgnt_cb;
-    UINT8    comp[3];
-    BTM_TRACE_EVENT ("btm_ble_proc_resolve_x");
-    /* compare the hash with 3 LSB of bd address */
-    comp[0] = p_mgnt_cb->random_bda[5];
-    comp[1] = p_mgnt_cb->random_bda[4];
-    comp[2] = p_mgnt_cb->random_bda[3];
+    UINT8 key[BT_OCTET16_LEN];
+    UINT8 o_key[BT_OCTET16_LEN];
+    UINT8 block[BT_OCTET16_LEN];
+    UINT8 hash[BT_OCTET16_LEN];
+    UINT8 i;
 
-    if (p) {
-        if (!memcmp(p->param_buf, &comp[0], 3)) {
-            /* match is found */
-            BTM_TRACE_EVENT ("match is found");
-            btm_ble_resolve_address_cmpl();
-            return TRUE;
-        }
+    /* the AES core works on big endian operands, the IRK is kept little endian */
+    for (i = 0; i < BT_OCTET16_LEN; i++) {
+        key[i] = irk[BT_OCTET16_LEN - 1 - i];
     }
 
-    return FALSE;
+    /* r' = padding || prand, prand is the 3 MSB of the address */
+    memset(block, 0, BT_OCTET16_LEN - 3);
+    block[13] = rpa[0];
+    block[14] = rpa[1];
+    block[15] = rpa[2];
+
+    bluedroid_aes_encrypt_128(block, hash, key, o_key);
+
+    return (hash[13] == rpa[3] && hash[14] == rpa[4] && hash[15] == rpa[5]);
 }
+
+#if (BTM_BLE_RPA_CACHE_SIZE > 0)
+/*******************************************************************************
+**
+** Function         btm_ble_rpa_cache_find
+**
+** Description      This function looks up a resolvable private address in the
+**                  resolution cache.
+**
+** Returns          TRUE if a valid entry was found, its device record index,
+**                  BTM_SEC_MAX_DEVICE_RECORDS if the address does not resolve,
+**                  is returned in p_rec_index.
+**
+*******************************************************************************/
+static BOOLEAN btm_ble_rpa_cache_find(BD_ADDR rpa, UINT16 *p_rec_index)
+{
+    tBTM_LE_RANDOM_CB      *p_mgnt_cb = &btm_cb.ble_ctr_cb.addr_mgnt_cb;
+    tBTM_BLE_RPA_CACHE_ENT *p_ent = &p_mgnt_cb->rpa_cache[BTM_BLE_RPA_CACHE_IDX(rpa)];
+    tBTM_SEC_DEV_REC       *p_dev_rec;
+
+    if (!p_ent->in_use || memcmp(p_ent->rpa, rpa, BD_ADDR_LEN) != 0) {
+        return FALSE;
+    }
+
+    if (osi_time_get_os_boottime_ms() - p_ent->time_ms >= BTM_BLE_RPA_CACHE_TIMEOUT_MS) {
+        p_ent->in_use = FALSE;
+        return FALSE;
+    }
+
+    if (p_ent->rec_index >= BTM_SEC_MAX_DEVICE_RECORDS) {
+        p_mgnt_cb->rpa_cache_stats.neg_hits++;
+        *p_rec_index = BTM_SEC_MAX_DEVICE_RECORDS;
+        return TRUE;
+    }
+
+    /* the record may have been reused since, keys are cleared when it is freed */
+    p_dev_rec = &btm_cb.sec_dev_rec[p_ent->rec_index];
+    if (!(p_dev_rec->sec_flags & BTM_SEC_IN_USE) || !(p_dev_rec->ble.key_type & BTM_LE_KEY_PID)) {
+        p_ent->in_use = FALSE;
+        return FALSE;
+    }
+
+    p_mgnt_cb->rpa_cache_stats.hits++;
+    *p_rec_index = p_ent->rec_index;
+    return TRUE;
+}
+
+/*******************************************************************************
+**
+** Function         btm_ble_rpa_cache_add
+**
+** Description      This function records the result of resolving an address,
+**                  replacing the entry that shares its slot.
+**
+** Returns          None.
+**
+*******************************************************************************/
+static void btm_ble_rpa_cache_add(BD_ADDR rpa, UINT16 rec_index)
+{
+    tBTM_BLE_RPA_CACHE_ENT *p_ent = &btm_cb.ble_ctr_cb.addr_mgnt_cb.rpa_cache[BTM_BLE_RPA_CACHE_IDX(rpa)];
+
+    memcpy(p_ent->rpa, rpa, BD_ADDR_LEN);
+    p_ent->rec_index = (rec_index < BTM_SEC_MAX_DEVICE_RECORDS) ? (UINT8)rec_index : BTM_BLE_RPA_CACHE_NO_MATCH;
+    p_ent->time_ms = osi_time_get_os_boottime_ms();
+    p_ent->in_use = TRUE;
+}
+#endif  ///BTM_BLE_RPA_CACHE_SIZE > 0
 #endif  ///SMP_INCLUDED == TRUE
 
 /*******************************************************************************
@@ -320,25 +392,10 @@ BOOLEAN btm_ble_addr_resolvable (BD_ADDR rpa, tBTM_SEC_DEV_REC *p_dev_rec)
         return rt;
     }
 
-    UINT8 rand[3];
-    tSMP_ENC output;
     if ((p_dev_rec->device_type & BT_DEVICE_TYPE_BLE) &&
             (p_dev_rec->ble.key_type & BTM_LE_KEY_PID)) {
         BTM_TRACE_DEBUG("%s try to resolve", __func__);
-        /* use the 3 MSB of bd address as prand */
-        rand[0] = rpa[2];
-        rand[1] = rpa[1];
-        rand[2] = rpa[0];
-
-        /* generate X = E irk(R0, R1, R2) and R is random address 3 LSO */
-        SMP_Encrypt(p_dev_rec->ble.keys.irk, BT_OCTET16_LEN,
-                    &rand[0], 3, &output);
-
-        rand[0] = rpa[5];
-        rand[1] = rpa[4];
-        rand[2] = rpa[3];
-
-        if (!memcmp(output.param_buf, &rand[0], 3)) {
+        if (btm_ble_rpa_match_irk(p_dev_rec->ble.keys.irk, rpa)) {
             btm_ble_init_pseudo_addr (p_dev_rec, rpa);
             rt = TRUE;
         }
@@ -352,47 +409,34 @@ BOOLEAN btm_ble_addr_resolvable (BD_ADDR rpa, tBTM_SEC_DEV_REC *p_dev_rec)
 **
 ** Function         btm_ble_match_random_bda
 **
-** Description      This function match the random address to the appointed device
-**                  record, starting from calculating IRK. If record index exceed
-**                  the maximum record number, matching failed and send callback.
+** Description      This function matches the random address against the IRK of
+**                  every LE device record in one pass.
 **
-** Returns          None.
+** Returns          index of the matching device record, or
+**                  BTM_SEC_MAX_DEVICE_RECORDS if no IRK resolves the address.
 **
 *******************************************************************************/
-static BOOLEAN btm_ble_match_random_bda(UINT16 rec_index)
+static UINT16 btm_ble_match_random_bda(BD_ADDR random_bda)
 {
-    /* use the 3 MSB of bd address as prand */
+    tBTM_SEC_DEV_REC *p_dev_rec;
+    UINT16 rec_index;
 
-    tBTM_LE_RANDOM_CB *p_mgnt_cb = &btm_cb.ble_ctr_cb.addr_mgnt_cb;
-    UINT8 rand[3];
-    rand[0] = p_mgnt_cb->random_bda[2];
-    rand[1] = p_mgnt_cb->random_bda[1];
-    rand[2] = p_mgnt_cb->random_bda[0];
-
-    BTM_TRACE_EVENT("%s rec_index = %d", __func__, rec_index);
-
-    if (rec_index < BTM_SEC_MAX_DEVICE_RECORDS) {
-        tSMP_ENC output;
-        tBTM_SEC_DEV_REC *p_dev_rec;
+    for (rec_index = 0; rec_index < BTM_SEC_MAX_DEVICE_RECORDS; rec_index++) {
         p_dev_rec = &btm_cb.sec_dev_rec[rec_index];
 
-        BTM_TRACE_DEBUG("sec_flags = %02x device_type = %d", p_dev_rec->sec_flags,
-                        p_dev_rec->device_type);
-
         if ((p_dev_rec->device_type & BT_DEVICE_TYPE_BLE) &&
                 (p_dev_rec->ble.key_type & BTM_LE_KEY_PID)) {
-            /* generate X = E irk(R0, R1, R2) and R is random address 3 LSO */
-            SMP_Encrypt(p_dev_rec->ble.keys.irk, BT_OCTET16_LEN,
-                        &rand[0], 3, &output);
-            return btm_ble_proc_resolve_x(&output);
-        } else {
-            // not completed
-            return FALSE;
+#if (BTM_BLE_RPA_CACHE_SIZE > 0)
+            btm_cb.ble_ctr_cb.addr_mgnt_cb.rpa_cache_stats.irk_checks++;
+#endif
+            if (btm_ble_rpa_match_irk(p_dev_rec->ble.keys.irk, random_bda)) {
+                BTM_TRACE_EVENT("%s match is found, rec_index = %d", __func__, rec_index);
+                break;
+            }
         }
-    } else { /* no  match found */
-        btm_ble_resolve_address_cmpl();
-        return TRUE;
     }
+
+    return rec_index;
 }
 #endif ///BLE_INCLUDED == TRUE && SMP_INCLUDED == TRUE
 
@@ -415,18 +459,18 @@ void btm_ble_resolve_random_addr(BD_ADDR random_bda, tBTM_BLE_RESOLVE_CBACK *p_c
     if ( !p_mgnt_cb->busy) {
         p_mgnt_cb->p = p;
         p_mgnt_cb->busy = TRUE;
-        p_mgnt_cb->index = 0;
         p_mgnt_cb->p_resolve_cback = p_cback;
         memcpy(p_mgnt_cb->random_bda, random_bda, BD_ADDR_LEN);
-        /* start to resolve random address */
-        /* check for next security record */
-        while (TRUE) {
-            if (btm_ble_match_random_bda(p_mgnt_cb->index)) {
-                /* atch found or went through the list */
-                break;
-            }
-            p_mgnt_cb->index ++;
+#if (BTM_BLE_RPA_CACHE_SIZE > 0)
+        if (!btm_ble_rpa_cache_find(random_bda, &p_mgnt_cb->index)) {
+            p_mgnt_cb->rpa_cache_stats.misses++;
+            p_mgnt_cb->index = btm_ble_match_random_bda(random_bda);
+            btm_ble_rpa_cache_add(random_bda, p_mgnt_cb->index);
         }
+#else
+        p_mgnt_cb->index = btm_ble_match_random_bda(random_bda);
+#endif
+        btm_ble_resolve_address_cmpl();
     } else {
         (*p_cback)(NULL, p);
     }
@@ -434,6 +478,54 @@ void btm_ble_resolve_random_addr(BD_ADDR random_bda, tBTM_BLE_RESOLVE_CBACK *p_c
 
 }
 
+/*******************************************************************************
+**
+** Function         btm_ble_rpa_cache_clear
+**
+** Description      This function drops all cached address resolutions. It is
+**                  called when an IRK is added or removed.
+**
+** Returns          None.
+**
+*******************************************************************************/
+void btm_ble_rpa_cache_clear(void)
+{
+#if (SMP_INCLUDED == TRUE && BTM_BLE_RPA_CACHE_SIZE > 0)
+    tBTM_LE_RANDOM_CB *p_mgnt_cb = &btm_cb.ble_ctr_cb.addr_mgnt_cb;
+    UINT16 i;
+
+    for (i = 0; i < BTM_BLE_RPA_CACHE_SIZE; i++) {
+        p_mgnt_cb->rpa_cache[i].in_use = FALSE;
+    }
+#endif
+}
+
+/*******************************************************************************
+**
+** Function         BTM_BleGetRpaCacheStats
+**
+** Description      This function reads the counters of the resolvable private
+**                  address cache.
+**
+** Parameters       p_stats - counters copied out
+**
+** Returns          BTM_SUCCESS, or BTM_MODE_UNSUPPORTED if there is no cache.
+**
+*******************************************************************************/
+tBTM_STATUS BTM_BleGetRpaCacheStats(tBTM_BLE_RPA_CACHE_STATS *p_stats)
+{
+#if (SMP_INCLUDED == TRUE && BTM_BLE_RPA_CACHE_SIZE > 0)
+    if (p_stats == NULL) {
+        return BTM_ILLEGAL_VALUE;
+    }
+    memcpy(p_stats, &btm_cb.ble_ctr_cb.addr_mgnt_cb.rpa_cache_stats, sizeof(tBTM_BLE_RPA_CACHE_STATS));
+    return BTM_SUCCESS;
+#else
+    UNUSED(p_stats);
+    return BTM_MODE_UNSUPPORTED;
+#endif
+}
+
 
 /*******************************************************************************
 **  address mapping between pseudo address and real connection address
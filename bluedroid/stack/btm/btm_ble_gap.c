@@ -27,6 +27,7 @@
 #include <stddef.h>
 
 #include "stack/bt_types.h"
+#include "osi/alarm.h"
 //#include "bt_utils.h"
 #include "btm_int.h"
 #include "stack/btm_ble_api.h"
@@ -67,6 +68,7 @@ tBTM_CallbackFunc conn_param_update_cb;
 *******************************************************************************/
 static void btm_ble_update_adv_flag(UINT8 flag);
 static void btm_ble_process_adv_pkt_cont(BD_ADDR bda, UINT8 addr_type, UINT8 evt_type, UINT8 *p);
+static void btm_ble_update_scan_stats(tINQ_DB_ENT *p_i);
 UINT8 *btm_ble_build_adv_data(tBTM_BLE_AD_MASK *p_data_mask, UINT8 **p_dst,
                               tBTM_BLE_ADV_DATA *p_data);
 static UINT8 btm_set_conn_mode_adv_init_addr(tBTM_BLE_INQ_CB *p_cb,
@@ -2915,6 +2917,7 @@ BOOLEAN btm_ble_update_inq_result(BD_ADDR bda, tINQ_DB_ENT *p_i, UINT8 addr_type
     p_cur->inq_result_type = BTM_INQ_RESULT_BLE;
     p_cur->ble_addr_type    = addr_type;
     p_cur->rssi = rssi;
+    btm_ble_update_scan_stats(p_i);
 
     /* active scan, always wait until get scan_rsp to report the result */
     if ((btm_cb.ble_ctr_cb.inq_var.scan_type == BTM_BLE_SCAN_MODE_ACTI &&
@@ -3011,7 +3014,7 @@ void btm_clear_all_pending_le_entry(void)
         if ((p_ent->in_use) &&
                 (p_ent->inq_info.results.device_type == BT_DEVICE_TYPE_BLE) &&
                 !p_ent->scan_rsp) {
-            p_ent->in_use = FALSE;
+            btm_inq_db_free_ent(p_ent);
         }
     }
 }
@@ -3197,6 +3200,104 @@ static void btm_ble_process_last_adv_pkt(void)
     }
 }
 
+/*******************************************************************************
+**
+** Function         btm_ble_update_scan_stats
+**
+** Description      This function counts an advertising report of an inquiry
+**                  database entry and updates its RSSI and interval statistics.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btm_ble_update_scan_stats(tINQ_DB_ENT *p_i)
+{
+    tBTM_BLE_SCAN_STATS *p_stats = &p_i->scan_stats;
+    INT8                rssi = p_i->inq_info.results.rssi;
+    UINT32              now = osi_time_get_os_boottime_ms();
+    UINT32              interval;
+
+    if (p_stats->adv_count == 0) {
+        p_stats->rssi_min = rssi;
+        p_stats->rssi_max = rssi;
+        p_i->rssi_sum_q4 = (INT32)rssi << 4;
+    } else {
+        if (rssi < p_stats->rssi_min) {
+            p_stats->rssi_min = rssi;
+        }
+        if (rssi > p_stats->rssi_max) {
+            p_stats->rssi_max = rssi;
+        }
+        /* running averages with a weight of 1/8 for the new sample */
+        p_i->rssi_sum_q4 += (((INT32)rssi << 4) - p_i->rssi_sum_q4) / 8;
+
+        interval = now - p_stats->last_seen_ms;
+        if (p_stats->adv_count == 1) {
+            p_stats->adv_interval_ms = interval;
+        } else {
+            p_stats->adv_interval_ms = p_stats->adv_interval_ms - (p_stats->adv_interval_ms / 8) + (interval / 8);
+        }
+    }
+
+    if (p_stats->adv_count < 0xFFFF) {
+        p_stats->adv_count++;
+    }
+    p_stats->rssi_last = rssi;
+    p_stats->rssi_avg = (INT8)(p_i->rssi_sum_q4 / 16);
+    p_stats->last_seen_ms = now;
+
+    btm_inq_db_touch(p_i);
+}
+
+/*******************************************************************************
+**
+** Function         BTM_BleGetScanStats
+**
+** Description      This function reads the advertising report statistics
+**                  kept for a device in the inquiry database.
+**
+** Parameters       bd_addr - device address
+**                  p_stats - statistics copied out
+**
+** Returns          BTM_SUCCESS if the device is known; otherwise BTM_UNKNOWN_ADDR.
+**
+*******************************************************************************/
+tBTM_STATUS BTM_BleGetScanStats(BD_ADDR bd_addr, tBTM_BLE_SCAN_STATS *p_stats)
+{
+    tINQ_DB_ENT *p_i = btm_inq_db_find(bd_addr);
+
+    if (p_i == NULL || p_stats == NULL || p_i->scan_stats.adv_count == 0) {
+        return BTM_UNKNOWN_ADDR;
+    }
+
+    memcpy(p_stats, &p_i->scan_stats, sizeof(tBTM_BLE_SCAN_STATS));
+    return BTM_SUCCESS;
+}
+
+/*******************************************************************************
+**
+** Function         btm_ble_count_dup_report
+**
+** Description      This function updates the RSSI and scan statistics of an
+**                  inquiry database entry from an advertising report that is
+**                  not reported again in this inquiry.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btm_ble_count_dup_report(tINQ_DB_ENT *p_i, UINT8 *p)
+{
+    UINT8   data_len;
+
+    STREAM_TO_UINT8(data_len, p);
+    if (data_len > BTM_BLE_ADV_DATA_LEN_MAX) {
+        return;
+    }
+
+    p_i->inq_info.results.rssi = (INT8)p[data_len];
+    btm_ble_update_scan_stats(p_i);
+}
+
 /*******************************************************************************
 **
 ** Function         btm_ble_process_adv_pkt_cont
@@ -3257,7 +3358,10 @@ static void btm_ble_process_adv_pkt_cont(BD_ADDR bda, UINT8 addr_type, UINT8 evt
         } else if (BTM_BLE_IS_DISCO_ACTIVE(btm_cb.ble_ctr_cb.scan_activity)) {
             update = FALSE;
         } else {
-            /* if yes, skip it */
+            /* if yes, skip it, the report still counts towards the scan statistics */
+            if (p_i) {
+                btm_ble_count_dup_report(p_i, p);
+            }
             return; /* assumption: one result per event */
         }
     }
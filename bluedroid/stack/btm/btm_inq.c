@@ -1244,6 +1244,100 @@ tBTM_STATUS BTM_ReadInquiryRspTxPower (tBTM_CMPL_CB *p_cb)
 **                                                                              **
 **********************************************************************************
 *********************************************************************************/
+#define BTM_INQ_DB_IDX(p_ent)   ((UINT16)((p_ent) - btm_cb.btm_inq_vars.inq_db) + 1)
+#define BTM_INQ_DB_ENT(idx)     (&btm_cb.btm_inq_vars.inq_db[(idx) - 1])
+
+/*******************************************************************************
+**
+** Function         btm_inq_db_hash
+**
+** Description      Hash bucket of an address. The low three bytes are the
+**                  LAP of a public address or random bits of a random one.
+**
+** Returns          bucket index
+**
+*******************************************************************************/
+static UINT16 btm_inq_db_hash (BD_ADDR p_bda)
+{
+    UINT32 key = ((UINT32)p_bda[3] << 16) | ((UINT32)p_bda[4] << 8) | p_bda[5];
+
+    key ^= ((UINT32)p_bda[0] << 16) | ((UINT32)p_bda[1] << 8) | p_bda[2];
+    return (UINT16)(((key * 2654435761U) >> 16) & (BTM_INQ_DB_HASH_SIZE - 1));
+}
+
+/*******************************************************************************
+**
+** Function         btm_inq_db_lru_append
+**
+** Description      Put an entry at the most recently seen end of the LRU list.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btm_inq_db_lru_append (tINQ_DB_ENT *p_ent)
+{
+    tBTM_INQUIRY_VAR_ST *p_inq = &btm_cb.btm_inq_vars;
+    UINT16              idx = BTM_INQ_DB_IDX(p_ent);
+
+    p_ent->lru_prev = p_inq->inq_db_lru_tail;
+    p_ent->lru_next = BTM_INQ_DB_NONE;
+    if (p_inq->inq_db_lru_tail != BTM_INQ_DB_NONE) {
+        BTM_INQ_DB_ENT(p_inq->inq_db_lru_tail)->lru_next = idx;
+    } else {
+        p_inq->inq_db_lru_head = idx;
+    }
+    p_inq->inq_db_lru_tail = idx;
+}
+
+/*******************************************************************************
+**
+** Function         btm_inq_db_lru_unlink
+**
+** Description      Take an entry off the LRU list.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btm_inq_db_lru_unlink (tINQ_DB_ENT *p_ent)
+{
+    tBTM_INQUIRY_VAR_ST *p_inq = &btm_cb.btm_inq_vars;
+
+    if (p_ent->lru_prev != BTM_INQ_DB_NONE) {
+        BTM_INQ_DB_ENT(p_ent->lru_prev)->lru_next = p_ent->lru_next;
+    } else {
+        p_inq->inq_db_lru_head = p_ent->lru_next;
+    }
+    if (p_ent->lru_next != BTM_INQ_DB_NONE) {
+        BTM_INQ_DB_ENT(p_ent->lru_next)->lru_prev = p_ent->lru_prev;
+    } else {
+        p_inq->inq_db_lru_tail = p_ent->lru_prev;
+    }
+}
+
+/*******************************************************************************
+**
+** Function         btm_inq_db_unlink
+**
+** Description      Take an in use entry off its hash bucket and the LRU list.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btm_inq_db_unlink (tINQ_DB_ENT *p_ent)
+{
+    UINT16  *p_idx = &btm_cb.btm_inq_vars.inq_db_hash[btm_inq_db_hash(p_ent->inq_info.results.remote_bd_addr)];
+    UINT16  idx = BTM_INQ_DB_IDX(p_ent);
+
+    while (*p_idx != BTM_INQ_DB_NONE) {
+        if (*p_idx == idx) {
+            *p_idx = p_ent->hash_next;
+            break;
+        }
+        p_idx = &BTM_INQ_DB_ENT(*p_idx)->hash_next;
+    }
+    btm_inq_db_lru_unlink(p_ent);
+}
+
 /*******************************************************************************
 **
 ** Function         btm_inq_db_reset
@@ -1415,14 +1509,19 @@ void btm_clr_inq_db (BD_ADDR p_bda)
     BTM_TRACE_DEBUG ("btm_clr_inq_db: inq_active:0x%x state:%d\n",
                      btm_cb.btm_inq_vars.inq_active, btm_cb.btm_inq_vars.state);
 #endif
-    for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++) {
-        if (p_ent->in_use) {
-            /* If this is the specified BD_ADDR or clearing all devices */
-            if (p_bda == NULL ||
-                    (!memcmp (p_ent->inq_info.results.remote_bd_addr, p_bda, BD_ADDR_LEN))) {
-                p_ent->in_use = FALSE;
-            }
+    if (p_bda != NULL) {
+        if ((p_ent = btm_inq_db_find(p_bda)) != NULL) {
+            btm_inq_db_free_ent(p_ent);
         }
+    } else {
+        for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++) {
+            p_ent->in_use = FALSE;
+        }
+        memset(p_inq->inq_db_hash, 0, sizeof(p_inq->inq_db_hash));
+        p_inq->inq_db_lru_head = BTM_INQ_DB_NONE;
+        p_inq->inq_db_lru_tail = BTM_INQ_DB_NONE;
+        p_inq->inq_db_free = BTM_INQ_DB_NONE;
+        p_inq->inq_db_hwm = 0;
     }
 #if (BTM_INQ_DEBUG == TRUE)
     BTM_TRACE_DEBUG ("inq_active:0x%x state:%d\n",
@@ -1467,6 +1566,7 @@ BOOLEAN btm_inq_find_bdaddr (BD_ADDR p_bda)
 {
     tBTM_INQUIRY_VAR_ST *p_inq = &btm_cb.btm_inq_vars;
     tINQ_BDADDR         *p_db = &p_inq->p_bd_db[0];
+    tINQ_DB_ENT         *p_ent;
     UINT16       xx;
 
     /* Don't bother searching, database doesn't exist or periodic mode */
@@ -1474,9 +1574,21 @@ BOOLEAN btm_inq_find_bdaddr (BD_ADDR p_bda)
         return (FALSE);
     }
 
+    /* A device still in the inquiry database carries the inquiry it was last seen in,
+       repeated advertisers are answered from the hash without walking the list */
+    if ((p_ent = btm_inq_db_find(p_bda)) != NULL && p_ent->inq_count == p_inq->inq_counter) {
+        btm_inq_db_touch(p_ent);
+        return (TRUE);
+    }
+
+    /* Evicted devices, and devices whose entry was not marked for this inquiry
+       (e.g. the report was dropped), may already be in the list */
     for (xx = 0; xx < p_inq->num_bd_entries; xx++, p_db++) {
         if (!memcmp(p_db->bd_addr, p_bda, BD_ADDR_LEN)
                 && p_db->inq_count == p_inq->inq_counter) {
+            if (p_ent) {
+                btm_inq_db_touch(p_ent);
+            }
             return (TRUE);
         }
     }
@@ -1503,13 +1615,15 @@ BOOLEAN btm_inq_find_bdaddr (BD_ADDR p_bda)
 *******************************************************************************/
 tINQ_DB_ENT *btm_inq_db_find (BD_ADDR p_bda)
 {
-    UINT16       xx;
-    tINQ_DB_ENT  *p_ent = btm_cb.btm_inq_vars.inq_db;
+    UINT16       idx = btm_cb.btm_inq_vars.inq_db_hash[btm_inq_db_hash(p_bda)];
+    tINQ_DB_ENT  *p_ent;
 
-    for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++) {
-        if ((p_ent->in_use) && (!memcmp (p_ent->inq_info.results.remote_bd_addr, p_bda, BD_ADDR_LEN))) {
+    while (idx != BTM_INQ_DB_NONE) {
+        p_ent = BTM_INQ_DB_ENT(idx);
+        if (!memcmp (p_ent->inq_info.results.remote_bd_addr, p_bda, BD_ADDR_LEN)) {
             return (p_ent);
         }
+        idx = p_ent->hash_next;
     }
 
     /* If here, not found */
@@ -1529,33 +1643,108 @@ tINQ_DB_ENT *btm_inq_db_find (BD_ADDR p_bda)
 *******************************************************************************/
 tINQ_DB_ENT *btm_inq_db_new (BD_ADDR p_bda)
 {
-    UINT16       xx;
-    tINQ_DB_ENT  *p_ent = btm_cb.btm_inq_vars.inq_db;
-    tINQ_DB_ENT  *p_old = btm_cb.btm_inq_vars.inq_db;
-    UINT32       ot = 0xFFFFFFFF;
+    tBTM_INQUIRY_VAR_ST *p_inq = &btm_cb.btm_inq_vars;
+    tINQ_DB_ENT         *p_ent;
+    UINT16              bucket;
+
+    if (p_inq->inq_db_free != BTM_INQ_DB_NONE) {
+        p_ent = BTM_INQ_DB_ENT(p_inq->inq_db_free);
+        p_inq->inq_db_free = p_ent->hash_next;
+    } else if (p_inq->inq_db_hwm < BTM_INQ_DB_SIZE) {
+        p_ent = &p_inq->inq_db[p_inq->inq_db_hwm++];
+    } else {
+        /* If here, no free entry found. Reuse the least recently seen one. */
+        p_ent = BTM_INQ_DB_ENT(p_inq->inq_db_lru_head);
+        btm_inq_db_unlink(p_ent);
+    }
 
-    for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++) {
-        if (!p_ent->in_use) {
-            memset (p_ent, 0, sizeof (tINQ_DB_ENT));
-            memcpy (p_ent->inq_info.results.remote_bd_addr, p_bda, BD_ADDR_LEN);
-            p_ent->in_use = TRUE;
+    memset (p_ent, 0, sizeof (tINQ_DB_ENT));
+    memcpy (p_ent->inq_info.results.remote_bd_addr, p_bda, BD_ADDR_LEN);
+    p_ent->in_use = TRUE;
 
-            return (p_ent);
-        }
+    bucket = btm_inq_db_hash(p_bda);
+    p_ent->hash_next = p_inq->inq_db_hash[bucket];
+    p_inq->inq_db_hash[bucket] = BTM_INQ_DB_IDX(p_ent);
+    btm_inq_db_lru_append(p_ent);
 
-        if (p_ent->time_of_resp < ot) {
-            p_old = p_ent;
-            ot    = p_ent->time_of_resp;
-        }
+    return (p_ent);
+}
+
+/*******************************************************************************
+**
+** Function         btm_inq_db_free_ent
+**
+** Description      This function removes an entry from the inquiry database.
+**
+** Returns          void
+**
+*******************************************************************************/
+void btm_inq_db_free_ent (tINQ_DB_ENT *p_ent)
+{
+    tBTM_INQUIRY_VAR_ST *p_inq = &btm_cb.btm_inq_vars;
+
+    if (!p_ent->in_use) {
+        return;
     }
 
-    /* If here, no free entry found. Return the oldest. */
+    btm_inq_db_unlink(p_ent);
+    p_ent->in_use = FALSE;
+    p_ent->hash_next = p_inq->inq_db_free;
+    p_inq->inq_db_free = BTM_INQ_DB_IDX(p_ent);
+}
 
-    memset (p_old, 0, sizeof (tINQ_DB_ENT));
-    memcpy (p_old->inq_info.results.remote_bd_addr, p_bda, BD_ADDR_LEN);
-    p_old->in_use = TRUE;
+/*******************************************************************************
+**
+** Function         btm_inq_db_touch
+**
+** Description      This function records a response from the device of an
+**                  entry, making it the last one to be reused.
+**
+** Returns          void
+**
+*******************************************************************************/
+void btm_inq_db_touch (tINQ_DB_ENT *p_ent)
+{
+    p_ent->time_of_resp = osi_time_get_os_boottime_ms();
 
-    return (p_old);
+    if (btm_cb.btm_inq_vars.inq_db_lru_tail != BTM_INQ_DB_IDX(p_ent)) {
+        btm_inq_db_lru_unlink(p_ent);
+        btm_inq_db_lru_append(p_ent);
+    }
+}
+
+/*******************************************************************************
+**
+** Function         btm_inq_db_rebuild
+**
+** Description      This function rebuilds the hash, LRU and free lists after
+**                  the entries have been moved around the table.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void btm_inq_db_rebuild (void)
+{
+    tBTM_INQUIRY_VAR_ST *p_inq = &btm_cb.btm_inq_vars;
+    tINQ_DB_ENT         *p_ent = p_inq->inq_db;
+    UINT16              xx, bucket;
+
+    memset(p_inq->inq_db_hash, 0, sizeof(p_inq->inq_db_hash));
+    p_inq->inq_db_lru_head = BTM_INQ_DB_NONE;
+    p_inq->inq_db_lru_tail = BTM_INQ_DB_NONE;
+    p_inq->inq_db_free = BTM_INQ_DB_NONE;
+
+    for (xx = 0; xx < p_inq->inq_db_hwm; xx++, p_ent++) {
+        if (p_ent->in_use) {
+            bucket = btm_inq_db_hash(p_ent->inq_info.results.remote_bd_addr);
+            p_ent->hash_next = p_inq->inq_db_hash[bucket];
+            p_inq->inq_db_hash[bucket] = BTM_INQ_DB_IDX(p_ent);
+            btm_inq_db_lru_append(p_ent);
+        } else {
+            p_ent->hash_next = p_inq->inq_db_free;
+            p_inq->inq_db_free = BTM_INQ_DB_IDX(p_ent);
+        }
+    }
 }
 
 
@@ -1933,7 +2122,7 @@ void btm_process_inq_results (UINT8 *p, UINT8 inq_res_mode)
             p_cur->dev_class[2]       = dc[2];
             p_cur->clock_offset       = clock_offset  | BTM_CLOCK_OFFSET_VALID;
 
-            p_i->time_of_resp = osi_time_get_os_boottime_ms();
+            btm_inq_db_touch(p_i);
 
             if (p_i->inq_count != p_inq->inq_counter) {
                 p_inq->inq_cmpl_info.num_resp++;    /* A new response was found */
@@ -2006,7 +2195,7 @@ void btm_process_inq_results (UINT8 *p, UINT8 inq_res_mode)
 *******************************************************************************/
 void btm_sort_inq_result(void)
 {
-    UINT8               xx, yy, num_resp;
+    UINT16              xx, yy, num_resp;
     tINQ_DB_ENT         *p_tmp  = NULL;
     tINQ_DB_ENT         *p_ent  = btm_cb.btm_inq_vars.inq_db;
     tINQ_DB_ENT         *p_next = btm_cb.btm_inq_vars.inq_db + 1;
@@ -2028,6 +2217,7 @@ void btm_sort_inq_result(void)
         }
 
         osi_free(p_tmp);
+        btm_inq_db_rebuild();
     }
 }
 
@@ -181,6 +181,20 @@ typedef void (tBTM_BLE_RESOLVE_CBACK) (void *match_rec, void *p);
 
 typedef void (tBTM_BLE_ADDR_CBACK) (BD_ADDR_PTR static_random, void *p);
 
+#if (SMP_INCLUDED == TRUE && BTM_BLE_RPA_CACHE_SIZE > 0)
+#define BTM_BLE_RPA_CACHE_NO_MATCH  0xFF
+/* the 3 LSB of a resolvable private address are its hash */
+#define BTM_BLE_RPA_CACHE_IDX(rpa)  (((rpa)[3] ^ (rpa)[4] ^ (rpa)[5]) & (BTM_BLE_RPA_CACHE_SIZE - 1))
+
+/* result of resolving a resolvable private address */
+typedef struct {
+    BD_ADDR                     rpa;
+    UINT8                       rec_index;      /* sec_dev_rec index, BTM_BLE_RPA_CACHE_NO_MATCH if no IRK resolves it */
+    BOOLEAN                     in_use;
+    UINT32                      time_ms;        /* osi_time_get_os_boottime_ms() when resolved */
+} tBTM_BLE_RPA_CACHE_ENT;
+#endif
+
 /* random address management control block */
 typedef struct {
     tBLE_ADDR_TYPE              own_addr_type;         /* local device LE address type */
@@ -193,6 +207,10 @@ typedef struct {
     void                        *p;
     TIMER_LIST_ENT              raddr_timer_ent;
     tBTM_SET_LOCAL_PRIVACY_CBACK *set_local_privacy_cback;
+#if (SMP_INCLUDED == TRUE && BTM_BLE_RPA_CACHE_SIZE > 0)
+    tBTM_BLE_RPA_CACHE_ENT      rpa_cache[BTM_BLE_RPA_CACHE_SIZE];
+    tBTM_BLE_RPA_CACHE_STATS    rpa_cache_stats;
+#endif
 } tBTM_LE_RANDOM_CB;
 
 #define BTM_BLE_MAX_BG_CONN_DEV_NUM    10
@@ -446,6 +464,7 @@ void btm_ble_enqueue_direct_conn_req(void *p_param);
 void btm_gen_resolvable_private_addr (void *p_cmd_cplt_cback);
 void btm_gen_non_resolvable_private_addr (tBTM_BLE_ADDR_CBACK *p_cback, void *p);
 void btm_ble_resolve_random_addr(BD_ADDR random_bda, tBTM_BLE_RESOLVE_CBACK *p_cback, void *p);
+void btm_ble_rpa_cache_clear(void);
 void btm_gen_resolve_paddr_low(tBTM_RAND_ENC *p);
 
 /*  privacy function */
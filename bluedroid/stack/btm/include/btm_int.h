@@ -226,12 +226,20 @@ UINT32          inq_count;          /* "timestamps" the entry with a particular
 /* the same device.                                         */
 tBTM_INQ_INFO   inq_info;
 BOOLEAN         in_use;
+UINT16          hash_next;          /* next entry in the hash bucket (or free list), BTM_INQ_DB_NONE at the end */
+UINT16          lru_prev;           /* entry seen before this one */
+UINT16          lru_next;           /* entry seen after this one */
 
 #if (BLE_INCLUDED == TRUE)
 BOOLEAN         scan_rsp;
+tBTM_BLE_SCAN_STATS scan_stats;
+INT32           rssi_sum_q4;        /* running RSSI average, 1/16 dBm */
 #endif
 } tINQ_DB_ENT;
 
+/* Inquiry database links hold the entry index + 1 so that a zeroed control block is an empty database */
+#define BTM_INQ_DB_NONE             0
+
 
 enum {
 INQ_NONE,
@@ -278,6 +286,11 @@ typedef struct {
     UINT16           num_bd_entries;        /* Number of entries in database */
     UINT16           max_bd_entries;        /* Maximum number of entries that can be stored */
     tINQ_DB_ENT      inq_db[BTM_INQ_DB_SIZE];
+    UINT16           inq_db_hash[BTM_INQ_DB_HASH_SIZE]; /* first entry of each address hash bucket */
+    UINT16           inq_db_lru_head;       /* least recently seen entry, evicted first */
+    UINT16           inq_db_lru_tail;       /* most recently seen entry */
+    UINT16           inq_db_free;           /* released entries, chained by hash_next */
+    UINT16           inq_db_hwm;            /* entries at and above this index were never used */
     tBTM_INQ_PARMS   inqparms;              /* Contains the parameters for the current inquiry */
     tBTM_INQUIRY_CMPL inq_cmpl_info;        /* Status and number of responses from the last inquiry */
 
@@ -948,6 +961,8 @@ void         btm_event_filter_complete (UINT8 *p);
 void         btm_inq_stop_on_ssp(void);
 void         btm_inq_clear_ssp(void);
 tINQ_DB_ENT *btm_inq_db_find (BD_ADDR p_bda);
+void         btm_inq_db_free_ent (tINQ_DB_ENT *p_ent);
+void         btm_inq_db_touch (tINQ_DB_ENT *p_ent);
 BOOLEAN      btm_inq_find_bdaddr (BD_ADDR p_bda);
 
 BOOLEAN btm_lookup_eir(BD_ADDR_PTR p_rem_addr);
@@ -961,6 +976,7 @@ void         btm_acl_created (BD_ADDR bda, DEV_CLASS dc, BD_NAME bdn,
 void         btm_acl_removed (BD_ADDR bda, tBT_TRANSPORT transport);
 void         btm_acl_device_down (void);
 void         btm_acl_update_busy_level (tBTM_BLI_EVENT event);
+void         btm_acl_set_sched_class (UINT16 hci_handle, UINT8 sched_class);
 
 void         btm_cont_rswitch (tACL_CONN *p,
                                tBTM_SEC_DEV_REC *p_dev_rec,
@@ -30,6 +30,7 @@
 #include "stack/btu.h"
 #include "osi/hash_map.h"
 #include "stack/hcimsgs.h"
+#include "hci/hci_layer.h"
 #include "l2c_int.h"
 #include "osi/osi.h"
 #if (defined(SDP_INCLUDED) && SDP_INCLUDED == TRUE)
@@ -117,6 +118,7 @@ typedef void (tUSER_TIMEOUT_FUNC) (TIMER_LIST_ENT *p_tle);
 static void btu_l2cap_alarm_process(TIMER_LIST_ENT *p_tle);
 static void btu_general_alarm_process(TIMER_LIST_ENT *p_tle);
 static void btu_hci_msg_process(BT_HDR *p_msg);
+static void btu_hci_msg_batch_process(hci_msg_batch_t *p_batch);
 
 #if (defined(BTA_INCLUDED) && BTA_INCLUDED == TRUE)
 static void btu_bta_alarm_process(TIMER_LIST_ENT *p_tle);
@@ -190,6 +192,17 @@ static void btu_hci_msg_process(BT_HDR *p_msg)
 
 }
 
+static void btu_hci_msg_batch_process(hci_msg_batch_t *p_batch)
+{
+    uint16_t i;
+
+    for (i = 0; i < p_batch->count; i++) {
+        btu_hci_msg_process(p_batch->packets[i]);
+    }
+
+    osi_free(p_batch);
+}
+
 #if (defined(BTA_INCLUDED) && BTA_INCLUDED == TRUE)
 static void btu_bta_alarm_process(TIMER_LIST_ENT *p_tle)
 {
@@ -229,6 +242,9 @@ void btu_task_thread_handler(void *arg)
             case SIG_BTU_HCI_MSG:
                 btu_hci_msg_process((BT_HDR *)e.par);
                 break;
+            case SIG_BTU_HCI_MSG_BATCH:
+                btu_hci_msg_batch_process((hci_msg_batch_t *)e.par);
+                break;
 #if (defined(BTA_INCLUDED) && BTA_INCLUDED == TRUE)
             case SIG_BTU_BTA_MSG:
                 bta_sys_event((BT_HDR *)e.par);
@@ -248,6 +264,11 @@ void btu_task_thread_handler(void *arg)
             case SIG_BTU_L2CAP_ALARM:
                 btu_l2cap_alarm_process((TIMER_LIST_ENT *)e.par);
                 break;
+#if (SMP_INCLUDED == TRUE)
+            case SIG_BTU_SMP_ECC_CMPL:
+                smp_ecc_job_cmpl((tSMP_ECC_JOB *)e.par);
+                break;
+#endif
             default:
                 break;
             }
@@ -386,6 +407,12 @@ static void btu_general_alarm_process(TIMER_LIST_ENT *p_tle)
         gatt_ind_ack_timeout(p_tle);
         break;
 
+#if (GATTS_NOTIF_BATCH_INCLUDED == TRUE)
+    case BTU_TTYPE_ATT_NOTIF_FLUSH:
+        attp_notif_flush_timeout(p_tle);
+        break;
+#endif
+
 #if (defined(SMP_INCLUDED) && SMP_INCLUDED == TRUE)
     case BTU_TTYPE_SMP_PAIRING_CMD:
         smp_rsp_timeout(p_tle);
@@ -439,7 +466,7 @@ void btu_start_timer(TIMER_LIST_ENT *p_tle, UINT16 type, UINT32 timeout_sec)
     // Get the alarm for the timer list entry.
     osi_mutex_lock(&btu_general_alarm_lock, OSI_MUTEX_MAX_TIMEOUT);
     if (!hash_map_has_key(btu_general_alarm_hash_map, p_tle)) {
-        alarm = osi_alarm_new("btu_gen", btu_general_alarm_cb, (void *)p_tle, 0);
+        alarm = osi_alarm_new_ext("btu_gen", btu_general_alarm_cb, (void *)p_tle, NULL);
         hash_map_set(btu_general_alarm_hash_map, p_tle, alarm);
     }
     osi_mutex_unlock(&btu_general_alarm_lock);
@@ -553,7 +580,7 @@ void btu_start_quick_timer(TIMER_LIST_ENT *p_tle, UINT16 type, UINT32 timeout_ti
     // Get the alarm for the timer list entry.
     osi_mutex_lock(&btu_l2cap_alarm_lock, OSI_MUTEX_MAX_TIMEOUT);
     if (!hash_map_has_key(btu_l2cap_alarm_hash_map, p_tle)) {
-        alarm = osi_alarm_new("btu_l2cap", btu_l2cap_alarm_cb, (void *)p_tle, 0);
+        alarm = osi_alarm_new_ext("btu_l2cap", btu_l2cap_alarm_cb, (void *)p_tle, NULL);
         hash_map_set(btu_l2cap_alarm_hash_map, p_tle, (void *)alarm);
     }
     osi_mutex_unlock(&btu_l2cap_alarm_lock);
@@ -639,7 +666,7 @@ void btu_start_timer_oneshot(TIMER_LIST_ENT *p_tle, UINT16 type, UINT32 timeout_
     // Get the alarm for the timer list entry.
     osi_mutex_lock(&btu_oneshot_alarm_lock, OSI_MUTEX_MAX_TIMEOUT);
     if (!hash_map_has_key(btu_oneshot_alarm_hash_map, p_tle)) {
-        alarm = osi_alarm_new("btu_oneshot", btu_oneshot_alarm_cb, (void *)p_tle, 0);
+        alarm = osi_alarm_new_ext("btu_oneshot", btu_oneshot_alarm_cb, (void *)p_tle, NULL);
         hash_map_set(btu_oneshot_alarm_hash_map, p_tle, alarm);
     }
     osi_mutex_unlock(&btu_oneshot_alarm_lock);
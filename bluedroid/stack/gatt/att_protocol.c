@@ -29,6 +29,8 @@
 
 #include "gatt_int.h"
 #include "stack/l2c_api.h"
+#include "stack/btu.h"
+#include "osi/thread.h"
 
 #define GATT_HDR_FIND_TYPE_VALUE_LEN    21
 #define GATT_OP_CODE_SIZE   1
@@ -465,6 +467,10 @@ tGATT_STATUS attp_send_sr_msg (tGATT_TCB *p_tcb, BT_HDR *p_msg)
 
     if (p_tcb != NULL) {
         if (p_msg != NULL) {
+#if (GATTS_NOTIF_BATCH_INCLUDED == TRUE)
+            /* queued notifications go out ahead of anything sent after them */
+            attp_flush_notif(p_tcb);
+#endif  ///GATTS_NOTIF_BATCH_INCLUDED == TRUE
             p_msg->offset = L2CAP_MIN_OFFSET;
             cmd_sent = attp_send_msg_to_l2cap (p_tcb, p_msg);
         }
@@ -472,6 +478,178 @@ tGATT_STATUS attp_send_sr_msg (tGATT_TCB *p_tcb, BT_HDR *p_msg)
     return cmd_sent;
 }
 
+#if (GATTS_NOTIF_BATCH_INCLUDED == TRUE)
+/* length of a queued notification in a Multiple Handle Value Notification:
+   handle, value length and value, the notification opcode is dropped */
+#define ATTP_MULTI_NOTIF_TUPLE_LEN(p_buf)   ((p_buf)->len - GATT_OP_CODE_SIZE + 2)
+
+/*******************************************************************************
+**
+** Function         attp_queue_notif
+**
+** Description      Queue a handle value notification PDU on the connection.
+**                  The queue is sent once the BTU task has handled the
+**                  messages already waiting for it, or when it holds
+**                  GATTS_NOTIF_BATCH_MAX notifications.
+**
+** Parameter        p_tcb: pointer to the connecton control block.
+**                  p_msg: notification PDU built by attp_build_sr_msg.
+**
+** Returns          GATT_SUCCESS if queued or sent; otherwise error code.
+**
+*******************************************************************************/
+tGATT_STATUS attp_queue_notif (tGATT_TCB *p_tcb, BT_HDR *p_msg)
+{
+    if (p_tcb->notif_q == NULL) {
+        p_tcb->notif_q = fixed_queue_new(QUEUE_SIZE_MAX);
+        if (p_tcb->notif_q == NULL) {
+            return attp_send_sr_msg(p_tcb, p_msg);
+        }
+    }
+
+    p_msg->offset = L2CAP_MIN_OFFSET;
+    fixed_queue_enqueue(p_tcb->notif_q, p_msg);
+
+    if (fixed_queue_length(p_tcb->notif_q) >= GATTS_NOTIF_BATCH_MAX) {
+        return attp_flush_notif(p_tcb);
+    }
+
+    if (!p_tcb->notif_flush_ent.in_use) {
+        p_tcb->notif_flush_ent.event = BTU_TTYPE_ATT_NOTIF_FLUSH;
+        p_tcb->notif_flush_ent.param = (TIMER_PARAM_TYPE)p_tcb;
+        p_tcb->notif_flush_ent.in_use = TRUE;
+        if (btu_task_post(SIG_BTU_GENERAL_ALARM, &p_tcb->notif_flush_ent,
+                          TASK_POST_NON_BLOCKING) != TASK_POST_SUCCESS) {
+            p_tcb->notif_flush_ent.in_use = FALSE;
+            return attp_flush_notif(p_tcb);
+        }
+    }
+    return GATT_SUCCESS;
+}
+
+/*******************************************************************************
+**
+** Function         attp_build_multi_notif
+**
+** Description      Move queued notifications, starting with p_first, into one
+**                  Multiple Handle Value Notification PDU.
+**
+** Returns          The PDU, or NULL if less than two notifications fit into
+**                  the MTU or no buffer is available.
+**
+*******************************************************************************/
+static BT_HDR *attp_build_multi_notif (tGATT_TCB *p_tcb, BT_HDR *p_first)
+{
+    BT_HDR  *p_buf = p_first;
+    BT_HDR  *p_next = fixed_queue_try_peek_first(p_tcb->notif_q);
+    BT_HDR  *p_multi;
+    UINT8   *p, *p_src;
+    UINT16  handle, val_len;
+
+    if (p_next == NULL ||
+            GATT_OP_CODE_SIZE + ATTP_MULTI_NOTIF_TUPLE_LEN(p_first) +
+            ATTP_MULTI_NOTIF_TUPLE_LEN(p_next) > p_tcb->payload_size) {
+        return NULL;
+    }
+
+    if ((p_multi = (BT_HDR *)osi_malloc(sizeof(BT_HDR) + L2CAP_MIN_OFFSET + p_tcb->payload_size)) == NULL) {
+        return NULL;
+    }
+
+    p_multi->offset = L2CAP_MIN_OFFSET;
+    p_multi->len = GATT_OP_CODE_SIZE;
+    p = (UINT8 *)(p_multi + 1) + L2CAP_MIN_OFFSET;
+    UINT8_TO_STREAM (p, GATT_HANDLE_MULTI_VALUE_NOTIF);
+
+    while (p_buf != NULL) {
+        /* opcode, handle, value */
+        p_src = (UINT8 *)(p_buf + 1) + p_buf->offset + GATT_OP_CODE_SIZE;
+        val_len = p_buf->len - GATT_OP_CODE_SIZE - 2;
+        STREAM_TO_UINT16 (handle, p_src);
+        UINT16_TO_STREAM (p, handle);
+        UINT16_TO_STREAM (p, val_len);
+        ARRAY_TO_STREAM (p, p_src, val_len);
+        p_multi->len += ATTP_MULTI_NOTIF_TUPLE_LEN(p_buf);
+        osi_free(p_buf);
+
+        p_buf = fixed_queue_try_peek_first(p_tcb->notif_q);
+        if (p_buf == NULL || p_multi->len + ATTP_MULTI_NOTIF_TUPLE_LEN(p_buf) > p_tcb->payload_size) {
+            break;
+        }
+        p_buf = fixed_queue_try_dequeue(p_tcb->notif_q);
+    }
+
+    return p_multi;
+}
+
+/*******************************************************************************
+**
+** Function         attp_flush_notif
+**
+** Description      Send the notifications queued on the connection. If the
+**                  client enabled Multiple Handle Value Notifications they
+**                  are packed into as few PDUs as the MTU allows, otherwise
+**                  they are handed to L2CAP back to back so the controller
+**                  can send them in the same connection events.
+**
+** Parameter        p_tcb: pointer to the connecton control block.
+**
+** Returns          GATT_SUCCESS if sucessfully sent; otherwise error code.
+**
+*******************************************************************************/
+tGATT_STATUS attp_flush_notif (tGATT_TCB *p_tcb)
+{
+    tGATT_STATUS    status = GATT_SUCCESS;
+    tGATT_STATUS    ret;
+    BT_HDR          *p_buf;
+    BT_HDR          *p_multi;
+
+    if (p_tcb->notif_q == NULL) {
+        return GATT_SUCCESS;
+    }
+
+    while ((p_buf = fixed_queue_try_dequeue(p_tcb->notif_q)) != NULL) {
+        if (status == GATT_INTERNAL_ERROR) {
+            /* L2CAP refused the link, drop the rest */
+            osi_free(p_buf);
+            continue;
+        }
+
+        if ((p_tcb->cl_supp_feat & GATT_CL_SUPP_FEAT_MULTI_NOTIF) &&
+                (p_multi = attp_build_multi_notif(p_tcb, p_buf)) != NULL) {
+            p_buf = p_multi;
+        }
+
+        ret = attp_send_msg_to_l2cap(p_tcb, p_buf);
+        if (ret != GATT_SUCCESS) {
+            status = ret;
+        }
+    }
+    return status;
+}
+
+/*******************************************************************************
+**
+** Function         attp_notif_flush_timeout
+**
+** Description      BTU handler of the flush posted by attp_queue_notif.
+**
+** Returns          void
+**
+*******************************************************************************/
+void attp_notif_flush_timeout (TIMER_LIST_ENT *p_tle)
+{
+    tGATT_TCB *p_tcb = (tGATT_TCB *)p_tle->param;
+
+    /* the link may have gone down since the flush was posted */
+    if (!p_tle->in_use || p_tcb == NULL || !p_tcb->in_use) {
+        return;
+    }
+    p_tle->in_use = FALSE;
+    attp_flush_notif(p_tcb);
+}
+#endif  ///GATTS_NOTIF_BATCH_INCLUDED == TRUE
+
 /*******************************************************************************
 **
 ** Function         attp_cl_send_cmd
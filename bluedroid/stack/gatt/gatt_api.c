@@ -654,7 +654,11 @@ tGATT_STATUS GATTS_HandleValueNotification (UINT16 conn_id, UINT16 attr_handle,
 
         if ((p_buf = attp_build_sr_msg (p_tcb, GATT_HANDLE_VALUE_NOTIF, (tGATT_SR_MSG *)&notif))
                 != NULL) {
+#if (GATTS_NOTIF_BATCH_INCLUDED == TRUE)
+            cmd_sent = attp_queue_notif (p_tcb, p_buf);
+#else
             cmd_sent = attp_send_sr_msg (p_tcb, p_buf);
+#endif
         } else {
             cmd_sent = GATT_NO_RESOURCES;
         }
@@ -662,6 +666,188 @@ tGATT_STATUS GATTS_HandleValueNotification (UINT16 conn_id, UINT16 attr_handle,
     return cmd_sent;
 }
 
+/*******************************************************************************
+**
+** Function         GATTS_AllocHandleValueBuf
+**
+** Description      This function allocates a handle value notification or
+**                  indication PDU that already has room for the L2CAP/HCI
+**                  headers and the ATT opcode and handle. The caller writes
+**                  the value in place at GATTS_HANDLE_VALUE_BUF_DATA(p_buf)
+**                  and hands the buffer to GATTS_SendHandleValueBuf, so the
+**                  value is never copied again on its way to L2CAP.
+**
+** Parameter        mtu: ATT MTU of the connection as last reported to the
+**                       caller, e.g. cached by BTC from the MTU events. The
+**                       TCB is owned by the BTU task and is not read here;
+**                       GATTS_SendHandleValueBuf truncates to the current MTU.
+**                  val_len: Length of the attribute value. It is truncated
+**                           to (mtu - 3).
+**
+** Returns          pointer to the buffer, NULL if the MTU is invalid or no
+**                  buffer is available.
+**
+*******************************************************************************/
+BT_HDR *GATTS_AllocHandleValueBuf (UINT16 mtu, UINT16 val_len)
+{
+    BT_HDR          *p_buf;
+
+    if (mtu <= GATT_HDR_SIZE) {
+        GATT_TRACE_ERROR ("GATTS_AllocHandleValueBuf invalid mtu: %u \n", mtu);
+        return NULL;
+    }
+
+    if (val_len > mtu - GATT_HDR_SIZE) {
+        val_len = mtu - GATT_HDR_SIZE;
+    }
+
+    if ((p_buf = (BT_HDR *)osi_malloc((UINT16)(sizeof(BT_HDR) + L2CAP_MIN_OFFSET + GATT_HDR_SIZE + val_len))) != NULL) {
+        p_buf->event = 0;
+        p_buf->layer_specific = 0;
+        p_buf->offset = L2CAP_MIN_OFFSET;
+        p_buf->len = GATT_HDR_SIZE + val_len;
+    }
+    return p_buf;
+}
+
+/*******************************************************************************
+**
+** Function         GATTS_SendHandleValueBuf
+**
+** Description      This function sends a buffer obtained from
+**                  GATTS_AllocHandleValueBuf as a handle value notification
+**                  or indication. The ATT header is written in front of the
+**                  value in place and the buffer is passed to L2CAP as is.
+**
+** Parameter        conn_id: connection identifier.
+**                  attr_handle: Attribute handle of this handle value indication.
+**                  p_buf: buffer from GATTS_AllocHandleValueBuf. p_buf->len
+**                         may be reduced by the caller to send a shorter value.
+**                  need_confirm: TRUE to send an indication, FALSE to send a
+**                                notification.
+**
+** Returns          GATT_SUCCESS if sucessfully sent; otherwise error code.
+**                  p_buf is always consumed.
+**
+*******************************************************************************/
+tGATT_STATUS GATTS_SendHandleValueBuf (UINT16 conn_id, UINT16 attr_handle,
+                                       BT_HDR *p_buf, BOOLEAN need_confirm)
+{
+    tGATT_STATUS    cmd_sent;
+    tGATT_IF         gatt_if = GATT_GET_GATT_IF(conn_id);
+    UINT8           tcb_idx = GATT_GET_TCB_IDX(conn_id);
+    tGATT_REG       *p_reg = gatt_get_regcb(gatt_if);
+    tGATT_TCB       *p_tcb = gatt_get_tcb_by_idx(tcb_idx);
+    UINT8           *p;
+
+    GATT_TRACE_API ("GATTS_SendHandleValueBuf");
+
+    if (p_buf == NULL) {
+        return GATT_ILLEGAL_PARAMETER;
+    }
+
+    if ( (p_reg == NULL) || (p_tcb == NULL)) {
+        GATT_TRACE_ERROR ("GATTS_SendHandleValueBuf Unknown  conn_id: %u \n", conn_id);
+        cmd_sent = (tGATT_STATUS) GATT_INVALID_CONN_ID;
+    } else if (!GATT_HANDLE_IS_VALID (attr_handle) || p_buf->offset != L2CAP_MIN_OFFSET ||
+               p_buf->len < GATT_HDR_SIZE) {
+        cmd_sent = GATT_ILLEGAL_PARAMETER;
+    } else if (need_confirm && GATT_HANDLE_IS_VALID(p_tcb->indicate_handle)) {
+        cmd_sent = GATT_BUSY;
+    } else {
+        cmd_sent = GATT_SUCCESS;
+    }
+
+    if (cmd_sent != GATT_SUCCESS) {
+        osi_free(p_buf);
+        return cmd_sent;
+    }
+
+    /* ensure data not exceed MTU size */
+    if (p_buf->len > p_tcb->payload_size) {
+        GATT_TRACE_WARNING("attribute value too long, to be truncated to %d", p_tcb->payload_size - GATT_HDR_SIZE);
+        p_buf->len = p_tcb->payload_size;
+    }
+
+    p = (UINT8 *)(p_buf + 1) + p_buf->offset;
+    UINT8_TO_STREAM (p, need_confirm ? GATT_HANDLE_VALUE_IND : GATT_HANDLE_VALUE_NOTIF);
+    UINT16_TO_STREAM (p, attr_handle);
+
+    cmd_sent = attp_send_sr_msg (p_tcb, p_buf);
+
+    if (need_confirm && (cmd_sent == GATT_SUCCESS || cmd_sent == GATT_CONGESTED)) {
+        p_tcb->indicate_handle = attr_handle;
+        gatt_start_conf_timer(p_tcb);
+    }
+    return cmd_sent;
+}
+
+#if (GATTS_SR_STATS_INCLUDED == TRUE)
+/*******************************************************************************
+**
+** Function         GATTS_GetSrStats
+**
+** Description      This function reads the server request statistics of the
+**                  link used by a connection: how many requests were answered
+**                  by the stack or by the application, and histograms of the
+**                  request latency and of the time spent waiting for the
+**                  application.
+**
+** Parameter        conn_id: connection identifier.
+**                  p_stats: statistics copied out.
+**
+** Returns          GATT_SUCCESS if the statistics are read; otherwise error code.
+**
+*******************************************************************************/
+tGATT_STATUS GATTS_GetSrStats (UINT16 conn_id, tGATTS_SR_STATS *p_stats)
+{
+    UINT8           tcb_idx = GATT_GET_TCB_IDX(conn_id);
+    tGATT_TCB       *p_tcb = gatt_get_tcb_by_idx(tcb_idx);
+
+    if (p_stats == NULL) {
+        return GATT_ILLEGAL_PARAMETER;
+    }
+
+    if (p_tcb == NULL) {
+        GATT_TRACE_ERROR ("GATTS_GetSrStats Unknown  conn_id: %u \n", conn_id);
+        return (tGATT_STATUS) GATT_INVALID_CONN_ID;
+    }
+
+    memcpy(p_stats, &p_tcb->sr_stats, sizeof(tGATTS_SR_STATS));
+    return GATT_SUCCESS;
+}
+#endif  ///GATTS_SR_STATS_INCLUDED == TRUE
+
+#if (GATTS_NOTIF_BATCH_INCLUDED == TRUE)
+/*******************************************************************************
+**
+** Function         GATTS_FlushHandleValueNotifications
+**
+** Description      This function sends the notifications queued on a
+**                  connection by GATTS_HandleValueNotification without
+**                  waiting for the BTU task to become idle.
+**
+** Parameter        conn_id: connection identifier.
+**
+** Returns          GATT_SUCCESS if sucessfully sent; otherwise error code.
+**
+*******************************************************************************/
+tGATT_STATUS GATTS_FlushHandleValueNotifications (UINT16 conn_id)
+{
+    UINT8           tcb_idx = GATT_GET_TCB_IDX(conn_id);
+    tGATT_TCB       *p_tcb = gatt_get_tcb_by_idx(tcb_idx);
+
+    GATT_TRACE_API ("GATTS_FlushHandleValueNotifications");
+
+    if (p_tcb == NULL) {
+        GATT_TRACE_ERROR ("GATTS_FlushHandleValueNotifications Unknown  conn_id: %u \n", conn_id);
+        return (tGATT_STATUS) GATT_INVALID_CONN_ID;
+    }
+
+    return attp_flush_notif(p_tcb);
+}
+#endif  ///GATTS_NOTIF_BATCH_INCLUDED == TRUE
+
 /*******************************************************************************
 **
 ** Function         GATTS_SendRsp
@@ -171,6 +171,44 @@ void gatt_profile_clcb_dealloc (tGATT_PROFILE_CLCB *p_clcb)
     memset(p_clcb, 0, sizeof(tGATT_PROFILE_CLCB));
 }
 
+#if (GATTS_NOTIF_BATCH_INCLUDED == TRUE)
+/*******************************************************************************
+**
+** Function         gatt_cl_supp_feat_write
+**
+** Description      Handle a write of the Client Supported Features value. A
+**                  client may enable features but not disable them again.
+**
+** Returns          status of the write.
+**
+*******************************************************************************/
+static UINT8 gatt_cl_supp_feat_write (UINT16 conn_id, tGATT_WRITE_REQ *p_write)
+{
+    tGATT_TCB   *p_tcb = gatt_get_tcb_by_idx(GATT_GET_TCB_IDX(conn_id));
+    UINT8       feat;
+
+    if (p_tcb == NULL) {
+        return GATT_INTERNAL_ERROR;
+    }
+    if (p_write->is_prep || p_write->offset != 0) {
+        return GATT_REQ_NOT_SUPPORTED;
+    }
+    if (p_write->len < 1) {
+        return GATT_INVALID_ATTR_LEN;
+    }
+
+    /* only the bits the server supports are kept */
+    feat = p_write->value[0] & GATT_CL_SUPP_FEAT_MULTI_NOTIF;
+    if (p_tcb->cl_supp_feat & ~feat) {
+        return GATT_VALUE_NOT_ALLOWED;
+    }
+
+    p_tcb->cl_supp_feat = feat;
+    GATT_TRACE_DEBUG("client supported features 0x%02x", feat);
+    return GATT_SUCCESS;
+}
+#endif  ///GATTS_NOTIF_BATCH_INCLUDED == TRUE
+
 /*******************************************************************************
 **
 ** Function         gatt_request_cback
@@ -191,10 +229,35 @@ static void gatt_request_cback (UINT16 conn_id, UINT32 trans_id, tGATTS_REQ_TYPE
 
     switch (type) {
     case GATTS_REQ_TYPE_READ:
+#if (GATTS_NOTIF_BATCH_INCLUDED == TRUE)
+        if (p_data->read_req.handle == gatt_cb.handle_of_cl_supp_feat) {
+            tGATT_TCB *p_tcb = gatt_get_tcb_by_idx(GATT_GET_TCB_IDX(conn_id));
+
+            if (p_tcb == NULL) {
+                status = GATT_INTERNAL_ERROR;
+            } else if (p_data->read_req.offset > 1) {
+                status = GATT_INVALID_OFFSET;
+            } else {
+                rsp_msg.attr_value.handle = p_data->read_req.handle;
+                rsp_msg.attr_value.len = 1 - p_data->read_req.offset;
+                rsp_msg.attr_value.value[0] = p_tcb->cl_supp_feat;
+                status = GATT_SUCCESS;
+            }
+            break;
+        }
+#endif  ///GATTS_NOTIF_BATCH_INCLUDED == TRUE
         status = GATT_READ_NOT_PERMIT;
         break;
 
     case GATTS_REQ_TYPE_WRITE:
+#if (GATTS_NOTIF_BATCH_INCLUDED == TRUE)
+        if (p_data->write_req.handle == gatt_cb.handle_of_cl_supp_feat) {
+            rsp_msg.handle = p_data->write_req.handle;
+            status = gatt_cl_supp_feat_write(conn_id, &p_data->write_req);
+            ignore = !p_data->write_req.need_rsp;
+            break;
+        }
+#endif  ///GATTS_NOTIF_BATCH_INCLUDED == TRUE
         status = GATT_WRITE_NOT_PERMIT;
         break;
 
@@ -306,6 +369,16 @@ void gatt_profile_db_init (void)
     GATT_TRACE_DEBUG ("gatt_profile_db_init:  handle of service changed%d\n",
                       gatt_cb.handle_of_h_r);
 
+#if (GATTS_NOTIF_BATCH_INCLUDED == TRUE)
+    /* add Client Supported Features characteristic, the value is kept per client
+    */
+    uuid.uu.uuid16 = GATT_UUID_CLIENT_SUP_FEAT;
+    gatt_cb.handle_of_cl_supp_feat = GATTS_AddCharacteristic(service_handle, &uuid,
+                                     GATT_PERM_READ | GATT_PERM_WRITE,
+                                     GATT_CHAR_PROP_BIT_READ | GATT_CHAR_PROP_BIT_WRITE,
+                                     NULL, NULL);
+#endif  ///GATTS_NOTIF_BATCH_INCLUDED == TRUE
+
     /* start service
     */
     status = GATTS_StartService (gatt_cb.gatt_if, service_handle, GATTP_TRANSPORT_SUPPORTED );
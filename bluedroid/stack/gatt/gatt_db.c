@@ -38,7 +38,8 @@
 /********************************************************************************
 **              L O C A L    F U N C T I O N     P R O T O T Y P E S            *
 *********************************************************************************/
-static BOOLEAN allocate_svc_db_buf(tGATT_SVC_DB *p_db);
+static BOOLEAN allocate_svc_db_buf(tGATT_SVC_DB *p_db, UINT32 size);
+static BOOLEAN allocate_attr_tab_in_db(tGATT_SVC_DB *p_db, UINT16 num_handle);
 static void *allocate_attr_in_db(tGATT_SVC_DB *p_db, tBT_UUID *p_uuid, tGATT_PERM perm);
 static BOOLEAN deallocate_attr_in_db(tGATT_SVC_DB *p_db, void *p_attr);
 static BOOLEAN copy_extra_byte_in_db(tGATT_SVC_DB *p_db, void **p_dst, UINT16 len);
@@ -67,7 +68,10 @@ BOOLEAN gatts_init_service_db (tGATT_SVC_DB *p_db, tBT_UUID *p_service,  BOOLEAN
         p_db->svc_buffer = fixed_queue_new(QUEUE_SIZE_MAX);
     }
 
-    if (!allocate_svc_db_buf(p_db)) {
+    /* size the first buffer for the whole service so the attribute records
+       are contiguous, later values and 128 bit UUIDs spill into GATT_DB_BUF_SIZE buffers */
+    if (!allocate_svc_db_buf(p_db, num_handle * sizeof(tGATT_ATTR16)) ||
+        !allocate_attr_tab_in_db(p_db, num_handle)) {
         GATT_TRACE_ERROR("gatts_init_service_db failed, no resources\n");
         return FALSE;
     }
@@ -76,6 +80,8 @@ BOOLEAN gatts_init_service_db (tGATT_SVC_DB *p_db, tBT_UUID *p_service,  BOOLEAN
     GATT_TRACE_DEBUG("s_hdl = %d num_handle = %d\n", s_hdl, num_handle );
 
     /* update service database information */
+    p_db->p_attr_list   = NULL;
+    p_db->start_handle  = s_hdl;
     p_db->next_handle   = s_hdl;
     p_db->end_handle    = s_hdl + num_handle;
 
@@ -105,6 +111,29 @@ tBT_UUID *gatts_get_service_uuid (tGATT_SVC_DB *p_db)
     }
 }
 
+/*******************************************************************************
+**
+** Function         gatts_find_attr_by_handle
+**
+** Description      Look up an attribute of the service database by handle.
+**
+** Parameter        p_db: database pointer.
+**                  handle: attribute handle.
+**
+** Returns          pointer to the attribute, either tGATT_ATTR16, tGATT_ATTR32
+**                  or tGATT_ATTR128, NULL if not found.
+**
+*******************************************************************************/
+void *gatts_find_attr_by_handle (tGATT_SVC_DB *p_db, UINT16 handle)
+{
+    if (p_db == NULL || p_db->p_attr_tab == NULL ||
+        handle < p_db->start_handle || handle >= p_db->next_handle) {
+        return NULL;
+    }
+
+    return p_db->p_attr_tab[handle - p_db->start_handle];
+}
+
 /*******************************************************************************
 **
 ** Function         gatts_check_attr_readability
@@ -372,6 +401,11 @@ tGATT_STATUS gatts_db_read_attr_value_by_type (tGATT_TCB   *p_tcb,
                     /* one callback at a time */
                     break;
                 } else if (status == GATT_SUCCESS || status == GATT_STACK_RSP) {
+#if (GATTS_SR_FAST_PATH == TRUE)
+                    /* stack managed value, answered here without the application */
+                    status = GATT_SUCCESS;
+                    UNUSED(have_send_request);
+#else
                     if (status == GATT_STACK_RSP){
                         need_rsp = FALSE;
                         status = gatts_send_app_read_request(p_tcb, op_code, p_attr->handle, 0, trans_id, need_rsp);
@@ -383,6 +417,7 @@ tGATT_STATUS gatts_db_read_attr_value_by_type (tGATT_TCB   *p_tcb,
                             trans_id = p_tcb->sr_cmd.trans_id;
                         }
                     }
+#endif
 
                     if (p_rsp->offset == 0) {
                         p_rsp->offset = len + 2;
@@ -705,36 +740,32 @@ tGATT_STATUS gatts_set_attribute_value(tGATT_SVC_DB *p_db, UINT16 attr_handle,
         return GATT_INVALID_PDU;
     }
 
-    p_cur    =  (tGATT_ATTR16 *) p_db->p_attr_list;
+    p_cur    =  (tGATT_ATTR16 *) gatts_find_attr_by_handle(p_db, attr_handle);
 
-    while (p_cur != NULL) {
-        if (p_cur->handle == attr_handle) {
-            /* for characteristic should not be set, return GATT_NOT_FOUND */
-            if (p_cur->uuid_type == GATT_ATTR_UUID_TYPE_16) {
-                switch (p_cur->uuid) {
-                    case GATT_UUID_PRI_SERVICE:
-                    case GATT_UUID_SEC_SERVICE:
-                    case GATT_UUID_CHAR_DECLARE:
-                        return GATT_NOT_FOUND;
-                        break;
-                }
+    if (p_cur != NULL) {
+        /* for characteristic should not be set, return GATT_NOT_FOUND */
+        if (p_cur->uuid_type == GATT_ATTR_UUID_TYPE_16) {
+            switch (p_cur->uuid) {
+                case GATT_UUID_PRI_SERVICE:
+                case GATT_UUID_SEC_SERVICE:
+                case GATT_UUID_CHAR_DECLARE:
+                    return GATT_NOT_FOUND;
+                    break;
             }
+        }
 
-            /* in other cases, value can be set*/
-            if ((p_cur->p_value == NULL) || (p_cur->p_value->attr_val.attr_val == NULL) \
-                    || (p_cur->p_value->attr_val.attr_max_len == 0)){
-                GATT_TRACE_ERROR("Error in %s, line=%d, attribute value should not be NULL here\n", __func__, __LINE__);
-                return GATT_NOT_FOUND;
-            } else if (p_cur->p_value->attr_val.attr_max_len < length) {
-                GATT_TRACE_ERROR("gatts_set_attribute_value failed:Invalid value length");
-                return GATT_INVALID_ATTR_LEN;
-            } else{
-                memcpy(p_cur->p_value->attr_val.attr_val, value, length);
-                p_cur->p_value->attr_val.attr_len = length;
-            }
-            break;
+        /* in other cases, value can be set*/
+        if ((p_cur->p_value == NULL) || (p_cur->p_value->attr_val.attr_val == NULL) \
+                || (p_cur->p_value->attr_val.attr_max_len == 0)){
+            GATT_TRACE_ERROR("Error in %s, line=%d, attribute value should not be NULL here\n", __func__, __LINE__);
+            return GATT_NOT_FOUND;
+        } else if (p_cur->p_value->attr_val.attr_max_len < length) {
+            GATT_TRACE_ERROR("gatts_set_attribute_value failed:Invalid value length");
+            return GATT_INVALID_ATTR_LEN;
+        } else{
+            memcpy(p_cur->p_value->attr_val.attr_val, value, length);
+            p_cur->p_value->attr_val.attr_len = length;
         }
-        p_cur = p_cur->p_next;
     }
 
     return GATT_SUCCESS;
@@ -778,29 +809,16 @@ tGATT_STATUS gatts_get_attribute_value(tGATT_SVC_DB *p_db, UINT16 attr_handle,
         return GATT_INVALID_PDU;
     }
 
-    p_cur    =  (tGATT_ATTR16 *) p_db->p_attr_list;
+    p_cur    =  (tGATT_ATTR16 *) gatts_find_attr_by_handle(p_db, attr_handle);
 
-    while (p_cur != NULL) {
-        if (p_cur->handle == attr_handle) {
-
-            if (p_cur->uuid_type == GATT_ATTR_UUID_TYPE_16) {
-                switch (p_cur->uuid) {
-                case GATT_UUID_CHAR_DECLARE:
-                case GATT_UUID_INCLUDE_SERVICE:
-                    break;
-                default:
-                    if (p_cur->p_value &&  p_cur->p_value->attr_val.attr_len != 0) {
-                        *length = p_cur->p_value->attr_val.attr_len;
-                        *value = p_cur->p_value->attr_val.attr_val;
-                        return GATT_SUCCESS;
-                    } else {
-                        GATT_TRACE_ERROR("gatts_get_attribute_value failed:the value length is 0");
-                        return GATT_INVALID_ATTR_LEN;
-                    }
-                    break;
-                }
-            } else {
-                if (p_cur->p_value->attr_val.attr_len != 0) {
+    if (p_cur != NULL) {
+        if (p_cur->uuid_type == GATT_ATTR_UUID_TYPE_16) {
+            switch (p_cur->uuid) {
+            case GATT_UUID_CHAR_DECLARE:
+            case GATT_UUID_INCLUDE_SERVICE:
+                break;
+            default:
+                if (p_cur->p_value &&  p_cur->p_value->attr_val.attr_len != 0) {
                     *length = p_cur->p_value->attr_val.attr_len;
                     *value = p_cur->p_value->attr_val.attr_val;
                     return GATT_SUCCESS;
@@ -808,14 +826,19 @@ tGATT_STATUS gatts_get_attribute_value(tGATT_SVC_DB *p_db, UINT16 attr_handle,
                     GATT_TRACE_ERROR("gatts_get_attribute_value failed:the value length is 0");
                     return GATT_INVALID_ATTR_LEN;
                 }
-
+                break;
+            }
+        } else {
+            if (p_cur->p_value->attr_val.attr_len != 0) {
+                *length = p_cur->p_value->attr_val.attr_len;
+                *value = p_cur->p_value->attr_val.attr_val;
+                return GATT_SUCCESS;
+            } else {
+                GATT_TRACE_ERROR("gatts_get_attribute_value failed:the value length is 0");
+                return GATT_INVALID_ATTR_LEN;
             }
-
-            break;
 
         }
-
-        p_cur = p_cur->p_next;
     }
 
     return GATT_NOT_FOUND;
@@ -833,30 +856,17 @@ BOOLEAN gatts_is_auto_response(UINT16 attr_handle)
 
     p_db = &p_decl->svc_db;
 
-    tGATT_ATTR16  *p_cur, *p_next;
+    tGATT_ATTR16  *p_cur;
 
-    if (p_db == NULL) {
-        GATT_TRACE_DEBUG("gatts_get_attribute_value Fail:p_db is NULL.\n");
-        return rsp;
-    }
     if (p_db->p_attr_list == NULL) {
         GATT_TRACE_DEBUG("gatts_get_attribute_value Fail:p_db->p_attr_list is NULL.\n");
         return rsp;
     }
 
-    p_cur    =  (tGATT_ATTR16 *) p_db->p_attr_list;
-    p_next  = (tGATT_ATTR16 *) p_cur->p_next;
-
-    for (; p_cur != NULL && p_next != NULL;
-            p_cur = p_next, p_next = (tGATT_ATTR16 *)p_next->p_next) {
-        if (p_cur->handle == attr_handle) {
-            if (p_cur->p_value != NULL && p_cur->control.auto_rsp == GATT_RSP_BY_STACK) {
-                rsp = true;
-                return rsp;
-            }
-
-        }
+    p_cur    =  (tGATT_ATTR16 *) gatts_find_attr_by_handle(p_db, attr_handle);
 
+    if (p_cur != NULL && p_cur->p_value != NULL && p_cur->control.auto_rsp == GATT_RSP_BY_STACK) {
+        rsp = true;
     }
 
     return rsp;
@@ -899,22 +909,20 @@ tGATT_STATUS gatts_read_attr_value_by_handle(tGATT_TCB *p_tcb,
     tGATT_ATTR16  *p_attr;
     UINT8       *pp = p_value;
 
-    if (p_db && p_db->p_attr_list) {
-        p_attr = (tGATT_ATTR16 *)p_db->p_attr_list;
-
-        while (p_attr && handle >= p_attr->handle) {
-            if (p_attr->handle == handle) {
-                status = read_attr_value (p_attr, offset, &pp,
-                                          (BOOLEAN)(op_code == GATT_REQ_READ_BLOB),
-                                          mtu, p_len, sec_flag, key_size);
-
-                if ((status == GATT_PENDING) || (status == GATT_STACK_RSP)) {
-                    BOOLEAN need_rsp = (status != GATT_STACK_RSP);
-                    status = gatts_send_app_read_request(p_tcb, op_code, p_attr->handle, offset, trans_id, need_rsp);
-                }
-                break;
-            }
-            p_attr = (tGATT_ATTR16 *)p_attr->p_next;
+    if ((p_attr = (tGATT_ATTR16 *)gatts_find_attr_by_handle(p_db, handle)) != NULL) {
+        status = read_attr_value (p_attr, offset, &pp,
+                                  (BOOLEAN)(op_code == GATT_REQ_READ_BLOB),
+                                  mtu, p_len, sec_flag, key_size);
+
+#if (GATTS_SR_FAST_PATH == TRUE)
+        /* a stack managed value is already in the response, only
+           application managed values need the read request callback */
+        if (status == GATT_PENDING) {
+#else
+        if ((status == GATT_PENDING) || (status == GATT_STACK_RSP)) {
+#endif
+            BOOLEAN need_rsp = (status != GATT_STACK_RSP);
+            status = gatts_send_app_read_request(p_tcb, op_code, p_attr->handle, offset, trans_id, need_rsp);
         }
     }
 
@@ -929,33 +937,24 @@ tGATT_STATUS gatts_write_attr_value_by_handle(tGATT_SVC_DB *p_db,
     tGATT_STATUS status = GATT_NOT_FOUND;
     tGATT_ATTR16  *p_attr;
 
-    if (p_db && p_db->p_attr_list) {
-        p_attr = (tGATT_ATTR16 *)p_db->p_attr_list;
-
-        while (p_attr && handle >= p_attr->handle) {
-            if (p_attr->handle == handle ) {
-                if (p_attr->control.auto_rsp == GATT_RSP_BY_APP) {
-                    return GATT_APP_RSP;
-                }
-
-                if ((p_attr->p_value != NULL) && 
-                    (p_attr->p_value->attr_val.attr_max_len >= offset + len) && 
-                    p_attr->p_value->attr_val.attr_val != NULL) {
-                    memcpy(p_attr->p_value->attr_val.attr_val + offset, p_value, len);
-                    p_attr->p_value->attr_val.attr_len = len + offset;
-                    return GATT_SUCCESS;
-                } else if (p_attr->p_value->attr_val.attr_max_len < offset + len){
-                    GATT_TRACE_DEBUG("Remote device try to write with a length larger then attribute's max length\n");
-                    return GATT_INVALID_ATTR_LEN;               
-                } else if ((p_attr->p_value == NULL) || (p_attr->p_value->attr_val.attr_val == NULL)){
-                    GATT_TRACE_ERROR("Error in %s, line=%d, %s should not be NULL here\n", __func__, __LINE__, \
-                                    (p_attr->p_value == NULL) ? "p_value" : "attr_val.attr_val");
-                    return GATT_UNKNOWN_ERROR;
-                }
-            }
-
-            p_attr = (tGATT_ATTR16 *)p_attr->p_next;
+    if ((p_attr = (tGATT_ATTR16 *)gatts_find_attr_by_handle(p_db, handle)) != NULL) {
+        if (p_attr->control.auto_rsp == GATT_RSP_BY_APP) {
+            return GATT_APP_RSP;
+        }
 
+        if ((p_attr->p_value != NULL) && 
+            (p_attr->p_value->attr_val.attr_max_len >= offset + len) && 
+            p_attr->p_value->attr_val.attr_val != NULL) {
+            memcpy(p_attr->p_value->attr_val.attr_val + offset, p_value, len);
+            p_attr->p_value->attr_val.attr_len = len + offset;
+            return GATT_SUCCESS;
+        } else if (p_attr->p_value != NULL && p_attr->p_value->attr_val.attr_max_len < offset + len){
+            GATT_TRACE_DEBUG("Remote device try to write with a length larger then attribute's max length\n");
+            return GATT_INVALID_ATTR_LEN;
+        } else {
+            GATT_TRACE_ERROR("Error in %s, line=%d, %s should not be NULL here\n", __func__, __LINE__, \
+                            (p_attr->p_value == NULL) ? "p_value" : "attr_val.attr_val");
+            return GATT_UNKNOWN_ERROR;
         }
     }
 
@@ -990,18 +989,10 @@ tGATT_STATUS gatts_read_attr_perm_check(tGATT_SVC_DB *p_db,
     tGATT_STATUS status = GATT_NOT_FOUND;
     tGATT_ATTR16  *p_attr;
 
-    if (p_db && p_db->p_attr_list) {
-        p_attr = (tGATT_ATTR16 *)p_db->p_attr_list;
-
-        while (p_attr && handle >= p_attr->handle) {
-            if (p_attr->handle == handle) {
-                status = gatts_check_attr_readability (p_attr, 0,
-                                                       is_long,
-                                                       sec_flag, key_size);
-                break;
-            }
-            p_attr = (tGATT_ATTR16 *) p_attr->p_next;
-        }
+    if ((p_attr = (tGATT_ATTR16 *)gatts_find_attr_by_handle(p_db, handle)) != NULL) {
+        status = gatts_check_attr_readability (p_attr, 0,
+                                               is_long,
+                                               sec_flag, key_size);
     }
 
     return status;
@@ -1039,119 +1030,110 @@ tGATT_STATUS gatts_write_attr_perm_check (tGATT_SVC_DB *p_db, UINT8 op_code,
     GATT_TRACE_DEBUG( "gatts_write_attr_perm_check op_code=0x%0x handle=0x%04x offset=%d len=%d sec_flag=0x%0x key_size=%d",
                       op_code, handle, offset, len, sec_flag, key_size);
 
-    if (p_db != NULL) {
-        p_attr = (tGATT_ATTR16 *) p_db->p_attr_list;
-
-        while (p_attr != NULL) {
-            if (p_attr->handle == handle) {
-                perm = p_attr->permission;
-                min_key_size = (((perm & GATT_ENCRYPT_KEY_SIZE_MASK) >> 12));
-                if (min_key_size != 0 ) {
-                    min_key_size += 6;
-                }
-                GATT_TRACE_DEBUG( "gatts_write_attr_perm_check p_attr->permission =0x%04x min_key_size==0x%04x",
-                                  p_attr->permission,
-                                  min_key_size);
-
-                if ((op_code == GATT_CMD_WRITE || op_code == GATT_REQ_WRITE)
-                        && (perm & GATT_WRITE_SIGNED_PERM)) {
-                    /* use the rules for the mixed security see section 10.2.3*/
-                    /* use security mode 1 level 2 when the following condition follows */
-                    /* LE security mode 2 level 1 and LE security mode 1 level 2 */
-                    if ((perm & GATT_PERM_WRITE_SIGNED) && (perm & GATT_PERM_WRITE_ENCRYPTED)) {
-                        perm = GATT_PERM_WRITE_ENCRYPTED;
-                    }
-                    /* use security mode 1 level 3 when the following condition follows */
-                    /* LE security mode 2 level 2 and security mode 1 and LE */
-                    else if (((perm & GATT_PERM_WRITE_SIGNED_MITM) && (perm & GATT_PERM_WRITE_ENCRYPTED)) ||
-                             /* LE security mode 2 and security mode 1 level 3 */
-                             ((perm & GATT_WRITE_SIGNED_PERM) && (perm & GATT_PERM_WRITE_ENC_MITM))) {
-                        perm = GATT_PERM_WRITE_ENC_MITM;
-                    }
-                }
+    if ((p_attr = (tGATT_ATTR16 *)gatts_find_attr_by_handle(p_db, handle)) != NULL) {
+        perm = p_attr->permission;
+        min_key_size = (((perm & GATT_ENCRYPT_KEY_SIZE_MASK) >> 12));
+        if (min_key_size != 0 ) {
+            min_key_size += 6;
+        }
+        GATT_TRACE_DEBUG( "gatts_write_attr_perm_check p_attr->permission =0x%04x min_key_size==0x%04x",
+                          p_attr->permission,
+                          min_key_size);
+
+        if ((op_code == GATT_CMD_WRITE || op_code == GATT_REQ_WRITE)
+                && (perm & GATT_WRITE_SIGNED_PERM)) {
+            /* use the rules for the mixed security see section 10.2.3*/
+            /* use security mode 1 level 2 when the following condition follows */
+            /* LE security mode 2 level 1 and LE security mode 1 level 2 */
+            if ((perm & GATT_PERM_WRITE_SIGNED) && (perm & GATT_PERM_WRITE_ENCRYPTED)) {
+                perm = GATT_PERM_WRITE_ENCRYPTED;
+            }
+            /* use security mode 1 level 3 when the following condition follows */
+            /* LE security mode 2 level 2 and security mode 1 and LE */
+            else if (((perm & GATT_PERM_WRITE_SIGNED_MITM) && (perm & GATT_PERM_WRITE_ENCRYPTED)) ||
+                     /* LE security mode 2 and security mode 1 level 3 */
+                     ((perm & GATT_WRITE_SIGNED_PERM) && (perm & GATT_PERM_WRITE_ENC_MITM))) {
+                perm = GATT_PERM_WRITE_ENC_MITM;
+            }
+        }
 
-                if ((op_code == GATT_SIGN_CMD_WRITE) && !(perm & GATT_WRITE_SIGNED_PERM)) {
-                    status = GATT_WRITE_NOT_PERMIT;
-                    GATT_TRACE_DEBUG( "gatts_write_attr_perm_check - sign cmd write not allowed");
-                }
-                if ((op_code == GATT_SIGN_CMD_WRITE) && (sec_flag & GATT_SEC_FLAG_ENCRYPTED)) {
-                    status = GATT_INVALID_PDU;
-                    GATT_TRACE_ERROR( "gatts_write_attr_perm_check - Error!! sign cmd write sent on a encypted link");
-                } else if (!(perm & GATT_WRITE_ALLOWED)) {
+        if ((op_code == GATT_SIGN_CMD_WRITE) && !(perm & GATT_WRITE_SIGNED_PERM)) {
+            status = GATT_WRITE_NOT_PERMIT;
+            GATT_TRACE_DEBUG( "gatts_write_attr_perm_check - sign cmd write not allowed");
+        }
+        if ((op_code == GATT_SIGN_CMD_WRITE) && (sec_flag & GATT_SEC_FLAG_ENCRYPTED)) {
+            status = GATT_INVALID_PDU;
+            GATT_TRACE_ERROR( "gatts_write_attr_perm_check - Error!! sign cmd write sent on a encypted link");
+        } else if (!(perm & GATT_WRITE_ALLOWED)) {
+            status = GATT_WRITE_NOT_PERMIT;
+            GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_WRITE_NOT_PERMIT");
+        }
+        /* require authentication, but not been authenticated */
+        else if ((perm & GATT_WRITE_AUTH_REQUIRED ) && !(sec_flag & GATT_SEC_FLAG_LKEY_UNAUTHED)) {
+            status = GATT_INSUF_AUTHENTICATION;
+            GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INSUF_AUTHENTICATION");
+        } else if ((perm & GATT_WRITE_MITM_REQUIRED ) && !(sec_flag & GATT_SEC_FLAG_LKEY_AUTHED)) {
+            status = GATT_INSUF_AUTHENTICATION;
+            GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INSUF_AUTHENTICATION: MITM required");
+        } else if ((perm & GATT_WRITE_ENCRYPTED_PERM ) && !(sec_flag & GATT_SEC_FLAG_ENCRYPTED)) {
+            status = GATT_INSUF_ENCRYPTION;
+            GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INSUF_ENCRYPTION");
+        } else if ((perm & GATT_WRITE_ENCRYPTED_PERM ) && (sec_flag & GATT_SEC_FLAG_ENCRYPTED) && (key_size < min_key_size)) {
+            status = GATT_INSUF_KEY_SIZE;
+            GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INSUF_KEY_SIZE");
+        }
+        /* LE security mode 2 attribute  */
+        else if (perm & GATT_WRITE_SIGNED_PERM && op_code != GATT_SIGN_CMD_WRITE && !(sec_flag & GATT_SEC_FLAG_ENCRYPTED)
+                 &&  (perm & GATT_WRITE_ALLOWED) == 0) {
+            status = GATT_INSUF_AUTHENTICATION;
+            GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INSUF_AUTHENTICATION: LE security mode 2 required");
+        } else { /* writable: must be char value declaration or char descritpors */
+            if (p_attr->uuid_type == GATT_ATTR_UUID_TYPE_16) {
+                switch (p_attr->uuid) {
+                case GATT_UUID_CHAR_PRESENT_FORMAT:/* should be readable only */
+                case GATT_UUID_CHAR_EXT_PROP:/* should be readable only */
+                case GATT_UUID_CHAR_AGG_FORMAT: /* should be readable only */
+                case GATT_UUID_CHAR_VALID_RANGE:
                     status = GATT_WRITE_NOT_PERMIT;
-                    GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_WRITE_NOT_PERMIT");
-                }
-                /* require authentication, but not been authenticated */
-                else if ((perm & GATT_WRITE_AUTH_REQUIRED ) && !(sec_flag & GATT_SEC_FLAG_LKEY_UNAUTHED)) {
-                    status = GATT_INSUF_AUTHENTICATION;
-                    GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INSUF_AUTHENTICATION");
-                } else if ((perm & GATT_WRITE_MITM_REQUIRED ) && !(sec_flag & GATT_SEC_FLAG_LKEY_AUTHED)) {
-                    status = GATT_INSUF_AUTHENTICATION;
-                    GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INSUF_AUTHENTICATION: MITM required");
-                } else if ((perm & GATT_WRITE_ENCRYPTED_PERM ) && !(sec_flag & GATT_SEC_FLAG_ENCRYPTED)) {
-                    status = GATT_INSUF_ENCRYPTION;
-                    GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INSUF_ENCRYPTION");
-                } else if ((perm & GATT_WRITE_ENCRYPTED_PERM ) && (sec_flag & GATT_SEC_FLAG_ENCRYPTED) && (key_size < min_key_size)) {
-                    status = GATT_INSUF_KEY_SIZE;
-                    GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INSUF_KEY_SIZE");
-                }
-                /* LE security mode 2 attribute  */
-                else if (perm & GATT_WRITE_SIGNED_PERM && op_code != GATT_SIGN_CMD_WRITE && !(sec_flag & GATT_SEC_FLAG_ENCRYPTED)
-                         &&  (perm & GATT_WRITE_ALLOWED) == 0) {
-                    status = GATT_INSUF_AUTHENTICATION;
-                    GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INSUF_AUTHENTICATION: LE security mode 2 required");
-                } else { /* writable: must be char value declaration or char descritpors */
-                    if (p_attr->uuid_type == GATT_ATTR_UUID_TYPE_16) {
-                        switch (p_attr->uuid) {
-                        case GATT_UUID_CHAR_PRESENT_FORMAT:/* should be readable only */
-                        case GATT_UUID_CHAR_EXT_PROP:/* should be readable only */
-                        case GATT_UUID_CHAR_AGG_FORMAT: /* should be readable only */
-                        case GATT_UUID_CHAR_VALID_RANGE:
-                            status = GATT_WRITE_NOT_PERMIT;
-                            break;
+                    break;
 
-                        case GATT_UUID_CHAR_CLIENT_CONFIG:
-                        /* coverity[MISSING_BREAK] */
-                        /* intnended fall through, ignored */
-                        /* fall through */
-                        case GATT_UUID_CHAR_SRVR_CONFIG:
-                            max_size = 2;
-                        case GATT_UUID_CHAR_DESCRIPTION:
-                        default: /* any other must be character value declaration */
-                            status = GATT_SUCCESS;
-                            break;
-                        }
-                    } else if (p_attr->uuid_type == GATT_ATTR_UUID_TYPE_128 ||
-                               p_attr->uuid_type == GATT_ATTR_UUID_TYPE_32) {
-                        status = GATT_SUCCESS;
-                    } else {
-                        status = GATT_INVALID_PDU;
-                    }
+                case GATT_UUID_CHAR_CLIENT_CONFIG:
+                /* coverity[MISSING_BREAK] */
+                /* intnended fall through, ignored */
+                /* fall through */
+                case GATT_UUID_CHAR_SRVR_CONFIG:
+                    max_size = 2;
+                case GATT_UUID_CHAR_DESCRIPTION:
+                default: /* any other must be character value declaration */
+                    status = GATT_SUCCESS;
+                    break;
+                }
+            } else if (p_attr->uuid_type == GATT_ATTR_UUID_TYPE_128 ||
+                       p_attr->uuid_type == GATT_ATTR_UUID_TYPE_32) {
+                status = GATT_SUCCESS;
+            } else {
+                status = GATT_INVALID_PDU;
+            }
 
-                    if (p_data == NULL && len  > 0) {
-                        status = GATT_INVALID_PDU;
-                    }
-                    /* these attribute does not allow write blob */
+            if (p_data == NULL && len  > 0) {
+                status = GATT_INVALID_PDU;
+            }
+            /* these attribute does not allow write blob */
 // btla-specific ++
-                    else if ( (p_attr->uuid_type == GATT_ATTR_UUID_TYPE_16) &&
-                              (p_attr->uuid == GATT_UUID_CHAR_CLIENT_CONFIG ||
-                               p_attr->uuid == GATT_UUID_CHAR_SRVR_CONFIG) )
+            else if ( (p_attr->uuid_type == GATT_ATTR_UUID_TYPE_16) &&
+                      (p_attr->uuid == GATT_UUID_CHAR_CLIENT_CONFIG ||
+                       p_attr->uuid == GATT_UUID_CHAR_SRVR_CONFIG) )
 // btla-specific --
-                    {
-                        if (op_code == GATT_REQ_PREPARE_WRITE && offset != 0) { /* does not allow write blob */
-                            status = GATT_NOT_LONG;
-                            GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_NOT_LONG");
-                        } else if (len != max_size) { /* data does not match the required format */
-                            status = GATT_INVALID_ATTR_LEN;
-                            GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INVALID_PDU");
-                        } else {
-                            status = GATT_SUCCESS;
-                        }
-                    }
+            {
+                if (op_code == GATT_REQ_PREPARE_WRITE && offset != 0) { /* does not allow write blob */
+                    status = GATT_NOT_LONG;
+                    GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_NOT_LONG");
+                } else if (len != max_size) { /* data does not match the required format */
+                    status = GATT_INVALID_ATTR_LEN;
+                    GATT_TRACE_ERROR( "gatts_write_attr_perm_check - GATT_INVALID_PDU");
+                } else {
+                    status = GATT_SUCCESS;
                 }
-                break;
-            } else {
-                p_attr = (tGATT_ATTR16 *)p_attr->p_next;
             }
         }
     }
@@ -1201,7 +1183,7 @@ static void *allocate_attr_in_db(tGATT_SVC_DB *p_db, tBT_UUID *p_uuid, tGATT_PER
     }
 
     if (p_db->mem_free < len) {
-        if (!allocate_svc_db_buf(p_db)) {
+        if (!allocate_svc_db_buf(p_db, GATT_DB_BUF_SIZE)) {
             GATT_TRACE_ERROR("allocate_attr_in_db failed, no resources\n");
             return NULL;
         }
@@ -1229,18 +1211,14 @@ static void *allocate_attr_in_db(tGATT_SVC_DB *p_db, tBT_UUID *p_uuid, tGATT_PER
     p_attr16->permission = perm;
     p_attr16->p_next = NULL;
 
-    /* link the attribute record into the end of DB */
+    /* link the attribute record into the end of DB, the last one is the previous handle */
     if (p_db->p_attr_list == NULL) {
         p_db->p_attr_list = p_attr16;
     } else {
-        p_last = (tGATT_ATTR16 *)p_db->p_attr_list;
-
-        while (p_last != NULL && p_last->p_next != NULL) {
-            p_last = (tGATT_ATTR16 *)p_last->p_next;
-        }
-
+        p_last = (tGATT_ATTR16 *)p_db->p_attr_tab[p_attr16->handle - 1 - p_db->start_handle];
         p_last->p_next = p_attr16;
     }
+    p_db->p_attr_tab[p_attr16->handle - p_db->start_handle] = p_attr16;
 
     if (p_attr16->uuid_type == GATT_ATTR_UUID_TYPE_16) {
         GATT_TRACE_DEBUG("=====> handle = [0x%04x] uuid16 = [0x%04x] perm=0x%02x\n",
@@ -1296,6 +1274,7 @@ static BOOLEAN deallocate_attr_in_db(tGATT_SVC_DB *p_db, void *p_attr)
     /* else attr not found */
     if ( found) {
         p_db->next_handle --;
+        p_db->p_attr_tab[((tGATT_ATTR16 *)p_attr)->handle - p_db->start_handle] = NULL;
     }
 
     return found;
@@ -1322,7 +1301,7 @@ static BOOLEAN copy_extra_byte_in_db(tGATT_SVC_DB *p_db, void **p_dst, UINT16 le
     UINT8 *p = (UINT8 *)*p_dst;
 
     if (p_db->mem_free < len) {
-        if (!allocate_svc_db_buf(p_db)) {
+        if (!allocate_svc_db_buf(p_db, GATT_DB_BUF_SIZE)) {
             GATT_TRACE_ERROR("copy_extra_byte_in_db failed, no resources\n");
             return FALSE;
         }
@@ -1346,19 +1325,28 @@ static BOOLEAN copy_extra_byte_in_db(tGATT_SVC_DB *p_db, void **p_dst, UINT16 le
 ** Returns          TRUE if allocation succeed, otherwise FALSE.
 **
 *******************************************************************************/
-static BOOLEAN allocate_svc_db_buf(tGATT_SVC_DB *p_db)
+static BOOLEAN allocate_svc_db_buf(tGATT_SVC_DB *p_db, UINT32 size)
 {
     BT_HDR  *p_buf;
 
     GATT_TRACE_DEBUG("allocate_svc_db_buf allocating extra buffer");
 
-    if ((p_buf = (BT_HDR *)osi_calloc(GATT_DB_BUF_SIZE)) == NULL) {
+    if (size < GATT_DB_BUF_SIZE) {
+        size = GATT_DB_BUF_SIZE;
+    }
+
+    if ((p_buf = (BT_HDR *)osi_calloc(size)) == NULL && size > GATT_DB_BUF_SIZE) {
+        size = GATT_DB_BUF_SIZE;
+        p_buf = (BT_HDR *)osi_calloc(size);
+    }
+
+    if (p_buf == NULL) {
         GATT_TRACE_ERROR("allocate_svc_db_buf failed, no resources");
         return FALSE;
     }
 
     p_db->p_free_mem    = (UINT8 *) p_buf;
-    p_db->mem_free = GATT_DB_BUF_SIZE;
+    p_db->mem_free = size;
 
     fixed_queue_enqueue(p_db->svc_buffer, p_buf);
 
@@ -1366,6 +1354,32 @@ static BOOLEAN allocate_svc_db_buf(tGATT_SVC_DB *p_db)
 
 }
 
+/*******************************************************************************
+**
+** Function         allocate_attr_tab_in_db
+**
+** Description      Utility function to allocate the handle index of a service
+**                  database. It is kept in the service buffer queue so it is
+**                  released together with the attributes.
+**
+** Returns          TRUE if allocation succeed, otherwise FALSE.
+**
+*******************************************************************************/
+static BOOLEAN allocate_attr_tab_in_db(tGATT_SVC_DB *p_db, UINT16 num_handle)
+{
+    void **p_tab;
+
+    if ((p_tab = (void **)osi_calloc(((UINT32)num_handle + 1) * sizeof(void *))) == NULL) {
+        GATT_TRACE_ERROR("allocate_attr_tab_in_db failed, no resources");
+        return FALSE;
+    }
+
+    p_db->p_attr_tab = p_tab;
+    fixed_queue_enqueue(p_db->svc_buffer, p_tab);
+
+    return TRUE;
+}
+
 /*******************************************************************************
 **
 ** Function         gatts_send_app_read_request
@@ -30,6 +30,9 @@
 #include "gatt_int.h"
 #include "stack/l2c_api.h"
 #include "l2c_int.h"
+#if (GATTS_SR_STATS_INCLUDED == TRUE)
+#include "osi/alarm.h"
+#endif  ///GATTS_SR_STATS_INCLUDED == TRUE
 #define GATT_MTU_REQ_MIN_LEN        2
 
 
@@ -104,6 +107,47 @@ UINT32 gatt_sr_enqueue_cmd (tGATT_TCB *p_tcb, UINT8 op_code, UINT16 handle)
     return trans_id;
 }
 
+#if (GATTS_SR_STATS_INCLUDED == TRUE)
+/*******************************************************************************
+**
+** Function         gatt_sr_stats_add
+**
+** Description      Count a time in a log2 millisecond histogram.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void gatt_sr_stats_add (UINT32 *p_hist, UINT32 ms)
+{
+    UINT8 bucket = 0;
+
+    while (ms != 0 && bucket < GATTS_SR_STATS_BUCKETS - 1) {
+        ms >>= 1;
+        bucket++;
+    }
+    p_hist[bucket]++;
+}
+
+/*******************************************************************************
+**
+** Function         gatt_sr_stats_rsp_done
+**
+** Description      Record the latency of a request that has been answered.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void gatt_sr_stats_rsp_done (tGATT_TCB *p_tcb, UINT32 now)
+{
+    UINT32 latency = now - p_tcb->sr_req_start;
+
+    gatt_sr_stats_add(p_tcb->sr_stats.latency_hist, latency);
+    if (latency > p_tcb->sr_stats.max_latency_ms) {
+        p_tcb->sr_stats.max_latency_ms = latency;
+    }
+}
+#endif  ///GATTS_SR_STATS_INCLUDED == TRUE
+
 /*******************************************************************************
 **
 ** Function         gatt_sr_cmd_empty
@@ -146,6 +190,17 @@ void gatt_dequeue_sr_cmd (tGATT_TCB *p_tcb)
     }
 
     memset( &p_tcb->sr_cmd, 0, sizeof(tGATT_SR_CMD));
+
+#if (GATTS_SR_STATS_INCLUDED == TRUE)
+    if (p_tcb->sr_app_pending) {
+        UINT32 now = osi_time_get_os_boottime_ms();
+
+        p_tcb->sr_app_pending = FALSE;
+        p_tcb->sr_stats.app_rsp_cnt++;
+        gatt_sr_stats_add(p_tcb->sr_stats.queue_hist, now - p_tcb->sr_app_start);
+        gatt_sr_stats_rsp_done(p_tcb, now);
+    }
+#endif  ///GATTS_SR_STATS_INCLUDED == TRUE
 }
 
 /*******************************************************************************
@@ -1242,36 +1297,30 @@ void gatt_attr_process_prepare_write (tGATT_TCB *p_tcb, UINT8 i_rcb, UINT16 hand
     if (status == GATT_SUCCESS){
         if ((trans_id = gatt_sr_enqueue_cmd(p_tcb, op_code, handle)) != 0) {
             p_db = gatt_cb.sr_reg[i_rcb].p_db;
-            if (p_db && p_db->p_attr_list) {
-                p_attr = (tGATT_ATTR16 *)p_db->p_attr_list;
-                while (p_attr && handle >= p_attr->handle) {
-                    if (p_attr->handle == handle ) {
-                        p_attr_temp = p_attr;
-                        if (p_attr->control.auto_rsp == GATT_RSP_BY_APP) {
-                            status = GATT_APP_RSP;
-                        } else if (p_attr->p_value != NULL &&
-                            offset > p_attr->p_value->attr_val.attr_max_len) {
-                            status = GATT_INVALID_OFFSET; 
-                             is_need_prepare_write_rsp = TRUE;
-                             is_need_queue_data = TRUE;
-                        } else if (p_attr->p_value != NULL &&
-                            ((offset + len) > p_attr->p_value->attr_val.attr_max_len)){
-                            status = GATT_INVALID_ATTR_LEN;
-                            is_need_prepare_write_rsp = TRUE;
-                            is_need_queue_data = TRUE;
-                        } else if (p_attr->p_value == NULL) {
-                            GATT_TRACE_ERROR("Error in %s, attribute of handle 0x%x not allocate value buffer\n",
-                                        __func__, handle);
-                            status = GATT_UNKNOWN_ERROR;
-                        } else {
-                             //valid prepare write request, need to send response and queue the data
-                             //status: GATT_SUCCESS
-                             is_need_prepare_write_rsp = TRUE;
-                             is_need_queue_data = TRUE;
-                         }
-                    }
-                    p_attr = (tGATT_ATTR16 *)p_attr->p_next;
-                }
+            if ((p_attr = (tGATT_ATTR16 *)gatts_find_attr_by_handle(p_db, handle)) != NULL) {
+                p_attr_temp = p_attr;
+                if (p_attr->control.auto_rsp == GATT_RSP_BY_APP) {
+                    status = GATT_APP_RSP;
+                } else if (p_attr->p_value != NULL &&
+                    offset > p_attr->p_value->attr_val.attr_max_len) {
+                    status = GATT_INVALID_OFFSET; 
+                     is_need_prepare_write_rsp = TRUE;
+                     is_need_queue_data = TRUE;
+                } else if (p_attr->p_value != NULL &&
+                    ((offset + len) > p_attr->p_value->attr_val.attr_max_len)){
+                    status = GATT_INVALID_ATTR_LEN;
+                    is_need_prepare_write_rsp = TRUE;
+                    is_need_queue_data = TRUE;
+                } else if (p_attr->p_value == NULL) {
+                    GATT_TRACE_ERROR("Error in %s, attribute of handle 0x%x not allocate value buffer\n",
+                                __func__, handle);
+                    status = GATT_UNKNOWN_ERROR;
+                } else {
+                     //valid prepare write request, need to send response and queue the data
+                     //status: GATT_SUCCESS
+                     is_need_prepare_write_rsp = TRUE;
+                     is_need_queue_data = TRUE;
+                 }
             }
         } else{
             status = GATT_UNKNOWN_ERROR;
@@ -1453,31 +1502,27 @@ void gatts_process_attribute_req (tGATT_TCB *p_tcb, UINT8 op_code,
     if (GATT_HANDLE_IS_VALID(handle)) {
         for (i = 0; i < GATT_MAX_SR_PROFILES; i ++, p_rcb ++) {
             if (p_rcb->in_use && p_rcb->s_hdl <= handle && p_rcb->e_hdl >= handle) {
-                p_attr = (tGATT_ATTR16 *)p_rcb->p_db->p_attr_list;
-
-                while (p_attr) {
-                    if (p_attr->handle == handle) {
-                        switch (op_code) {
-                        case GATT_REQ_READ: /* read char/char descriptor value */
-                        case GATT_REQ_READ_BLOB:
-                            gatts_process_read_req(p_tcb, p_rcb, op_code, handle, len, p);
-                            break;
-
-                        case GATT_REQ_WRITE: /* write char/char descriptor value */
-                        case GATT_CMD_WRITE:
-                        case GATT_SIGN_CMD_WRITE:
-                            gatts_process_write_req(p_tcb, i, handle, op_code, len, p);
-                            break;
-                        
-                        case GATT_REQ_PREPARE_WRITE:
-                            gatt_attr_process_prepare_write (p_tcb, i, handle, op_code, len, p);
-                        default:
-                            break;
-                        }
-                        status = GATT_SUCCESS;
+                p_attr = (tGATT_ATTR16 *)gatts_find_attr_by_handle(p_rcb->p_db, handle);
+
+                if (p_attr != NULL) {
+                    switch (op_code) {
+                    case GATT_REQ_READ: /* read char/char descriptor value */
+                    case GATT_REQ_READ_BLOB:
+                        gatts_process_read_req(p_tcb, p_rcb, op_code, handle, len, p);
+                        break;
+
+                    case GATT_REQ_WRITE: /* write char/char descriptor value */
+                    case GATT_CMD_WRITE:
+                    case GATT_SIGN_CMD_WRITE:
+                        gatts_process_write_req(p_tcb, i, handle, op_code, len, p);
+                        break;
+                    
+                    case GATT_REQ_PREPARE_WRITE:
+                        gatt_attr_process_prepare_write (p_tcb, i, handle, op_code, len, p);
+                    default:
                         break;
                     }
-                    p_attr = (tGATT_ATTR16 *)p_attr->p_next;
+                    status = GATT_SUCCESS;
                 }
                 break;
             }
@@ -1637,6 +1682,15 @@ void gatt_server_handle_client_req (tGATT_TCB *p_tcb, UINT8 op_code,
         }
         /* otherwise, ignore the pkt */
     } else {
+#if (GATTS_SR_STATS_INCLUDED == TRUE)
+        BOOLEAN is_req = (op_code != GATT_CMD_WRITE &&
+                          op_code != GATT_SIGN_CMD_WRITE &&
+                          op_code != GATT_HANDLE_VALUE_CONF);
+
+        if (is_req) {
+            p_tcb->sr_req_start = osi_time_get_os_boottime_ms();
+        }
+#endif  ///GATTS_SR_STATS_INCLUDED == TRUE
         switch (op_code) {
         case GATT_REQ_READ_BY_GRP_TYPE:         /* discover primary services */
         case GATT_REQ_FIND_TYPE_VALUE:          /* discover service by UUID */
@@ -1681,6 +1735,19 @@ void gatt_server_handle_client_req (tGATT_TCB *p_tcb, UINT8 op_code,
         default:
             break;
         }
+
+#if (GATTS_SR_STATS_INCLUDED == TRUE)
+        /* answered in this context, or left to the application */
+        if (is_req) {
+            if (gatt_sr_cmd_empty(p_tcb)) {
+                p_tcb->sr_stats.stack_rsp_cnt++;
+                gatt_sr_stats_rsp_done(p_tcb, osi_time_get_os_boottime_ms());
+            } else {
+                p_tcb->sr_app_pending = TRUE;
+                p_tcb->sr_app_start = osi_time_get_os_boottime_ms();
+            }
+        }
+#endif  ///GATTS_SR_STATS_INCLUDED == TRUE
     }
 }
 
@@ -382,13 +382,20 @@ tGATT_HDL_LIST_ELEM *gatt_find_hdl_buffer_by_handle(UINT16 handle)
 tGATT_HDL_LIST_ELEM *gatt_find_hdl_buffer_by_attr_handle(UINT16 attr_handle)
 {
     tGATT_HDL_LIST_INFO *p_list_info = &gatt_cb.hdl_list_info;
-    tGATT_HDL_LIST_ELEM      *p_list = NULL;
+    tGATT_HDL_LIST_ELEM      *p_list = gatt_cb.p_last_hdl_elem;
+
+    /* requests usually hit the same service back to back */
+    if (p_list != NULL && p_list->in_use && (p_list->asgn_range.s_handle <= attr_handle)
+            && (p_list->asgn_range.e_handle >= attr_handle)) {
+        return (p_list);
+    }
 
     p_list = p_list_info->p_first;
 
     while (p_list != NULL) {
         if (p_list->in_use && (p_list->asgn_range.s_handle <= attr_handle) 
 			&& (p_list->asgn_range.e_handle >= attr_handle)) {
+            gatt_cb.p_last_hdl_elem = p_list;
             return (p_list);
         }
         p_list = p_list->p_next;
@@ -502,6 +509,7 @@ void gatt_free_srvc_db_buffer_app_id(tBT_UUID *p_app_id)
 
             p_elem->svc_db.mem_free = 0;
             p_elem->svc_db.p_attr_list = p_elem->svc_db.p_free_mem = NULL;
+            p_elem->svc_db.p_attr_tab = NULL;
         }
     }
 }
@@ -2244,6 +2252,10 @@ void gatt_cleanup_upon_disc(BD_ADDR bda, UINT16 reason, tBT_TRANSPORT transport)
         fixed_queue_free(p_tcb->sr_cmd.multi_rsp_q, osi_free_func);
         p_tcb->sr_cmd.multi_rsp_q = NULL;
 #endif /* #if (GATTS_INCLUDED) */
+#if (GATTS_NOTIF_BATCH_INCLUDED == TRUE)
+        fixed_queue_free(p_tcb->notif_q, osi_free_func);
+        p_tcb->notif_q = NULL;
+#endif  ///GATTS_NOTIF_BATCH_INCLUDED == TRUE
         for (i = 0; i < GATT_MAX_APPS; i ++) {
             p_reg = &gatt_cb.cl_rcb[i];
             if (p_reg->in_use && p_reg->app_cb.p_conn_cb) {
@@ -74,8 +74,6 @@ typedef UINT8 tGATT_SEC_ACTION;
 #define GATT_AUTH_SIGN_MASK     0x80  /*0x1000-0000*/
 #define GATT_AUTH_SIGN_LEN      12
 
-#define GATT_HDR_SIZE           3 /* 1B opcode + 2B handle */
-
 /* wait for ATT cmd response timeout value */
 #define GATT_WAIT_FOR_RSP_TOUT       30
 #define GATT_WAIT_FOR_DISC_RSP_TOUT  5
@@ -221,9 +219,11 @@ typedef struct {
 */
 typedef struct {
     void            *p_attr_list;       /* pointer to the first attribute, either tGATT_ATTR16 or tGATT_ATTR128 */
+    void            **p_attr_tab;       /* attributes indexed by (handle - start_handle), kept in svc_buffer */
     UINT8           *p_free_mem;        /* Pointer to free memory       */
     fixed_queue_t   *svc_buffer;         /* buffer queue used for service database */
     UINT32          mem_free;           /* Memory still available       */
+    UINT16          start_handle;       /* First handle number          */
     UINT16          end_handle;         /* Last handle number           */
     UINT16          next_handle;        /* Next usable handle value     */
 } tGATT_SVC_DB;
@@ -404,6 +404,17 @@ typedef struct {
     BOOLEAN         in_use;
     UINT8           tcb_idx;
     tGATT_PREPARE_WRITE_RECORD prepare_write_record;    /* prepare write packets record */
+#if (GATTS_NOTIF_BATCH_INCLUDED == TRUE)
+    UINT8           cl_supp_feat;       /* Client Supported Features written by the peer */
+    fixed_queue_t   *notif_q;           /* notification PDUs waiting to be sent */
+    TIMER_LIST_ENT  notif_flush_ent;    /* posted to the BTU task to send notif_q */
+#endif  ///GATTS_NOTIF_BATCH_INCLUDED == TRUE
+#if (GATTS_SR_STATS_INCLUDED == TRUE)
+    tGATTS_SR_STATS sr_stats;
+    UINT32          sr_req_start;       /* time the pending request was received, ms */
+    UINT32          sr_app_start;       /* time it was handed to the application, ms */
+    BOOLEAN         sr_app_pending;     /* sr_cmd is waiting for the application */
+#endif  ///GATTS_SR_STATS_INCLUDED == TRUE
 } tGATT_TCB;
 
 
@@ -507,6 +518,7 @@ typedef struct {
 #if (GATTS_INCLUDED == TRUE)    
     tGATT_HDL_LIST_INFO hdl_list_info;
     tGATT_HDL_LIST_ELEM hdl_list[GATT_MAX_SR_PROFILES];
+    tGATT_HDL_LIST_ELEM *p_last_hdl_elem;   /* last hit of gatt_find_hdl_buffer_by_attr_handle */
     tGATT_SRV_LIST_INFO srv_list_info;
     tGATT_SRV_LIST_ELEM srv_list[GATT_MAX_SR_PROFILES];
 #endif  ///GATTS_INCLUDED == TRUE
@@ -528,6 +540,9 @@ typedef struct {
     tGATT_PROFILE_CLCB  profile_clcb[GATT_MAX_APPS];
 #endif  ///GATTS_INCLUDED == TRUE
     UINT16              handle_of_h_r;          /* Handle of the handles reused characteristic value */
+#if (GATTS_NOTIF_BATCH_INCLUDED == TRUE)
+    UINT16              handle_of_cl_supp_feat; /* Handle of the client supported features value */
+#endif  ///GATTS_NOTIF_BATCH_INCLUDED == TRUE
 
     tGATT_APPL_INFO       cb_info;
 
@@ -595,6 +610,11 @@ extern tGATT_STATUS attp_send_cl_msg (tGATT_TCB *p_tcb, UINT16 clcb_idx, UINT8 o
 extern BT_HDR *attp_build_sr_msg(tGATT_TCB *p_tcb, UINT8 op_code, tGATT_SR_MSG *p_msg);
 extern tGATT_STATUS attp_send_sr_msg (tGATT_TCB *p_tcb, BT_HDR *p_msg);
 extern tGATT_STATUS attp_send_msg_to_l2cap(tGATT_TCB *p_tcb, BT_HDR *p_toL2CAP);
+#if (GATTS_NOTIF_BATCH_INCLUDED == TRUE)
+extern tGATT_STATUS attp_queue_notif (tGATT_TCB *p_tcb, BT_HDR *p_msg);
+extern tGATT_STATUS attp_flush_notif (tGATT_TCB *p_tcb);
+extern void attp_notif_flush_timeout (TIMER_LIST_ENT *p_tle);
+#endif  ///GATTS_NOTIF_BATCH_INCLUDED == TRUE
 
 /* utility functions */
 extern UINT8 *gatt_dbg_op_name(UINT8 op_code);
@@ -746,6 +766,7 @@ extern tGATT_STATUS gatts_write_attr_perm_check (tGATT_SVC_DB *p_db, UINT8 op_co
 extern tGATT_STATUS gatts_read_attr_perm_check(tGATT_SVC_DB *p_db, BOOLEAN is_long, UINT16 handle, tGATT_SEC_FLAG sec_flag, UINT8 key_size);
 extern void gatts_update_srv_list_elem(UINT8 i_sreg, UINT16 handle, BOOLEAN is_primary);
 extern tBT_UUID *gatts_get_service_uuid (tGATT_SVC_DB *p_db);
+extern void *gatts_find_attr_by_handle (tGATT_SVC_DB *p_db, UINT16 handle);
 
 extern void gatt_reset_bgdev_list(void);
 extern uint16_t gatt_get_local_mtu(void);
@@ -850,6 +850,25 @@ typedef struct {
     tBTM_BLE_ENERGY_INFO_CBACK *p_ener_cback;
 } tBTM_BLE_ENERGY_INFO_CB;
 
+/* advertising report statistics of a device in the inquiry database */
+typedef struct {
+    UINT16  adv_count;          /* reports since the device entered the database */
+    INT8    rssi_last;
+    INT8    rssi_min;
+    INT8    rssi_max;
+    INT8    rssi_avg;           /* running average */
+    UINT32  adv_interval_ms;    /* running average of the time between reports */
+    UINT32  last_seen_ms;       /* time of the last report, osi_time_get_os_boottime_ms() */
+} tBTM_BLE_SCAN_STATS;
+
+/* resolvable private address cache counters */
+typedef struct {
+    UINT32  hits;               /* addresses resolved to a bonded device from the cache */
+    UINT32  neg_hits;           /* addresses known from the cache not to resolve */
+    UINT32  misses;             /* addresses checked against every IRK */
+    UINT32  irk_checks;         /* AES operations run for the misses */
+} tBTM_BLE_RPA_CACHE_STATS;
+
 typedef BOOLEAN (tBTM_BLE_SEL_CBACK)(BD_ADDR random_bda,     UINT8 *p_remote_name);
 typedef void (tBTM_BLE_CTRL_FEATURES_CBACK)(tBTM_STATUS status);
 
@@ -2051,6 +2070,38 @@ tBTM_STATUS BTM_BleGetEnergyInfo(tBTM_BLE_ENERGY_INFO_CBACK *p_ener_cback);
 //extern
 tBTM_STATUS BTM_SetBleDataLength(BD_ADDR bd_addr, UINT16 tx_pdu_length);
 
+/*******************************************************************************
+**
+** Function         BTM_BleGetScanStats
+**
+** Description      This function reads the advertising report statistics
+**                  kept for a device in the inquiry database.
+**
+** Parameters       bd_addr - device address
+**                  p_stats - statistics copied out
+**
+** Returns          BTM_SUCCESS if the device is known; otherwise BTM_UNKNOWN_ADDR.
+**
+*******************************************************************************/
+//extern
+tBTM_STATUS BTM_BleGetScanStats(BD_ADDR bd_addr, tBTM_BLE_SCAN_STATS *p_stats);
+
+/*******************************************************************************
+**
+** Function         BTM_BleGetRpaCacheStats
+**
+** Description      This function reads the counters of the resolvable private
+**                  address cache, the hit rate is
+**                  (hits + neg_hits) / (hits + neg_hits + misses).
+**
+** Parameters       p_stats - counters copied out
+**
+** Returns          BTM_SUCCESS, or BTM_MODE_UNSUPPORTED if there is no cache.
+**
+*******************************************************************************/
+//extern
+tBTM_STATUS BTM_BleGetRpaCacheStats(tBTM_BLE_RPA_CACHE_STATS *p_stats);
+
 /*
 #ifdef __cplusplus
 }
@@ -162,6 +162,7 @@ typedef void (*tBTU_EVENT_CALLBACK)(BT_HDR *p_hdr);
 
 #define BTU_TTYPE_UCD_TO                            108
 #define BTU_TTYPE_BLE_SCAN                          109
+#define BTU_TTYPE_ATT_NOTIF_FLUSH                   110
 
 
 /* This is the inquiry response information held by BTU, and available
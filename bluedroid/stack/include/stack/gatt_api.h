@@ -44,6 +44,7 @@
 #define  GATT_INSUF_ENCRYPTION               0x0f
 #define  GATT_UNSUPPORT_GRP_TYPE             0x10
 #define  GATT_INSUF_RESOURCE                 0x11
+#define  GATT_VALUE_NOT_ALLOWED              0x13
 
 
 #define  GATT_NO_RESOURCES                   0x80
@@ -108,6 +109,7 @@ typedef UINT8 tGATT_STATUS;
 #define  GATT_HANDLE_VALUE_NOTIF             0x1B
 #define  GATT_HANDLE_VALUE_IND               0x1D
 #define  GATT_HANDLE_VALUE_CONF              0x1E
+#define  GATT_HANDLE_MULTI_VALUE_NOTIF       0x23 /* sent only, not counted in GATT_OP_CODE_MAX */
 #define  GATT_SIGN_CMD_WRITE                 0xD2 /* changed in V4.0 1101-0010 (signed write)  see write cmd above*/
 #define  GATT_OP_CODE_MAX                    GATT_HANDLE_VALUE_CONF + 1 /* 0x1E = 30 + 1 = 31*/
 
@@ -115,6 +117,11 @@ typedef UINT8 tGATT_STATUS;
 
 #define  GATT_HANDLE_IS_VALID(x) ((x) != 0)
 
+/* Client Supported Features characteristic value bits */
+#define GATT_CL_SUPP_FEAT_ROBUST_CACHING    0x01
+#define GATT_CL_SUPP_FEAT_EATT              0x02
+#define GATT_CL_SUPP_FEAT_MULTI_NOTIF       0x04
+
 #define GATT_CONN_UNKNOWN                   0
 #define GATT_CONN_L2C_FAILURE               1                               /* general L2cap failure  */
 #define GATT_CONN_TIMEOUT                   HCI_ERR_CONNECTION_TOUT         /* 0x08 connection timeout  */
@@ -141,6 +148,13 @@ typedef UINT16 tGATT_DISCONN_REASON;
 */
 #define GATT_DEF_BLE_MTU_SIZE               23
 
+/* ATT header in front of an attribute value: 1B opcode + 2B handle
+*/
+#define GATT_HDR_SIZE                       3
+
+/* start of the attribute value in a GATTS_AllocHandleValueBuf buffer */
+#define GATTS_HANDLE_VALUE_BUF_DATA(p_buf)  ((UINT8 *)((p_buf) + 1) + (p_buf)->offset + GATT_HDR_SIZE)
+
 /* invalid connection ID
 */
 #define GATT_INVALID_CONN_ID                0xFFFF
@@ -347,6 +361,21 @@ typedef union {
 
 } tGATTS_RSP;
 
+#if (GATTS_SR_STATS_INCLUDED == TRUE)
+/* GATT server request statistics of one connection. Histogram bucket 0 counts
+** times below 1 ms, bucket n below 2^n ms and the last bucket everything above.
+*/
+#define GATTS_SR_STATS_BUCKETS      10
+
+typedef struct {
+    UINT32  stack_rsp_cnt;                          /* requests answered in the BTU task */
+    UINT32  app_rsp_cnt;                            /* requests answered by the application */
+    UINT32  max_latency_ms;
+    UINT32  latency_hist[GATTS_SR_STATS_BUCKETS];   /* request received to response sent */
+    UINT32  queue_hist[GATTS_SR_STATS_BUCKETS];     /* request given to the application to its response */
+} tGATTS_SR_STATS;
+#endif  ///GATTS_SR_STATS_INCLUDED == TRUE
+
 /* Transports for the primary service  */
 #define GATT_TRANSPORT_LE           BT_TRANSPORT_LE
 #define GATT_TRANSPORT_BR_EDR       BT_TRANSPORT_BR_EDR
@@ -875,6 +904,77 @@ extern  tGATT_STATUS GATTS_HandleValueIndication (UINT16 conn_id,
 extern  tGATT_STATUS GATTS_HandleValueNotification (UINT16 conn_id, UINT16 attr_handle,
         UINT16 val_len, UINT8 *p_val);
 
+/*******************************************************************************
+**
+** Function         GATTS_AllocHandleValueBuf
+**
+** Description      This function allocates a handle value notification or
+**                  indication PDU with L2CAP headroom. The value is written
+**                  in place at GATTS_HANDLE_VALUE_BUF_DATA(p_buf). It does
+**                  not look at the connection, so it can be called from any
+**                  task.
+**
+** Parameter        mtu: ATT MTU of the connection as last reported to the caller.
+**                  val_len: Length of the attribute value, truncated to (mtu - 3).
+**
+** Returns          pointer to the buffer, NULL on failure.
+**
+*******************************************************************************/
+extern BT_HDR *GATTS_AllocHandleValueBuf (UINT16 mtu, UINT16 val_len);
+
+/*******************************************************************************
+**
+** Function         GATTS_SendHandleValueBuf
+**
+** Description      This function sends a buffer from GATTS_AllocHandleValueBuf
+**                  as a handle value notification or indication without
+**                  copying the value.
+**
+** Parameter        conn_id: connection identifier.
+**                  attr_handle: Attribute handle of this handle value indication.
+**                  p_buf: buffer to send, always consumed.
+**                  need_confirm: TRUE for an indication, FALSE for a notification.
+**
+** Returns          GATT_SUCCESS if sucessfully sent; otherwise error code.
+**
+*******************************************************************************/
+extern tGATT_STATUS GATTS_SendHandleValueBuf (UINT16 conn_id, UINT16 attr_handle,
+        BT_HDR *p_buf, BOOLEAN need_confirm);
+
+#if (GATTS_SR_STATS_INCLUDED == TRUE)
+/*******************************************************************************
+**
+** Function         GATTS_GetSrStats
+**
+** Description      This function copies the request latency and queueing
+**                  histograms of a connection. They are reset when the
+**                  connection is set up.
+**
+** Parameter        conn_id: connection identifier.
+**                  p_stats: output statistics.
+**
+** Returns          GATT_SUCCESS if the connection is known; otherwise error code.
+**
+*******************************************************************************/
+extern tGATT_STATUS GATTS_GetSrStats (UINT16 conn_id, tGATTS_SR_STATS *p_stats);
+#endif  ///GATTS_SR_STATS_INCLUDED == TRUE
+
+#if (GATTS_NOTIF_BATCH_INCLUDED == TRUE)
+/*******************************************************************************
+**
+** Function         GATTS_FlushHandleValueNotifications
+**
+** Description      This function sends the notifications queued on a
+**                  connection now instead of when the BTU task is idle.
+**
+** Parameter        conn_id: connection identifier.
+**
+** Returns          GATT_SUCCESS if sucessfully sent; otherwise error code.
+**
+*******************************************************************************/
+extern tGATT_STATUS GATTS_FlushHandleValueNotifications (UINT16 conn_id);
+#endif  ///GATTS_NOTIF_BATCH_INCLUDED == TRUE
+
 
 /*******************************************************************************
 **
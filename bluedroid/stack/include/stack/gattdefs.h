@@ -54,6 +54,8 @@
 
 /* Attribute Profile Attribute UUID */
 #define GATT_UUID_GATT_SRV_CHGD          0x2A05
+#define GATT_UUID_CLIENT_SUP_FEAT        0x2B29
+#define GATT_UUID_GATT_DB_HASH           0x2B2A
 /* Attribute Protocol Test */
 
 /* Link Loss Service */
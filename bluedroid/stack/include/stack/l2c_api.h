@@ -56,6 +56,12 @@
 #define L2CAP_PRIORITY_NORMAL       0
 #define L2CAP_PRIORITY_HIGH         1
 
+/* Values for sched_class parameter to L2CA_SetAclSchedClass */
+#define L2CAP_ACL_CLASS_DEFAULT     0
+#define L2CAP_ACL_CLASS_MEDIA       1   /* A2DP streaming */
+#define L2CAP_ACL_CLASS_HID         2   /* Latency sensitive links, e.g. LE HID */
+#define L2CAP_ACL_CLASS_BULK        3   /* Throughput links that may wait, e.g. SPP */
+
 /* Values for priority parameter to L2CA_SetTxPriority */
 #define L2CAP_CHNL_PRIORITY_HIGH    0
 #define L2CAP_CHNL_PRIORITY_MEDIUM  1
@@ -726,6 +732,19 @@ extern UINT16   L2CA_FlushChannel (UINT16 lcid, UINT16 num_to_flush);
 *******************************************************************************/
 extern BOOLEAN L2CA_SetAclPriority (BD_ADDR bd_addr, UINT8 priority);
 
+/*******************************************************************************
+**
+** Function         L2CA_SetAclSchedClass
+**
+** Description      Sets the class the host schedules outbound data of an ACL
+**                  link with (L2CAP_ACL_CLASS_*). The class goes back to
+**                  L2CAP_ACL_CLASS_DEFAULT when the link is released.
+**
+** Returns          TRUE if a valid link, else FALSE
+**
+*******************************************************************************/
+extern BOOLEAN L2CA_SetAclSchedClass (BD_ADDR bd_addr, tBT_TRANSPORT transport, UINT8 sched_class);
+
 /*******************************************************************************
 **
 ** Function         L2CA_FlowControl
@@ -597,6 +597,7 @@ extern void     l2cu_update_lcb_4_bonding (BD_ADDR p_bd_addr, BOOLEAN is_bonding
 
 extern UINT8    l2cu_get_conn_role (tL2C_LCB *p_this_lcb);
 extern BOOLEAN  l2cu_set_acl_priority (BD_ADDR bd_addr, UINT8 priority, BOOLEAN reset_after_rs);
+extern BOOLEAN  l2cu_set_acl_sched_class (BD_ADDR bd_addr, tBT_TRANSPORT transport, UINT8 sched_class);
 
 extern void     l2cu_enqueue_ccb (tL2C_CCB *p_ccb);
 extern void     l2cu_dequeue_ccb (tL2C_CCB *p_ccb);
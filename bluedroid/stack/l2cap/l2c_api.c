@@ -972,6 +972,25 @@ BOOLEAN L2CA_SetAclPriority (BD_ADDR bd_addr, UINT8 priority)
     return (l2cu_set_acl_priority(bd_addr, priority, FALSE));
 }
 
+/*******************************************************************************
+**
+** Function         L2CA_SetAclSchedClass
+**
+** Description      Sets the class the host schedules outbound data of an ACL
+**                  link with (L2CAP_ACL_CLASS_*).
+**
+** Returns          TRUE if a valid link, else FALSE
+**
+*******************************************************************************/
+BOOLEAN L2CA_SetAclSchedClass (BD_ADDR bd_addr, tBT_TRANSPORT transport, UINT8 sched_class)
+{
+    L2CAP_TRACE_API ("L2CA_SetAclSchedClass()  bdaddr: %02x%02x%02x%02x%04x, transport:%d, class:%d",
+                     bd_addr[0], bd_addr[1], bd_addr[2],
+                     bd_addr[3], (bd_addr[4] << 8) + bd_addr[5], transport, sched_class);
+
+    return (l2cu_set_acl_sched_class(bd_addr, transport, sched_class));
+}
+
 /*******************************************************************************
 **
 ** Function         L2CA_FlowControl
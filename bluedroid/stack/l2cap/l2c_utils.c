@@ -133,6 +133,8 @@ void l2cu_release_lcb (tL2C_LCB *p_lcb)
     p_lcb->in_use     = FALSE;
     p_lcb->is_bonding = FALSE;
 
+    btm_acl_set_sched_class(p_lcb->handle, L2CAP_ACL_CLASS_DEFAULT);
+
     /* Stop and release timers */
     btu_free_timer (&p_lcb->timer_entry);
     memset(&p_lcb->timer_entry, 0, sizeof(TIMER_LIST_ENT));
@@ -2467,6 +2469,12 @@ BOOLEAN l2cu_set_acl_priority (BD_ADDR bd_addr, UINT8 priority, BOOLEAN reset_af
         return (FALSE);
     }
 
+    /* Let the HCI scheduler favour the link as well, whatever the controller */
+    if (!reset_after_rs) {
+        btm_acl_set_sched_class(p_lcb->handle, (priority == L2CAP_PRIORITY_HIGH) ?
+                                L2CAP_ACL_CLASS_MEDIA : L2CAP_ACL_CLASS_DEFAULT);
+    }
+
     if (BTM_IS_BRCM_CONTROLLER()) {
         /* Called from above L2CAP through API; send VSC if changed */
         if ((!reset_after_rs && (priority != p_lcb->acl_priority)) ||
@@ -2491,6 +2499,29 @@ BOOLEAN l2cu_set_acl_priority (BD_ADDR bd_addr, UINT8 priority, BOOLEAN reset_af
     return (TRUE);
 }
 
+/*******************************************************************************
+**
+** Function         l2cu_set_acl_sched_class
+**
+** Description      Sets the class the host schedules outbound data of an ACL
+**                  link with.
+**
+** Returns          TRUE if a valid link, else FALSE
+**
+*******************************************************************************/
+BOOLEAN l2cu_set_acl_sched_class (BD_ADDR bd_addr, tBT_TRANSPORT transport, UINT8 sched_class)
+{
+    tL2C_LCB *p_lcb;
+
+    if ((p_lcb = l2cu_find_lcb_by_bd_addr(bd_addr, transport)) == NULL) {
+        L2CAP_TRACE_WARNING ("L2CAP - no LCB for L2CA_SetAclSchedClass");
+        return (FALSE);
+    }
+
+    btm_acl_set_sched_class(p_lcb->handle, sched_class);
+    return (TRUE);
+}
+
 #if (L2CAP_NON_FLUSHABLE_PB_INCLUDED == TRUE)
 /******************************************************************************
 **
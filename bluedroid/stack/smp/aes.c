@@ -58,6 +58,11 @@
 #  define USE_TABLES
 #endif
 
+/* define to encrypt with a table of 32-bit round words (needs the tables) */
+#if defined( USE_TABLES ) && defined( HAVE_UINT_32T ) && (SMP_AES_TTABLE == TRUE)
+#  define USE_T_TABLE
+#endif
+
 /*  On Intel Core 2 duo VERSION_1 is faster */
 
 /* alternative versions (test for performance on your system) */
@@ -205,6 +210,13 @@ static const uint_8t gfmul_b[256] = mm_data(fb);
 static const uint_8t gfmul_d[256] = mm_data(fd);
 static const uint_8t gfmul_e[256] = mm_data(fe);
 
+#if defined( USE_T_TABLE )
+/* SubBytes and MixColumns of one byte as a column word, row 0 in the low byte */
+#define t_w(x)  ((uint_32t)f2(x) | ((uint_32t)(x) << 8) | ((uint_32t)(x) << 16) | ((uint_32t)f3(x) << 24))
+
+static const uint_32t t_fn[256] = sb_data(t_w);
+#endif
+
 #define s_box(x)     sbox[(x)]
 #define is_box(x)    isbox[(x)]
 #define gfm2_sb(x)   gfm2_sbox[(x)]
@@ -501,6 +513,66 @@ static void inv_mix_sub_columns( uint_8t dt[N_BLOCK], uint_8t st[N_BLOCK] )
     dt[11] = is_box(gfm_b(st[12]) ^ gfm_d(st[13]) ^ gfm_9(st[14]) ^ gfm_e(st[15]));
 }
 
+#if defined( USE_T_TABLE )
+
+#define rot_8(x)    (((x) << 8) | ((x) >> 24))
+#define rot_16(x)   (((x) << 16) | ((x) >> 16))
+#define rot_24(x)   (((x) << 24) | ((x) >> 8))
+
+/* columns are loaded byte by byte, so any alignment and byte order works */
+#define word_in(p, c)   ((uint_32t)(p)[4 * (c)] | ((uint_32t)(p)[4 * (c) + 1] << 8) \
+                         | ((uint_32t)(p)[4 * (c) + 2] << 16) | ((uint_32t)(p)[4 * (c) + 3] << 24))
+
+#define word_out(p, c, w) { (p)[4 * (c)] = (uint_8t)(w); (p)[4 * (c) + 1] = (uint_8t)((w) >> 8); \
+                            (p)[4 * (c) + 2] = (uint_8t)((w) >> 16); (p)[4 * (c) + 3] = (uint_8t)((w) >> 24); }
+
+/* one full round for an output column, x0 .. x3 are the columns ShiftRows takes rows 0 .. 3 from */
+#define t_round(x0, x1, x2, x3, k) \
+    (t_fn[(x0) & 0xff] ^ rot_8(t_fn[((x1) >> 8) & 0xff]) \
+     ^ rot_16(t_fn[((x2) >> 16) & 0xff]) ^ rot_24(t_fn[(x3) >> 24]) ^ (k))
+
+/* the last round has no MixColumns */
+#define t_last(x0, x1, x2, x3, k) \
+    (((uint_32t)s_box((x0) & 0xff) | ((uint_32t)s_box(((x1) >> 8) & 0xff) << 8) \
+      | ((uint_32t)s_box(((x2) >> 16) & 0xff) << 16) | ((uint_32t)s_box((x3) >> 24) << 24)) ^ (k))
+
+/*  Encrypt a single block of 16 bytes with a key schedule of rnd rounds */
+
+static void encrypt_t_table( const uint_8t in[N_BLOCK], uint_8t out[N_BLOCK], const uint_8t *ksch, uint_8t rnd )
+{
+    uint_32t s0, s1, s2, s3, t0, t1, t2, t3;
+    uint_8t r;
+
+    s0 = word_in(in, 0) ^ word_in(ksch, 0);
+    s1 = word_in(in, 1) ^ word_in(ksch, 1);
+    s2 = word_in(in, 2) ^ word_in(ksch, 2);
+    s3 = word_in(in, 3) ^ word_in(ksch, 3);
+
+    for ( r = 1 ; r < rnd ; ++r ) {
+        ksch += N_BLOCK;
+        t0 = t_round(s0, s1, s2, s3, word_in(ksch, 0));
+        t1 = t_round(s1, s2, s3, s0, word_in(ksch, 1));
+        t2 = t_round(s2, s3, s0, s1, word_in(ksch, 2));
+        t3 = t_round(s3, s0, s1, s2, word_in(ksch, 3));
+        s0 = t0;
+        s1 = t1;
+        s2 = t2;
+        s3 = t3;
+    }
+
+    ksch += N_BLOCK;
+    t0 = t_last(s0, s1, s2, s3, word_in(ksch, 0));
+    t1 = t_last(s1, s2, s3, s0, word_in(ksch, 1));
+    t2 = t_last(s2, s3, s0, s1, word_in(ksch, 2));
+    t3 = t_last(s3, s0, s1, s2, word_in(ksch, 3));
+    word_out(out, 0, t0);
+    word_out(out, 1, t1);
+    word_out(out, 2, t2);
+    word_out(out, 3, t3);
+}
+
+#endif
+
 #if defined( AES_ENC_PREKEYED ) || defined( AES_DEC_PREKEYED )
 
 /*  Set the cipher key for the pre-keyed version */
@@ -572,6 +644,13 @@ return_type bt_aes_set_key( const unsigned char key[], length_type keylen, aes_c
 /* @breif change the name by snake for avoid the conflict with libcrypto */
 return_type bluedroid_aes_encrypt( const unsigned char in[N_BLOCK], unsigned char  out[N_BLOCK], const aes_context ctx[1] )
 {
+#if defined( USE_T_TABLE )
+    if ( ctx->rnd ) {
+        encrypt_t_table( in, out, ctx->ksch, ctx->rnd );
+    } else {
+        return (return_type) - 1;
+    }
+#else
     if ( ctx->rnd ) {
         uint_8t s1[N_BLOCK], r;
         copy_and_key( s1, in, ctx->ksch );
@@ -594,6 +673,7 @@ return_type bluedroid_aes_encrypt( const unsigned char in[N_BLOCK], unsigned cha
     } else {
         return (return_type) - 1;
     }
+#endif
     return 0;
 }
 
@@ -672,6 +752,7 @@ return_type aes_cbc_decrypt( const unsigned char *in, unsigned char *out,
 
 #if defined( AES_ENC_128_OTFK )
 
+#if !defined( USE_T_TABLE )
 /*  The 'on the fly' encryption key update for for 128 bit keys */
 
 static void update_encrypt_key_128( uint_8t k[N_BLOCK], uint_8t *rc )
@@ -691,12 +772,63 @@ static void update_encrypt_key_128( uint_8t k[N_BLOCK], uint_8t *rc )
         k[cc + 3] ^= k[cc - 1];
     }
 }
+#else
+/*  The 'on the fly' key update on column words */
+#define update_key_words_128(k0, k1, k2, k3, rc) {                                             \
+    k0 ^= ((uint_32t)s_box(((k3) >> 8) & 0xff) | ((uint_32t)s_box(((k3) >> 16) & 0xff) << 8)  \
+           | ((uint_32t)s_box((k3) >> 24) << 16) | ((uint_32t)s_box((k3) & 0xff) << 24)) ^ (rc); \
+    k1 ^= k0;                                                                                 \
+    k2 ^= k1;                                                                                 \
+    k3 ^= k2;                                                                                 \
+    rc = f2(rc);                                                                              \
+}
+#endif
 
 /*  Encrypt a single block of 16 bytes with 'on the fly' 128 bit keying */
 
 void bluedroid_aes_encrypt_128( const unsigned char in[N_BLOCK], unsigned char out[N_BLOCK],
                                 const unsigned char key[N_BLOCK], unsigned char o_key[N_BLOCK] )
 {
+#if defined( USE_T_TABLE )
+    uint_32t s0, s1, s2, s3, t0, t1, t2, t3;
+    uint_32t k0, k1, k2, k3;
+    uint_8t r, rc = 1;
+
+    k0 = word_in(key, 0);
+    k1 = word_in(key, 1);
+    k2 = word_in(key, 2);
+    k3 = word_in(key, 3);
+    s0 = word_in(in, 0) ^ k0;
+    s1 = word_in(in, 1) ^ k1;
+    s2 = word_in(in, 2) ^ k2;
+    s3 = word_in(in, 3) ^ k3;
+
+    for ( r = 1 ; r < 10 ; ++r ) {
+        update_key_words_128(k0, k1, k2, k3, rc);
+        t0 = t_round(s0, s1, s2, s3, k0);
+        t1 = t_round(s1, s2, s3, s0, k1);
+        t2 = t_round(s2, s3, s0, s1, k2);
+        t3 = t_round(s3, s0, s1, s2, k3);
+        s0 = t0;
+        s1 = t1;
+        s2 = t2;
+        s3 = t3;
+    }
+
+    update_key_words_128(k0, k1, k2, k3, rc);
+    t0 = t_last(s0, s1, s2, s3, k0);
+    t1 = t_last(s1, s2, s3, s0, k1);
+    t2 = t_last(s2, s3, s0, s1, k2);
+    t3 = t_last(s3, s0, s1, s2, k3);
+    word_out(out, 0, t0);
+    word_out(out, 1, t1);
+    word_out(out, 2, t2);
+    word_out(out, 3, t3);
+    word_out(o_key, 0, k0);
+    word_out(o_key, 1, k1);
+    word_out(o_key, 2, k2);
+    word_out(o_key, 3, k3);
+#else
     uint_8t s1[N_BLOCK], r, rc = 1;
 
     if (o_key != key) {
@@ -723,6 +855,7 @@ void bluedroid_aes_encrypt_128( const unsigned char in[N_BLOCK], unsigned char o
     shift_sub_rows( s1 );
     update_encrypt_key_128( o_key, &rc );
     copy_and_key( out, s1, o_key );
+#endif
 }
 
 #endif
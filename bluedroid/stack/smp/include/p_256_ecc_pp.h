@@ -26,8 +26,6 @@
 
 #include "p_256_multprecision.h"
 
-typedef unsigned long  DWORD;
-
 typedef struct {
     DWORD x[KEY_LENGTH_DWORDS_P256];
     DWORD y[KEY_LENGTH_DWORDS_P256];
@@ -53,14 +51,33 @@ typedef struct {
 
 } elliptic_curve_t;
 
+// affine point with 32-bit limbs, least significant limb first
+typedef struct {
+    uint32_t x[KEY_LENGTH_DWORDS_P256];
+    uint32_t y[KEY_LENGTH_DWORDS_P256];
+} affine_point_t;
+
+// fixed-base comb for G: P256_COMB_TEETH teeth spaced P256_COMB_SPACING bits apart
+#define P256_COMB_TEETH     5
+#define P256_COMB_SPACING   52
+#define P256_COMB_POINTS    ((1 << P256_COMB_TEETH) - 1)
+
 extern elliptic_curve_t curve;
 extern elliptic_curve_t curve_p256;
+extern const affine_point_t p_256_comb_table[P256_COMB_POINTS];
 
 void ECC_PointMult_Bin_NAF(Point *q, Point *p, DWORD *n, uint32_t keyLength);
 
+// q = n * p on P-256, window NAF on Jacobian coordinates
+void ECC_PointMult_P256(Point *q, Point *p, DWORD *n);
+
+// q = n * G on P-256, with the fixed-base comb table when it is built in
+void ECC_PointMult_Base_P256(Point *q, DWORD *n);
+
 bool ECC_CheckPointIsInElliCur_P256(Point *p);
 
-#define ECC_PointMult(q, p, n, keyLength)  ECC_PointMult_Bin_NAF(q, p, n, keyLength)
+// P-256 goes to the dedicated engine, other lengths to the generic binary NAF
+void ECC_PointMult(Point *q, Point *p, DWORD *n, uint32_t keyLength);
 
 void p_256_init_curve(UINT32 keyLength);
 
@@ -26,7 +26,9 @@
 #include "stack/bt_types.h"
 
 /* Type definitions */
-typedef unsigned long  DWORD;
+/* Keys are handled as arrays of DWORD, so DWORD has to be exactly 32 bits,
+   also on LP64 hosts */
+typedef uint32_t  DWORD;
 
 #define DWORD_BITS      32
 #define DWORD_BYTES     4
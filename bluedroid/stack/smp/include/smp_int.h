@@ -30,6 +30,7 @@
 #include "stack/btm_ble_api.h"
 #include "stack/btm_api.h"
 #include "stack/smp_api.h"
+#include "aes.h"
 
 #define SMP_MODEL_ENCRYPTION_ONLY  0   /* Legacy mode, Just Works model */
 #define SMP_MODEL_PASSKEY       1   /* Legacy mode, Passkey Entry model, this side inputs the key */
@@ -338,6 +339,7 @@ typedef struct {
     UINT32          static_passkey;
     BOOLEAN         accept_specified_sec_auth;
     tSMP_AUTH_REQ   origin_loc_auth_req;
+    UINT32          ecc_seq;     /* sequence number of the ECC job the pairing waits for, 0 if none */
 } tSMP_CB;
 
 /* Server Action functions are of this type */
@@ -440,6 +442,7 @@ extern void smp_generate_csrk(tSMP_CB *p_cb, tSMP_INT_DATA *p_data);
 extern void smp_fast_conn_param(tSMP_CB *p_cb, tSMP_INT_DATA *p_data);
 extern void smp_key_pick_key(tSMP_CB *p_cb, tSMP_INT_DATA *p_data);
 extern void smp_both_have_public_keys(tSMP_CB *p_cb, tSMP_INT_DATA *p_data);
+extern void smp_dhkey_computed(tSMP_CB *p_cb);
 extern void smp_start_secure_connection_phase1(tSMP_CB *p_cb, tSMP_INT_DATA *p_data);
 extern void smp_process_local_nonce(tSMP_CB *p_cb, tSMP_INT_DATA *p_data);
 extern void smp_process_pairing_commitment(tSMP_CB *p_cb, tSMP_INT_DATA *p_data);
@@ -532,7 +535,42 @@ extern void smp_debug_print_nbyte_little_endian (UINT8 *p, const UINT8 *key_name
         UINT8 len);
 #endif
 
+/* smp_ecc.c */
+#define SMP_ECC_OP_KEY_PAIR     0       /* public key := private_key * G */
+#define SMP_ECC_OP_DHKEY        1       /* DHKey := x of private_key * peer public key */
+typedef UINT8 tSMP_ECC_OP;
+
+typedef struct smp_ecc_job tSMP_ECC_JOB;
+typedef void (tSMP_ECC_CBACK)(tSMP_ECC_JOB *p_job);
+
+struct smp_ecc_job {
+    tSMP_ECC_OP     op;
+    UINT32          seq;                /* set by smp_ecc_submit */
+    tSMP_ECC_CBACK  *p_cback;           /* called in BTU task with the result */
+    BT_OCTET32      private_key;
+    tSMP_PUBLIC_KEY publ_key;           /* in: peer key for DHKEY, out: result */
+};
+
+extern void smp_ecc_init(void);
+extern void smp_ecc_free(void);
+extern void smp_ecc_compute(tSMP_ECC_JOB *p_job);
+extern BOOLEAN smp_ecc_submit(tSMP_ECC_JOB *p_job);
+extern void smp_ecc_job_cmpl(tSMP_ECC_JOB *p_job);
+extern void smp_ecc_precompute_key_pair(void);
+extern BOOLEAN smp_ecc_take_key_pair(BT_OCTET32 private_key, tSMP_PUBLIC_KEY *p_publ_key);
+
 /* smp_cmac.c */
+/* streaming AES-CMAC state, all blocks in big endian (RFC 4493) byte order */
+typedef struct {
+    aes_context     aes;                    /* expanded key schedule */
+    UINT8           x[BT_OCTET16_LEN];      /* chaining value */
+    UINT8           buf[BT_OCTET16_LEN];    /* pending block, may be the last one */
+    UINT8           buf_len;
+} tSMP_CMAC_CTX;
+
+extern void smp_cmac_init(tSMP_CMAC_CTX *p_ctx, const UINT8 *key);
+extern void smp_cmac_update(tSMP_CMAC_CTX *p_ctx, const UINT8 *p_data, UINT16 len);
+extern void smp_cmac_final(tSMP_CMAC_CTX *p_ctx, UINT8 *p_mac);
 extern BOOLEAN aes_cipher_msg_auth_code(BT_OCTET16 key, UINT8 *input, UINT16 length,
                                         UINT16 tlen, UINT8 *p_signature);
 extern void print128(BT_OCTET16 x, const UINT8 *key_name);
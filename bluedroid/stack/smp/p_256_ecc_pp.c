@@ -24,6 +24,7 @@
 //#include <stdio.h>
 //#include <stdlib.h>
 #include <string.h>
+#include "common/bt_target.h"
 #include "p_256_ecc_pp.h"
 #include "p_256_multprecision.h"
 
@@ -240,40 +241,629 @@ void ECC_PointMult_Bin_NAF(Point *q, Point *p, DWORD *n, uint32_t keyLength)
     multiprecision_mersenns_mult_mod(q->y, q->y, q->z, keyLength);
 }
 
-bool ECC_CheckPointIsInElliCur_P256(Point *p)
+/*
+ * Dedicated P-256 engine. Field elements are 8 x 32-bit limbs, least
+ * significant first, always fully reduced modulo p. Points are kept in
+ * Jacobian coordinates (X, Y, Z) <-> (X / Z^2, Y / Z^3), Z == 0 being the
+ * point at infinity, and only converted to affine at the end.
+ */
+#define P256_LIMBS          KEY_LENGTH_DWORDS_P256
+#define P256_WNAF_WIDTH     5
+#define P256_WNAF_POINTS    (1 << (P256_WNAF_WIDTH - 2))    // P, 3P, ..., 15P
+
+typedef uint32_t p256_fe[P256_LIMBS];
+
+typedef struct {
+    p256_fe x;
+    p256_fe y;
+    p256_fe z;
+} p256_jacobian_t;
+
+static const p256_fe p256_p = {
+    0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0x00000000,
+    0x00000000, 0x00000000, 0x00000001, 0xFFFFFFFF
+};
+
+static const p256_fe p256_b = {
+    0x27d2604b, 0x3bce3c3e, 0xcc53b0f6, 0x651d06b0,
+    0x769886bc, 0xb3ebbd55, 0xaa3a93e7, 0x5ac635d8
+};
+
+#if (SMP_P256_COMB_TABLE != TRUE)
+static const affine_point_t p256_g = {
+    {
+        0xd898c296, 0xf4a13945, 0x2deb33a0, 0x77037d81,
+        0x63a440f2, 0xf8bce6e5, 0xe12c4247, 0x6b17d1f2
+    },
+    {
+        0x37bf51f5, 0xcbb64068, 0x6b315ece, 0x2bce3357,
+        0x7c0f9e16, 0x8ee7eb4a, 0xfe1a7f9b, 0x4fe342e2
+    }
+};
+#endif
+
+static int p256_fe_is_zero(const p256_fe a)
 {
-    /* y^2 % q */
-    DWORD y_y_q[KEY_LENGTH_DWORDS_P256] = {0x0};
-    /* x^2 % q */
-    DWORD x_x_q[KEY_LENGTH_DWORDS_P256] = {0x0};
-    /* x % q */
-    DWORD x_q[KEY_LENGTH_DWORDS_P256] = {0x0};
-    /* x^2, To prevent overflow, the length of the x square here needs to 
-       be expanded to two times the original one. */
-    DWORD x_x[2*KEY_LENGTH_DWORDS_P256] = {0x0};
-    /* y_y_q =(p->y)^2(mod q) */
-    multiprecision_mersenns_squa_mod(y_y_q, p->y, KEY_LENGTH_DWORDS_P256);
-    /* Calculate the value of p->x square, x_x = (p->x)^2 */
-    multiprecision_mult(x_x, p->x, p->x, KEY_LENGTH_DWORDS_P256);
-    /* The function of the elliptic curve is y^2 = x^3 - 3x + b (mod q) ==>
-       y^2 = (x^2 - 3)*x + b (mod q),
-       so we calculate the x^2 - 3 value here */
-    x_x[0] -= 3;
-    /* Using math relations. (a*b) % q = ((a%q)*(b%q)) % q ==> 
-      (x^2 - 3)*x = (((x^2 - 3) % q) * x % q) % q */
-    multiprecision_fast_mod_P256(x_x_q, x_x);
-    /* x_x = x_x_q * x_q */
-    multiprecision_mult(x_x, x_x_q, p->x, KEY_LENGTH_DWORDS_P256);
-    /* x_q = x_x % q */
-    multiprecision_fast_mod_P256(x_q, x_x);
-    /* Save the result in x_x_q */
-    multiprecision_add_mod(x_x_q, x_q, curve_p256.b, KEY_LENGTH_DWORDS_P256);
-    /* compare the y_y_q and x_x_q, see if they are on a given elliptic curve. */
-    if (multiprecision_compare(y_y_q, x_x_q, KEY_LENGTH_DWORDS_P256)) {
-        return false;
+    uint32_t d = 0;
+
+    for (int i = 0; i < P256_LIMBS; i++) {
+        d |= a[i];
+    }
+    return d == 0;
+}
+
+// returns a >= p
+static int p256_fe_ge_p(const p256_fe a)
+{
+    for (int i = P256_LIMBS - 1; i >= 0; i--) {
+        if (a[i] != p256_p[i]) {
+            return a[i] > p256_p[i];
+        }
+    }
+    return 1;
+}
+
+static uint32_t p256_add_p(p256_fe r)
+{
+    uint64_t c = 0;
+
+    for (int i = 0; i < P256_LIMBS; i++) {
+        c += (uint64_t)r[i] + p256_p[i];
+        r[i] = (uint32_t)c;
+        c >>= 32;
+    }
+    return (uint32_t)c;
+}
+
+static uint32_t p256_sub_p(p256_fe r)
+{
+    int64_t c = 0;
+
+    for (int i = 0; i < P256_LIMBS; i++) {
+        c += (int64_t)r[i] - p256_p[i];
+        r[i] = (uint32_t)c;
+        c >>= 32;
+    }
+    return (uint32_t)(c & 1);   // borrow
+}
+
+// r = a + b mod p
+static void p256_fe_add(p256_fe r, const p256_fe a, const p256_fe b)
+{
+    uint64_t c = 0;
+
+    for (int i = 0; i < P256_LIMBS; i++) {
+        c += (uint64_t)a[i] + b[i];
+        r[i] = (uint32_t)c;
+        c >>= 32;
+    }
+
+    if (c || p256_fe_ge_p(r)) {
+        p256_sub_p(r);
+    }
+}
+
+// r = a - b mod p
+static void p256_fe_sub(p256_fe r, const p256_fe a, const p256_fe b)
+{
+    int64_t c = 0;
+
+    for (int i = 0; i < P256_LIMBS; i++) {
+        c += (int64_t)a[i] - b[i];
+        r[i] = (uint32_t)c;
+        c >>= 32;
+    }
+
+    if (c) {
+        p256_add_p(r);
+    }
+}
+
+// r = 2a mod p
+static void p256_fe_dbl(p256_fe r, const p256_fe a)
+{
+    p256_fe_add(r, a, a);
+}
+
+// Solinas reduction of a 512-bit product t, see FIPS 186-4 D.2.3 (r = t mod p)
+static void p256_fe_reduce(p256_fe r, const uint32_t t[2 * P256_LIMBS])
+{
+    int64_t c;
+    int32_t carry;
+
+    c  = (int64_t)t[0] + t[8] + t[9] - t[11] - t[12] - t[13] - t[14];
+    r[0] = (uint32_t)c;
+    c >>= 32;
+    c += (int64_t)t[1] + t[9] + t[10] - t[12] - t[13] - t[14] - t[15];
+    r[1] = (uint32_t)c;
+    c >>= 32;
+    c += (int64_t)t[2] + t[10] + t[11] - t[13] - t[14] - t[15];
+    r[2] = (uint32_t)c;
+    c >>= 32;
+    c += (int64_t)t[3] + 2 * ((int64_t)t[11] + t[12]) + t[13] - t[15] - t[8] - t[9];
+    r[3] = (uint32_t)c;
+    c >>= 32;
+    c += (int64_t)t[4] + 2 * ((int64_t)t[12] + t[13]) + t[14] - t[9] - t[10];
+    r[4] = (uint32_t)c;
+    c >>= 32;
+    c += (int64_t)t[5] + 2 * ((int64_t)t[13] + t[14]) + t[15] - t[10] - t[11];
+    r[5] = (uint32_t)c;
+    c >>= 32;
+    c += (int64_t)t[6] + 3 * (int64_t)t[14] + 2 * (int64_t)t[15] + t[13] - t[8] - t[9];
+    r[6] = (uint32_t)c;
+    c >>= 32;
+    c += (int64_t)t[7] + 3 * (int64_t)t[15] + t[8] - t[10] - t[11] - t[12] - t[13];
+    r[7] = (uint32_t)c;
+    carry = (int32_t)(c >> 32);
+
+    // the value is r + carry * 2^256, with a small carry
+    while (carry < 0) {
+        carry += p256_add_p(r);
+    }
+    while (carry > 0) {
+        carry -= p256_sub_p(r);
+    }
+    if (p256_fe_ge_p(r)) {
+        p256_sub_p(r);
+    }
+}
+
+// r = a * b mod p
+static void p256_fe_mul(p256_fe r, const p256_fe a, const p256_fe b)
+{
+    uint32_t t[2 * P256_LIMBS];
+    uint64_t c;
+
+    for (int i = 0; i < P256_LIMBS; i++) {
+        t[i] = 0;
+    }
+
+    for (int i = 0; i < P256_LIMBS; i++) {
+        c = 0;
+        for (int j = 0; j < P256_LIMBS; j++) {
+            c += (uint64_t)a[i] * b[j] + t[i + j];
+            t[i + j] = (uint32_t)c;
+            c >>= 32;
+        }
+        t[i + P256_LIMBS] = (uint32_t)c;
+    }
+
+    p256_fe_reduce(r, t);
+}
+
+// r = a^2 mod p, computing each cross product once
+static void p256_fe_sqr(p256_fe r, const p256_fe a)
+{
+    uint32_t t[2 * P256_LIMBS];
+    uint64_t c;
+    uint32_t hi;
+
+    for (int i = 0; i < 2 * P256_LIMBS; i++) {
+        t[i] = 0;
+    }
+
+    // sum of a[i] * a[j] for i < j
+    for (int i = 0; i < P256_LIMBS - 1; i++) {
+        c = 0;
+        for (int j = i + 1; j < P256_LIMBS; j++) {
+            c += (uint64_t)a[i] * a[j] + t[i + j];
+            t[i + j] = (uint32_t)c;
+            c >>= 32;
+        }
+        t[i + P256_LIMBS] = (uint32_t)c;
+    }
+
+    // double it and add the squares
+    hi = 0;
+    c = 0;
+    for (int i = 0; i < P256_LIMBS; i++) {
+        uint64_t sq = (uint64_t)a[i] * a[i];
+        uint32_t lo2 = (t[2 * i] << 1) | hi;
+        uint32_t hi2 = (t[2 * i + 1] << 1) | (t[2 * i] >> 31);
+
+        hi = t[2 * i + 1] >> 31;
+        c += (uint64_t)lo2 + (uint32_t)sq;
+        t[2 * i] = (uint32_t)c;
+        c >>= 32;
+        c += (uint64_t)hi2 + (uint32_t)(sq >> 32);
+        t[2 * i + 1] = (uint32_t)c;
+        c >>= 32;
+    }
+
+    p256_fe_reduce(r, t);
+}
+
+// r = a^(2^n) mod p
+static void p256_fe_sqr_n(p256_fe r, const p256_fe a, int n)
+{
+    p256_fe_sqr(r, a);
+    while (--n > 0) {
+        p256_fe_sqr(r, r);
+    }
+}
+
+// r = a^-1 = a^(p-2) mod p, p - 2 = ffffffff 00000001 00000000 00000000 00000000 ffffffff ffffffff fffffffd
+static void p256_fe_inv(p256_fe r, const p256_fe a)
+{
+    p256_fe x2, x3, x6, x12, x15, x30, x32, t;
+
+    p256_fe_sqr(t, a);
+    p256_fe_mul(x2, t, a);              // 2^2 - 1
+    p256_fe_sqr(t, x2);
+    p256_fe_mul(x3, t, a);              // 2^3 - 1
+    p256_fe_sqr_n(t, x3, 3);
+    p256_fe_mul(x6, t, x3);             // 2^6 - 1
+    p256_fe_sqr_n(t, x6, 6);
+    p256_fe_mul(x12, t, x6);            // 2^12 - 1
+    p256_fe_sqr_n(t, x12, 3);
+    p256_fe_mul(x15, t, x3);            // 2^15 - 1
+    p256_fe_sqr_n(t, x15, 15);
+    p256_fe_mul(x30, t, x15);           // 2^30 - 1
+    p256_fe_sqr_n(t, x30, 2);
+    p256_fe_mul(x32, t, x2);            // 2^32 - 1
+
+    p256_fe_sqr_n(t, x32, 32);
+    p256_fe_mul(t, t, a);               // ffffffff 00000001
+    p256_fe_sqr_n(t, t, 128);
+    p256_fe_mul(t, t, x32);             // ... 00000000 00000000 00000000 ffffffff
+    p256_fe_sqr_n(t, t, 32);
+    p256_fe_mul(t, t, x32);             // ... ffffffff
+    p256_fe_sqr_n(t, t, 30);
+    p256_fe_mul(t, t, x30);
+    p256_fe_sqr_n(t, t, 2);
+    p256_fe_mul(r, t, a);               // ... fffffffd
+}
+
+static void p256_from_dwords(p256_fe r, const DWORD *a)
+{
+    for (int i = 0; i < P256_LIMBS; i++) {
+        r[i] = (uint32_t)a[i];
+    }
+}
+
+static void p256_to_dwords(DWORD *r, const p256_fe a)
+{
+    for (int i = 0; i < P256_LIMBS; i++) {
+        r[i] = a[i];
+    }
+}
+
+// r = 2p, a = -3 (dbl-2001-b: 3M + 5S)
+static void p256_point_double(p256_jacobian_t *r, const p256_jacobian_t *p)
+{
+    p256_fe delta, gamma, beta, alpha, t1, t2;
+
+    if (p256_fe_is_zero(p->z)) {
+        *r = *p;
+        return;
+    }
+
+    p256_fe_sqr(delta, p->z);
+    p256_fe_sqr(gamma, p->y);
+    p256_fe_mul(beta, p->x, gamma);
+
+    p256_fe_sub(t1, p->x, delta);
+    p256_fe_add(t2, p->x, delta);
+    p256_fe_mul(alpha, t1, t2);
+    p256_fe_dbl(t1, alpha);
+    p256_fe_add(alpha, alpha, t1);          // alpha = 3 (x - delta)(x + delta)
+
+    p256_fe_add(t1, p->y, p->z);
+    p256_fe_sqr(t1, t1);
+    p256_fe_sub(t1, t1, gamma);
+    p256_fe_sub(r->z, t1, delta);           // z3 = (y + z)^2 - gamma - delta
+
+    p256_fe_dbl(beta, beta);
+    p256_fe_dbl(beta, beta);                // 4 beta
+    p256_fe_sqr(t1, alpha);
+    p256_fe_dbl(t2, beta);
+    p256_fe_sub(r->x, t1, t2);              // x3 = alpha^2 - 8 beta
+
+    p256_fe_sub(t1, beta, r->x);
+    p256_fe_mul(t1, alpha, t1);
+    p256_fe_sqr(gamma, gamma);
+    p256_fe_dbl(gamma, gamma);
+    p256_fe_dbl(gamma, gamma);
+    p256_fe_dbl(gamma, gamma);              // 8 gamma^2
+    p256_fe_sub(r->y, t1, gamma);           // y3 = alpha (4 beta - x3) - 8 gamma^2
+}
+
+#if (SMP_P256_COMB_TABLE == TRUE)
+// r = p + q, q affine (madd-2007-bl: 7M + 4S). r may alias p.
+static void p256_point_add_affine(p256_jacobian_t *r, const p256_jacobian_t *p,
+                                  const uint32_t *qx, const uint32_t *qy)
+{
+    p256_fe z1z1, u2, s2, h, hh, i, j, rr, v, t;
+
+    if (p256_fe_is_zero(p->z)) {
+        memcpy(r->x, qx, sizeof(p256_fe));
+        memcpy(r->y, qy, sizeof(p256_fe));
+        memset(r->z, 0, sizeof(p256_fe));
+        r->z[0] = 1;
+        return;
+    }
+
+    p256_fe_sqr(z1z1, p->z);
+    p256_fe_mul(u2, qx, z1z1);
+    p256_fe_mul(s2, p->z, z1z1);
+    p256_fe_mul(s2, qy, s2);
+    p256_fe_sub(h, u2, p->x);
+    p256_fe_sub(rr, s2, p->y);
+
+    if (p256_fe_is_zero(h)) {
+        if (p256_fe_is_zero(rr)) {
+            p256_point_double(r, p);
+        } else {
+            memset(r, 0, sizeof(p256_jacobian_t));  // p = -q
+        }
+        return;
+    }
+
+    p256_fe_sqr(hh, h);
+    p256_fe_dbl(i, hh);
+    p256_fe_dbl(i, i);                      // I = 4 HH
+    p256_fe_mul(j, h, i);
+    p256_fe_dbl(rr, rr);
+    p256_fe_mul(v, p->x, i);
+
+    p256_fe_add(t, p->z, h);
+    p256_fe_sqr(t, t);
+    p256_fe_sub(t, t, z1z1);
+    p256_fe_sub(r->z, t, hh);               // z3 = (z1 + h)^2 - z1z1 - hh
+
+    p256_fe_mul(t, p->y, j);
+    p256_fe_dbl(t, t);                      // 2 y1 J
+
+    p256_fe_sqr(i, rr);
+    p256_fe_sub(i, i, j);
+    p256_fe_sub(i, i, v);
+    p256_fe_sub(r->x, i, v);                // x3 = r^2 - J - 2V
+
+    p256_fe_sub(v, v, r->x);
+    p256_fe_mul(v, rr, v);
+    p256_fe_sub(r->y, v, t);                // y3 = r (V - x3) - 2 y1 J
+}
+#endif
+
+// r = p + q (add-2007-bl: 11M + 5S). r may alias p.
+static void p256_point_add(p256_jacobian_t *r, const p256_jacobian_t *p, const p256_jacobian_t *q)
+{
+    p256_fe z1z1, z2z2, u1, u2, s1, s2, h, i, j, rr, v, t;
+
+    if (p256_fe_is_zero(q->z)) {
+        *r = *p;
+        return;
+    }
+    if (p256_fe_is_zero(p->z)) {
+        *r = *q;
+        return;
+    }
+
+    p256_fe_sqr(z1z1, p->z);
+    p256_fe_sqr(z2z2, q->z);
+    p256_fe_mul(u1, p->x, z2z2);
+    p256_fe_mul(u2, q->x, z1z1);
+    p256_fe_mul(s1, q->z, z2z2);
+    p256_fe_mul(s1, p->y, s1);
+    p256_fe_mul(s2, p->z, z1z1);
+    p256_fe_mul(s2, q->y, s2);
+    p256_fe_sub(h, u2, u1);
+    p256_fe_sub(rr, s2, s1);
+
+    if (p256_fe_is_zero(h)) {
+        if (p256_fe_is_zero(rr)) {
+            p256_point_double(r, p);
+        } else {
+            memset(r, 0, sizeof(p256_jacobian_t));
+        }
+        return;
+    }
+
+    p256_fe_dbl(i, h);
+    p256_fe_sqr(i, i);                      // I = (2H)^2
+    p256_fe_mul(j, h, i);
+    p256_fe_dbl(rr, rr);
+    p256_fe_mul(v, u1, i);
+
+    p256_fe_add(t, p->z, q->z);
+    p256_fe_sqr(t, t);
+    p256_fe_sub(t, t, z1z1);
+    p256_fe_sub(t, t, z2z2);
+    p256_fe_mul(r->z, t, h);                // z3 = ((z1 + z2)^2 - z1z1 - z2z2) H
+
+    p256_fe_mul(s1, s1, j);
+    p256_fe_dbl(s1, s1);                    // 2 S1 J
+
+    p256_fe_sqr(t, rr);
+    p256_fe_sub(t, t, j);
+    p256_fe_sub(t, t, v);
+    p256_fe_sub(r->x, t, v);                // x3 = r^2 - J - 2V
+
+    p256_fe_sub(v, v, r->x);
+    p256_fe_mul(v, rr, v);
+    p256_fe_sub(r->y, v, s1);               // y3 = r (V - x3) - 2 S1 J
+}
+
+// q = affine(p); the point at infinity is returned as (0, 0)
+static void p256_point_to_affine(Point *q, const p256_jacobian_t *p)
+{
+    p256_fe zinv, zinv2, t;
+
+    memset(q, 0, sizeof(Point));
+    if (p256_fe_is_zero(p->z)) {
+        return;
+    }
+
+    p256_fe_inv(zinv, p->z);
+    p256_fe_sqr(zinv2, zinv);
+    p256_fe_mul(t, p->x, zinv2);
+    p256_to_dwords(q->x, t);
+    p256_fe_mul(zinv2, zinv2, zinv);
+    p256_fe_mul(t, p->y, zinv2);
+    p256_to_dwords(q->y, t);
+    q->z[0] = 1;
+}
+
+// width-w NAF of the scalar, least significant digit first; returns the number of digits
+static int p256_wnaf(int8_t *naf, const DWORD *n)
+{
+    uint32_t k[P256_LIMBS + 1];
+    int len = 0;
+    int digit;
+
+    p256_from_dwords(k, n);
+    k[P256_LIMBS] = 0;
+
+    for (;;) {
+        uint32_t nz = 0;
+        for (int i = 0; i <= P256_LIMBS; i++) {
+            nz |= k[i];
+        }
+        if (nz == 0) {
+            break;
+        }
+
+        digit = 0;
+        if (k[0] & 1) {
+            digit = k[0] & ((1 << P256_WNAF_WIDTH) - 1);
+            if (digit >= (1 << (P256_WNAF_WIDTH - 1))) {
+                digit -= (1 << P256_WNAF_WIDTH);
+            }
+
+            // k -= digit
+            if (digit > 0) {
+                k[0] -= digit;              // only clears low bits, no borrow
+            } else {
+                uint64_t c = (uint64_t)k[0] + (uint32_t)(-digit);
+                k[0] = (uint32_t)c;
+                for (int i = 1; i <= P256_LIMBS && (c >> 32); i++) {
+                    c = (uint64_t)k[i] + 1;
+                    k[i] = (uint32_t)c;
+                }
+            }
+        }
+        naf[len++] = (int8_t)digit;
+
+        for (int i = 0; i < P256_LIMBS; i++) {
+            k[i] = (k[i] >> 1) | (k[i + 1] << 31);
+        }
+        k[P256_LIMBS] >>= 1;
+    }
+
+    return len;
+}
+
+void ECC_PointMult_P256(Point *q, Point *p, DWORD *n)
+{
+    p256_jacobian_t table[P256_WNAF_POINTS];
+    p256_jacobian_t r, t;
+    int8_t naf[KEY_LENGTH_DWORDS_P256 * DWORD_BITS + 1];
+    int len;
+
+    // table[i] = (2i + 1) p
+    p256_from_dwords(table[0].x, p->x);
+    p256_from_dwords(table[0].y, p->y);
+    memset(table[0].z, 0, sizeof(p256_fe));
+    table[0].z[0] = 1;
+
+    p256_point_double(&t, &table[0]);
+    for (int i = 1; i < P256_WNAF_POINTS; i++) {
+        p256_point_add(&table[i], &table[i - 1], &t);
+    }
+
+    len = p256_wnaf(naf, n);
+
+    memset(&r, 0, sizeof(p256_jacobian_t));
+    for (int i = len - 1; i >= 0; i--) {
+        p256_point_double(&r, &r);
+        if (naf[i] > 0) {
+            p256_point_add(&r, &r, &table[naf[i] >> 1]);
+        } else if (naf[i] < 0) {
+            t = table[(-naf[i]) >> 1];
+            if (!p256_fe_is_zero(t.y)) {
+                p256_fe_sub(t.y, p256_p, t.y);
+            }
+            p256_point_add(&r, &r, &t);
+        }
+    }
+
+    p256_point_to_affine(q, &r);
+
+    memset(naf, 0, sizeof(naf));
+    memset(&r, 0, sizeof(r));
+}
+
+void ECC_PointMult_Base_P256(Point *q, DWORD *n)
+{
+#if (SMP_P256_COMB_TABLE == TRUE)
+    p256_fe k;
+    p256_jacobian_t r;
+
+    p256_from_dwords(k, n);
+    memset(&r, 0, sizeof(p256_jacobian_t));
+
+    for (int i = P256_COMB_SPACING - 1; i >= 0; i--) {
+        uint32_t idx = 0;
+
+        for (int j = 0; j < P256_COMB_TEETH; j++) {
+            int bit = j * P256_COMB_SPACING + i;
+            if (bit < KEY_LENGTH_DWORDS_P256 * DWORD_BITS) {
+                idx |= ((k[bit >> 5] >> (bit & 31)) & 1) << j;
+            }
+        }
+
+        p256_point_double(&r, &r);
+        if (idx) {
+            p256_point_add_affine(&r, &r, p_256_comb_table[idx - 1].x, p_256_comb_table[idx - 1].y);
+        }
+    }
+
+    p256_point_to_affine(q, &r);
+
+    memset(k, 0, sizeof(k));
+    memset(&r, 0, sizeof(r));
+#else
+    Point g;
+
+    memset(&g, 0, sizeof(Point));
+    p256_to_dwords(g.x, p256_g.x);
+    p256_to_dwords(g.y, p256_g.y);
+    ECC_PointMult_P256(q, &g, n);
+#endif
+}
+
+void ECC_PointMult(Point *q, Point *p, DWORD *n, uint32_t keyLength)
+{
+    if (keyLength != KEY_LENGTH_DWORDS_P256) {
+        ECC_PointMult_Bin_NAF(q, p, n, keyLength);
+    } else if (p == &curve_p256.G) {
+        ECC_PointMult_Base_P256(q, n);
     } else {
-        return true;
+        ECC_PointMult_P256(q, p, n);
     }
 }
 
+bool ECC_CheckPointIsInElliCur_P256(Point *p)
+{
+    p256_fe x, y, lhs, rhs, t;
+
+    p256_from_dwords(x, p->x);
+    p256_from_dwords(y, p->y);
 
+    /* the coordinates must be field elements */
+    if (p256_fe_ge_p(x) || p256_fe_ge_p(y)) {
+        return false;
+    }
+
+    /* y^2 == x^3 - 3x + b == (x^2 - 3) * x + b (mod p) */
+    p256_fe_sqr(lhs, y);
+
+    p256_fe_sqr(rhs, x);
+    p256_fe_dbl(t, x);
+    p256_fe_add(t, t, x);
+    p256_fe_mul(rhs, rhs, x);
+    p256_fe_sub(rhs, rhs, t);
+    p256_fe_add(rhs, rhs, p256_b);
+
+    return memcmp(lhs, rhs, sizeof(p256_fe)) == 0;
+}
@@ -64,10 +64,12 @@ void SMP_Init(void)
     smp_l2cap_if_init();
     /* initialization of P-256 parameters */
     p_256_init_curve(KEY_LENGTH_DWORDS_P256);
+    smp_ecc_init();
 }
 
 void SMP_Free(void)
 {
+    smp_ecc_free();
     memset(&smp_cb, 0, sizeof(tSMP_CB));
 #if SMP_DYNAMIC_MEMORY
     FREE_AND_RESET(smp_cb_ptr);
@@ -123,6 +125,9 @@ BOOLEAN SMP_Register (tSMP_CALLBACK *p_cback)
     }
     smp_cb.p_callback = p_cback;
 
+    /* the controller is up by now, get a key pair ready for the first pairing */
+    smp_ecc_precompute_key_pair();
+
     return (TRUE);
 
 }
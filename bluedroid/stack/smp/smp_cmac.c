@@ -23,7 +23,6 @@
  ******************************************************************************/
 
 #include "common/bt_target.h"
-#include "osi/allocator.h"
 
 #if SMP_INCLUDED == TRUE
 //    #include <stdio.h>
@@ -33,19 +32,8 @@
 #include "smp_int.h"
 #include "stack/hcimsgs.h"
 
-typedef struct {
-    UINT8               *text;
-    UINT16              len;
-    UINT16              round;
-} tCMAC_CB;
-
-tCMAC_CB    cmac_cb;
-
-/* Rb for AES-128 as block cipher, LSB as [0] */
-BT_OCTET16 const_Rb = {
-    0x87, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
-};
+/* Rb for AES-128 as block cipher, MSB as [0] */
+static const UINT8 const_Rb = 0x87;
 
 void print128(BT_OCTET16 x, const UINT8 *key_name)
 {
@@ -65,203 +53,144 @@ void print128(BT_OCTET16 x, const UINT8 *key_name)
 
 /*******************************************************************************
 **
-** Function         padding
-**
-** Description      utility function to padding the given text to be a 128 bits
-**                  data. The parameter dest is input and output parameter, it
-**                  must point to a BT_OCTET16_LEN memory space; where include
-**                  length bytes valid data.
-**
-** Returns          void
-**
-*******************************************************************************/
-static void padding ( BT_OCTET16 dest, UINT8 length )
-{
-    UINT8   i, *p = dest;
-    /* original last block */
-    for ( i = length ; i < BT_OCTET16_LEN; i++ ) {
-        p[BT_OCTET16_LEN - i - 1] = ( i == length ) ? 0x80 : 0;
-    }
-}
-/*******************************************************************************
-**
-** Function         leftshift_onebit
-**
-** Description      utility function to left shift one bit for a 128 bits value.
-**
-** Returns          void
-**
-*******************************************************************************/
-static void leftshift_onebit(UINT8 *input, UINT8 *output)
-{
-    UINT8   i, overflow = 0 , next_overflow = 0;
-    SMP_TRACE_EVENT ("leftshift_onebit ");
-    /* input[0] is LSB */
-    for ( i = 0; i < BT_OCTET16_LEN ; i ++ ) {
-        next_overflow = (input[i] & 0x80) ? 1 : 0;
-        output[i] = (input[i] << 1) | overflow;
-        overflow = next_overflow;
-    }
-    return;
-}
-/*******************************************************************************
-**
-** Function         cmac_aes_cleanup
+** Function         cmac_xor_block
 **
-** Description      clean up function for AES_CMAC algorithm.
+** Description      XOR a 128 bits block into another one, dest := dest (+) src.
 **
 ** Returns          void
 **
 *******************************************************************************/
-static void cmac_aes_cleanup(void)
+static void cmac_xor_block(UINT8 *dest, const UINT8 *src)
 {
-    if (cmac_cb.text != NULL) {
-        osi_free(cmac_cb.text);
+    UINT8 i;
+
+    for (i = 0; i < BT_OCTET16_LEN; i++) {
+        dest[i] ^= src[i];
     }
-    memset(&cmac_cb, 0, sizeof(tCMAC_CB));
 }
 
 /*******************************************************************************
 **
-** Function         cmac_aes_k_calculate
+** Function         cmac_double
 **
-** Description      This function is the calculation of block cipher using AES-128.
+** Description      Doubling in GF(2^128) used to derive the CMAC subkeys,
+**                  output := (input << 1) (+) (MSB(input) ? Rb : 0).
+**                  Both blocks are in big endian byte order.
 **
 ** Returns          void
 **
 *******************************************************************************/
-static BOOLEAN cmac_aes_k_calculate(BT_OCTET16 key, UINT8 *p_signature, UINT16 tlen)
+static void cmac_double(const UINT8 *input, UINT8 *output)
 {
-    tSMP_ENC output;
-    UINT8    i = 1, err = 0;
-    UINT8    x[16] = {0};
-    UINT8   *p_mac;
-
-    SMP_TRACE_EVENT ("cmac_aes_k_calculate ");
-
-    while (i <= cmac_cb.round) {
-        smp_xor_128(&cmac_cb.text[(cmac_cb.round - i)*BT_OCTET16_LEN], x); /* Mi' := Mi (+) X  */
+    UINT8 i, msb = input[0] & 0x80;
 
-        if (!SMP_Encrypt(key, BT_OCTET16_LEN, &cmac_cb.text[(cmac_cb.round - i)*BT_OCTET16_LEN], BT_OCTET16_LEN, &output)) {
-            err = 1;
-            break;
-        }
-
-        memcpy(x, output.param_buf, BT_OCTET16_LEN);
-        i ++;
+    for (i = 0; i < BT_OCTET16_LEN - 1; i++) {
+        output[i] = (UINT8)((input[i] << 1) | (input[i + 1] >> 7));
     }
+    output[BT_OCTET16_LEN - 1] = (UINT8)(input[BT_OCTET16_LEN - 1] << 1);
 
-    if (!err) {
-        p_mac = output.param_buf + (BT_OCTET16_LEN - tlen);
-        memcpy(p_signature, p_mac, tlen);
-
-        SMP_TRACE_DEBUG("tlen = %d p_mac = %p", tlen, p_mac);
-        SMP_TRACE_DEBUG("p_mac[0] = 0x%02x p_mac[1] = 0x%02x p_mac[2] = 0x%02x p_mac[3] = 0x%02x",
-                        *p_mac, *(p_mac + 1), *(p_mac + 2), *(p_mac + 3));
-        SMP_TRACE_DEBUG("p_mac[4] = 0x%02x p_mac[5] = 0x%02x p_mac[6] = 0x%02x p_mac[7] = 0x%02x",
-                        *(p_mac + 4), *(p_mac + 5), *(p_mac + 6), *(p_mac + 7));
-
-        return TRUE;
-
-    } else {
-        return FALSE;
+    if (msb) {
+        output[BT_OCTET16_LEN - 1] ^= const_Rb;
     }
 }
+
 /*******************************************************************************
 **
-** Function         cmac_prepare_last_block
+** Function         smp_cmac_init
 **
-** Description      This function proceeed to prepare the last block of message
-**                  Mn depending on the size of the message.
+** Description      Start a streaming AES-CMAC calculation. The key schedule is
+**                  expanded once here and reused for every block of the message.
+**
+** Parameters       p_ctx - CMAC context to initialize.
+**                  key - CMAC key in big endian (RFC 4493) byte order.
 **
 ** Returns          void
 **
 *******************************************************************************/
-static void cmac_prepare_last_block (BT_OCTET16 k1, BT_OCTET16 k2)
+void smp_cmac_init(tSMP_CMAC_CTX *p_ctx, const UINT8 *key)
 {
-//    UINT8       x[16] = {0};
-    BOOLEAN      flag;
-
-    SMP_TRACE_EVENT ("cmac_prepare_last_block ");
-    /* last block is a complete block set flag to 1 */
-    flag = ((cmac_cb.len % BT_OCTET16_LEN) == 0 && cmac_cb.len != 0)  ? TRUE : FALSE;
-
-    SMP_TRACE_DEBUG("flag = %d round = %d", flag, cmac_cb.round);
-
-    if ( flag ) {
-        /* last block is complete block */
-        smp_xor_128(&cmac_cb.text[0], k1);
-    } else { /* padding then xor with k2 */
-        padding(&cmac_cb.text[0], (UINT8)(cmac_cb.len % 16));
-
-        smp_xor_128(&cmac_cb.text[0], k2);
-    }
+    memset(p_ctx, 0, sizeof(tSMP_CMAC_CTX));
+    bt_aes_set_key(key, BT_OCTET16_LEN, &p_ctx->aes);
 }
+
 /*******************************************************************************
 **
-** Function         cmac_subkey_cont
+** Function         smp_cmac_update
 **
-** Description      This is the callback function when CIPHk(0[128]) is completed.
+** Description      Feed message bytes into a streaming AES-CMAC calculation.
+**                  May be called any number of times with any length; the
+**                  last complete block is held back until smp_cmac_final.
+**
+** Parameters       p_ctx - CMAC context set up by smp_cmac_init.
+**                  p_data - message bytes in big endian (RFC 4493) order.
+**                  len - number of bytes in p_data.
 **
 ** Returns          void
 **
 *******************************************************************************/
-static void cmac_subkey_cont(tSMP_ENC *p)
+void smp_cmac_update(tSMP_CMAC_CTX *p_ctx, const UINT8 *p_data, UINT16 len)
 {
-    UINT8 k1[BT_OCTET16_LEN], k2[BT_OCTET16_LEN];
-    UINT8 *pp = p->param_buf;
-    SMP_TRACE_EVENT ("cmac_subkey_cont ");
-    print128(pp, (const UINT8 *)"K1 before shift");
-
-    /* If MSB(L) = 0, then K1 = L << 1 */
-    if ( (pp[BT_OCTET16_LEN - 1] & 0x80) != 0 ) {
-        /* Else K1 = ( L << 1 ) (+) Rb */
-        leftshift_onebit(pp, k1);
-        smp_xor_128(k1, const_Rb);
-    } else {
-        leftshift_onebit(pp, k1);
-    }
+    UINT16 n;
+
+    while (len > 0) {
+        if (p_ctx->buf_len == BT_OCTET16_LEN) {
+            /* more data follows, so the pending block is not the last one */
+            cmac_xor_block(p_ctx->x, p_ctx->buf);
+            bluedroid_aes_encrypt(p_ctx->x, p_ctx->x, &p_ctx->aes);
+            p_ctx->buf_len = 0;
+        }
 
-    if ( (k1[BT_OCTET16_LEN - 1] & 0x80) != 0 ) {
-        /* K2 =  (K1 << 1) (+) Rb */
-        leftshift_onebit(k1, k2);
-        smp_xor_128(k2, const_Rb);
-    } else {
-        /* If MSB(K1) = 0, then K2 = K1 << 1 */
-        leftshift_onebit(k1, k2);
+        n = BT_OCTET16_LEN - p_ctx->buf_len;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(&p_ctx->buf[p_ctx->buf_len], p_data, n);
+        p_ctx->buf_len += n;
+        p_data += n;
+        len -= n;
     }
-
-    print128(k1, (const UINT8 *)"K1");
-    print128(k2, (const UINT8 *)"K2");
-
-    cmac_prepare_last_block (k1, k2);
 }
+
 /*******************************************************************************
 **
-** Function         cmac_generate_subkey
+** Function         smp_cmac_final
 **
-** Description      This is the function to generate the two subkeys.
+** Description      Finish a streaming AES-CMAC calculation: derive the K1/K2
+**                  subkeys, process the last block and output the tag. The
+**                  context is wiped afterwards.
 **
-** Parameters       key - CMAC key, expect SRK when used by SMP.
+** Parameters       p_ctx - CMAC context set up by smp_cmac_init.
+**                  p_mac - 16 bytes tag output in big endian byte order.
 **
 ** Returns          void
 **
 *******************************************************************************/
-static BOOLEAN cmac_generate_subkey(BT_OCTET16 key)
+void smp_cmac_final(tSMP_CMAC_CTX *p_ctx, UINT8 *p_mac)
 {
-    BT_OCTET16 z = {0};
-    BOOLEAN     ret = TRUE;
-    tSMP_ENC output;
-    SMP_TRACE_EVENT (" cmac_generate_subkey");
-
-    if (SMP_Encrypt(key, BT_OCTET16_LEN, z, BT_OCTET16_LEN, &output)) {
-        cmac_subkey_cont(&output);;
-    } else {
-        ret = FALSE;
+    UINT8 l[BT_OCTET16_LEN] = {0};
+    UINT8 k[BT_OCTET16_LEN];
+
+    /* L := CIPHk(0[128]), K1 := double(L) */
+    bluedroid_aes_encrypt(l, l, &p_ctx->aes);
+    cmac_double(l, k);
+
+    if (p_ctx->buf_len != BT_OCTET16_LEN) {
+        /* incomplete (or empty) last block: pad with 10..0 and use K2 */
+        memset(&p_ctx->buf[p_ctx->buf_len], 0, BT_OCTET16_LEN - p_ctx->buf_len);
+        p_ctx->buf[p_ctx->buf_len] = 0x80;
+        memcpy(l, k, BT_OCTET16_LEN);
+        cmac_double(l, k);
     }
 
-    return ret;
+    cmac_xor_block(p_ctx->buf, k);
+    cmac_xor_block(p_ctx->x, p_ctx->buf);
+    bluedroid_aes_encrypt(p_ctx->x, p_mac, &p_ctx->aes);
+
+    memset(l, 0, sizeof(l));
+    memset(k, 0, sizeof(k));
+    memset(p_ctx, 0, sizeof(tSMP_CMAC_CTX));
 }
+
 /*******************************************************************************
 **
 ** Function         aes_cipher_msg_auth_code
@@ -274,51 +203,50 @@ static BOOLEAN cmac_generate_subkey(BT_OCTET16 key)
 **                  tlen - lenth of mac desired
 **                  p_signature - data pointer to where signed data to be stored, tlen long.
 **
-** Returns          FALSE if out of resources, TRUE in other cases.
+** Returns          FALSE if tlen is invalid, TRUE in other cases.
 **
 *******************************************************************************/
 BOOLEAN aes_cipher_msg_auth_code(BT_OCTET16 key, UINT8 *input, UINT16 length,
                                  UINT16 tlen, UINT8 *p_signature)
 {
-    UINT16  len, diff;
-    UINT16  n = (length + BT_OCTET16_LEN - 1) / BT_OCTET16_LEN;       /* n is number of rounds */
-    BOOLEAN ret = FALSE;
+    tSMP_CMAC_CTX ctx;
+    UINT8   rev[BT_OCTET16_LEN];
+    UINT8   mac[BT_OCTET16_LEN];
+    UINT16  n, i;
 
     SMP_TRACE_EVENT ("%s", __func__);
 
-    if (n == 0) {
-        n = 1;
+    if (tlen > BT_OCTET16_LEN) {
+        SMP_TRACE_ERROR("%s invalid tlen = %d", __func__, tlen);
+        return FALSE;
     }
-    len = n * BT_OCTET16_LEN;
 
-    SMP_TRACE_DEBUG("AES128_CMAC started, allocate buffer size = %d", len);
-    /* allocate a memory space of multiple of 16 bytes to hold text  */
-    if ((cmac_cb.text = (UINT8 *)osi_malloc(len)) != NULL) {
-        cmac_cb.round = n;
-
-        memset(cmac_cb.text, 0, len);
-        diff = len - length;
+    for (i = 0; i < BT_OCTET16_LEN; i++) {
+        rev[i] = key[BT_OCTET16_LEN - 1 - i];
+    }
+    smp_cmac_init(&ctx, rev);
 
-        if (input != NULL && length > 0) {
-            memcpy(&cmac_cb.text[diff] , input, (int)length);
-            cmac_cb.len = length;
-        } else {
-            cmac_cb.len = 0;
+    /* the message is the input read from its last byte backwards */
+    while (length > 0) {
+        n = (length < BT_OCTET16_LEN) ? length : BT_OCTET16_LEN;
+        for (i = 0; i < n; i++) {
+            rev[i] = input[length - 1 - i];
         }
+        smp_cmac_update(&ctx, rev, n);
+        length -= n;
+    }
 
-        /* prepare calculation for subkey s and last block of data */
-        if (cmac_generate_subkey(key)) {
-            /* start calculation */
-            ret = cmac_aes_k_calculate(key, p_signature, tlen);
-        }
-        /* clean up */
-        cmac_aes_cleanup();
-    } else {
-        ret = FALSE;
-        SMP_TRACE_ERROR("No resources");
+    smp_cmac_final(&ctx, mac);
+
+    /* the signature is the MSB tlen bytes of the tag, in little endian */
+    for (i = 0; i < tlen; i++) {
+        p_signature[i] = mac[tlen - 1 - i];
     }
 
-    return ret;
+    SMP_TRACE_DEBUG("tlen = %d", tlen);
+    memset(rev, 0, sizeof(rev));
+
+    return TRUE;
 }
 
 #if 0 /* testing code, sample data from spec */
@@ -358,8 +286,6 @@ void test_cmac(void)
     }
 
 
-    memset(&cmac_cb, 0, sizeof(tCMAC_CB));
-
     SMP_TRACE_WARNING("\n Example 1: len = %d\n", len);
 
     aes_cipher_msg_auth_code(key, M, len, 128, test_cmac_cback, 0);
@@ -0,0 +1,487 @@
+/******************************************************************************
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the P-256 worker of the LE Secure Connections pairing.
+ *  Key pair generation and DHKey computation run in their own low priority
+ *  task and the result is posted back to the BTU task, so a point
+ *  multiplication never blocks HCI event and ACL data processing.
+ *
+ ******************************************************************************/
+
+#include "common/bt_target.h"
+
+#if SMP_INCLUDED == TRUE
+
+#include <string.h>
+#include "osi/allocator.h"
+#include "osi/thread.h"
+#include "osi/semaphore.h"
+#include "osi/mutex.h"
+#include "stack/btm_ble_api.h"
+#include "stack/hcimsgs.h"
+#include "smp_int.h"
+#include "p_256_ecc_pp.h"
+
+#if (SMP_ECC_WORKER_INCLUDED == TRUE)
+
+#define SMP_ECC_PRECOMPUTE  (SMP_ECC_PRECOMPUTE_KEY == TRUE)
+
+/* state of the precomputed key pair */
+enum {
+    SMP_ECC_SPARE_NONE,
+    SMP_ECC_SPARE_RAND,         /* collecting the private key from the controller */
+    SMP_ECC_SPARE_BUSY,         /* public key being computed by the worker */
+    SMP_ECC_SPARE_READY
+};
+
+typedef struct {
+    BOOLEAN         running;
+    volatile BOOLEAN stopping;          /* read by the worker task */
+    UINT32          seq;
+    UINT32          first_seq;          /* first sequence number since smp_ecc_init */
+#if SMP_ECC_PRECOMPUTE
+    UINT8           spare_state;
+    UINT8           spare_rand_len;
+    BT_OCTET32      spare_private_key;
+    tSMP_PUBLIC_KEY spare_publ_key;
+#endif
+} tSMP_ECC_CB;
+
+static tSMP_ECC_CB smp_ecc_cb;
+
+static aos_task_t smp_ecc_task_hdl;
+static aos_queue_t smp_ecc_queue;
+static void *smp_ecc_queue_buf[SMP_ECC_QUEUE_LEN];
+static osi_sem_t smp_ecc_exit_sem;
+
+/* Held while a result is handed to SMP and while smp_ecc_free resets the state.
+   Both run in the BTU task (SMP_Free is called from btu_free_core), the lock
+   keeps them ordered should either move. Kept across SMP_Free for the results
+   still queued to the BTU task. */
+static osi_mutex_t smp_ecc_cmpl_lock;
+static BOOLEAN smp_ecc_cmpl_lock_ready;
+#endif /* SMP_ECC_WORKER_INCLUDED == TRUE */
+
+/*******************************************************************************
+**
+** Function         smp_ecc_compute
+**
+** Description      Run the point multiplication described by the job and store
+**                  the result in p_job->publ_key. For SMP_ECC_OP_DHKEY only the
+**                  x coordinate of the result (the DHKey) is meaningful.
+**
+** Returns          void
+**
+*******************************************************************************/
+void smp_ecc_compute(tSMP_ECC_JOB *p_job)
+{
+    Point       p, q;
+    BT_OCTET32  private_key;
+
+    memcpy(private_key, p_job->private_key, BT_OCTET32_LEN);
+
+    if (p_job->op == SMP_ECC_OP_DHKEY) {
+        memset(&p, 0, sizeof(Point));
+        memcpy(p.x, p_job->publ_key.x, BT_OCTET32_LEN);
+        memcpy(p.y, p_job->publ_key.y, BT_OCTET32_LEN);
+        ECC_PointMult(&q, &p, (DWORD *) private_key, KEY_LENGTH_DWORDS_P256);
+    } else {
+        ECC_PointMult(&q, &(curve_p256.G), (DWORD *) private_key, KEY_LENGTH_DWORDS_P256);
+    }
+
+    memcpy(p_job->publ_key.x, q.x, BT_OCTET32_LEN);
+    memcpy(p_job->publ_key.y, q.y, BT_OCTET32_LEN);
+
+    memset(private_key, 0, BT_OCTET32_LEN);
+    memset(&q, 0, sizeof(Point));
+}
+
+#if (SMP_ECC_WORKER_INCLUDED == TRUE)
+/*******************************************************************************
+**
+** Function         smp_ecc_post_result
+**
+** Description      Post a result to the BTU task. The post never blocks, since
+**                  smp_ecc_free waits in the BTU task for this task to exit; a
+**                  full BTU queue is retried until the worker is stopped.
+**
+** Returns          TRUE if posted, FALSE if the worker is stopping.
+**
+*******************************************************************************/
+static BOOLEAN smp_ecc_post_result(tSMP_ECC_JOB *p_job)
+{
+    while (!smp_ecc_cb.stopping) {
+        if (btu_task_post(SIG_BTU_SMP_ECC_CMPL, p_job, TASK_POST_NON_BLOCKING) == TASK_POST_SUCCESS) {
+            return TRUE;
+        }
+        aos_msleep(SMP_ECC_POST_RETRY_MS);
+    }
+
+    return FALSE;
+}
+
+/*******************************************************************************
+**
+** Function         smp_ecc_task_handler
+**
+** Description      ECC worker task. Runs the queued jobs one at a time and
+**                  posts every result back to the BTU task. A NULL job stops
+**                  the task.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void smp_ecc_task_handler(void *arg)
+{
+    tSMP_ECC_JOB *p_job;
+    unsigned int len;
+
+    for (;;) {
+        if (aos_queue_recv(&smp_ecc_queue, AOS_WAIT_FOREVER, &p_job, &len) != 0) {
+            continue;
+        }
+
+        if (p_job == NULL) {
+            break;
+        }
+
+        smp_ecc_compute(p_job);
+
+        if (!smp_ecc_post_result(p_job)) {
+            memset(p_job, 0, sizeof(tSMP_ECC_JOB));
+            osi_free(p_job);
+        }
+    }
+
+    osi_sem_give(&smp_ecc_exit_sem);
+    aos_task_exit(0);
+}
+
+/*******************************************************************************
+**
+** Function         smp_ecc_init
+**
+** Description      Start the ECC worker task. On failure SMP keeps running the
+**                  point multiplications in the BTU task.
+**
+** Returns          void
+**
+*******************************************************************************/
+void smp_ecc_init(void)
+{
+    UINT32 seq = smp_ecc_cb.seq;
+
+    /* sequence numbers carry on across SMP_Free, so results posted before it
+       are told apart from the jobs of this run */
+    memset(&smp_ecc_cb, 0, sizeof(tSMP_ECC_CB));
+    smp_ecc_cb.seq = seq;
+    smp_ecc_cb.first_seq = (seq + 1 == 0) ? 1 : seq + 1;
+
+    if (!smp_ecc_cmpl_lock_ready) {
+        if (osi_mutex_new(&smp_ecc_cmpl_lock) != 0) {
+            SMP_TRACE_ERROR("%s unable to create mutex", __func__);
+            return;
+        }
+        smp_ecc_cmpl_lock_ready = TRUE;
+    }
+
+    if (osi_sem_new(&smp_ecc_exit_sem, 1, 0) != 0) {
+        SMP_TRACE_ERROR("%s unable to create semaphore", __func__);
+        return;
+    }
+
+    if (aos_queue_new(&smp_ecc_queue, smp_ecc_queue_buf, sizeof(smp_ecc_queue_buf), sizeof(void *)) != 0) {
+        SMP_TRACE_ERROR("%s unable to create queue", __func__);
+        osi_sem_free(&smp_ecc_exit_sem);
+        return;
+    }
+
+    if (aos_task_new_ext(&smp_ecc_task_hdl, SMP_ECC_TASK_NAME, smp_ecc_task_handler, NULL,
+                         SMP_ECC_TASK_STACK_SIZE, SMP_ECC_TASK_PRIO) != 0) {
+        SMP_TRACE_ERROR("%s unable to create task", __func__);
+        aos_queue_free(&smp_ecc_queue);
+        osi_sem_free(&smp_ecc_exit_sem);
+        return;
+    }
+
+    smp_ecc_cb.running = TRUE;
+}
+
+/*******************************************************************************
+**
+** Function         smp_ecc_free
+**
+** Description      Stop the ECC worker task. Waits for the job in progress;
+**                  results that complete after this point are dropped, and
+**                  so are results already posted to the BTU task, since the
+**                  SMP control block they refer to is about to be freed.
+**                  If the worker can't be told to stop, nothing is freed.
+**
+** Returns          void
+**
+*******************************************************************************/
+void smp_ecc_free(void)
+{
+    tSMP_ECC_JOB *p_job = NULL;
+    unsigned int len;
+    UINT32 seq = smp_ecc_cb.seq;
+
+    if (!smp_ecc_cb.running) {
+        return;
+    }
+
+    smp_ecc_cb.stopping = TRUE;
+
+    /* free the jobs that were never started, which also makes room for the
+       stop job; nothing else queues jobs once stopping is set */
+    while (aos_queue_recv(&smp_ecc_queue, 0, &p_job, &len) == 0) {
+        memset(p_job, 0, sizeof(tSMP_ECC_JOB));
+        osi_free(p_job);
+    }
+
+    p_job = NULL;
+    if (aos_queue_send(&smp_ecc_queue, &p_job, sizeof(void *)) != 0) {
+        /* the worker still runs, so its queue and semaphore must stay */
+        SMP_TRACE_ERROR("%s unable to stop the ECC worker", __func__);
+        assert(0);
+        return;
+    }
+    osi_sem_take(&smp_ecc_exit_sem, OSI_SEM_MAX_TIMEOUT);
+
+    aos_queue_free(&smp_ecc_queue);
+    osi_sem_free(&smp_ecc_exit_sem);
+
+    osi_mutex_lock(&smp_ecc_cmpl_lock, OSI_MUTEX_MAX_TIMEOUT);
+    memset(&smp_ecc_cb, 0, sizeof(tSMP_ECC_CB));
+    smp_ecc_cb.seq = seq;
+    osi_mutex_unlock(&smp_ecc_cmpl_lock);
+}
+#else
+void smp_ecc_init(void)
+{
+}
+
+void smp_ecc_free(void)
+{
+}
+#endif /* SMP_ECC_WORKER_INCLUDED == TRUE */
+
+/*******************************************************************************
+**
+** Function         smp_ecc_submit
+**
+** Description      Queue a copy of the job to the ECC worker. The job's
+**                  callback is called in the BTU task when the result is
+**                  ready; p_job->seq is set to the sequence number the result
+**                  will carry.
+**
+** Returns          TRUE if queued. FALSE if the worker is not available, in
+**                  which case the caller should run smp_ecc_compute itself.
+**
+*******************************************************************************/
+BOOLEAN smp_ecc_submit(tSMP_ECC_JOB *p_job)
+{
+#if (SMP_ECC_WORKER_INCLUDED == TRUE)
+    tSMP_ECC_JOB *p_copy;
+
+    if (!smp_ecc_cb.running || smp_ecc_cb.stopping) {
+        return FALSE;
+    }
+
+    if ((p_copy = (tSMP_ECC_JOB *)osi_malloc(sizeof(tSMP_ECC_JOB))) == NULL) {
+        SMP_TRACE_ERROR("%s no resources", __func__);
+        return FALSE;
+    }
+
+    /* 0 is reserved for "no job pending" */
+    if (++smp_ecc_cb.seq == 0) {
+        smp_ecc_cb.seq = 1;
+    }
+    p_job->seq = smp_ecc_cb.seq;
+    memcpy(p_copy, p_job, sizeof(tSMP_ECC_JOB));
+
+    if (aos_queue_send(&smp_ecc_queue, &p_copy, sizeof(void *)) != 0) {
+        SMP_TRACE_ERROR("%s queue full", __func__);
+        memset(p_copy, 0, sizeof(tSMP_ECC_JOB));
+        osi_free(p_copy);
+        return FALSE;
+    }
+
+    SMP_TRACE_DEBUG("%s op %d seq %d", __func__, p_job->op, p_job->seq);
+    return TRUE;
+#else
+    return FALSE;
+#endif
+}
+
+/*******************************************************************************
+**
+** Function         smp_ecc_job_cmpl
+**
+** Description      Called in the BTU task when the worker posts a result.
+**                  Hands the result to the submitter and frees the job.
+**                  Results of jobs submitted before the last smp_ecc_free
+**                  are dropped without calling back.
+**
+** Returns          void
+**
+*******************************************************************************/
+void smp_ecc_job_cmpl(tSMP_ECC_JOB *p_job)
+{
+    SMP_TRACE_DEBUG("%s op %d seq %d", __func__, p_job->op, p_job->seq);
+
+#if (SMP_ECC_WORKER_INCLUDED == TRUE)
+    osi_mutex_lock(&smp_ecc_cmpl_lock, OSI_MUTEX_MAX_TIMEOUT);
+    if (!smp_ecc_cb.running || (INT32)(p_job->seq - smp_ecc_cb.first_seq) < 0) {
+        SMP_TRACE_WARNING("%s drop result of a freed SMP, seq %d", __func__, p_job->seq);
+    } else if (p_job->p_cback) {
+        (*p_job->p_cback)(p_job);
+    }
+    osi_mutex_unlock(&smp_ecc_cmpl_lock);
+#else
+    if (p_job->p_cback) {
+        (*p_job->p_cback)(p_job);
+    }
+#endif
+
+    memset(p_job, 0, sizeof(tSMP_ECC_JOB));
+    osi_free(p_job);
+}
+
+#if (SMP_ECC_WORKER_INCLUDED == TRUE && SMP_ECC_PRECOMPUTE)
+/*******************************************************************************
+**
+** Function         smp_ecc_spare_cback
+**
+** Description      Public key of the precomputed key pair is ready.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void smp_ecc_spare_cback(tSMP_ECC_JOB *p_job)
+{
+    if (smp_ecc_cb.spare_state != SMP_ECC_SPARE_BUSY) {
+        return;
+    }
+
+    memcpy(&smp_ecc_cb.spare_publ_key, &p_job->publ_key, sizeof(tSMP_PUBLIC_KEY));
+    smp_ecc_cb.spare_state = SMP_ECC_SPARE_READY;
+    SMP_TRACE_DEBUG("%s spare key pair ready", __func__);
+}
+
+/*******************************************************************************
+**
+** Function         smp_ecc_spare_rand_cback
+**
+** Description      Collects the 32 octets of the precomputed private key from
+**                  LE Rand and hands the key to the worker once complete.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void smp_ecc_spare_rand_cback(tBTM_RAND_ENC *p)
+{
+    tSMP_ECC_JOB job;
+
+    if (smp_ecc_cb.spare_state != SMP_ECC_SPARE_RAND) {
+        return;
+    }
+
+    if (p == NULL || p->status != HCI_SUCCESS || p->param_len != BT_OCTET8_LEN) {
+        SMP_TRACE_WARNING("%s rand failed", __func__);
+        smp_ecc_cb.spare_state = SMP_ECC_SPARE_NONE;
+        return;
+    }
+
+    memcpy(&smp_ecc_cb.spare_private_key[smp_ecc_cb.spare_rand_len], p->param_buf, BT_OCTET8_LEN);
+    smp_ecc_cb.spare_rand_len += BT_OCTET8_LEN;
+
+    if (smp_ecc_cb.spare_rand_len < BT_OCTET32_LEN) {
+        if (!btsnd_hcic_ble_rand((void *)smp_ecc_spare_rand_cback)) {
+            smp_ecc_cb.spare_state = SMP_ECC_SPARE_NONE;
+        }
+        return;
+    }
+
+    memset(&job, 0, sizeof(tSMP_ECC_JOB));
+    job.op = SMP_ECC_OP_KEY_PAIR;
+    job.p_cback = smp_ecc_spare_cback;
+    memcpy(job.private_key, smp_ecc_cb.spare_private_key, BT_OCTET32_LEN);
+
+    smp_ecc_cb.spare_state = smp_ecc_submit(&job) ? SMP_ECC_SPARE_BUSY : SMP_ECC_SPARE_NONE;
+    memset(job.private_key, 0, BT_OCTET32_LEN);
+}
+#endif
+
+/*******************************************************************************
+**
+** Function         smp_ecc_precompute_key_pair
+**
+** Description      Start computing a local key pair for the next pairing if
+**                  none is ready or in progress. Should be called when SMP is
+**                  not waiting for the worker itself.
+**
+** Returns          void
+**
+*******************************************************************************/
+void smp_ecc_precompute_key_pair(void)
+{
+#if (SMP_ECC_WORKER_INCLUDED == TRUE && SMP_ECC_PRECOMPUTE)
+    if (!smp_ecc_cb.running || smp_ecc_cb.spare_state != SMP_ECC_SPARE_NONE) {
+        return;
+    }
+
+    SMP_TRACE_DEBUG("%s", __func__);
+    smp_ecc_cb.spare_state = SMP_ECC_SPARE_RAND;
+    smp_ecc_cb.spare_rand_len = 0;
+    if (!btsnd_hcic_ble_rand((void *)smp_ecc_spare_rand_cback)) {
+        smp_ecc_cb.spare_state = SMP_ECC_SPARE_NONE;
+    }
+#endif
+}
+
+/*******************************************************************************
+**
+** Function         smp_ecc_take_key_pair
+**
+** Description      Hand out the precomputed key pair, if one is ready. Each
+**                  key pair is given out only once.
+**
+** Returns          TRUE if private_key and p_publ_key were filled in.
+**
+*******************************************************************************/
+BOOLEAN smp_ecc_take_key_pair(BT_OCTET32 private_key, tSMP_PUBLIC_KEY *p_publ_key)
+{
+#if (SMP_ECC_WORKER_INCLUDED == TRUE && SMP_ECC_PRECOMPUTE)
+    if (smp_ecc_cb.spare_state != SMP_ECC_SPARE_READY) {
+        return FALSE;
+    }
+
+    memcpy(private_key, smp_ecc_cb.spare_private_key, BT_OCTET32_LEN);
+    memcpy(p_publ_key, &smp_ecc_cb.spare_publ_key, sizeof(tSMP_PUBLIC_KEY));
+
+    memset(smp_ecc_cb.spare_private_key, 0, BT_OCTET32_LEN);
+    memset(&smp_ecc_cb.spare_publ_key, 0, sizeof(tSMP_PUBLIC_KEY));
+    smp_ecc_cb.spare_state = SMP_ECC_SPARE_NONE;
+    return TRUE;
+#else
+    return FALSE;
+#endif
+}
+
+#endif /* SMP_INCLUDED == TRUE */
@@ -55,6 +55,10 @@ static void smp_process_ediv(tSMP_CB *p_cb, tSMP_ENC *p);
 static BOOLEAN smp_calculate_legacy_short_term_key(tSMP_CB *p_cb, tSMP_ENC *output);
 static void smp_continue_private_key_creation(tSMP_CB *p_cb, tBTM_RAND_ENC *p);
 static void smp_process_private_key(tSMP_CB *p_cb);
+static void smp_process_public_key(tSMP_CB *p_cb);
+static void smp_ecc_public_key_cback(tSMP_ECC_JOB *p_job);
+static void smp_ecc_dhkey_cback(tSMP_ECC_JOB *p_job);
+static void smp_process_dhkey(tSMP_CB *p_cb);
 static void smp_finish_nonce_generation(tSMP_CB *p_cb);
 static void smp_process_new_nonce(tSMP_CB *p_cb);
 
@@ -134,11 +138,11 @@ BOOLEAN smp_encrypt_data (UINT8 *key, UINT8 key_len,
                           tSMP_ENC *p_out)
 {
     aes_context ctx;
-    UINT8 *p_start = NULL;
     UINT8 *p = NULL;
-    UINT8 *p_rev_data = NULL;    /* input data in big endilan format */
-    UINT8 *p_rev_key = NULL;     /* input key in big endilan format */
-    UINT8 *p_rev_output = NULL;  /* encrypted output in big endilan format */
+    UINT8 rev_data[SMP_ENCRYT_DATA_SIZE];    /* input data in big endilan format */
+    UINT8 rev_key[SMP_ENCRYT_KEY_SIZE];      /* input key in big endilan format */
+    UINT8 rev_output[SMP_ENCRYT_DATA_SIZE];  /* encrypted output in big endilan format */
+    UINT8 i;
 
     SMP_TRACE_DEBUG ("%s\n", __func__);
     if ( (p_out == NULL ) || (key_len != SMP_ENCRYT_KEY_SIZE) ) {
@@ -146,33 +150,27 @@ BOOLEAN smp_encrypt_data (UINT8 *key, UINT8 key_len,
         return FALSE;
     }
 
-    if ((p_start = (UINT8 *)osi_malloc((SMP_ENCRYT_DATA_SIZE * 4))) == NULL) {
-        SMP_TRACE_ERROR ("%s failed unable to allocate buffer\n", __func__);
-        return FALSE;
-    }
-
     if (pt_len > SMP_ENCRYT_DATA_SIZE) {
         pt_len = SMP_ENCRYT_DATA_SIZE;
     }
 
-    memset(p_start, 0, SMP_ENCRYT_DATA_SIZE * 4);
-    p = p_start;
-    ARRAY_TO_STREAM (p, plain_text, pt_len); /* byte 0 to byte 15 */
-    p_rev_data = p = p_start + SMP_ENCRYT_DATA_SIZE; /* start at byte 16 */
-    REVERSE_ARRAY_TO_STREAM (p, p_start, SMP_ENCRYT_DATA_SIZE);  /* byte 16 to byte 31 */
-    p_rev_key = p; /* start at byte 32 */
-    REVERSE_ARRAY_TO_STREAM (p, key, SMP_ENCRYT_KEY_SIZE); /* byte 32 to byte 47 */
+    /* plain text is zero padded at its MSB end, byte 0 being the LSB */
+    memset(rev_data, 0, SMP_ENCRYT_DATA_SIZE);
+    for (i = 0; i < pt_len; i++) {
+        rev_data[SMP_ENCRYT_DATA_SIZE - 1 - i] = plain_text[i];
+    }
+    p = rev_key;
+    REVERSE_ARRAY_TO_STREAM (p, key, SMP_ENCRYT_KEY_SIZE);
 
 #if SMP_DEBUG == TRUE && SMP_DEBUG_VERBOSE == TRUE
     smp_debug_print_nbyte_little_endian(key, (const UINT8 *)"Key", SMP_ENCRYT_KEY_SIZE);
-    smp_debug_print_nbyte_little_endian(p_start, (const UINT8 *)"Plain text", SMP_ENCRYT_DATA_SIZE);
+    smp_debug_print_nbyte_little_endian(plain_text, (const UINT8 *)"Plain text", pt_len);
 #endif
-    p_rev_output = p;
-    bt_aes_set_key(p_rev_key, SMP_ENCRYT_KEY_SIZE, &ctx);
-    bluedroid_aes_encrypt(p_rev_data, p, &ctx);  /* outputs in byte 48 to byte 63 */
+    bt_aes_set_key(rev_key, SMP_ENCRYT_KEY_SIZE, &ctx);
+    bluedroid_aes_encrypt(rev_data, rev_output, &ctx);
 
     p = p_out->param_buf;
-    REVERSE_ARRAY_TO_STREAM (p, p_rev_output, SMP_ENCRYT_DATA_SIZE);
+    REVERSE_ARRAY_TO_STREAM (p, rev_output, SMP_ENCRYT_DATA_SIZE);
 #if SMP_DEBUG == TRUE && SMP_DEBUG_VERBOSE == TRUE
     smp_debug_print_nbyte_little_endian(p_out->param_buf, (const UINT8 *)"Encrypted text", SMP_ENCRYT_KEY_SIZE);
 #endif
@@ -181,7 +179,8 @@ BOOLEAN smp_encrypt_data (UINT8 *key, UINT8 key_len,
     p_out->status = HCI_SUCCESS;
     p_out->opcode =  HCI_BLE_ENCRYPT;
 
-    osi_free(p_start);
+    memset(rev_key, 0, sizeof(rev_key));
+    memset(&ctx, 0, sizeof(ctx));
 
     return TRUE;
 }
@@ -960,8 +959,9 @@ BOOLEAN smp_calculate_legacy_short_term_key(tSMP_CB *p_cb, tSMP_ENC *output)
 **
 ** Description      This function is called to create private key used to
 **                  calculate public key and DHKey.
-**                  The function starts private key creation requesting controller
-**                  to generate [0-7] octets of private key.
+**                  A key pair precomputed by the ECC worker is used if one is
+**                  ready. Otherwise the function starts private key creation
+**                  requesting controller to generate [0-7] octets of private key.
 **
 ** Returns          void
 **
@@ -969,6 +969,12 @@ BOOLEAN smp_calculate_legacy_short_term_key(tSMP_CB *p_cb, tSMP_ENC *output)
 void smp_create_private_key(tSMP_CB *p_cb, tSMP_INT_DATA *p_data)
 {
     SMP_TRACE_DEBUG ("%s", __FUNCTION__);
+    if (smp_ecc_take_key_pair(p_cb->private_key, &p_cb->loc_publ_key)) {
+        SMP_TRACE_DEBUG ("%s use precomputed key pair", __func__);
+        smp_process_public_key(p_cb);
+        return;
+    }
+
     p_cb->rand_enc_proc_state = SMP_GENERATE_PRIVATE_KEY_0_7;
     if (!btsnd_hcic_ble_rand((void *)smp_rand_back)) {
         smp_rand_back(NULL);
@@ -1067,24 +1073,70 @@ void smp_continue_private_key_creation (tSMP_CB *p_cb, tBTM_RAND_ENC *p)
 ** Function         smp_process_private_key
 **
 ** Description      This function processes private key.
-**                  It calculates public key and notifies SM that private key /
-**                  public key pair is created.
+**                  It calculates public key, in the ECC worker task if it is
+**                  available, and continues in smp_process_public_key.
 **
 ** Returns          void
 **
 *******************************************************************************/
 void smp_process_private_key(tSMP_CB *p_cb)
 {
-    Point       public_key;
-    BT_OCTET32  private_key;
+    tSMP_ECC_JOB job;
 
     SMP_TRACE_DEBUG ("%s", __FUNCTION__);
 
-    memcpy(private_key, p_cb->private_key, BT_OCTET32_LEN);
-    ECC_PointMult(&public_key, &(curve_p256.G), (DWORD *) private_key, KEY_LENGTH_DWORDS_P256);
-    memcpy(p_cb->loc_publ_key.x, public_key.x, BT_OCTET32_LEN);
-    memcpy(p_cb->loc_publ_key.y, public_key.y, BT_OCTET32_LEN);
+    memset(&job, 0, sizeof(tSMP_ECC_JOB));
+    job.op = SMP_ECC_OP_KEY_PAIR;
+    job.p_cback = smp_ecc_public_key_cback;
+    memcpy(job.private_key, p_cb->private_key, BT_OCTET32_LEN);
+
+    if (smp_ecc_submit(&job)) {
+        p_cb->ecc_seq = job.seq;
+    } else {
+        smp_ecc_compute(&job);
+        memcpy(&p_cb->loc_publ_key, &job.publ_key, sizeof(tSMP_PUBLIC_KEY));
+        smp_process_public_key(p_cb);
+    }
+
+    memset(job.private_key, 0, BT_OCTET32_LEN);
+}
 
+/*******************************************************************************
+**
+** Function         smp_ecc_public_key_cback
+**
+** Description      The ECC worker has calculated the local public key.
+**                  Results of a pairing that has already ended are dropped.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void smp_ecc_public_key_cback(tSMP_ECC_JOB *p_job)
+{
+    tSMP_CB *p_cb = &smp_cb;
+
+    if (p_job->seq != p_cb->ecc_seq) {
+        SMP_TRACE_WARNING ("%s drop stale public key, seq %d", __func__, p_job->seq);
+        return;
+    }
+    p_cb->ecc_seq = 0;
+
+    memcpy(&p_cb->loc_publ_key, &p_job->publ_key, sizeof(tSMP_PUBLIC_KEY));
+    smp_process_public_key(p_cb);
+}
+
+/*******************************************************************************
+**
+** Function         smp_process_public_key
+**
+** Description      This function notifies SM that private key / public key
+**                  pair is created.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void smp_process_public_key(tSMP_CB *p_cb)
+{
     smp_debug_print_nbyte_little_endian (p_cb->private_key, (const UINT8 *)"private",
                                          BT_OCTET32_LEN);
     smp_debug_print_nbyte_little_endian (p_cb->loc_publ_key.x, (const UINT8 *)"local public(x)",
@@ -1101,27 +1153,75 @@ void smp_process_private_key(tSMP_CB *p_cb)
 **
 ** Description      The function:
 **                  - calculates a new public key using as input local private
-**                    key and peer public key;
-**                  - saves the new public key x-coordinate as DHKey.
+**                    key and peer public key, in the ECC worker task if it is
+**                    available;
+**                  - saves the new public key x-coordinate as DHKey and
+**                    continues in smp_process_dhkey.
 **
 ** Returns          void
 **
 *******************************************************************************/
 void smp_compute_dhkey (tSMP_CB *p_cb)
 {
-    Point       peer_publ_key, new_publ_key;
-    BT_OCTET32  private_key;
+    tSMP_ECC_JOB job;
 
     SMP_TRACE_DEBUG ("%s\n", __FUNCTION__);
 
-    memcpy(private_key, p_cb->private_key, BT_OCTET32_LEN);
-    memcpy(peer_publ_key.x, p_cb->peer_publ_key.x, BT_OCTET32_LEN);
-    memcpy(peer_publ_key.y, p_cb->peer_publ_key.y, BT_OCTET32_LEN);
+    memset(&job, 0, sizeof(tSMP_ECC_JOB));
+    job.op = SMP_ECC_OP_DHKEY;
+    job.p_cback = smp_ecc_dhkey_cback;
+    memcpy(job.private_key, p_cb->private_key, BT_OCTET32_LEN);
+    memcpy(&job.publ_key, &p_cb->peer_publ_key, sizeof(tSMP_PUBLIC_KEY));
 
-    ECC_PointMult(&new_publ_key, &peer_publ_key, (DWORD *) private_key, KEY_LENGTH_DWORDS_P256);
+    if (smp_ecc_submit(&job)) {
+        p_cb->ecc_seq = job.seq;
+    } else {
+        smp_ecc_compute(&job);
+        memcpy(p_cb->dhkey, job.publ_key.x, BT_OCTET32_LEN);
+        smp_process_dhkey(p_cb);
+    }
 
-    memcpy(p_cb->dhkey, new_publ_key.x, BT_OCTET32_LEN);
+    memset(&job, 0, sizeof(tSMP_ECC_JOB));
+}
 
+/*******************************************************************************
+**
+** Function         smp_ecc_dhkey_cback
+**
+** Description      The ECC worker has calculated the DHKey. The worker is idle
+**                  for the rest of the pairing, so the key pair for the next
+**                  pairing is started here.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void smp_ecc_dhkey_cback(tSMP_ECC_JOB *p_job)
+{
+    tSMP_CB *p_cb = &smp_cb;
+
+    if (p_job->seq != p_cb->ecc_seq) {
+        SMP_TRACE_WARNING ("%s drop stale DHKey, seq %d", __func__, p_job->seq);
+        return;
+    }
+    p_cb->ecc_seq = 0;
+
+    memcpy(p_cb->dhkey, p_job->publ_key.x, BT_OCTET32_LEN);
+    smp_ecc_precompute_key_pair();
+    smp_process_dhkey(p_cb);
+}
+
+/*******************************************************************************
+**
+** Function         smp_process_dhkey
+**
+** Description      This function is called when the DHKey is saved in the
+**                  control block. It continues the public key exchange.
+**
+** Returns          void
+**
+*******************************************************************************/
+static void smp_process_dhkey(tSMP_CB *p_cb)
+{
     smp_debug_print_nbyte_little_endian (p_cb->dhkey, (const UINT8 *)"Old DHKey",
                                          BT_OCTET32_LEN);
 
@@ -1133,6 +1233,8 @@ void smp_compute_dhkey (tSMP_CB *p_cb)
                                          BT_OCTET32_LEN);
     smp_debug_print_nbyte_little_endian (p_cb->dhkey, (const UINT8 *)"Reverted DHKey",
                                          BT_OCTET32_LEN);
+
+    smp_dhkey_computed(p_cb);
 }
 
 /*******************************************************************************
@@ -0,0 +1,273 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks the P-256 point multiplications against the debug key pairs and
+// DHKey of the Core Specification (Vol 3 Part H 2.3.5.6.1 and Appendix D.1),
+// compares them with the generic binary NAF multiplication for a fixed set of
+// scalars, and checks ECC_CheckPointIsInElliCur_P256 on good and bad points.
+// With "bench" as argv[1] it also times each multiplication. The Makefile
+// builds this with and without the fixed base comb table.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/bt_target.h"
+#include "p_256_ecc_pp.h"
+#include "host_bench.h"
+
+#define P256_TEST_SCALARS       300
+#define P256_BENCH_SAMPLES      200
+
+/* most significant byte first */
+static const char *p256_priv_a = "3f49f6d4a3c55f3874c9b3e3d2103f504aff607beb40b7995899b8a6cd3c1abd";
+static const char *p256_pub_a_x = "20b003d2f297be2c5e2c83a7e9f9a5b9eff49111acf4fddbcc0301480e359de6";
+static const char *p256_pub_a_y = "dc809c49652aeb6d63329abf5a52155c766345c28fed3024741c8ed01589d28b";
+static const char *p256_priv_b = "55188b3d32f6bb9a900afcfbeed4e72a59cb9ac2f19d7cfb6b4fdd49f47fc5fd";
+static const char *p256_pub_b_x = "1ea1f0f01faf1d9609592284f19e4c0047b58afd8615a69f559077b22faaa190";
+static const char *p256_pub_b_y = "4c55f33e429dad377356703a9ab85160472d1130e28e36765f89aff915b1214a";
+static const char *p256_dhkey = "ec0234a357c8ad05341010a60a397d9b99796b13b4f866f1868d34f373bfa698";
+
+static uint32_t p256_test_seed = 0x12345678;
+
+/* parses a big endian number into the little endian words of the stack */
+static void p256_test_dwords(const char *hex, DWORD *out)
+{
+    uint8_t buf[KEY_LENGTH_DWORDS_P256 * 4];
+
+    host_test_hex(hex, buf, sizeof(buf));
+    host_test_reverse(buf, sizeof(buf));
+    memcpy(out, buf, sizeof(buf));
+}
+
+static uint32_t p256_test_rand(void)
+{
+    /* xorshift32, the scalars are the same on every run */
+    p256_test_seed ^= p256_test_seed << 13;
+    p256_test_seed ^= p256_test_seed >> 17;
+    p256_test_seed ^= p256_test_seed << 5;
+    return p256_test_seed;
+}
+
+static void p256_test_scalar(DWORD *k, int i)
+{
+    int j;
+
+    for (j = 0; j < KEY_LENGTH_DWORDS_P256; j++) {
+        k[j] = p256_test_rand();
+    }
+
+    /* edge cases first: 1, 2, n - 1 and a scalar with only the top bit set */
+    if (i == 0 || i == 1) {
+        memset(k, 0, KEY_LENGTH_DWORDS_P256 * sizeof(DWORD));
+        k[0] = i + 1;
+    } else if (i == 2) {
+        p256_test_dwords("ffffffff00000000ffffffffffffffffbce6faada7179e84f3b9cac2fc632550", k);
+    } else if (i == 3) {
+        memset(k, 0, KEY_LENGTH_DWORDS_P256 * sizeof(DWORD));
+        k[KEY_LENGTH_DWORDS_P256 - 1] = 0x80000000;
+    }
+}
+
+static int p256_test_expect_point(const char *name, const Point *got, const DWORD *x, const DWORD *y)
+{
+    char name_y[64];
+    int fail;
+
+    fail = host_test_expect(name, (const uint8_t *)got->x, (const uint8_t *)x, KEY_LENGTH_DWORDS_P256 * 4);
+    if (y) {
+        snprintf(name_y, sizeof(name_y), "%s, y", name);
+        fail |= host_test_expect(name_y, (const uint8_t *)got->y, (const uint8_t *)y, KEY_LENGTH_DWORDS_P256 * 4);
+    }
+    return fail;
+}
+
+static int p256_test_vectors(void)
+{
+    DWORD priv_a[KEY_LENGTH_DWORDS_P256], priv_b[KEY_LENGTH_DWORDS_P256], k[KEY_LENGTH_DWORDS_P256];
+    DWORD pub_a_x[KEY_LENGTH_DWORDS_P256], pub_a_y[KEY_LENGTH_DWORDS_P256];
+    DWORD pub_b_x[KEY_LENGTH_DWORDS_P256], pub_b_y[KEY_LENGTH_DWORDS_P256];
+    DWORD dhkey[KEY_LENGTH_DWORDS_P256];
+    Point q, pub_a, pub_b;
+    int fail = 0;
+
+    p256_test_dwords(p256_priv_a, priv_a);
+    p256_test_dwords(p256_pub_a_x, pub_a_x);
+    p256_test_dwords(p256_pub_a_y, pub_a_y);
+    p256_test_dwords(p256_priv_b, priv_b);
+    p256_test_dwords(p256_pub_b_x, pub_b_x);
+    p256_test_dwords(p256_pub_b_y, pub_b_y);
+    p256_test_dwords(p256_dhkey, dhkey);
+
+    memset(&pub_a, 0, sizeof(Point));
+    memcpy(pub_a.x, pub_a_x, sizeof(pub_a_x));
+    memcpy(pub_a.y, pub_a_y, sizeof(pub_a_y));
+    memset(&pub_b, 0, sizeof(Point));
+    memcpy(pub_b.x, pub_b_x, sizeof(pub_b_x));
+    memcpy(pub_b.y, pub_b_y, sizeof(pub_b_y));
+
+    memcpy(k, priv_a, sizeof(k));
+    ECC_PointMult_Base_P256(&q, k);
+    fail |= p256_test_expect_point("debug key A, base", &q, pub_a_x, pub_a_y);
+    memcpy(k, priv_b, sizeof(k));
+    ECC_PointMult_Base_P256(&q, k);
+    fail |= p256_test_expect_point("debug key B, base", &q, pub_b_x, pub_b_y);
+
+    memcpy(k, priv_a, sizeof(k));
+    ECC_PointMult_P256(&q, &pub_b, k);
+    fail |= p256_test_expect_point("DHKey A, variable base", &q, dhkey, NULL);
+    memcpy(k, priv_b, sizeof(k));
+    ECC_PointMult_P256(&q, &pub_a, k);
+    fail |= p256_test_expect_point("DHKey B, variable base", &q, dhkey, NULL);
+
+    memcpy(k, priv_a, sizeof(k));
+    ECC_PointMult(&q, &pub_b, k, KEY_LENGTH_DWORDS_P256);
+    fail |= p256_test_expect_point("DHKey A, ECC_PointMult", &q, dhkey, NULL);
+
+    return fail;
+}
+
+static int p256_test_on_curve(void)
+{
+    DWORD x[KEY_LENGTH_DWORDS_P256], y[KEY_LENGTH_DWORDS_P256];
+    Point p;
+    int fail = 0;
+
+    memset(&p, 0, sizeof(Point));
+    p256_test_dwords(p256_pub_a_x, x);
+    p256_test_dwords(p256_pub_a_y, y);
+    memcpy(p.x, x, sizeof(x));
+    memcpy(p.y, y, sizeof(y));
+
+    if (!ECC_CheckPointIsInElliCur_P256(&p)) {
+        printf("FAIL on curve, debug key A\n");
+        fail = 1;
+    }
+
+    p.y[0] ^= 1;
+    if (ECC_CheckPointIsInElliCur_P256(&p)) {
+        printf("FAIL off curve, debug key A with y changed\n");
+        fail = 1;
+    }
+
+    /* coordinates must be reduced */
+    memset(&p, 0, sizeof(Point));
+    memcpy(p.x, curve_p256.p, KEY_LENGTH_DWORDS_P256 * sizeof(DWORD));
+    if (ECC_CheckPointIsInElliCur_P256(&p)) {
+        printf("FAIL off curve, x = p\n");
+        fail = 1;
+    }
+
+    if (!fail) {
+        printf("PASS ECC_CheckPointIsInElliCur_P256\n");
+    }
+    return fail;
+}
+
+/* base and variable base multiplications against the binary NAF one */
+static int p256_test_scalars(void)
+{
+    DWORD a[KEY_LENGTH_DWORDS_P256], b[KEY_LENGTH_DWORDS_P256], k[KEY_LENGTH_DWORDS_P256];
+    Point pa, ref, q;
+    int i, fail = 0;
+
+    for (i = 0; i < P256_TEST_SCALARS; i++) {
+        p256_test_scalar(a, i);
+        p256_test_scalar(b, P256_TEST_SCALARS);
+
+        memcpy(k, a, sizeof(k));
+        ECC_PointMult_Bin_NAF(&ref, &curve_p256.G, k, KEY_LENGTH_DWORDS_P256);
+        memcpy(k, a, sizeof(k));
+        ECC_PointMult_Base_P256(&pa, k);
+        if (memcmp(pa.x, ref.x, sizeof(ref.x)) || memcmp(pa.y, ref.y, sizeof(ref.y))) {
+            printf("FAIL base multiplication, scalar %d\n", i);
+            fail = 1;
+        }
+        memcpy(k, a, sizeof(k));
+        ECC_PointMult_P256(&q, &curve_p256.G, k);
+        if (memcmp(q.x, ref.x, sizeof(ref.x)) || memcmp(q.y, ref.y, sizeof(ref.y))) {
+            printf("FAIL variable base multiplication of G, scalar %d\n", i);
+            fail = 1;
+        }
+        if (!ECC_CheckPointIsInElliCur_P256(&pa)) {
+            printf("FAIL result off curve, scalar %d\n", i);
+            fail = 1;
+        }
+
+        memcpy(k, b, sizeof(k));
+        ECC_PointMult_Bin_NAF(&ref, &pa, k, KEY_LENGTH_DWORDS_P256);
+        memcpy(k, b, sizeof(k));
+        ECC_PointMult_P256(&q, &pa, k);
+        if (memcmp(q.x, ref.x, sizeof(ref.x)) || memcmp(q.y, ref.y, sizeof(ref.y))) {
+            printf("FAIL variable base multiplication, scalar %d\n", i);
+            fail = 1;
+        }
+    }
+
+    if (!fail) {
+        printf("PASS %d scalars against the binary NAF multiplication\n", P256_TEST_SCALARS);
+    }
+    return fail;
+}
+
+static void p256_bench(void)
+{
+    static uint64_t legacy[P256_BENCH_SAMPLES], base[P256_BENCH_SAMPLES], var[P256_BENCH_SAMPLES];
+    DWORD k[KEY_LENGTH_DWORDS_P256];
+    Point p, q;
+    uint64_t t;
+    int i;
+
+    p256_test_scalar(k, P256_TEST_SCALARS);
+    ECC_PointMult_Base_P256(&p, k);
+
+    for (i = 0; i < P256_BENCH_SAMPLES; i++) {
+        p256_test_scalar(k, P256_TEST_SCALARS);
+        t = host_bench_now_ns();
+        ECC_PointMult_Bin_NAF(&q, &p, k, KEY_LENGTH_DWORDS_P256);
+        legacy[i] = (host_bench_now_ns() - t) / 1000;
+
+        p256_test_scalar(k, P256_TEST_SCALARS);
+        t = host_bench_now_ns();
+        ECC_PointMult_Base_P256(&q, k);
+        base[i] = (host_bench_now_ns() - t) / 1000;
+
+        p256_test_scalar(k, P256_TEST_SCALARS);
+        t = host_bench_now_ns();
+        ECC_PointMult_P256(&q, &p, k);
+        var[i] = (host_bench_now_ns() - t) / 1000;
+    }
+
+    host_bench_report_dist("binary NAF (legacy)", legacy, P256_BENCH_SAMPLES, "us");
+    host_bench_report_dist("fixed base, key pair", base, P256_BENCH_SAMPLES, "us");
+    host_bench_report_dist("variable base, DHKey", var, P256_BENCH_SAMPLES, "us");
+}
+
+int main(int argc, char **argv)
+{
+    int fail = 0;
+
+    p_256_init_curve(KEY_LENGTH_DWORDS_P256);
+
+    fail |= p256_test_vectors();
+    fail |= p256_test_on_curve();
+    fail |= p256_test_scalars();
+    if (fail) {
+        printf("p256: FAIL\n");
+        return 1;
+    }
+
+    if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+        p256_bench();
+    }
+    return 0;
+}
@@ -0,0 +1,296 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks the SMP block cipher and AES-CMAC against the FIPS-197, SP 800-38A,
+// RFC 4493 and Core Specification (Vol 3 Part H Appendix D) test vectors.
+// With "bench" as argv[1] it also times single block encryption and AES-CMAC
+// over the message sizes used by pairing. The Makefile builds this with the
+// T-table and with the byte oriented cipher.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/bt_target.h"
+#include "smp_int.h"
+#include "aes.h"
+#include "host_bench.h"
+
+#if SMP_DYNAMIC_MEMORY == FALSE
+tSMP_CB smp_cb;
+#else
+static tSMP_CB smp_cb_host;
+tSMP_CB *smp_cb_ptr = &smp_cb_host;
+#endif
+
+#define SMP_BENCH_BLOCKS        1000000
+#define SMP_BENCH_MACS          100000
+#define SMP_BENCH_SAMPLES       20000
+
+/* RFC 4493 section 4 */
+static const char *rfc4493_key = "2b7e151628aed2a6abf7158809cf4f3c";
+static const char *rfc4493_msg =
+    "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51"
+    "30c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710";
+static const struct {
+    uint16_t    len;
+    const char  *mac;
+} rfc4493_vec[] = {
+    { 0,  "bb1d6929e95937287fa37d129b756746" },
+    { 16, "070a16b46b4d4144f79bdd9dd04a287c" },
+    { 40, "dfa66747de9ae63030ca32611497c827" },
+    { 64, "51f0bebf7e3b9d92fc49741779363cfe" },
+};
+
+/* Core Specification Vol 3 Part H Appendix D, most significant byte first */
+static const char *smp_u = "20b003d2f297be2c5e2c83a7e9f9a5b9eff49111acf4fddbcc0301480e359de6";
+static const char *smp_v = "55188b3d32f6bb9a900afcfbeed4e72a59cb9ac2f19d7cfb6b4fdd49f47fc5fd";
+static const char *smp_x = "d5cb8454d177733effffb2ec712baeab";
+static const char *smp_y = "a6e8e7cc25a75f6e216583f7ff3dc4cf";
+static const char *smp_w = "ec0234a357c8ad05341010a60a397d9b99796b13b4f866f1868d34f373bfa698";
+static const char *smp_a1 = "0056123737bfce";
+static const char *smp_a2 = "00a713702dcfc1";
+static const char *smp_r = "12a3343bb453bb5408da42d20c2d0fc8";
+static const char *smp_iocap = "010102";
+
+/* parses a big endian vector into the little endian order of the SMP functions */
+static void smp_test_le(const char *hex, uint8_t *out, size_t len)
+{
+    host_test_hex(hex, out, len);
+    host_test_reverse(out, len);
+}
+
+static int smp_test_aes(void)
+{
+    uint8_t key[32], pt[16], ct[16], out[16], o_key[16];
+    aes_context ctx;
+    int fail = 0;
+
+    /* FIPS-197 C.1 */
+    host_test_hex("000102030405060708090a0b0c0d0e0f", key, 16);
+    host_test_hex("00112233445566778899aabbccddeeff", pt, 16);
+    host_test_hex("69c4e0d86a7b0430d8cdb78070b4c55a", ct, 16);
+    bt_aes_set_key(key, 16, &ctx);
+    bluedroid_aes_encrypt(pt, out, &ctx);
+    fail |= host_test_expect("FIPS-197 C.1 encrypt", out, ct, 16);
+    bluedroid_aes_decrypt(ct, out, &ctx);
+    fail |= host_test_expect("FIPS-197 C.1 decrypt", out, pt, 16);
+    bluedroid_aes_encrypt_128(pt, out, key, o_key);
+    fail |= host_test_expect("FIPS-197 C.1 encrypt_128", out, ct, 16);
+    bluedroid_aes_decrypt_128(ct, out, o_key, o_key);
+    fail |= host_test_expect("FIPS-197 C.1 decrypt_128", out, pt, 16);
+    fail |= host_test_expect("FIPS-197 C.1 decrypt_128 key", o_key, key, 16);
+
+    /* FIPS-197 C.3 */
+    host_test_hex("000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f", key, 32);
+    host_test_hex("8ea2b7ca516745bfeafc49904b496089", ct, 16);
+    bt_aes_set_key(key, 32, &ctx);
+    bluedroid_aes_encrypt(pt, out, &ctx);
+    fail |= host_test_expect("FIPS-197 C.3 encrypt", out, ct, 16);
+
+    /* SP 800-38A F.1.1, first block */
+    host_test_hex(rfc4493_key, key, 16);
+    host_test_hex("6bc1bee22e409f96e93d7e117393172a", pt, 16);
+    host_test_hex("3ad77bb40d7a3660a89ecaf32466ef97", ct, 16);
+    bt_aes_set_key(key, 16, &ctx);
+    bluedroid_aes_encrypt(pt, out, &ctx);
+    fail |= host_test_expect("SP 800-38A F.1.1 encrypt", out, ct, 16);
+
+    return fail;
+}
+
+static int smp_test_cmac(void)
+{
+    uint8_t key[16], key_le[16], msg[64], msg_le[64], mac[16], expect[16];
+    tSMP_CMAC_CTX cmac;
+    char name[48];
+    uint16_t off, chunk, n;
+    size_t i;
+    int fail = 0;
+
+    host_test_hex(rfc4493_key, key, 16);
+    host_test_hex(rfc4493_msg, msg, sizeof(msg));
+    memcpy(key_le, key, 16);
+    host_test_reverse(key_le, 16);
+
+    for (i = 0; i < sizeof(rfc4493_vec) / sizeof(rfc4493_vec[0]); i++) {
+        uint16_t len = rfc4493_vec[i].len;
+
+        host_test_hex(rfc4493_vec[i].mac, expect, 16);
+
+        /* little endian one shot interface used by the stack */
+        memcpy(msg_le, msg, len);
+        host_test_reverse(msg_le, len);
+        aes_cipher_msg_auth_code(key_le, msg_le, len, 16, mac);
+        host_test_reverse(mac, 16);
+        snprintf(name, sizeof(name), "RFC 4493 len %u", len);
+        fail |= host_test_expect(name, mac, expect, 16);
+
+        aes_cipher_msg_auth_code(key_le, msg_le, len, 8, mac);
+        host_test_reverse(mac, 8);
+        snprintf(name, sizeof(name), "RFC 4493 len %u tlen 8", len);
+        fail |= host_test_expect(name, mac, expect, 8);
+
+        /* streaming, with chunks of 1, 3, 7, ... bytes across block edges */
+        smp_cmac_init(&cmac, key);
+        for (off = 0, chunk = 1; off < len; off += n, chunk = chunk * 2 + 1) {
+            n = (chunk < len - off) ? chunk : len - off;
+            smp_cmac_update(&cmac, msg + off, n);
+        }
+        smp_cmac_final(&cmac, mac);
+        snprintf(name, sizeof(name), "RFC 4493 len %u streaming", len);
+        fail |= host_test_expect(name, mac, expect, 16);
+    }
+
+    return fail;
+}
+
+static int smp_test_functions(void)
+{
+    uint8_t u[32], v[32], w[32], x[16], y[16], r[16], a1[7], a2[7], iocap[3];
+    uint8_t out[16], out2[16], expect[16];
+    uint8_t key_id[4];
+    uint32_t vres;
+    int fail = 0;
+
+    smp_test_le(smp_u, u, 32);
+    smp_test_le(smp_v, v, 32);
+    smp_test_le(smp_w, w, 32);
+    smp_test_le(smp_x, x, 16);
+    smp_test_le(smp_y, y, 16);
+    smp_test_le(smp_r, r, 16);
+    smp_test_le(smp_a1, a1, 7);
+    smp_test_le(smp_a2, a2, 7);
+    smp_test_le(smp_iocap, iocap, 3);
+
+    /* D.2 f4 */
+    smp_calculate_f4(u, v, x, 0, out);
+    smp_test_le("f2c916f107a9bd1cf1eda1bea974872d", expect, 16);
+    fail |= host_test_expect("f4", out, expect, 16);
+
+    /* D.3 f5 */
+    smp_calculate_f5(w, x, y, a1, a2, out, out2);
+    smp_test_le("2965f176a1084a02fd3f6a20ce636e20", expect, 16);
+    fail |= host_test_expect("f5 MacKey", out, expect, 16);
+    smp_test_le("6986791169d7cd23980522b594750a38", expect, 16);
+    fail |= host_test_expect("f5 LTK", out2, expect, 16);
+
+    /* D.4 f6 */
+    smp_test_le("2965f176a1084a02fd3f6a20ce636e20", w, 16);
+    smp_calculate_f6(w, x, y, r, iocap, a1, a2, out);
+    smp_test_le("e3c473989cd0e8c5d26c0b09da958f61", expect, 16);
+    fail |= host_test_expect("f6", out, expect, 16);
+
+    /* D.5 g2 */
+    vres = smp_calculate_g2(u, v, x, y);
+    if (vres == 0x2f9ed5ba % 1000000) {
+        printf("PASS g2\n");
+    } else {
+        printf("FAIL g2\n  got    %u\n  expect %u\n", vres, 0x2f9ed5ba % 1000000);
+        fail = 1;
+    }
+
+    /* D.8 h6 */
+    smp_test_le("ec0234a357c8ad05341010a60a397d9b", w, 16);
+    smp_test_le("6c656272", key_id, 4);
+    smp_calculate_h6(w, key_id, out);
+    smp_test_le("2d9ae102e76dc91ce8d3a9e280b16399", expect, 16);
+    fail |= host_test_expect("h6", out, expect, 16);
+
+    return fail;
+}
+
+static void smp_bench_aes(void)
+{
+    uint8_t key[16], block[16], o_key[16];
+    aes_context ctx;
+    uint64_t start;
+    int i;
+
+    host_test_hex(rfc4493_key, key, 16);
+    memset(block, 0x5a, sizeof(block));
+
+    bt_aes_set_key(key, 16, &ctx);
+    start = host_bench_now_ns();
+    for (i = 0; i < SMP_BENCH_BLOCKS; i++) {
+        bluedroid_aes_encrypt(block, block, &ctx);
+    }
+    printf("%-28s %.1f ns/block\n", "aes encrypt, key schedule",
+           (double)(host_bench_now_ns() - start) / SMP_BENCH_BLOCKS);
+
+    start = host_bench_now_ns();
+    for (i = 0; i < SMP_BENCH_BLOCKS; i++) {
+        bluedroid_aes_encrypt_128(block, block, key, o_key);
+    }
+    printf("%-28s %.1f ns/block\n", "aes encrypt_128",
+           (double)(host_bench_now_ns() - start) / SMP_BENCH_BLOCKS);
+}
+
+static void smp_bench_cmac(uint16_t len)
+{
+    static uint64_t samples[SMP_BENCH_SAMPLES];
+    uint8_t key[16], msg[256], mac[16];
+    tSMP_CMAC_CTX cmac;
+    char name[48];
+    uint64_t start, t;
+    int i;
+
+    host_test_hex(rfc4493_key, key, 16);
+    memset(msg, 0xa5, sizeof(msg));
+
+    start = host_bench_now_ns();
+    for (i = 0; i < SMP_BENCH_MACS; i++) {
+        aes_cipher_msg_auth_code(key, msg, len, 16, mac);
+    }
+    printf("cmac %3u bytes, one shot     %.1f ns/mac\n", len,
+           (double)(host_bench_now_ns() - start) / SMP_BENCH_MACS);
+
+    start = host_bench_now_ns();
+    for (i = 0; i < SMP_BENCH_MACS; i++) {
+        smp_cmac_init(&cmac, key);
+        smp_cmac_update(&cmac, msg, len);
+        smp_cmac_final(&cmac, mac);
+    }
+    printf("cmac %3u bytes, streaming    %.1f ns/mac\n", len,
+           (double)(host_bench_now_ns() - start) / SMP_BENCH_MACS);
+
+    for (i = 0; i < SMP_BENCH_SAMPLES; i++) {
+        t = host_bench_ticks();
+        aes_cipher_msg_auth_code(key, msg, len, 16, mac);
+        samples[i] = host_bench_ticks() - t;
+    }
+    snprintf(name, sizeof(name), "cmac %u bytes", len);
+    host_bench_report_dist(name, samples, SMP_BENCH_SAMPLES, HOST_BENCH_TICK_UNIT);
+}
+
+int main(int argc, char **argv)
+{
+    int fail = 0;
+
+    fail |= smp_test_aes();
+    fail |= smp_test_cmac();
+    fail |= smp_test_functions();
+    if (fail) {
+        printf("smp crypto: FAIL\n");
+        return 1;
+    }
+
+    if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+        smp_bench_aes();
+        /* f4 and g2 messages, f5 key derivation, a signed write */
+        smp_bench_cmac(65);
+        smp_bench_cmac(80);
+        smp_bench_cmac(53);
+        smp_bench_cmac(256);
+    }
+    return 0;
+}
@@ -0,0 +1,74 @@
+# Shared rules for the host test and benchmark programs. A component test
+# Makefile sets BT_ROOT to the bluedroid directory before including this.
+#
+#   make        build the programs
+#   make check  run the test vectors and bit exactness comparisons
+#   make bench  run the benchmarks
+
+CC      ?= cc
+O       ?= build
+OPT     ?= -O2
+
+HOST_DIR := $(BT_ROOT)/test/host
+
+# Same include directories as package.yaml, with host stand-ins for the OS
+HOST_INCLUDES := $(HOST_DIR)/include \
+	$(BT_ROOT)/include \
+	$(BT_ROOT)/api/include/api \
+	$(BT_ROOT)/bta/include \
+	$(BT_ROOT)/bta/ar/include \
+	$(BT_ROOT)/bta/av/include \
+	$(BT_ROOT)/bta/dm/include \
+	$(BT_ROOT)/bta/gatt/include \
+	$(BT_ROOT)/bta/hh/include \
+	$(BT_ROOT)/bta/hf_client/include \
+	$(BT_ROOT)/bta/jv/include \
+	$(BT_ROOT)/bta/sdp/include \
+	$(BT_ROOT)/bta/sys/include \
+	$(BT_ROOT)/device/include \
+	$(BT_ROOT)/hci/include \
+	$(BT_ROOT)/hci/vendor/include \
+	$(BT_ROOT)/hci/vendor \
+	$(BT_ROOT)/osi/include \
+	$(BT_ROOT)/external/sbc/decoder/include \
+	$(BT_ROOT)/external/sbc/encoder/include \
+	$(BT_ROOT)/btc/profile/esp/blufi/include \
+	$(BT_ROOT)/btc/profile/esp/include \
+	$(BT_ROOT)/btc/profile/std/a2dp/include \
+	$(BT_ROOT)/btc/profile/std/include \
+	$(BT_ROOT)/btc/include \
+	$(BT_ROOT)/stack/btm/include \
+	$(BT_ROOT)/stack/gap/include \
+	$(BT_ROOT)/stack/gatt/include \
+	$(BT_ROOT)/stack/l2cap/include \
+	$(BT_ROOT)/stack/sdp/include \
+	$(BT_ROOT)/stack/smp/include \
+	$(BT_ROOT)/stack/avct/include \
+	$(BT_ROOT)/stack/avrc/include \
+	$(BT_ROOT)/stack/avdt/include \
+	$(BT_ROOT)/stack/a2dp/include \
+	$(BT_ROOT)/stack/rfcomm/include \
+	$(BT_ROOT)/stack/include \
+	$(BT_ROOT)/common/include
+
+# By default the bond store and GATT client cache use files on the host.
+# HOST_KV_CFLAGS builds them on aos_kv instead, with HOST_KV_SRCS providing an
+# in-memory one.
+HOST_CFLAGS := -std=gnu99 $(OPT) -g -Wall \
+	-Wno-unused-function -Wno-unused-variable -Wno-unused-but-set-variable \
+	-DBOND_STORE_KV_INCLUDED=FALSE \
+	$(addprefix -I,$(HOST_INCLUDES))
+HOST_KV_CFLAGS := $(filter-out -DBOND_STORE_KV_INCLUDED=FALSE,$(HOST_CFLAGS)) \
+	-DBOND_STORE_KV_INCLUDED=TRUE
+
+# osi_malloc and friends on the C library
+HOST_OSI_SRCS := $(HOST_DIR)/host_osi.c
+HOST_KV_SRCS := $(HOST_DIR)/host_kv.c
+
+$(O):
+	mkdir -p $@
+
+.PHONY: all check bench clean
+
+clean:
+	rm -rf $(O)
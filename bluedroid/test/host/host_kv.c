@@ -0,0 +1,126 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// In-memory aos_kv for the host tests. Like the target, a get into a buffer
+// that is too small fails and reports the length of the value.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "aos/kv.h"
+
+typedef struct host_kv_item {
+    struct host_kv_item *next;
+    char *key;
+    void *value;
+    int len;
+} host_kv_item_t;
+
+static host_kv_item_t *host_kv_items;
+static int host_kv_write_count;
+
+static host_kv_item_t **host_kv_find(const char *key)
+{
+    host_kv_item_t **p = &host_kv_items;
+
+    while (*p && strcmp((*p)->key, key) != 0) {
+        p = &(*p)->next;
+    }
+    return p;
+}
+
+int aos_kv_set(const char *key, const void *value, int len, int sync)
+{
+    host_kv_item_t **p = host_kv_find(key);
+    void *copy;
+
+    (void)sync;
+    if (!key || !value || len <= 0 || (copy = malloc(len)) == NULL) {
+        return -1;
+    }
+    memcpy(copy, value, len);
+
+    if (!*p) {
+        if ((*p = calloc(1, sizeof(host_kv_item_t))) == NULL || ((*p)->key = strdup(key)) == NULL) {
+            free(*p);
+            *p = NULL;
+            free(copy);
+            return -1;
+        }
+    }
+    free((*p)->value);
+    (*p)->value = copy;
+    (*p)->len = len;
+    host_kv_write_count++;
+    return 0;
+}
+
+int aos_kv_get(const char *key, void *buffer, int *buffer_len)
+{
+    host_kv_item_t *item = *host_kv_find(key);
+
+    if (!item) {
+        return -1;
+    }
+    if (*buffer_len < item->len) {
+        *buffer_len = item->len;
+        return -1;
+    }
+    memcpy(buffer, item->value, item->len);
+    *buffer_len = item->len;
+    return 0;
+}
+
+int aos_kv_del(const char *key)
+{
+    host_kv_item_t **p = host_kv_find(key);
+    host_kv_item_t *item = *p;
+
+    if (!item) {
+        return -1;
+    }
+    *p = item->next;
+    free(item->key);
+    free(item->value);
+    free(item);
+    return 0;
+}
+
+int host_kv_count(void)
+{
+    int count = 0;
+
+    for (host_kv_item_t *item = host_kv_items; item; item = item->next) {
+        count++;
+    }
+    return count;
+}
+
+int host_kv_writes(void)
+{
+    return host_kv_write_count;
+}
+
+int host_kv_len(const char *key)
+{
+    host_kv_item_t *item = *host_kv_find(key);
+
+    return item ? item->len : -1;
+}
+
+void host_kv_reset(void)
+{
+    while (host_kv_items) {
+        aos_kv_del(host_kv_items->key);
+    }
+    host_kv_write_count = 0;
+}
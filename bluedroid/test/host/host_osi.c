@@ -0,0 +1,50 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// The osi allocator on top of the C library, for host tests of code that
+// allocates through osi_malloc and friends. Built without
+// CONFIG_BLUEDROID_MEM_DEBUG, so only the plain entry points are needed.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "osi/allocator.h"
+
+char *osi_strdup(const char *str)
+{
+    return strdup(str);
+}
+
+void *osi_malloc_func(size_t size)
+{
+    return malloc(size);
+}
+
+void *osi_calloc_func(size_t size)
+{
+    return calloc(1, size);
+}
+
+void osi_free_func(void *ptr)
+{
+    free(ptr);
+}
+
+const allocator_t allocator_malloc = {
+    osi_malloc_func,
+    osi_free_func
+};
+
+const allocator_t allocator_calloc = {
+    osi_calloc_func,
+    osi_free_func
+};
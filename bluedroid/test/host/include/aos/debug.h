@@ -0,0 +1,12 @@
+/*
+ * Host stand-in for the AliOS Things debug API, used by the host test and
+ * benchmark builds only.
+ */
+#ifndef _HOST_AOS_DEBUG_H_
+#define _HOST_AOS_DEBUG_H_
+
+#include <assert.h>
+
+#define aos_assert(x) assert(x)
+
+#endif /* _HOST_AOS_DEBUG_H_ */
@@ -0,0 +1,27 @@
+/*
+ * Host stand-in for the AliOS Things kernel API, used by the host test and
+ * benchmark builds only. It only declares what the stack headers refer to,
+ * code that really runs kernel services is not built for the host.
+ */
+#ifndef _HOST_AOS_KERNEL_H_
+#define _HOST_AOS_KERNEL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    void *hdl;
+} aos_hdl_t;
+
+typedef aos_hdl_t aos_task_t;
+typedef aos_hdl_t aos_queue_t;
+typedef aos_hdl_t aos_mutex_t;
+typedef aos_hdl_t aos_sem_t;
+typedef aos_hdl_t aos_timer_t;
+
+#define AOS_WAIT_FOREVER    0xffffffffu
+#define AOS_DEFAULT_APP_PRI 32
+
+long long aos_now_ms(void);
+
+#endif /* _HOST_AOS_KERNEL_H_ */
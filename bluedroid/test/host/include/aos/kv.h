@@ -0,0 +1,23 @@
+/*
+ * Host stand-in for the AliOS Things key-value API, used by the host test
+ * builds only. test/host/host_kv.c keeps the values in memory, the
+ * host_kv_* helpers let a test inspect and reset them.
+ */
+#ifndef _HOST_AOS_KV_H_
+#define _HOST_AOS_KV_H_
+
+int aos_kv_set(const char *key, const void *value, int len, int sync);
+int aos_kv_get(const char *key, void *buffer, int *buffer_len);
+int aos_kv_del(const char *key);
+
+// Number of values, and of aos_kv_set calls since the last reset
+int host_kv_count(void);
+int host_kv_writes(void);
+
+// Returns the length of the value |key|, or -1 if there is none
+int host_kv_len(const char *key);
+
+// Deletes all values and resets the write count
+void host_kv_reset(void);
+
+#endif /* _HOST_AOS_KV_H_ */
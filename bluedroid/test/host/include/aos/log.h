@@ -0,0 +1,15 @@
+/*
+ * Host stand-in for the AliOS Things log API, used by the host test and
+ * benchmark builds only.
+ */
+#ifndef _HOST_AOS_LOG_H_
+#define _HOST_AOS_LOG_H_
+
+#include <stdio.h>
+
+#define LOGE(tag, fmt, ...) fprintf(stderr, fmt "\n", ##__VA_ARGS__)
+#define LOGW(tag, fmt, ...) fprintf(stderr, fmt "\n", ##__VA_ARGS__)
+#define LOGI(tag, fmt, ...) do { } while (0)
+#define LOGD(tag, fmt, ...) do { } while (0)
+
+#endif /* _HOST_AOS_LOG_H_ */
@@ -0,0 +1,147 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef _HOST_BENCH_H_
+#define _HOST_BENCH_H_
+
+// Small helpers shared by the host test and benchmark programs: a clock, a
+// cycle counter, a distribution report and hex string parsing.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HOST_BENCH_TICK_UNIT "cycles"
+#else
+#define HOST_BENCH_TICK_UNIT "ns"
+#endif
+
+static inline uint64_t host_bench_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// CPU cycles where the host has a cycle counter, nanoseconds otherwise
+static inline uint64_t host_bench_ticks(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return host_bench_now_ns();
+#endif
+}
+
+static int host_bench_cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+// Sorts |samples| and prints their min, percentiles, max and mean
+static inline void host_bench_report_dist(const char *name, uint64_t *samples, size_t count, const char *unit)
+{
+    uint64_t sum = 0;
+    size_t i;
+
+    if (count == 0) {
+        printf("%-28s no samples\n", name);
+        return;
+    }
+
+    qsort(samples, count, sizeof(uint64_t), host_bench_cmp_u64);
+    for (i = 0; i < count; i++) {
+        sum += samples[i];
+    }
+
+    printf("%-28s n=%-6zu min %llu p50 %llu p90 %llu p99 %llu max %llu mean %llu %s\n", name, count,
+           (unsigned long long)samples[0],
+           (unsigned long long)samples[count / 2],
+           (unsigned long long)samples[count * 9 / 10],
+           (unsigned long long)samples[count * 99 / 100],
+           (unsigned long long)samples[count - 1],
+           (unsigned long long)(sum / count), unit);
+}
+
+// Parses a hex string into |out|, most significant byte first. Spaces are
+// skipped. Returns the number of bytes written.
+static inline size_t host_test_hex(const char *hex, uint8_t *out, size_t max)
+{
+    size_t n = 0;
+    unsigned int byte;
+
+    while (*hex && n < max) {
+        if (*hex == ' ') {
+            hex++;
+            continue;
+        }
+        if (sscanf(hex, "%2x", &byte) != 1) {
+            break;
+        }
+        out[n++] = (uint8_t)byte;
+        hex += 2;
+    }
+    return n;
+}
+
+// Reverses |len| bytes in place, to turn a big endian test vector into the
+// little endian byte order the stack uses and back
+static inline void host_test_reverse(uint8_t *buf, size_t len)
+{
+    size_t i;
+    uint8_t t;
+
+    for (i = 0; i < len / 2; i++) {
+        t = buf[i];
+        buf[i] = buf[len - 1 - i];
+        buf[len - 1 - i] = t;
+    }
+}
+
+// Returns 0 if |len| bytes of |got| match |expect|, otherwise prints both and
+// returns 1
+static inline int host_test_expect(const char *name, const uint8_t *got, const uint8_t *expect, size_t len)
+{
+    size_t i;
+
+    if (memcmp(got, expect, len) == 0) {
+        printf("PASS %s\n", name);
+        return 0;
+    }
+
+    printf("FAIL %s\n  got    ", name);
+    for (i = 0; i < len; i++) {
+        printf("%02x", got[i]);
+    }
+    printf("\n  expect ");
+    for (i = 0; i < len; i++) {
+        printf("%02x", expect[i]);
+    }
+    printf("\n");
+    return 1;
+}
+
+// Returns 0 if |ok|, otherwise prints |name| and returns 1
+static inline int host_test_true(const char *name, int ok)
+{
+    printf("%s %s\n", ok ? "PASS" : "FAIL", name);
+    return ok ? 0 : 1;
+}
+
+#endif /* _HOST_BENCH_H_ */